@@ -19,6 +19,9 @@ public:
 	std::string saveFile;
 	std::string demoFile;
 
+	//! sim frame to start watching demoFile at, from its closest keyframe savegame if there is one
+	int demoStartFrame;
+
 	//! if this client is not the server player, the IP address we connect to
 	//! if this client is the server player, the IP address that other players connect to
 	std::string hostIP;
@@ -12,6 +12,7 @@
 #include "ConsoleHistory.h"
 #include "GameHelper.h"
 #include "GameSetup.h"
+#include "SimFrameStages.h"
 #include "GlobalUnsynced.h"
 #include "LoadScreen.h"
 #include "SelectedUnitsHandler.h"
@@ -119,8 +120,11 @@
 #include "System/SafeUtil.h"
 #include "System/SpringExitCode.h"
 #include "System/SpringMath.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveHandler.h"
+#include "System/LoadSave/DemoKeyframes.h"
 #include "System/LoadSave/DemoRecorder.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Misc.h"
@@ -149,6 +153,8 @@ CONFIG(int, ShowPlayerInfo).defaultValue(1).headlessValue(0);
 CONFIG(float, GuiOpacity).defaultValue(0.8f).minimumValue(0.0f).maximumValue(1.0f).description("Sets the opacity of the built-in Spring UI. Generally has no effect on LuaUI widgets. Can be set in-game using shift+, to decrease and shift+. to increase.");
 CONFIG(std::string, InputTextGeo).defaultValue("");
 
+CONFIG(bool, SimFrameStagesMT).defaultValue(false).safemodeValue(false).description("Run non-conflicting SimFrame stages (e.g. LOS and interceptors) concurrently. Experimental.");
+CONFIG(int, DemoKeyframeInterval).defaultValue(0).minimumValue(0).description("Seconds of game time between keyframe savegames written alongside a demo while watching it, 0 = off. Set DemoStartFrame in the start-script to start the demo from them.");
 CONFIG(int, SmoothTimeOffset).defaultValue(0).headlessValue(0).description("Enables frametimeoffset smoothing, 0 = off (old version), -1 = forced 0.5,  1-20 smooth, recommended = 2-3");
 
 CGame* game = nullptr;
@@ -214,11 +220,14 @@ CR_REG_METADATA(CGame, (
 
 	CR_MEMBER(speedControl),
 	CR_MEMBER(luaGCControl),
+	CR_IGNORED(simFrameStagesMT),
+	CR_IGNORED(demoKeyframeInterval),
 
 	CR_IGNORED(jobDispatcher),
 	CR_IGNORED(curKeyCodeChain),
 	CR_IGNORED(curScanCodeChain),
 	CR_IGNORED(worldDrawer),
+	CR_IGNORED(simFrameStages),
 	CR_IGNORED(saveFileHandler),
 
 	// Post Load
@@ -258,6 +267,9 @@ CGame::CGame(const std::string& mapFileName, const std::string& modFileName, ILo
 
 	speedControl = configHandler->GetInt("SpeedControl");
 
+	simFrameStagesMT = configHandler->GetBool("SimFrameStagesMT");
+	demoKeyframeInterval = configHandler->GetInt("DemoKeyframeInterval") * GAME_SPEED;
+
 	playerRoster.SetSortTypeByCode((PlayerRoster::SortType)configHandler->GetInt("ShowPlayerInfo"));
 
 	CInputReceiver::guiAlpha = configHandler->GetFloat("GuiOpacity");
@@ -291,6 +303,8 @@ CGame::CGame(const std::string& mapFileName, const std::string& modFileName, ILo
 
 	CResourceHandler::CreateInstance();
 	CCategoryHandler::CreateInstance();
+
+	InitSimFrameStages();
 }
 
 CGame::~CGame()
@@ -1724,6 +1738,49 @@ void CGame::StartPlaying()
 
 static const char* const tracingSimFrameName = "SimFrame";
 
+void CGame::InitSimFrameStages()
+{
+	std::array<CStageGraph::StageFunc, SIM_STAGE_COUNT> stageFuncs;
+
+	stageFuncs[SIM_STAGE_GAMEHELPER   ] = []() { helper->Update(); };
+	stageFuncs[SIM_STAGE_READMAP      ] = []() { readMap->Update(); };
+	stageFuncs[SIM_STAGE_SMOOTHGROUND ] = []() { smoothGround.UpdateSmoothMesh(); };
+	stageFuncs[SIM_STAGE_MAPDAMAGE    ] = []() { mapDamage->Update(); };
+	stageFuncs[SIM_STAGE_UNITS        ] = []() { unitHandler.Update(); };
+	stageFuncs[SIM_STAGE_PATHING      ] = []() { pathManager->Update(); };
+	stageFuncs[SIM_STAGE_PROJECTILES  ] = []() { projectileHandler.Update(); };
+	stageFuncs[SIM_STAGE_FEATURES     ] = []() { featureHandler.Update(); };
+	stageFuncs[SIM_STAGE_SCRIPTS      ] = []() {
+		/* The default GAME_SPEED is 30, which doesn't divide 1000 well,
+		 * so scripts will perceive 990ms per second. But this is fine,
+		 * since doing "29th February" style of extra counting would be
+		 * disruptive to sleeps that assume a constant tick length while
+		 * not being otherwise perceptible since most animations don't
+		 * run that long. */
+		static constexpr int tickMs = 1000 / GAME_SPEED;
+
+		SCOPED_TIMER("Sim::Script");
+		unitScriptEngine->Tick(tickMs);
+	};
+	stageFuncs[SIM_STAGE_ENVRESOURCES ] = []() { envResHandler.Update(); };
+	stageFuncs[SIM_STAGE_LOS          ] = []() { losHandler->Update(); };
+	// dead ghosts have to be updated in sim, after los,
+	// to make sure they represent the current knowledge correctly.
+	// should probably be split from drawer
+	stageFuncs[SIM_STAGE_GHOSTS       ] = []() { CUnitDrawer::UpdateGhostedBuildings(); };
+	stageFuncs[SIM_STAGE_INTERCEPT    ] = []() { interceptHandler.Update(false); };
+	stageFuncs[SIM_STAGE_TEAMHANDLER  ] = []() { teamHandler.GameFrame(gs->frameNum); };
+	stageFuncs[SIM_STAGE_PLAYERHANDLER] = []() { playerHandler.GameFrame(gs->frameNum); };
+	stageFuncs[SIM_STAGE_GAMEFRAMEPOST] = []() { eventHandler.GameFramePost(gs->frameNum); };
+
+	// masks and order are declared in SimFrameStages.h
+	simFrameStages.Clear();
+
+	for (const SimStageDef& def: SIM_STAGE_DEFS) {
+		simFrameStages.AddStage(def.name, def.reads, def.writes, std::move(stageFuncs[def.stage]), def.flags);
+	}
+}
+
 void CGame::SimFrame() {
 	ENTER_SYNCED_CODE();
 	ASSERT_SYNCED(gsRNG.GetGenState());
@@ -1800,37 +1857,7 @@ void CGame::SimFrame() {
 			eventHandler.GameFrame(gs->frameNum);
 		}
 
-		helper->Update();
-		readMap->Update();
-		smoothGround.UpdateSmoothMesh();
-		mapDamage->Update();
-		unitHandler.Update();
-		pathManager->Update();
-		projectileHandler.Update();
-		featureHandler.Update();
-		{
-			/* The default GAME_SPEED is 30, which doesn't divide 1000 well,
-			 * so scripts will perceive 990ms per second. But this is fine,
-			 * since doing "29th February" style of extra counting would be
-			 * disruptive to sleeps that assume a constant tick length while
-			 * not being otherwise perceptible since most animations don't
-			 * run that long. */
-			static constexpr int tickMs = 1000 / GAME_SPEED;
-
-			SCOPED_TIMER("Sim::Script");
-			unitScriptEngine->Tick(tickMs);
-		}
-		envResHandler.Update();
-		losHandler->Update();
-		// dead ghosts have to be updated in sim, after los,
-		// to make sure they represent the current knowledge correctly.
-		// should probably be split from drawer
-		CUnitDrawer::UpdateGhostedBuildings();
-		interceptHandler.Update(false);
-
-		teamHandler.GameFrame(gs->frameNum);
-		playerHandler.GameFrame(gs->frameNum);
-		eventHandler.GameFramePost(gs->frameNum);
+		simFrameStages.Run(simFrameStagesMT);
 	}
 
 	lastSimFrameTime = spring_gettime();
@@ -1859,6 +1886,31 @@ void CGame::SimFrame() {
 
 	ASSERT_SYNCED(gsRNG.GetGenState());
 	LEAVE_SYNCED_CODE();
+
+	SaveDemoKeyframe();
+}
+
+void CGame::SaveDemoKeyframe()
+{
+	if (demoKeyframeInterval <= 0 || gs->frameNum <= 0 || (gs->frameNum % demoKeyframeInterval) != 0)
+		return;
+	// only a watched demo's savegames can continue it, see CGameServer::PostLoad
+	if (!gameSetup->hostDemo || skipping || gameOver)
+		return;
+	// a save requested by the player goes first
+	if (!globalSaveFileData.name.empty())
+		return;
+
+	// keyframes go next to the demo, so later viewings can reuse them
+	const std::string& saveFile = FileSystem::EnsurePathSepAtEnd("Saves") + FileSystem::GetBasename(gameSetup->demoName) + "_" + IntToString(gs->frameNum) + ".ssf";
+	const std::string& indexFile = dataDirsAccess.LocateFile(CDemoKeyframeIndex::GetIndexFileName(gameSetup->demoName), FileQueryFlags::WRITE);
+
+	// written by an earlier viewing
+	if (FileSystem::FileExists(saveFile))
+		return;
+
+	// saved at the top of the main loop like any other savegame, ClientReadNet stops after this frame
+	globalSaveFileData = {saveFile, "", indexFile, gs->frameNum};
 }
 
 
@@ -2164,8 +2216,7 @@ bool CGame::IsSimLagging(float maxLatency) const
 void CGame::Save(std::string&& fileName, std::string&& saveArgs)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	globalSaveFileData.name = std::move(fileName);
-	globalSaveFileData.args = std::move(saveArgs);
+	globalSaveFileData = {std::move(fileName), std::move(saveArgs)};
 }
 
 
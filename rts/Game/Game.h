@@ -15,6 +15,7 @@
 #include "System/UnorderedMap.hpp"
 #include "System/creg/creg_cond.h"
 #include "System/Misc/SpringTime.h"
+#include "System/Threading/StageGraph.h"
 
 class LuaParser;
 class ILoadSaveHandler;
@@ -100,6 +101,8 @@ public:
 	void ParseInputTextGeometry(const std::string& geo);
 
 	void Save(std::string&& fileName, std::string&& saveArgs);
+	/// queues a keyframe savegame for the watched demo every DemoKeyframeInterval seconds
+	void SaveDemoKeyframe();
 
 	void ResizeEvent() override;
 
@@ -141,6 +144,7 @@ private:
 	void ClientReadNet();
 	void UpdateNumQueuedSimFrames();
 	void UpdateNetMessageProcessingTimeLeft();
+	void InitSimFrameStages();
 	void SimFrame();
 	void StartPlaying();
 
@@ -213,6 +217,12 @@ public:
 	// 0 := 1/f rate, 1 := 30/s rate
 	int luaGCControl = 0;
 
+	/// whether non-conflicting SimFrame stages may run concurrently
+	bool simFrameStagesMT = false;
+
+	/// frames between demo keyframes, 0 if disabled
+	int demoKeyframeInterval = 0;
+
 private:
 	JobDispatcher jobDispatcher;
 
@@ -221,6 +231,9 @@ private:
 
 	CWorldDrawer worldDrawer;
 
+	/// ordered synced per-frame update stages, see InitSimFrameStages
+	CStageGraph simFrameStages;
+
 	/// <playerID, <packetCode, total bytes> >
 	spring::unordered_map<int, PlayerTrafficInfo> playerTraffic;
 
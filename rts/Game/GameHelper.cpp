@@ -37,6 +37,7 @@
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Weapons/WeaponDefHandler.h"
 #include "Sim/Weapons/Weapon.h"
+#include "Sim/Weapons/WeaponTargetIndex.h"
 #include "System/EventHandler.h"
 #include "System/SpringMath.h"
 #include "System/Sound/ISoundChannels.h"
@@ -54,10 +55,15 @@ void CGameHelper::Init()
 		wdVec.clear();
 		wdVec.reserve(32);
 	}
+
+	ClearExplosionQueries();
+	weaponTargetIndex.Init();
 }
 
 void CGameHelper::Kill()
 {
+	ClearExplosionQueries();
+	weaponTargetIndex.Kill();
 }
 
 void CGameHelper::Update()
@@ -213,6 +219,52 @@ void CGameHelper::DoExplosionDamage(
 
 
 
+void CGameHelper::ClearExplosionQueries()
+{
+	for (ExplosionQuery& eq: explosionQueries) {
+		eq.quads.clear();
+		eq.units.clear();
+		eq.features.clear();
+		eq.repulsers.clear();
+		eq.stamp = 0;
+	}
+
+	nextExplosionQuery = 0;
+}
+
+const CGameHelper::ExplosionQuery& CGameHelper::GetExplosionQuery(const float3& pos, float radius)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	QuadFieldQuery qfQuery;
+	quadField.GetQuads(qfQuery, pos, radius);
+
+	const std::vector<int>& quads = *qfQuery.quads;
+
+	// the candidates of a query only depend on the set of quads it touched
+	// and their contents, so they can be shared between explosions as long
+	// as both are the same (the ColVol filter always runs on fresh state)
+	for (const ExplosionQuery& eq: explosionQueries) {
+		if (eq.quads != quads)
+			continue;
+		if (quadField.QuadsModifiedSince(eq.quads.data(), eq.quads.size(), eq.stamp))
+			continue;
+
+		return eq;
+	}
+
+	ExplosionQuery& eq = explosionQueries[(nextExplosionQuery++) % explosionQueries.size()];
+
+	eq.quads.clear();
+	eq.units.clear();
+	eq.features.clear();
+	eq.repulsers.clear();
+	eq.stamp = quadField.GetQuadStamp();
+
+	quadField.GatherUnitsAndFeaturesColVol(ThreadPool::GetThreadNum(), pos, radius, eq.quads, eq.units, eq.features, eq.repulsers);
+	assert(eq.quads == quads);
+	return eq;
+}
+
 void CGameHelper::DamageObjectsInExplosionRadius(
 	const CExplosionParams& params,
 	const float expRad,
@@ -221,11 +273,28 @@ void CGameHelper::DamageObjectsInExplosionRadius(
 	RECOIL_DETAILED_TRACY_ZONE;
 	static std::vector<CUnit*> unitCache;
 	static std::vector<CFeature*> featureCache;
+	static std::vector<CPlasmaRepulser*> repulserCache;
 
 	const unsigned int oldNumUnits = unitCache.size();
 	const unsigned int oldNumFeatures = featureCache.size();
 
-	quadField.GetUnitsAndFeaturesColVol(params.pos, expRad, unitCache, featureCache);
+	{
+		// same objects in the same order as GetUnitsAndFeaturesColVol; the
+		// query must not be held on to once damage is applied since nested
+		// explosions can replace it
+		const ExplosionQuery& eq = GetExplosionQuery(params.pos, expRad);
+
+		CQuadField::FilterUnitsAndFeaturesColVol(
+			params.pos,
+			expRad,
+			eq.units.data(), eq.units.size(),
+			eq.features.data(), eq.features.size(),
+			nullptr, 0,
+			unitCache,
+			featureCache,
+			repulserCache
+		);
+	}
 
 	const unsigned int newNumUnits = unitCache.size();
 	const unsigned int newNumFeatures = featureCache.size();
@@ -655,6 +724,16 @@ namespace {
 
 
 
+float CGameHelper::GetWeaponTargetScanRadius(const CWeapon* weapon)
+{
+	const float aimPosHeight = weapon->aimFromPos.y;
+	const float minMapHeight = std::max(0.0f, readMap->GetCurrMinHeight());
+
+	// find theoretical maximum range based on height above lowest point on map
+	// return (weapon->GetRange2D(weapon->autoTargetRangeBoost, (minMapHeight - aimPosHeight) * weapon->weaponDef->heightmod));
+	return (weapon->range + weapon->autoTargetRangeBoost + (aimPosHeight - minMapHeight) * weapon->weaponDef->heightmod);
+}
+
 size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets)
 {
 	const CUnit*  weaponOwner = weapon->owner;
@@ -667,7 +746,6 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 	const float3 testPos;
 
 	const float aimPosHeight = weapon->aimFromPos.y;
-	const float minMapHeight = std::max(0.0f, readMap->GetCurrMinHeight());
 
 	// how much damage the weapon deals over 1 second
 	const float secDamage = weaponDmg->GetDefault() * weapon->salvoSize / weapon->reloadTime * GAME_SPEED;
@@ -678,9 +756,7 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 
 	const float  baseRange = weapon->range;
 	const float rangeBoost = weapon->autoTargetRangeBoost;
-	// find theoretical maximum range based on height above lowest point on map
-	// const float scanRadius = weapon->GetRange2D(rangeBoost, (minMapHeight - aimPosHeight) * heightMod);
-	const float scanRadius = baseRange + rangeBoost + (aimPosHeight - minMapHeight) * heightMod;
+	const float scanRadius = GetWeaponTargetScanRadius(weapon);
 
 	// [0] := default, [1,2,3,4,5,6] := target is {avoidee, in bad category, crashing, last attacker, paralyzed, outside unboosted range}
 	constexpr float tgtPriorityMults[] = {1.0f, 10.0f, 100.0f, 1000.0f, 0.5f, 4.0f, 100000.0f};
@@ -701,9 +777,8 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 			continue;
 
 		for (const int qi: *qfQuery.quads) {
-			const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
-
-			for (CUnit* targetUnit: allyTeamUnits) {
+			// only the LOS and radar contacts, shared by all weapons of our allyteam this frame
+			for (CUnit* targetUnit: weaponTargetIndex.GetTargets(weaponOwner->allyteam, qi, t)) {
 				if (targetUnit->tempNum == tempNum)
 					continue;
 
@@ -13,6 +13,7 @@
 
 #include <array>
 #include <bit>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -20,6 +21,7 @@ class CUnit;
 class CWeapon;
 class CSolidObject;
 class CFeature;
+class CPlasmaRepulser;
 class CMobileCAI;
 struct UnitDef;
 struct MoveDef;
@@ -148,6 +150,7 @@ public:
 		bool synced = false
 	);
 
+	static float GetWeaponTargetScanRadius(const CWeapon* weapon);
 	static size_t GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets);
 
 	void Init();
@@ -205,6 +208,25 @@ private:
 	std::array<std::vector<WaitingDamage>, 128> waitingDamages;
 	static_assert (std::has_single_bit(std::tuple_size_v <decltype(waitingDamages)>), "Size is used in bit hax and must be 2^N");
 
+	// unfiltered QuadField candidates of recent explosions; salvos and
+	// cluster munitions tend to detonate many times in the same quads per
+	// frame, these then only need to run the ColVol filter on the cached
+	// candidates (valid as long as none of their quads has been modified)
+	struct ExplosionQuery {
+		std::vector<int> quads;
+		std::vector<CUnit*> units;
+		std::vector<CFeature*> features;
+		std::vector<CPlasmaRepulser*> repulsers;
+
+		uint64_t stamp = 0;
+	};
+
+	void ClearExplosionQueries();
+	const ExplosionQuery& GetExplosionQuery(const float3& pos, float radius);
+
+	std::array<ExplosionQuery, 8> explosionQueries;
+	size_t nextExplosionQuery = 0;
+
 public:
 	std::vector<int> targetUnitIDs; // GetEnemyUnits{NoLosTest}
 	std::vector<std::pair<float, CUnit*>> targetPairs; // GenerateWeaponTargets
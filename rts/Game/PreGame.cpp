@@ -38,6 +38,7 @@
 #include "System/TdfParser.h"
 #include "System/Input/KeyInput.h"
 #include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/VFSHandler.h"
 #include "System/LoadSave/DemoRecorder.h"
@@ -115,6 +116,18 @@ void CPreGame::LoadDemoFile(const std::string& demo)
 	assert(clientSetup->isHost);
 	wantDemo &= configHandler->GetBool("DemoFromDemo");
 
+	if (clientSetup->demoStartFrame > 0) {
+		const CDemoReader scanner(demo, 0.0f);
+		const CDemoKeyframeIndex::Keyframe* keyframe = scanner.GetKeyframeIndex().FindKeyframe(clientSetup->demoStartFrame);
+
+		// the server continues the demo after the keyframe and skips the remaining frames
+		if (keyframe != nullptr && FileSystem::FileExists(dataDirsAccess.LocateFile(keyframe->saveFile))) {
+			LOG("[PreGame::%s] starting demo \"%s\" from keyframe \"%s\" (frame %d)", __func__, demo.c_str(), keyframe->saveFile.c_str(), keyframe->frameNum);
+			LoadSaveFile(keyframe->saveFile);
+			return;
+		}
+	}
+
 	ReadDataFromDemo(demo);
 }
 
@@ -0,0 +1,96 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SIM_FRAME_STAGES_H
+#define SIM_FRAME_STAGES_H
+
+#include "System/Threading/StageGraph.h"
+
+// resources touched by the SimFrame stages, see CGame::InitSimFrameStages
+enum SimStageResource: CStageGraph::ResourceMask {
+	SIM_RES_HEIGHTMAP   = 1 << 0,
+	SIM_RES_SMOOTHMESH  = 1 << 1,
+	SIM_RES_BLOCKING    = 1 << 2, // groundBlockingObjectMap
+	SIM_RES_REGISTRY    = 1 << 3, // Sim::registry
+	SIM_RES_UNITS       = 1 << 4,
+	SIM_RES_PATHING     = 1 << 5,
+	SIM_RES_LOS         = 1 << 6,
+	SIM_RES_GHOSTS      = 1 << 7,
+};
+
+constexpr CStageGraph::ResourceMask SIM_RES_ALL = CStageGraph::RESOURCE_ALL;
+constexpr unsigned int SIM_STAGE_FLAG_MAIN = CStageGraph::STAGE_FLAG_MAIN_THREAD;
+
+// in execution order
+enum SimStage {
+	SIM_STAGE_GAMEHELPER,
+	SIM_STAGE_READMAP,
+	SIM_STAGE_SMOOTHGROUND,
+	SIM_STAGE_MAPDAMAGE,
+	SIM_STAGE_UNITS,
+	SIM_STAGE_PATHING,
+	SIM_STAGE_PROJECTILES,
+	SIM_STAGE_FEATURES,
+	SIM_STAGE_SCRIPTS,
+	SIM_STAGE_ENVRESOURCES,
+	SIM_STAGE_LOS,
+	SIM_STAGE_GHOSTS,
+	SIM_STAGE_INTERCEPT,
+	SIM_STAGE_TEAMHANDLER,
+	SIM_STAGE_PLAYERHANDLER,
+	SIM_STAGE_GAMEFRAMEPOST,
+	SIM_STAGE_COUNT,
+};
+
+struct SimStageDef {
+	SimStage stage;
+
+	const char* name;
+
+	CStageGraph::ResourceMask reads;
+	CStageGraph::ResourceMask writes;
+
+	unsigned int flags;
+};
+
+// NOTE:
+//   the masks must be complete for every stage that does not claim
+//   SIM_RES_ALL, otherwise running stages concurrently desyncs; any
+//   stage that can reach Lua, unit scripts or CEG's has to claim all
+//   resources (synced Lua can read and modify any sim state, LOS too)
+//   and be flagged SIM_STAGE_FLAG_MAIN (those are not thread-safe)
+constexpr SimStageDef SIM_STAGE_DEFS[SIM_STAGE_COUNT] = {
+	{SIM_STAGE_GAMEHELPER   , "GameHelper"   , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_READMAP      , "ReadMap"      , SIM_RES_HEIGHTMAP, SIM_RES_HEIGHTMAP, 0},
+	{SIM_STAGE_SMOOTHGROUND , "SmoothGround" , SIM_RES_HEIGHTMAP, SIM_RES_SMOOTHMESH, 0},
+	{SIM_STAGE_MAPDAMAGE    , "MapDamage"    , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_UNITS        , "Units"        , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_PATHING      , "Pathing"      ,
+		SIM_RES_HEIGHTMAP | SIM_RES_BLOCKING | SIM_RES_UNITS | SIM_RES_REGISTRY | SIM_RES_PATHING,
+		SIM_RES_REGISTRY | SIM_RES_PATHING,
+		0
+	},
+	{SIM_STAGE_PROJECTILES  , "Projectiles"  , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	// features spawn CEG's and send FeatureDestroyed
+	{SIM_STAGE_FEATURES     , "Features"     , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_SCRIPTS      , "Scripts"      , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	// generators receive WindChanged script call-ins
+	{SIM_STAGE_ENVRESOURCES , "EnvResources" , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_LOS          , "Los"          , SIM_RES_UNITS | SIM_RES_HEIGHTMAP | SIM_RES_LOS, SIM_RES_LOS, 0},
+	{SIM_STAGE_GHOSTS       , "Ghosts"       , SIM_RES_LOS | SIM_RES_GHOSTS, SIM_RES_GHOSTS, SIM_STAGE_FLAG_MAIN},
+	// interceptors ask Lua through AllowWeaponInterceptTarget
+	{SIM_STAGE_INTERCEPT    , "Intercept"    , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_TEAMHANDLER  , "TeamHandler"  , SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_PLAYERHANDLER, "PlayerHandler", SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+	{SIM_STAGE_GAMEFRAMEPOST, "GameFramePost", SIM_RES_ALL, SIM_RES_ALL, SIM_STAGE_FLAG_MAIN},
+};
+
+static_assert([]() {
+	for (int i = 0; i < SIM_STAGE_COUNT; i++) {
+		if (SIM_STAGE_DEFS[i].stage != i)
+			return false;
+	}
+
+	return true;
+}(), "SIM_STAGE_DEFS must be in SimStage order");
+
+#endif
@@ -253,6 +253,47 @@ void CBasicMapDamage::RecalcArea(int x1, int x2, int y1, int y2)
 }
 
 
+void CBasicMapDamage::RecalcDamagedAreas()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	if (damagedAreas.empty())
+		return;
+
+	// craters finishing in the same frame tend to overlap heavily; turn them
+	// into a set of disjoint rectangles covering the same squares so that all
+	// downstream consumers see each square only once. Process is deterministic
+	// w.r.t. the (synced) insertion order, and so is the iteration below
+	damagedAreas.Process(true);
+
+	// same sequence as RecalcArea, but consumer-major: every later stage then
+	// sees the heightmap (and features) already updated for the whole union
+	if (readMap->GetHeightMapUpdated()) {
+		for (const SRectangle& r: damagedAreas) {
+			readMap->UpdateHeightMapSynced(r);
+		}
+		for (const SRectangle& r: damagedAreas) {
+			featureHandler.TerrainChanged(r.x1, r.y1, r.x2, r.y2);
+			smoothGround.MapChanged(r.x1, r.y1, r.x2, r.y2);
+		}
+		{
+			SCOPED_TIMER("Sim::BasicMapDamage::Los");
+
+			for (const SRectangle& r: damagedAreas) {
+				losHandler->UpdateHeightMapSynced(r);
+			}
+		}
+		{
+			SCOPED_TIMER("Sim::BasicMapDamage::Path");
+
+			for (const SRectangle& r: damagedAreas) {
+				pathManager->TerrainChange(r.x1, r.y1, r.x2, r.y2, TERRAINCHANGE_DAMAGE_RECALCULATION);
+			}
+		}
+	}
+
+	damagedAreas.clear();
+}
+
 void CBasicMapDamage::Update()
 {
 	SCOPED_TIMER("Sim::BasicMapDamage");
@@ -292,9 +333,14 @@ void CBasicMapDamage::Update()
 		if (e.ttl != 0)
 			continue;
 
-		RecalcArea(e.x1 - 1, e.x2 + 1, e.y1 - 1, e.y2 + 1);
+		SRectangle area(e.x1 - 1, e.y1 - 1, e.x2 + 1, e.y2 + 1);
+		area.ClampIn({0, 0, mapDims.mapx, mapDims.mapy});
+
+		damagedAreas.push_back(area);
 	}
 
+	RecalcDamagedAreas();
+
 
 	// pop explosions that are no longer being processed
 	while (explUpdateQueueIdx < explosionUpdateQueue.size()) {
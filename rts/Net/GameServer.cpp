@@ -4,6 +4,7 @@
 #include "System/Net/UDPConnection.h"
 
 #include <functional>
+#include <utility>
 
 #if defined DEDICATED || defined DEBUG
 	#include <iostream>
@@ -185,6 +186,7 @@ void CGameServer::Initialize()
 	if (myGameSetup->hostDemo) {
 		Message(spring::format(PlayingDemo, myGameSetup->demoName.c_str()));
 		demoReader.reset(new CDemoReader(myGameSetup->demoName, modGameTime + 0.1f));
+		demoStartFrame = myClientSetup->demoStartFrame;
 	}
 
 	// initialize players, teams & ais
@@ -287,6 +289,11 @@ void CGameServer::PostLoad(int newServerFrameNum)
 
 	gameHasStarted = !PreSimFrame();
 
+	// loaded a keyframe savegame of the demo being watched, clients
+	// already have the state of every frame up to the one it was saved at
+	if (demoReader != nullptr && gameHasStarted)
+		SeekDemoData(newServerFrameNum);
+
 	// for all GameParticipant's
 	for (GameParticipant& p: players) {
 		p.lastFrameResponse = newServerFrameNum;
@@ -487,20 +494,10 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 				break;
 			}
 
-			case NETMSG_CREATE_NEWPLAYER: {
-				try {
-					netcode::UnpackPacket pckt(rpkt, 3);
-					unsigned char spectator, team, playerNum;
-					std::string name;
-					pckt >> playerNum;
-					pckt >> spectator;
-					pckt >> team;
-					pckt >> name;
-					AddAdditionalUser(name, "", true, (bool)spectator, (int)team, playerNum); // even though this is a demo, keep the players vector properly updated
-				} catch (const netcode::UnpackPacketException& ex) {
-					Message(spring::format("Warning: Discarding invalid new player packet in demo: %s", ex.what()));
+			case NETMSG_CREATE_NEWPLAYER:
+			case NETMSG_CCOMMAND: {
+				if (!ReadDemoPacket(rpkt))
 					continue;
-				}
 
 				Broadcast(rpkt);
 				break;
@@ -513,19 +510,6 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 				// never send these from demos
 				break;
 			}
-			case NETMSG_CCOMMAND: {
-				try {
-					CommandMessage msg(rpkt);
-					const Action& action = msg.GetAction();
-					if (msg.GetPlayerID() == SERVER_PLAYER && action.command == "cheat")
-						InverseOrSetBool(cheating, action.extra);
-				} catch (const netcode::UnpackPacketException& ex) {
-					Message(spring::format("Warning: Discarding invalid command message packet in demo: %s", ex.what()));
-					continue;
-				}
-				Broadcast(rpkt);
-				break;
-			}
 			default: {
 				Broadcast(rpkt);
 				break;
@@ -547,6 +531,72 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 	return ret;
 }
 
+void CGameServer::SeekDemoData(int targetFrameNum)
+{
+	DemoMsgTypeMask msgTypes;
+	msgTypes.Clear();
+	msgTypes.Add(NETMSG_NEWFRAME);
+	msgTypes.Add(NETMSG_KEYFRAME);
+	msgTypes.Add(NETMSG_CREATE_NEWPLAYER);
+	msgTypes.Add(NETMSG_CCOMMAND);
+
+	// only the server's own bookkeeping has to catch up, blocks without
+	// any players joining or cheats toggled are not even decompressed
+	while (demoReader->GetFrameNum() < targetFrameNum) {
+		netcode::RawPacket* buf = demoReader->GetNextPacket(msgTypes);
+
+		if (buf == nullptr)
+			break;
+
+		ReadDemoPacket(std::shared_ptr<const RawPacket>(buf));
+	}
+
+	if (demoReader->GetFrameNum() != targetFrameNum)
+		Message(spring::format("Warning: demo does not continue at frame %d", targetFrameNum));
+
+	// same as SkipTo, demo data after the frame is sent by the next Update
+	gameTime = GetDemoTime();
+	modGameTime = demoReader->GetModGameTime() + 0.001f;
+}
+
+bool CGameServer::ReadDemoPacket(std::shared_ptr<const RawPacket> packet)
+{
+	switch (packet->data[0]) {
+		case NETMSG_CREATE_NEWPLAYER: {
+			try {
+				netcode::UnpackPacket pckt(packet, 3);
+				unsigned char spectator, team, playerNum;
+				std::string name;
+				pckt >> playerNum;
+				pckt >> spectator;
+				pckt >> team;
+				pckt >> name;
+				AddAdditionalUser(name, "", true, (bool)spectator, (int)team, playerNum); // even though this is a demo, keep the players vector properly updated
+			} catch (const netcode::UnpackPacketException& ex) {
+				Message(spring::format("Warning: Discarding invalid new player packet in demo: %s", ex.what()));
+				return false;
+			}
+		} break;
+
+		case NETMSG_CCOMMAND: {
+			try {
+				CommandMessage msg(packet);
+				const Action& action = msg.GetAction();
+				if (msg.GetPlayerID() == SERVER_PLAYER && action.command == "cheat")
+					InverseOrSetBool(cheating, action.extra);
+			} catch (const netcode::UnpackPacketException& ex) {
+				Message(spring::format("Warning: Discarding invalid command message packet in demo: %s", ex.what()));
+				return false;
+			}
+		} break;
+
+		default: {
+		} break;
+	}
+
+	return true;
+}
+
 void CGameServer::Broadcast(std::shared_ptr<const netcode::RawPacket> packet)
 {
 	for (GameParticipant& p: players) {
@@ -839,6 +889,11 @@ void CGameServer::Update()
 		}
 	}
 
+	// the demo was started at a later frame; if a keyframe savegame
+	// of it was loaded, only the frames after that are left to skip
+	if (gameHasStarted && demoStartFrame > 0)
+		SkipTo(std::exchange(demoStartFrame, 0));
+
 	if (!gameHasStarted)
 		CheckForGameStart();
 	else if (!PreSimFrame() || demoReader != nullptr)
@@ -172,6 +172,10 @@ private:
 	void WriteDemoData();
 	/// read data from demo and send it to clients
 	bool SendDemoData(int targetFrameNum);
+	/// continue the demo after targetFrameNum without sending the frames in between
+	void SeekDemoData(int targetFrameNum);
+	/// apply new players and cheat toggles from the demo, false if the packet is invalid
+	bool ReadDemoPacket(std::shared_ptr<const netcode::RawPacket> packet);
 
 	void Broadcast(std::shared_ptr<const netcode::RawPacket> packet);
 
@@ -252,6 +256,8 @@ private:
 
 
 	int serverFrameNum = -1;
+	/// frame to skip to once the demo is running, see ClientSetup::demoStartFrame
+	int demoStartFrame = 0;
 
 	int syncErrorFrame = 0;
 	int syncWarningFrame = 0;
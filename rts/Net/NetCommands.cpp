@@ -34,6 +34,7 @@
 #include "System/SpringMath.h"
 #include "System/TimeProfiler.h"
 #include "System/LoadSave/DemoRecorder.h"
+#include "System/LoadSave/LoadSaveHandler.h"
 #include "System/Net/UnpackPacket.h"
 #include "System/Sound/ISound.h"
 #include "System/Sync/DumpState.h"
@@ -274,6 +275,9 @@ void CGame::ClientReadNet()
 			break;
 		if (spring_gettime() > msgProcEndTime)
 			break;
+		// a queued save (e.g. a demo keyframe) captures the state right after the last frame
+		if (!globalSaveFileData.name.empty())
+			break;
 
 		lastNetPacketProcessTime = spring_gettime();
 
@@ -615,7 +615,6 @@ bool CFeature::Update()
 
 	continueUpdating |= (smokeTime != 0);
 	continueUpdating |= (fireTime != 0);
-	continueUpdating |= (def->geoThermal);
 
 	if (smokeTime != 0) {
 		if (!((gs->frameNum + id) & 3) && projectileHandler.GetParticleSaturation() < 0.7f) {
@@ -631,9 +630,6 @@ bool CFeature::Update()
 	if (fireTime == 1)
 		featureHandler.DeleteFeature(this);
 
-	if (def->geoThermal)
-		EmitGeoSmoke();
-
 	smokeTime = std::max(smokeTime - 1, 0);
 	fireTime = std::max(fireTime - 1, 0);
 
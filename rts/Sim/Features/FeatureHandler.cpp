@@ -24,7 +24,8 @@ CR_REG_METADATA(CFeatureHandler, (
 	CR_MEMBER(deletedFeatureIDs),
 	CR_MEMBER(activeFeatureIDs),
 	CR_MEMBER(features),
-	CR_MEMBER(updateFeatures)
+	CR_MEMBER(updateFeatures),
+	CR_MEMBER(geoThermalFeatures)
 ))
 
 /******************************************************************************/
@@ -58,6 +59,7 @@ void CFeatureHandler::Kill() {
 	deletedFeatureIDs.clear();
 	features.clear();
 	updateFeatures.clear();
+	geoThermalFeatures.clear();
 }
 
 
@@ -141,6 +143,12 @@ bool CFeatureHandler::AddFeature(CFeature* feature)
 
 	InsertActiveFeature(feature);
 	SetFeatureUpdateable(feature);
+
+	// vents emit smoke for as long as they exist, but do not need
+	// to stay in the update-queue (and be moved) for that reason
+	if (feature->def->geoThermal)
+		geoThermalFeatures.push_back(feature);
+
 	return true;
 }
 
@@ -203,6 +211,10 @@ void CFeatureHandler::Update()
 
 		updateFeatures.erase(iter, updateFeatures.end());
 	}
+
+	for (CFeature* feature: geoThermalFeatures) {
+		feature->EmitGeoSmoke();
+	}
 }
 
 
@@ -239,6 +251,9 @@ bool CFeatureHandler::UpdateFeature(CFeature* feature)
 
 		features[feature->id] = nullptr;
 
+		if (feature->def->geoThermal)
+			spring::VectorErase(geoThermalFeatures, feature);
+
 		// ID must match parameter for object commands, just use this
 		CSolidObject::SetDeletingRefID(feature->GetBlockingMapID());
 		// destructor removes feature from update-queue
@@ -276,11 +291,26 @@ void CFeatureHandler::TerrainChanged(int x1, int y1, int x2, int y2)
 	const float3 mins(x1 * SQUARE_SIZE, 0, y1 * SQUARE_SIZE);
 	const float3 maxs(x2 * SQUARE_SIZE, 0, y2 * SQUARE_SIZE);
 
+	// a resting feature only samples the ground height and normal at its
+	// own position, and the normals of squares bordering the changed area
+	// change as well; features further away can stay asleep even if they
+	// share a quad with the changed area
+	const float3 wakeMins = mins - float3(2 * SQUARE_SIZE, 0, 2 * SQUARE_SIZE);
+	const float3 wakeMaxs = maxs + float3(2 * SQUARE_SIZE, 0, 2 * SQUARE_SIZE);
+
 	QuadFieldQuery qfQuery;
-	quadField.GetQuadsRectangle(qfQuery, mins, maxs);
+	quadField.GetQuadsRectangle(qfQuery, wakeMins, wakeMaxs);
 
 	for (const int qi: *qfQuery.quads) {
 		for (CFeature* f: quadField.GetQuad(qi).features) {
+			if (f->inUpdateQue)
+				continue;
+
+			if (f->pos.x < wakeMins.x || f->pos.x > wakeMaxs.x)
+				continue;
+			if (f->pos.z < wakeMins.z || f->pos.z > wakeMaxs.z)
+				continue;
+
 			// put this feature back in the update-queue
 			SetFeatureUpdateable(f);
 		}
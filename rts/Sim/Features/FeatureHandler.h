@@ -88,6 +88,7 @@ private:
 	std::vector<int> deletedFeatureIDs;
 	std::vector<CFeature*> features;
 	std::vector<CFeature*> updateFeatures;
+	std::vector<CFeature*> geoThermalFeatures;
 };
 
 extern CFeatureHandler featureHandler;
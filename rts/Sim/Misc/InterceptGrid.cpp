@@ -0,0 +1,272 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <limits>
+#include <algorithm>
+
+#include "InterceptGrid.h"
+
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/Rectangle.h"
+#include "System/SpringMath.h"
+
+#include "System/Misc/TracyDefs.h"
+
+
+bool CInterceptGrid::IsTargetCovered(const Interceptor& w, const Target& p, float impactDist)
+{
+	// there are four cases when an interceptor <w> should fire at a projectile <p>:
+	//     1. p's target position inside w's interception circle (w's owner can move!)
+	//     2. p's current position inside w's interception circle
+	//     3. p's projected impact position inside w's interception circle
+	//     4. p's trajectory intersects w's interception circle
+	const float3& pImpactPos = p.pos + p.dir * impactDist;
+	const float3& pTargetPos = p.targetPos;
+	const float3  pWeaponVec = p.pos - w.aimFromPos;
+
+	if (w.aimFromPos.SqDistance2D(pTargetPos) < Square(w.coverageRange))
+		return true; // 1
+
+	if (false /*wDef->noFlyThroughIntercept*/) {
+		// <w> is just a static interceptor and fires only at projectiles
+		// TARGETED within its current interception area; any projectiles
+		// CROSSING its interception area aren't targeted
+		//XXX implement in lua?
+		return false;
+	}
+
+	if (pWeaponVec.SqLength2D() < Square(w.coverageRange))
+		return true; // 2
+
+	if (w.aimFromPos.SqDistance2D(pImpactPos) < Square(w.coverageRange)) {
+		const float3 pTargetDir = (pTargetPos - p.pos).SafeNormalize();
+		const float3 pImpactDir = (pImpactPos - p.pos).SafeNormalize();
+
+		// the projected impact position can briefly shift into the covered
+		// area during transition from vertical to horizontal flight, so we
+		// perform an extra test (NOTE: assumes non-parabolic trajectory)
+		if (pTargetDir.dot(pImpactDir) >= 0.999f)
+			return true; // 3
+	}
+
+	const float3 pMinSepPos = p.pos + p.dir * std::clamp(-(pWeaponVec.dot(p.dir)), 0.0f, impactDist);
+	const float3 pMinSepVec = w.aimFromPos - pMinSepPos;
+
+	return (pMinSepVec.SqLength() < Square(w.coverageRange)); // 4
+}
+
+
+bool CInterceptGrid::CanReachTarget(const Interceptor& w, const Target& p)
+{
+	// necessary condition for the four cases in IsTargetCovered: either
+	// p's target position or some point along its flight-path (from p.pos
+	// - p.dir onward; covers impactDist == -1) lies within the coverage
+	// circle in 2D (plus some slack against rounding, since the exact
+	// tests compute their distances differently)
+	const float coverageSq = Square(w.coverageRange + 1.0f);
+
+	if (w.aimFromPos.SqDistance2D(p.targetPos) < coverageSq)
+		return true;
+
+	const float3 rayPos = p.pos - p.dir;
+	const float3 rayDir = p.dir * XZVector;
+	const float3 aimVec = (w.aimFromPos - rayPos) * XZVector;
+
+	const float dirSq = rayDir.SqLength();
+	const float t = (dirSq > 0.0f)? std::max(0.0f, aimVec.dot(rayDir) / dirSq): 0.0f;
+
+	return ((aimVec - rayDir * t).SqLength() < coverageSq);
+}
+
+
+void CInterceptGrid::Build()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// grid should be coarse enough to keep large (nuke) coverage areas
+	// at a few hundred cells, fine enough to separate point-defense
+	constexpr float MIN_CELL_SIZE = 256.0f;
+	constexpr int MAX_CELLS_PER_AXIS = 64;
+	// slack for rounding in the grid walk of AddCandidates
+	constexpr float CELL_MARGIN = SQUARE_SIZE;
+
+	float2 mins = { std::numeric_limits<float>::max(),  std::numeric_limits<float>::max()};
+	float2 maxs = {-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max()};
+
+	for (const Interceptor& w: interceptors) {
+		const float r = w.coverageRange + CELL_MARGIN;
+
+		mins.x = std::min(mins.x, w.aimFromPos.x - r);
+		mins.y = std::min(mins.y, w.aimFromPos.z - r);
+		maxs.x = std::max(maxs.x, w.aimFromPos.x + r);
+		maxs.y = std::max(maxs.y, w.aimFromPos.z + r);
+	}
+
+	gridMins = mins;
+	gridCellSize = std::max(MIN_CELL_SIZE, std::max(maxs.x - mins.x, maxs.y - mins.y) / MAX_CELLS_PER_AXIS);
+	gridSize.x = std::clamp(int((maxs.x - mins.x) / gridCellSize) + 1, 1, MAX_CELLS_PER_AXIS + 1);
+	gridSize.y = std::clamp(int((maxs.y - mins.y) / gridCellSize) + 1, 1, MAX_CELLS_PER_AXIS + 1);
+
+	const auto GetCellRect = [&](const Interceptor& w) {
+		const float r = w.coverageRange + CELL_MARGIN;
+
+		return SRectangle(
+			std::clamp(int((w.aimFromPos.x - r - gridMins.x) / gridCellSize), 0, gridSize.x - 1),
+			std::clamp(int((w.aimFromPos.z - r - gridMins.y) / gridCellSize), 0, gridSize.y - 1),
+			std::clamp(int((w.aimFromPos.x + r - gridMins.x) / gridCellSize), 0, gridSize.x - 1),
+			std::clamp(int((w.aimFromPos.z + r - gridMins.y) / gridCellSize), 0, gridSize.y - 1)
+		);
+	};
+
+	cellOffsets.clear();
+	cellOffsets.resize(gridSize.x * gridSize.y + 1, 0);
+
+	// count, prefix-sum, fill
+	for (const Interceptor& w: interceptors) {
+		const SRectangle r = GetCellRect(w);
+
+		for (int z = r.z1; z <= r.z2; z++) {
+			for (int x = r.x1; x <= r.x2; x++) {
+				cellOffsets[z * gridSize.x + x + 1] += 1;
+			}
+		}
+	}
+
+	for (size_t i = 1; i < cellOffsets.size(); i++) {
+		cellOffsets[i] += cellOffsets[i - 1];
+	}
+
+	cellInterceptors.clear();
+	cellInterceptors.resize(cellOffsets.back());
+
+	std::vector<int> fillOffsets(cellOffsets.begin(), cellOffsets.end() - 1);
+
+	for (size_t wIdx = 0; wIdx < interceptors.size(); wIdx++) {
+		const SRectangle r = GetCellRect(interceptors[wIdx]);
+
+		for (int z = r.z1; z <= r.z2; z++) {
+			for (int x = r.x1; x <= r.x2; x++) {
+				cellInterceptors[fillOffsets[z * gridSize.x + x]++] = wIdx;
+			}
+		}
+	}
+
+	candidateStamps.clear();
+	candidateStamps.resize(interceptors.size(), -1);
+}
+
+
+void CInterceptGrid::AddCandidates(const Target& p, int pIdx, std::vector< std::pair<int, int> >& pairs)
+{
+	const auto AddCell = [&](int x, int z) {
+		const int cellIdx = z * gridSize.x + x;
+
+		for (int i = cellOffsets[cellIdx]; i < cellOffsets[cellIdx + 1]; i++) {
+			const int wIdx = cellInterceptors[i];
+
+			if (candidateStamps[wIdx] == pIdx)
+				continue;
+
+			candidateStamps[wIdx] = pIdx;
+
+			// the cell only bounds the coverage area, test the actual circle
+			if (!CanReachTarget(interceptors[wIdx], p))
+				continue;
+
+			pairs.emplace_back(wIdx, pIdx);
+		}
+	};
+
+	const float2 gridMaxs = gridMins + float2(gridSize.x, gridSize.y) * gridCellSize;
+
+	const auto InGrid = [&](const float2& v) {
+		return (v.x >= gridMins.x && v.y >= gridMins.y && v.x < gridMaxs.x && v.y < gridMaxs.y);
+	};
+	const auto GetCell = [&](float v, float m, int n) {
+		return std::clamp(int((v - m) / gridCellSize), 0, n - 1);
+	};
+
+	const float2 targetPos = {p.targetPos.x, p.targetPos.z};
+
+	// case 1 in IsTargetCovered; a target outside the grid is out of everyone's reach
+	if (InGrid(targetPos))
+		AddCell(GetCell(targetPos.x, gridMins.x, gridSize.x), GetCell(targetPos.y, gridMins.y, gridSize.y));
+
+	// cases 2-4; walk all cells crossed by the flight-path ray starting at
+	// p.pos - p.dir (see CanReachTarget), clipped to the grid rectangle
+	const float2 rayPos = {p.pos.x - p.dir.x, p.pos.z - p.dir.z};
+	const float2 rayDir = {p.dir.x, p.dir.z};
+
+	if (!math::isfinite(rayPos.x + rayPos.y + rayDir.x + rayDir.y)) {
+		// should not happen, but never cull what we can not reason about
+		for (size_t wIdx = 0; wIdx < interceptors.size(); wIdx++) {
+			if (candidateStamps[wIdx] == pIdx)
+				continue;
+
+			candidateStamps[wIdx] = pIdx;
+			pairs.emplace_back(wIdx, pIdx);
+		}
+
+		return;
+	}
+
+	float tmin = 0.0f;
+	float tmax = std::numeric_limits<float>::max();
+
+	for (int axis = 0; axis < 2; axis++) {
+		const float o = (axis == 0)? rayPos.x: rayPos.y;
+		const float d = (axis == 0)? rayDir.x: rayDir.y;
+		const float lo = (axis == 0)? gridMins.x: gridMins.y;
+		const float hi = (axis == 0)? gridMaxs.x: gridMaxs.y;
+
+		if (d == 0.0f) {
+			if (o < lo || o >= hi)
+				return;
+
+			continue;
+		}
+
+		const float t0 = (lo - o) / d;
+		const float t1 = (hi - o) / d;
+
+		tmin = std::max(tmin, std::min(t0, t1));
+		tmax = std::min(tmax, std::max(t0, t1));
+	}
+
+	if (tmin > tmax)
+		return;
+
+	const float2 entryPos = rayPos + rayDir * tmin;
+
+	int x = GetCell(entryPos.x, gridMins.x, gridSize.x);
+	int z = GetCell(entryPos.y, gridMins.y, gridSize.y);
+
+	if (rayDir.x == 0.0f && rayDir.y == 0.0f) {
+		AddCell(x, z);
+		return;
+	}
+
+	// Amanatides-Woo grid traversal
+	const int stepX = (rayDir.x > 0.0f)? 1: -1;
+	const int stepZ = (rayDir.y > 0.0f)? 1: -1;
+
+	const float deltaX = (rayDir.x != 0.0f)? (gridCellSize / math::fabs(rayDir.x)): std::numeric_limits<float>::max();
+	const float deltaZ = (rayDir.y != 0.0f)? (gridCellSize / math::fabs(rayDir.y)): std::numeric_limits<float>::max();
+
+	float nextX = (rayDir.x != 0.0f)? ((gridMins.x + (x + (stepX > 0)) * gridCellSize - rayPos.x) / rayDir.x): std::numeric_limits<float>::max();
+	float nextZ = (rayDir.y != 0.0f)? ((gridMins.y + (z + (stepZ > 0)) * gridCellSize - rayPos.y) / rayDir.y): std::numeric_limits<float>::max();
+
+	for (int n = gridSize.x + gridSize.y; n >= 0; n--) {
+		AddCell(x, z);
+
+		if (nextX < nextZ) {
+			if ((x += stepX) < 0 || x >= gridSize.x)
+				break;
+
+			nextX += deltaX;
+		} else {
+			if ((z += stepZ) < 0 || z >= gridSize.y)
+				break;
+
+			nextZ += deltaZ;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef INTERCEPT_GRID_H
+#define INTERCEPT_GRID_H
+
+#include <utility>
+#include <vector>
+
+#include "System/float3.h"
+#include "System/type2.h"
+
+/**
+ * Geometry behind CInterceptHandler: the exact coverage test for an
+ * (interceptor, target) pair, and a uniform XZ-grid over the coverage
+ * circles of all interceptors that is walked along a target's flight-path
+ * to cull the interceptors it can never come close to.
+ */
+class CInterceptGrid
+{
+public:
+	struct Interceptor {
+		float3 aimFromPos;
+		float coverageRange = 0.0f;
+	};
+	struct Target {
+		float3 pos;
+		float3 dir;
+		float3 targetPos;
+	};
+
+public:
+	void Clear() { interceptors.clear(); }
+	void AddInterceptor(const Interceptor& w) { interceptors.push_back(w); }
+	void Build();
+
+	/**
+	 * Appends an (interceptor, target) index pair for every interceptor
+	 * added since the last Clear for which CanReachTarget holds, each at
+	 * most once and in no particular order; <pIdx> must differ between
+	 * calls following a Build.
+	 */
+	void AddCandidates(const Target& p, int pIdx, std::vector< std::pair<int, int> >& pairs);
+
+	/**
+	 * True if <p> is within the coverage of <w>, given the distance along
+	 * its flight-path at which it hits the ground (-1 if it does not).
+	 */
+	static bool IsTargetCovered(const Interceptor& w, const Target& p, float impactDist);
+	/// necessary condition for IsTargetCovered, independent of <impactDist>
+	static bool CanReachTarget(const Interceptor& w, const Target& p);
+
+private:
+	std::vector<Interceptor> interceptors;
+
+	// cells store indices into <interceptors> in CSR form (interceptor
+	// indices of cell i are [cellOffsets[i], cellOffsets[i + 1]))
+	std::vector<int> cellInterceptors;
+	std::vector<int> cellOffsets;
+
+	// per-interceptor index of the last target it was a candidate for
+	std::vector<int> candidateStamps;
+
+	float2 gridMins;
+	float gridCellSize = 0.0f;
+	int2 gridSize;
+};
+
+#endif /* INTERCEPT_GRID_H */
@@ -1,6 +1,5 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
-#include <limits>
 #include <algorithm>
 
 #include "InterceptHandler.h"
@@ -14,7 +13,6 @@
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/EventHandler.h"
 #include "System/float3.h"
-#include "System/SpringMath.h"
 #include "System/creg/STL_Deque.h"
 
 #include "System/Misc/TracyDefs.h"
@@ -23,101 +21,91 @@
 CR_BIND_DERIVED(CInterceptHandler, CObject, )
 CR_REG_METADATA(CInterceptHandler, (
 	CR_MEMBER(interceptors),
-	CR_MEMBER(interceptables)
+	CR_MEMBER(interceptables),
+
+	CR_IGNORED(interceptGrid),
+	CR_IGNORED(candidatePairs)
 ))
 
 CInterceptHandler interceptHandler;
 
 
+static CInterceptGrid::Interceptor ToGridInterceptor(const CWeapon* w)
+{
+	return {w->aimFromPos, w->weaponDef->coverageRange};
+}
+
+static CInterceptGrid::Target ToGridTarget(const CWeaponProjectile* p)
+{
+	return {p->pos, p->dir, p->GetTargetPos()};
+}
+
 
 void CInterceptHandler::Update(bool forced) {
 	RECOIL_DETAILED_TRACY_ZONE;
 	if (((gs->frameNum % UNIT_SLOWUPDATE_RATE) != 0) && !forced)
 		return;
 
-	for (CWeapon* w: interceptors) {
-		const WeaponDef* wDef = w->weaponDef;
-		const CUnit* wOwner = w->owner;
-
-		assert(wDef->interceptor || wDef->isShield);
-
-		for (CWeaponProjectile* p: interceptables) {
-			if (!p->CanBeInterceptedBy(wDef))
-				continue;
-			if (w->HasIncomingProjectile(p->id))
-				continue;
-
-			const int pAllyTeam = p->GetAllyteamID();
-
-			if (teamHandler.IsValidAllyTeam(pAllyTeam) && teamHandler.Ally(wOwner->allyteam, pAllyTeam))
-				continue;
-
-			// note: will be called every Update so long as gadget does not return true
-			if (!eventHandler.AllowWeaponInterceptTarget(wOwner, w, p))
-				continue;
-
-			// there are four cases when an interceptor <w> should fire at a projectile <p>:
-			//     1. p's target position inside w's interception circle (w's owner can move!)
-			//     2. p's current position inside w's interception circle
-			//     3. p's projected impact position inside w's interception circle
-			//     4. p's trajectory intersects w's interception circle
-			//
-			// these checks all need to be evaluated periodically, not just
-			// when a projectile is created and handed to AddInterceptTarget
-			const float weaponDist = w->aimFromPos.distance(p->pos);
-			const float impactDist = CGround::LineGroundCol(p->pos, p->pos + p->dir * weaponDist);
-
-			const float3& pImpactPos = p->pos + p->dir * impactDist;
-			const float3& pTargetPos = p->GetTargetPos();
-			const float3  pWeaponVec = p->pos - w->aimFromPos;
-
-			if (w->aimFromPos.SqDistance2D(pTargetPos) < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->AddIncomingProjectile(p->id);
-				continue; // 1
-			}
-
-			if (false /*wDef->noFlyThroughIntercept*/) {
-				// <w> is just a static interceptor and fires only at projectiles
-				// TARGETED within its current interception area; any projectiles
-				// CROSSING its interception area aren't targeted
-				//XXX implement in lua?
-				continue;
-			}
-
-			if (pWeaponVec.SqLength2D() < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->AddIncomingProjectile(p->id);
-				continue; // 2
-			}
-
-			if (w->aimFromPos.SqDistance2D(pImpactPos) < Square(wDef->coverageRange)) {
-				const float3 pTargetDir = (pTargetPos - p->pos).SafeNormalize();
-				const float3 pImpactDir = (pImpactPos - p->pos).SafeNormalize();
-
-				// the projected impact position can briefly shift into the covered
-				// area during transition from vertical to horizontal flight, so we
-				// perform an extra test (NOTE: assumes non-parabolic trajectory)
-				if (pTargetDir.dot(pImpactDir) >= 0.999f) {
-					w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-					w->AddIncomingProjectile(p->id);
-					continue; // 3
-				}
-			}
-
-			const float3 pMinSepPos = p->pos + p->dir * std::clamp(-(pWeaponVec.dot(p->dir)), 0.0f, impactDist);
-			const float3 pMinSepVec = w->aimFromPos - pMinSepPos;
-
-			if (pMinSepVec.SqLength() < Square(wDef->coverageRange)) {
-				w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
-				w->AddIncomingProjectile(p->id);
-				continue; // 4
-			}
-		}
+	if (interceptors.empty() || interceptables.empty())
+		return;
+
+	// cull (interceptor, target) pairs whose coverage area the target
+	// can not reach, then visit the rest in the same interceptor-major
+	// order as a full sweep would
+	interceptGrid.Clear();
+
+	for (const CWeapon* w: interceptors) {
+		interceptGrid.AddInterceptor(ToGridInterceptor(w));
+	}
+
+	interceptGrid.Build();
+	candidatePairs.clear();
+
+	for (size_t pIdx = 0; pIdx < interceptables.size(); pIdx++) {
+		interceptGrid.AddCandidates(ToGridTarget(interceptables[pIdx]), pIdx, candidatePairs);
+	}
+
+	std::sort(candidatePairs.begin(), candidatePairs.end());
+
+	for (const auto& pair: candidatePairs) {
+		TryInterceptTarget(interceptors[pair.first], interceptables[pair.second]);
 	}
 }
 
 
+void CInterceptHandler::TryInterceptTarget(CWeapon* w, CWeaponProjectile* p)
+{
+	const WeaponDef* wDef = w->weaponDef;
+	const CUnit* wOwner = w->owner;
+
+	assert(wDef->interceptor || wDef->isShield);
+
+	if (!p->CanBeInterceptedBy(wDef))
+		return;
+	if (w->HasIncomingProjectile(p->id))
+		return;
+
+	const int pAllyTeam = p->GetAllyteamID();
+
+	if (teamHandler.IsValidAllyTeam(pAllyTeam) && teamHandler.Ally(wOwner->allyteam, pAllyTeam))
+		return;
+
+	// note: will be called every Update so long as gadget does not return true
+	if (!eventHandler.AllowWeaponInterceptTarget(wOwner, w, p))
+		return;
+
+	// the coverage checks all need to be evaluated periodically, not just
+	// when a projectile is created and handed to AddInterceptTarget
+	const float weaponDist = w->aimFromPos.distance(p->pos);
+	const float impactDist = CGround::LineGroundCol(p->pos, p->pos + p->dir * weaponDist);
+
+	if (!CInterceptGrid::IsTargetCovered(ToGridInterceptor(w), ToGridTarget(p), impactDist))
+		return;
+
+	w->AddDeathDependence(p, DEPENDENCE_INTERCEPT);
+	w->AddIncomingProjectile(p->id);
+}
+
 
 void CInterceptHandler::AddInterceptorWeapon(CWeapon* weapon)
 {
@@ -147,7 +135,17 @@ void CInterceptHandler::AddInterceptTarget(CWeaponProjectile* target, const floa
 	// die before the interceptable itself does)
 	AddDeathDependence(target, DEPENDENCE_INTERCEPTABLE);
 
-	Update(true);
+	// only the new target needs to be matched now, pairs involving older
+	// targets are re-checked by the periodic Update; interceptors move
+	// during the frame so the grid is not worth (re)building for this
+	const CInterceptGrid::Target gridTarget = ToGridTarget(target);
+
+	for (CWeapon* w: interceptors) {
+		if (!CInterceptGrid::CanReachTarget(ToGridInterceptor(w), gridTarget))
+			continue;
+
+		TryInterceptTarget(w, target);
+	}
 }
 
 
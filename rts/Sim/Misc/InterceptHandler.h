@@ -4,13 +4,16 @@
 #define INTERCEPT_HANDLER_H
 
 #include <deque>
+#include <utility>
+#include <vector>
+
+#include "InterceptGrid.h"
 #include "System/Misc/NonCopyable.h"
 #include "System/Object.h"
 
 class CWeapon;
 class CWeaponProjectile;
 class CProjectile;
-class float3;
 
 class CInterceptHandler : public CObject, spring::noncopyable
 {
@@ -26,9 +29,17 @@ public:
 
 	void DependentDied(CObject* o);
 
+private:
+	void TryInterceptTarget(CWeapon* w, CWeaponProjectile* p);
+
 private:
 	std::deque<CWeapon*> interceptors;
 	std::deque<CWeaponProjectile*> interceptables;
+
+	CInterceptGrid interceptGrid;
+
+	// (interceptor, interceptable) index pairs left after spatial culling
+	std::vector< std::pair<int, int> > candidatePairs;
 };
 
 extern CInterceptHandler interceptHandler;
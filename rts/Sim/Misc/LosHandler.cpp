@@ -8,6 +8,7 @@
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Map/ReadMap.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/Log/ILog.h"
 #include "System/SpringHash.h"
 #include "System/creg/STL_Deque.h"
@@ -19,6 +20,9 @@
 #include "System/Misc/TracyDefs.h"
 
 #define USE_STAGGERED_UPDATES 0
+#define USE_DELTA_UPDATES 1
+
+CONFIG(bool, LosVisibilityPlanes).defaultValue(true).description("Mirror the per-allyteam LOS counters into a per-square bitmask of allyteams, so visibility queries for different allyteams share cache lines. Only used with at most 64 allyteams.");
 
 
 
@@ -64,6 +68,7 @@ inline void SLosInstance::Init(int radius, int allyteam, int2 basePos, float bas
 	this->isCached = false;
 	this->isQueuedForUpdate = false;
 	this->isQueuedForTerraform = false;
+	this->isQueuedForDelta = false;
 }
 
 
@@ -100,6 +105,17 @@ void ILosType::Init(const int mipLevel_, LosType type_)
 	for (CLosMap& losMap: losMaps) {
 		losMap.Init(size, int2(mapDims.mapx, mapDims.mapy), ctrHeightMap, mipHeightMap, type == LOS_TYPE_LOS);
 	}
+
+	visPlane.clear();
+
+	if (!configHandler->GetBool("LosVisibilityPlanes") || losMaps.size() > (sizeof(visPlane[0]) * 8))
+		return;
+
+	visPlane.resize(size.x * size.y, 0);
+
+	for (size_t i = 0; i < losMaps.size(); i++) {
+		losMaps[i].SetVisibilityPlane(visPlane.data(), uint64_t(1) << i);
+	}
 }
 
 void ILosType::Kill()
@@ -127,6 +143,9 @@ void ILosType::Kill()
 	losDeleted.clear();
 	losRecalc.clear();
 
+	losMoves.clear();
+	losDeltas.clear();
+
 	// mark as invalid
 	size = {0, 0};
 }
@@ -232,11 +251,24 @@ inline void ILosType::UpdateUnit(CUnit* unit, bool ignore)
 	if (CanRefInstance(uli))
 		return;
 
+	// instance whose entire footprint is about to be replaced by the new one
+	SLosInstance* movedFrom = nullptr;
+
 	if (uli != nullptr) {
 		unit->los[type] = nullptr;
 		UnrefInstance(uli);
+
+		if (uli->refCount == 0)
+			movedFrom = uli;
 	}
 
+	const auto AddMove = [&](SLosInstance* li) {
+		#if (USE_DELTA_UPDATES == 1)
+		if (movedFrom != nullptr)
+			losMoves.push_back({movedFrom, li});
+		#endif
+	};
+
 	const int hash = GetHashNum(unit->allyteam, baseLos, radius);
 
 	// Cache - search if there is already an instance with same properties
@@ -248,6 +280,7 @@ inline void ILosType::UpdateUnit(CUnit* unit, bool ignore)
 				cacheHits += (algoType == LOS_ALGO_RAYCAST);
 				unit->los[type] = li;
 				RefInstance(li);
+				AddMove(li);
 				return;
 			}
 		}
@@ -261,6 +294,7 @@ inline void ILosType::UpdateUnit(CUnit* unit, bool ignore)
 	unit->los[type] = li;
 	instanceHashes[hash].push_back(li);
 	UpdateInstanceStatus(li, SLosInstance::TLosStatus::NEW);
+	AddMove(li);
 }
 
 
@@ -304,6 +338,19 @@ inline void ILosType::LosRemove(SLosInstance* li)
 }
 
 
+inline void ILosType::LosDelta(SLosInstance* src, SLosInstance* dst)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	assert(src->allyteam == dst->allyteam);
+
+	if (algoType == LOS_ALGO_RAYCAST) {
+		losMaps[dst->allyteam].AddRaycastDelta(src, dst);
+	} else {
+		losMaps[dst->allyteam].AddCircleDelta(src, dst);
+	}
+}
+
+
 inline void ILosType::RefInstance(SLosInstance* li)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -496,6 +543,43 @@ inline int ILosType::GetHashNum(const int allyteam, const int2 baseLos, const fl
 }
 
 
+void ILosType::QueueDeltaUpdates()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// same rules as OptimizeInstanceUpdate, without modifying the status
+	const auto IsRemoved = [](const SLosInstance* li) {
+		constexpr auto a = SLosInstance::TLosStatus::NEW | SLosInstance::TLosStatus::REACTIVATE;
+		return ((li->status & SLosInstance::TLosStatus::REMOVE) != 0 && (li->status & a) == 0);
+	};
+	const auto IsAdded = [](const SLosInstance* li) {
+		if ((li->status & SLosInstance::TLosStatus::NEW) != 0)
+			return true;
+
+		return ((li->status & SLosInstance::TLosStatus::REACTIVATE) != 0 && (li->status & SLosInstance::TLosStatus::REMOVE) == 0);
+	};
+
+	losDeltas.clear();
+
+	for (const DeltaInstance& di: losMoves) {
+		if (di.src->isQueuedForDelta || di.dst->isQueuedForDelta)
+			continue;
+		if (di.src->allyteam != di.dst->allyteam)
+			continue;
+		if (!IsRemoved(di.src) || !IsAdded(di.dst))
+			continue;
+
+		assert(di.src->refCount == 0);
+		assert(di.dst->refCount > 0);
+
+		di.src->isQueuedForDelta = true;
+		di.dst->isQueuedForDelta = true;
+		losDeltas.push_back(di);
+	}
+
+	losMoves.clear();
+}
+
+
 void ILosType::Update()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -516,8 +600,14 @@ void ILosType::Update()
 	}
 
 	// no updates? -> early exit
-	if (losUpdate.empty())
+	if (losUpdate.empty()) {
+		losMoves.clear();
 		return;
+	}
+
+	// pair up instances replacing each other (moved units) before their
+	// status gets resolved below, these are neither removed nor added
+	QueueDeltaUpdates();
 
 
 	losRemove.clear();
@@ -540,10 +630,10 @@ void ILosType::Update()
 		switch (status) {
 			case SLosInstance::TLosStatus::NEW: {
 				if (algoType == LOS_ALGO_RAYCAST) losRecalc.push_back(li);
-				losAdd.push_back(li);
+				if (!li->isQueuedForDelta) losAdd.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::REACTIVATE: {
-				losAdd.push_back(li);
+				if (!li->isQueuedForDelta) losAdd.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::RECALC: {
 				losRemove.push_back(li);
@@ -551,7 +641,7 @@ void ILosType::Update()
 				losAdd.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::REMOVE: {
-				losRemove.push_back(li);
+				if (!li->isQueuedForDelta) losRemove.push_back(li);
 				losDeleted.push_back(li);
 			} break;
 			case SLosInstance::TLosStatus::NONE: {
@@ -590,6 +680,14 @@ void ILosType::Update()
 		LosAdd(li);
 	}
 
+	// move sight; each pair nets out to LosRemove(src) + LosAdd(dst)
+	for (const DeltaInstance& di: losDeltas) {
+		LosDelta(di.src, di.dst);
+
+		di.src->isQueuedForDelta = false;
+		di.dst->isQueuedForDelta = false;
+	}
+
 	// delete / move to cache unused instances
 	if (algoType == LOS_ALGO_RAYCAST) {
 		while (!losCache.empty() && ((losCache.size() + losDeleted.size()) > CACHE_SIZE)) {
@@ -48,6 +48,7 @@ struct SLosInstance
 		, isCached(false)
 		, isQueuedForUpdate(false)
 		, isQueuedForTerraform(false)
+		, isQueuedForDelta(false)
 	{}
 	void Init(int radius, int allyteam, int2 basePos, float baseHeight, int hashNum);
 
@@ -79,6 +80,7 @@ public:
 	bool isCached;
 	bool isQueuedForUpdate;
 	bool isQueuedForTerraform;
+	bool isQueuedForDelta;
 };
 
 
@@ -108,9 +110,20 @@ public:
 
 	inline bool InSight(const float3 pos, int allyTeam) const {
 		assert(allyTeam < losMaps.size());
+
+		if (!visPlane.empty())
+			return (((visPlane[ClampedSquareIdx(PosToSquare(pos))] >> allyTeam) & 1) != 0);
+
 		return (losMaps[allyTeam].At(PosToSquare(pos)) != 0);
 	}
 
+	/// same clamping as CLosMap::At
+	int ClampedSquareIdx(int2 p) const {
+		p.x = std::clamp(p.x, 0, size.x - 1);
+		p.y = std::clamp(p.y, 0, size.y - 1);
+		return (p.y * size.x + p.x);
+	}
+
 public:
 	enum LosAlgoType { LOS_ALGO_RAYCAST, LOS_ALGO_CIRCLE };
 	enum LosType {
@@ -138,6 +151,7 @@ private:
 
 	void LosAdd(SLosInstance* instance);
 	void LosRemove(SLosInstance* instance);
+	void LosDelta(SLosInstance* src, SLosInstance* dst);
 
 	void RefInstance(SLosInstance* instance);
 	void UnrefInstance(SLosInstance* instance);
@@ -150,6 +164,8 @@ private:
 	SLosInstance* CreateInstance();
 	void DeleteInstance(SLosInstance* instance);
 
+	void QueueDeltaUpdates();
+
 private:
 	int GetHashNum(const int allyteam, const int2 baseLos, const float radius) const;
 
@@ -173,6 +189,8 @@ public:
 	spring::unordered_map<int, std::vector<SLosInstance*> > instanceHashes;
 
 	std::vector<CLosMap> losMaps;
+	/// optional, one bit per allyteam for each square: set iff that allyteam's losMap count is non-zero
+	std::vector<uint64_t> visPlane;
 	std::deque<SLosInstance> instances;
 	std::vector<int> freeIDs;
 
@@ -182,6 +200,16 @@ private:
 		int timeoutTime;
 	};
 
+	/**
+	 * A unit moved from <src> (which lost its last reference) to <dst>. If
+	 * both are still removed resp. added when the update runs, only the
+	 * squares in which their footprints differ are touched.
+	 */
+	struct DeltaInstance {
+		SLosInstance* src;
+		SLosInstance* dst;
+	};
+
 	std::deque<DelayedInstance> delayedDeleteQue;
 	std::deque<DelayedInstance> delayedTerraQue;
 	std::deque<SLosInstance*> losUpdate;
@@ -192,6 +220,9 @@ private:
 	std::vector<SLosInstance*> losDeleted;
 	std::vector<SLosInstance*> losRecalc;
 
+	std::vector<DeltaInstance> losMoves;
+	std::vector<DeltaInstance> losDeltas;
+
 	static constexpr int CACHE_SIZE = 4096;
 };
 
@@ -5,6 +5,7 @@
 
 #include "LosMap.h"
 #include "LosHandler.h"
+#include "LosRaycastKernel.h"
 #include "Map/ReadMap.h"
 #include "System/SpringMath.h"
 #include "System/float3.h"
@@ -13,13 +14,21 @@
 #include "System/Threading/ThreadPool.h"
 #include "Game/GlobalUnsynced.h" // for myAllyTeam
 
-constexpr float LOS_BONUS_HEIGHT = 5.0f;
+using LosRaycast::LOS_BONUS_HEIGHT;
+using LosRaycast::ToAngleMapIdx;
 
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABLES;
 
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_ANGLE_TABLES;
 static std::array<std::vector< char>, ThreadPool::MAX_THREADS> LOSRAY_SQUARE_TABLES; // visible squares per instance
 
+static std::array<std::vector<  int>, ThreadPool::MAX_THREADS> CIRCLE_ROW_WIDTH_TABLES;
+static std::array<std::vector<  int>, ThreadPool::MAX_THREADS> CIRCLE_DELTA_ROW_WIDTH_TABLES;
+#if (LOS_RAYCAST_SIMD == 1)
+static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_QUAD_ANGLE_TABLES;
+static std::array<std::vector<float>, ThreadPool::MAX_THREADS> LOSRAY_QUAD_SQUARE_TABLES;
+#endif
+
 
 static float isqrtTableLookup(unsigned r, int threadNum)
 {
@@ -124,6 +133,10 @@ public:
 		return losTables[losSize][rayIndex][squareIdx];
 	}
 
+	const int2* GetLosTableRay(size_t losSize, size_t rayIndex) {
+		return losTables[losSize][rayIndex].data();
+	}
+
 	size_t GetLosTableRaySize(size_t losSize, size_t rayIndex) {
 		return losTables[losSize][rayIndex].size();
 	}
@@ -420,7 +433,7 @@ void CLosMap::AddCircle(SLosInstance* instance, int amount)
 			const unsigned ex = std::clamp(instance->basePos.x + width + 1, 0, size.x);
 
 			for (unsigned x_ = sx; x_ < ex; ++x_) {
-				losmap[(y_ * size.x) + x_] += amount;
+				AddToSquare((y_ * size.x) + x_, amount);
 			}
 		}
 	});
@@ -442,7 +455,7 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 	if ((amount > 0) && updateUnsyncedHeightMap) {
 		for (const SLosInstance::RLE rle: losSquares) {
 			for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
-				losmap[idx] += amount;
+				AddToSquare(idx, amount);
 
 				// skip if this los-square did not *enter* LOS
 				if (losmap[idx] != amount)
@@ -462,12 +475,132 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 
 	for (const SLosInstance::RLE rle: losSquares) {
 		for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
-			losmap[idx] += amount;
+			AddToSquare(idx, amount);
 		}
 	}
 }
 
 
+// Calls func(start, end) for every run of squares in <a> which is not in <b>;
+// both lists are sorted and non-overlapping (see AddSquaresToInstance).
+template<typename F>
+static void ForEachSquareRunDifference(const std::vector<SLosInstance::RLE>& a, const std::vector<SLosInstance::RLE>& b, const F& func)
+{
+	auto bit = b.begin();
+
+	for (const SLosInstance::RLE rle: a) {
+		int start = rle.start;
+		const int end = rle.start + rle.length;
+
+		while (bit != b.end() && int(bit->start + bit->length) <= start)
+			++bit;
+
+		for (auto it = bit; it != b.end() && it->start < end; ++it) {
+			if (it->start > start)
+				func(start, it->start);
+
+			start = std::max(start, int(it->start + it->length));
+		}
+
+		if (start < end)
+			func(start, end);
+	}
+}
+
+
+void CLosMap::AddRaycastDelta(const SLosInstance* src, const SLosInstance* dst)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	assert(src->allyteam == dst->allyteam);
+
+	const bool visibleInstanceSquares = (dst->allyteam >= 0 && (dst->allyteam == gu->myAllyTeam || gu->spectatingFullView));
+	const bool updateUnsyncedHeightMap = sendReadmapEvents && visibleInstanceSquares;
+
+	// squares leaving the footprint
+	ForEachSquareRunDifference(src->squares, dst->squares, [&](int start, int end) {
+		for (int idx = start; idx < end; ++idx) {
+			AddToSquare(idx, -1);
+		}
+	});
+
+	// squares entering the footprint
+	ForEachSquareRunDifference(dst->squares, src->squares, [&](int start, int end) {
+		for (int idx = start; idx < end; ++idx) {
+			AddToSquare(idx, 1);
+
+			if (!updateUnsyncedHeightMap || losmap[idx] != 1)
+				continue;
+
+			const int2 lm = IdxToCoord(idx, size.x);
+			const int2 p1 = (lm             ) * LOS2HEIGHT;
+			const int2 p2 = (lm + int2(1, 1)) * LOS2HEIGHT;
+			const int2 p3 = {std::min(p2.x, mapDims.mapxm1), std::min(p2.y, mapDims.mapym1)};
+
+			readMap->UpdateLOS(SRectangle(p1.x, p1.y,  p3.x, p3.y));
+		}
+	});
+}
+
+
+void CLosMap::AddCircleDelta(const SLosInstance* src, const SLosInstance* dst)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const int threadNum = ThreadPool::GetThreadNum();
+
+	std::vector<int>& srcRowWidths = CIRCLE_ROW_WIDTH_TABLES[threadNum];
+	std::vector<int>& dstRowWidths = CIRCLE_DELTA_ROW_WIDTH_TABLES[threadNum];
+
+	const auto GetRowWidths = [](const SLosInstance* li, std::vector<int>& rowWidths) {
+		rowWidths.clear();
+		rowWidths.resize(li->radius + 1, 0);
+
+		MidpointCircleAlgoPerLine(li->radius, [&](int width, int y) {
+			if (y >= 0)
+				rowWidths[y] = width;
+		});
+	};
+	// [sx, ex) of the instance's row <y_>, clamped to the map; empty if outside
+	const auto GetRowRange = [&](const SLosInstance* li, const std::vector<int>& rowWidths, int y_) {
+		const int y = y_ - li->basePos.y;
+
+		if (std::abs(y) > li->radius)
+			return int2(0, 0);
+
+		const int width = rowWidths[std::abs(y)];
+		return int2(std::clamp(li->basePos.x - width, 0, size.x), std::clamp(li->basePos.x + width + 1, 0, size.x));
+	};
+	const auto AddRow = [&](int y_, int sx, int ex, int amount) {
+		for (int x_ = sx; x_ < ex; ++x_) {
+			AddToSquare((y_ * size.x) + x_, amount);
+		}
+	};
+
+	GetRowWidths(src, srcRowWidths);
+	GetRowWidths(dst, dstRowWidths);
+
+	const int sy = std::max(std::min(src->basePos.y - src->radius, dst->basePos.y - dst->radius), 0);
+	const int ey = std::min(std::max(src->basePos.y + src->radius, dst->basePos.y + dst->radius) + 1, size.y);
+
+	for (int y_ = sy; y_ < ey; ++y_) {
+		const int2 srcRange = GetRowRange(src, srcRowWidths, y_);
+		const int2 dstRange = GetRowRange(dst, dstRowWidths, y_);
+
+		if (srcRange.x >= srcRange.y || dstRange.x >= dstRange.y || srcRange.y <= dstRange.x || dstRange.y <= srcRange.x) {
+			// disjoint (or empty) row ranges
+			AddRow(y_, srcRange.x, srcRange.y, -1);
+			AddRow(y_, dstRange.x, dstRange.y, +1);
+			continue;
+		}
+
+		// overlapping ranges, only touch the parts sticking out on either side
+		AddRow(y_, srcRange.x, dstRange.x, -1);
+		AddRow(y_, dstRange.x, srcRange.x, +1);
+		AddRow(y_, dstRange.y, srcRange.y, -1);
+		AddRow(y_, srcRange.y, dstRange.y, +1);
+	}
+}
+
+
 void CLosMap::PrepareRaycast(SLosInstance* instance) const
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -515,13 +648,6 @@ void CLosMap::LosAdd(SLosInstance* li) const
 }
 
 
-inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
-{
-	// [-radius, +radius]^2 -> [0, +2*radius]^2 -> idx
-	return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
-}
-
-
 inline void CastLos(
 	float* prvAngle,
 	float* maxAngle,
@@ -532,25 +658,9 @@ inline void CastLos(
 	int threadNum
 ) {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const size_t oidx = ToAngleMapIdx(off, losRadius);
-
-	// angle to square is smaller than current max-angle, so not visible
-	if (raycastAngles[oidx] < *maxAngle) {
-		losRaySquares[oidx] = false;
-		return;
-	}
-
-	if (raycastAngles[oidx] < *prvAngle) {
-		const float invR = isqrtTableLookup(off.x * off.x + off.y * off.y, threadNum);
-		const float angle = *prvAngle - LOS_BONUS_HEIGHT * invR;
-
-		if (raycastAngles[oidx] < (*maxAngle = angle)) {
-			losRaySquares[oidx] = false;
-			return;
-		}
-	}
+	const float invR = isqrtTableLookup(off.x * off.x + off.y * off.y, threadNum);
 
-	*prvAngle = raycastAngles[oidx];
+	LosRaycast::CastLos(prvAngle, maxAngle, ToAngleMapIdx(off, losRadius), invR, raycastAngles.data(), losRaySquares.data());
 }
 
 
@@ -599,6 +709,9 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	// we can just mark them true and continue until we reach the top.
 	// So now, only hilltops are cached in maxAng, and they're only cached when checking
 	// the square after the hilltop, since otherwise we can't know that the ascent ended.
+	//
+	// The kernels live in LosRaycastKernel.h; with SIMD the four mirrored rays are cast
+	// as one batch over a "quad" layout holding the four rotations of each square.
 	const int threadNum = ThreadPool::GetThreadNum();
 
 	const int2 pos   = li->basePos;
@@ -609,73 +722,64 @@ void CLosMap::UnsafeLosAdd(SLosInstance* li) const
 	CLosTableHelper& helper = losTableHelpers[threadNum];
 
 	std::vector<char>& losRaySquares = LOSRAY_SQUARE_TABLES[threadNum];
-	std::vector<float>& raycastAngles = RAYCAST_ANGLE_TABLES[threadNum];
+	std::vector< int>& circleRowWidths = CIRCLE_ROW_WIDTH_TABLES[threadNum];
 
 	helper.GenerateForLosSize(radius);
 
 	losRaySquares.clear();
 	losRaySquares.resize(Square((2 * radius) + 1), false);
-	raycastAngles.clear();
-	raycastAngles.resize(Square((2 * radius) + 1), -1e8);
+	circleRowWidths.clear();
+	circleRowWidths.resize(radius + 1, 0);
 
 
 	isqrtTableExpand((radius + 1) * (radius + 1), threadNum);
 
+	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
+		if (y >= 0)
+			circleRowWidths[y] = width;
+	});
+
+	const float* isqrtTable = RADIUS_ISQRT_TABLES[threadNum].data();
+	const size_t numRays = helper.GetLosTableSize(radius);
+
 	// Optimization: precalculate all angles
 	// 1. Center squares are accessed much more often by more rays than those on the border.
 	// 2. The heightmap is much bigger than the circle, and won't fit into the L2/L3. So
 	//    when we buffer the precalc in a vector just large enough for the processed data,
 	//    we reduce the amount of cache misses.
-	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
-		const unsigned y_ = pos.y + y;
-		const unsigned sx = pos.x - width;
-		const unsigned ex = pos.x + width + 1;
+	#if (LOS_RAYCAST_SIMD == 1)
+	std::vector<float>& quadAngles = RAYCAST_QUAD_ANGLE_TABLES[threadNum];
+	std::vector<float>& quadSquares = LOSRAY_QUAD_SQUARE_TABLES[threadNum];
 
-		const size_t oidx = ToAngleMapIdx(int2(sx - pos.x, y), radius);
+	quadAngles.clear();
+	quadAngles.resize(Square(radius + 1) * 4, -1e8);
+	quadSquares.clear();
+	quadSquares.resize(Square(radius + 1) * 4, 0.0f);
 
-		float* raycastAnglesPtr = &raycastAngles[oidx];
-		char* losRaySquaresPtr = &losRaySquares[oidx];
+	LosRaycast::FillQuadAngles(mipHeightMap, size.x, pos, losHeight, radius, circleRowWidths.data(), isqrtTable, quadAngles.data(), quadSquares.data());
 
-		int idx = MAP_SQUARE(int2(sx, y_));
+	// cast the rays
+	for (size_t i = 0; i < numRays; ++i) {
+		LosRaycast::CastQuadRay(helper.GetLosTableRay(radius, i), helper.GetLosTableRaySize(radius, i), radius, isqrtTable, quadAngles.data(), quadSquares.data());
+	}
 
-		for (unsigned x_ = sx; x_ < ex; ++x_) {
-			const int2 off(x_ - pos.x, y);
+	LosRaycast::QuadToSquares(radius, circleRowWidths.data(), quadSquares.data(), losRaySquares.data());
 
-			if (off == int2(0, 0)) {
-				++idx;
-				++raycastAnglesPtr;
-				++losRaySquaresPtr;
-				continue;
-			}
+	#else
+	std::vector<float>& raycastAngles = RAYCAST_ANGLE_TABLES[threadNum];
 
-			const float invR = isqrtTableLookup(off.x*off.x + off.y*off.y, threadNum);
-			const float dh = std::max(0.0f, mipHeightMap[idx++]) - losHeight;
+	raycastAngles.clear();
+	raycastAngles.resize(Square((2 * radius) + 1), -1e8);
 
-			*(raycastAnglesPtr++) = (dh + LOS_BONUS_HEIGHT) * invR;
-			*(losRaySquaresPtr++) = true;
-		}
-	});
+	LosRaycast::FillAngles(mipHeightMap, size.x, pos, losHeight, radius, circleRowWidths.data(), isqrtTable, raycastAngles.data(), losRaySquares.data());
 
 	// cast the rays
-	losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
-
-	const size_t numRays = helper.GetLosTableSize(radius);
-
 	for (size_t i = 0; i < numRays; ++i) {
-		float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-		float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
-
-		const size_t numSquares = helper.GetLosTableRaySize(radius, i);
-
-		for (size_t n = 0; n < numSquares; n++) {
-			const int2 square = helper.GetLosTableRaySquare(radius, i, n);
-
-			CastLos(&prvAngles[0], &maxAngles[0],       square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[1], &maxAngles[1],      -square              , losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[2], &maxAngles[2], int2( square.y, -square.x), losRaySquares, raycastAngles, radius, threadNum);
-			CastLos(&prvAngles[3], &maxAngles[3], int2(-square.y,  square.x), losRaySquares, raycastAngles, radius, threadNum);
-		}
+		LosRaycast::CastRay(helper.GetLosTableRay(radius, i), helper.GetLosTableRaySize(radius, i), radius, isqrtTable, raycastAngles.data(), losRaySquares.data());
 	}
+	#endif
+
+	losRaySquares[ToAngleMapIdx(int2(0, 0), radius)] = true;
 
 	// translate visible square indices to map square idx + RLE
 	AddSquaresToInstance(li, losRaySquares);
@@ -5,6 +5,7 @@
 #ifndef LOS_MAP_H
 #define LOS_MAP_H
 
+#include <cstdint>
 #include <vector>
 #include "System/type2.h"
 #include "System/SpringMath.h"
@@ -28,11 +29,20 @@ public:
 		ctrHeightMap = ctrHeightMap_;
 		mipHeightMap = mipHeightMap_;
 
+		visPlane = nullptr;
+		visBit = 0;
+
 		sendReadmapEvents = sendReadmapEvents_;
 	}
 
 	void Kill() {}
 
+	/// <plane> holds one bit per allyteam for every square, <bit> is this map's; kept in sync with the counters
+	void SetVisibilityPlane(uint64_t* plane, uint64_t bit) {
+		visPlane = plane;
+		visBit = bit;
+	}
+
 public:
 	/// circular area, for airLosMap, circular radar maps, jammer maps, ...
 	void AddCircle(SLosInstance* instance, int amount);
@@ -43,6 +53,12 @@ public:
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void PrepareRaycast(SLosInstance* instance) const;
 
+	/// same as AddCircle(src, -1) followed by AddCircle(dst, 1), but only touches squares in one of both
+	void AddCircleDelta(const SLosInstance* src, const SLosInstance* dst);
+
+	/// same as AddRaycast(src, -1) followed by AddRaycast(dst, 1), but only touches squares in one of both
+	void AddRaycastDelta(const SLosInstance* src, const SLosInstance* dst);
+
 public:
 	int At(int2 p) const {
 		p.x = std::clamp(p.x, 0, size.x - 1);
@@ -60,6 +76,15 @@ private:
 
 	void AddSquaresToInstance(SLosInstance* li, const std::vector<char>& losRaySquares) const;
 
+	void AddToSquare(int idx, int amount) {
+		const bool wasVisible = (losmap[idx] != 0);
+
+		losmap[idx] += amount;
+
+		if (visPlane != nullptr && wasVisible != (losmap[idx] != 0))
+			visPlane[idx] ^= visBit;
+	}
+
 protected:
 	int2 size;
 	int2 LOS2HEIGHT;
@@ -69,6 +94,9 @@ protected:
 	const float* ctrHeightMap = nullptr;
 	const float* mipHeightMap = nullptr;
 
+	uint64_t* visPlane = nullptr;
+	uint64_t visBit = 0;
+
 	bool sendReadmapEvents = false;
 };
 
@@ -0,0 +1,224 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOS_RAYCAST_KERNEL_H
+#define LOS_RAYCAST_KERNEL_H
+
+#include <algorithm>
+#include <cstddef>
+
+#include "System/XSimdOps.hpp"
+#include "System/type2.h"
+
+#if (XSIMD_X86_INSTR_SET >= XSIMD_X86_SSE2_VERSION) || (XSIMD_ARM_INSTR_SET >= XSIMD_ARM7_NEON_VERSION)
+	#define LOS_RAYCAST_SIMD 1
+#else
+	#define LOS_RAYCAST_SIMD 0
+#endif
+
+/**
+ * Building blocks of CLosMap's raycast LOS: fill a [-radius, +radius]^2
+ * grid with the elevation angle to each square of the disk, then cast the
+ * precalculated CLosTableHelper rays (upper right octant pair, mirrored in
+ * all four directions) over it and clear every square hidden behind an
+ * earlier one.
+ *
+ * The four mirrored directions have independent state and share the
+ * distance of each step. The SIMD variant therefore stores, for every
+ * square (x,y) of the first quadrant, the values of its four rotations
+ *   (x,y) (-x,-y) (y,-x) (-y,x)
+ * next to each other ("quad" layout), so each ray step becomes a single
+ * 4-wide load and compare. The axes are stored twice, once as (r,0) and
+ * once as (0,r), since rays can pass through both.
+ *
+ * All variants perform the same float operations in the same order (no
+ * reassociation, no FMA), so their results are identical and sync-safe.
+ */
+namespace LosRaycast {
+	static constexpr float LOS_BONUS_HEIGHT = 5.0f;
+
+	inline static constexpr size_t ToAngleMapIdx(const int2 p, const int radius)
+	{
+		// [-radius, +radius]^2 -> [0, +2*radius]^2 -> idx
+		return (p.y + radius) * (2 * radius + 1) + (p.x + radius);
+	}
+
+	inline static constexpr size_t ToQuadMapIdx(const int2 p, const int radius)
+	{
+		// [0, +radius]^2 -> idx of the first of four rotations
+		return (p.y * (radius + 1) + p.x) * 4;
+	}
+
+
+	/**
+	 * <rowWidths[y]> is the half-width of disk rows +y and -y, <isqrtTable>
+	 * maps squared distances to inverse distances, <heights> is indexed by
+	 * (pos.y + y) * <stride> + (pos.x + x) and must cover the whole disk
+	 */
+	inline void FillAngles(
+		const float* heights,
+		int stride,
+		int2 pos,
+		float losHeight,
+		int radius,
+		const int* rowWidths,
+		const float* isqrtTable,
+		float* raycastAngles,
+		char* losRaySquares
+	) {
+		for (int y = -radius; y <= radius; y++) {
+			const int width = rowWidths[std::abs(y)];
+			const float* rowHeights = &heights[(pos.y + y) * stride + pos.x];
+
+			for (int x = -width; x <= width; x++) {
+				if (x == 0 && y == 0)
+					continue;
+
+				const size_t oidx = ToAngleMapIdx(int2(x, y), radius);
+
+				const float invR = isqrtTable[x * x + y * y];
+				const float dh = std::max(0.0f, rowHeights[x]) - losHeight;
+
+				raycastAngles[oidx] = (dh + LOS_BONUS_HEIGHT) * invR;
+				losRaySquares[oidx] = true;
+			}
+		}
+	}
+
+	inline void CastLos(float* prvAngle, float* maxAngle, size_t oidx, float invR, const float* raycastAngles, char* losRaySquares)
+	{
+		// angle to square is smaller than current max-angle, so not visible
+		if (raycastAngles[oidx] < *maxAngle) {
+			losRaySquares[oidx] = false;
+			return;
+		}
+
+		if (raycastAngles[oidx] < *prvAngle) {
+			const float angle = *prvAngle - LOS_BONUS_HEIGHT * invR;
+
+			if (raycastAngles[oidx] < (*maxAngle = angle)) {
+				losRaySquares[oidx] = false;
+				return;
+			}
+		}
+
+		*prvAngle = raycastAngles[oidx];
+	}
+
+	inline void CastRay(const int2* ray, size_t numSquares, int radius, const float* isqrtTable, const float* raycastAngles, char* losRaySquares)
+	{
+		float maxAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+		float prvAngles[4] = {-1e7, -1e7, -1e7, -1e7};
+
+		for (size_t n = 0; n < numSquares; n++) {
+			const int2 sq = ray[n];
+			const float invR = isqrtTable[sq.x * sq.x + sq.y * sq.y];
+
+			CastLos(&prvAngles[0], &maxAngles[0], ToAngleMapIdx(     sq            , radius), invR, raycastAngles, losRaySquares);
+			CastLos(&prvAngles[1], &maxAngles[1], ToAngleMapIdx(    -sq            , radius), invR, raycastAngles, losRaySquares);
+			CastLos(&prvAngles[2], &maxAngles[2], ToAngleMapIdx(int2( sq.y, -sq.x), radius), invR, raycastAngles, losRaySquares);
+			CastLos(&prvAngles[3], &maxAngles[3], ToAngleMapIdx(int2(-sq.y,  sq.x), radius), invR, raycastAngles, losRaySquares);
+		}
+	}
+
+
+	#if (LOS_RAYCAST_SIMD == 1)
+	typedef xsimd::batch<float, 4> FloatBatch;
+
+	/// quad-layout counterpart of FillAngles, visibility is stored as 0.0 or 1.0
+	inline void FillQuadAngles(
+		const float* heights,
+		int stride,
+		int2 pos,
+		float losHeight,
+		int radius,
+		const int* rowWidths,
+		const float* isqrtTable,
+		float* quadAngles,
+		float* quadVisible
+	) {
+		const FloatBatch zero(0.0f);
+		const FloatBatch one(1.0f);
+		const FloatBatch baseHeight(losHeight);
+		const FloatBatch bonusHeight(LOS_BONUS_HEIGHT);
+
+		const float* center = &heights[pos.y * stride + pos.x];
+
+		for (int y = 0; y <= radius; y++) {
+			for (int x = (y == 0); x <= rowWidths[y]; x++) {
+				const FloatBatch h(
+					center[ y * stride + x],
+					center[-y * stride - x],
+					center[-x * stride + y],
+					center[ x * stride - y]
+				);
+
+				const FloatBatch invR(isqrtTable[x * x + y * y]);
+				const FloatBatch dh = xsimd::max(zero, h) - baseHeight;
+				const size_t qidx = ToQuadMapIdx(int2(x, y), radius);
+
+				((dh + bonusHeight) * invR).store_unaligned(&quadAngles[qidx]);
+				one.store_unaligned(&quadVisible[qidx]);
+			}
+		}
+	}
+
+	inline void CastQuadRay(const int2* ray, size_t numSquares, int radius, const float* isqrtTable, const float* quadAngles, float* quadVisible)
+	{
+		const FloatBatch zero(0.0f);
+		const FloatBatch bonusHeight(LOS_BONUS_HEIGHT);
+
+		FloatBatch maxAngles(-1e7f);
+		FloatBatch prvAngles(-1e7f);
+
+		for (size_t n = 0; n < numSquares; n++) {
+			const int2 sq = ray[n];
+			const size_t qidx = ToQuadMapIdx(sq, radius);
+
+			const FloatBatch angles(&quadAngles[qidx]);
+			const FloatBatch invR(isqrtTable[sq.x * sq.x + sq.y * sq.y]);
+
+			// lanes below the current max-angle are hidden right away, lanes
+			// past a hilltop first lower their max-angle (see CastLos)
+			const auto belowMax = (angles < maxAngles);
+			const auto descends = (~belowMax) & (angles < prvAngles);
+
+			const FloatBatch descMaxAngles = prvAngles - bonusHeight * invR;
+
+			maxAngles = xsimd::select(descends, descMaxAngles, maxAngles);
+
+			const auto hidden = belowMax | (descends & (angles < descMaxAngles));
+
+			prvAngles = xsimd::select(hidden, prvAngles, angles);
+
+			xsimd::select(hidden, zero, FloatBatch(&quadVisible[qidx])).store_unaligned(&quadVisible[qidx]);
+		}
+	}
+
+	/// scatters quad-layout visibility back into the [-radius, +radius]^2 grid
+	inline void QuadToSquares(int radius, const int* rowWidths, const float* quadVisible, char* losRaySquares)
+	{
+		for (int y = 0; y <= radius; y++) {
+			for (int x = 1; x <= rowWidths[y]; x++) {
+				const float* vis = &quadVisible[ToQuadMapIdx(int2(x, y), radius)];
+
+				losRaySquares[ToAngleMapIdx(int2( x,  y), radius)] = (vis[0] != 0.0f);
+				losRaySquares[ToAngleMapIdx(int2(-x, -y), radius)] = (vis[1] != 0.0f);
+				losRaySquares[ToAngleMapIdx(int2( y, -x), radius)] = (vis[2] != 0.0f);
+				losRaySquares[ToAngleMapIdx(int2(-y,  x), radius)] = (vis[3] != 0.0f);
+			}
+		}
+
+		// squares on the axes have a second copy at (0, r), hidden if either is
+		for (int r = 1; r <= radius; r++) {
+			const float* vis = &quadVisible[ToQuadMapIdx(int2(0, r), radius)];
+
+			losRaySquares[ToAngleMapIdx(int2( 0,  r), radius)] &= (vis[0] != 0.0f);
+			losRaySquares[ToAngleMapIdx(int2( 0, -r), radius)] &= (vis[1] != 0.0f);
+			losRaySquares[ToAngleMapIdx(int2( r,  0), radius)] &= (vis[2] != 0.0f);
+			losRaySquares[ToAngleMapIdx(int2(-r,  0), radius)] &= (vis[3] != 0.0f);
+		}
+	}
+	#endif
+}
+
+#endif
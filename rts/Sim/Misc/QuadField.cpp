@@ -33,7 +33,10 @@ CR_REG_METADATA(CQuadField, (
 	CR_IGNORED(tempFeatures),
 	CR_IGNORED(tempProjectiles),
 	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(tempQuads),
+	CR_IGNORED(movedProjectiles),
+	CR_IGNORED(quadStamps),
+	CR_IGNORED(quadStamp)
 ))
 
 CR_BIND(CQuadField::Quad, )
@@ -126,6 +129,9 @@ void CQuadField::Init(int2 mapDims, int quadSize)
 	invQuadSize = {1.0f / quadSizeX, 1.0f / quadSizeZ};
 
 	baseQuads.resize(numQuadsX * numQuadsZ);
+	quadStamps.clear();
+	quadStamps.resize(numQuadsX * numQuadsZ, 0);
+	quadStamp = 0;
 
 	size_t threadCount = ThreadPool::GetNumThreads();
 
@@ -164,6 +170,8 @@ void CQuadField::Kill()
 
 	for (auto cache : tempQuads)
 		cache.ReleaseAll();
+
+	movedProjectiles.clear();
 }
 
 
@@ -349,6 +357,7 @@ bool CQuadField::InsertUnitIf(CUnit* unit, const float3& wpos)
 
 	spring::VectorInsertUnique(baseQuads[wposQuadIdx].units, unit, false);
 	spring::VectorInsertUnique(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit, false);
+	StampQuad(wposQuadIdx);
 	return true;
 }
 
@@ -380,6 +389,7 @@ bool CQuadField::RemoveUnitIf(CUnit* unit, const float3& wpos)
 
 	spring::VectorErase(baseQuads[wposQuadIdx].units, unit);
 	spring::VectorErase(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit);
+	StampQuad(wposQuadIdx);
 	return true;
 }
 #endif
@@ -402,11 +412,13 @@ void CQuadField::MovedUnit(CUnit* unit)
 	for (const int qi: unit->quads) {
 		spring::VectorErase(baseQuads[qi].units, unit);
 		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
+		StampQuad(qi);
 	}
 
 	for (const int qi: *qfQuery.quads) {
 		spring::VectorInsertUnique(baseQuads[qi].units, unit, false);
 		spring::VectorInsertUnique(baseQuads[qi].teamUnits[unit->allyteam], unit, false);
+		StampQuad(qi);
 	}
 
 	unit->quads = std::move(*qfQuery.quads);
@@ -418,6 +430,7 @@ void CQuadField::RemoveUnit(CUnit* unit)
 	for (const int qi: unit->quads) {
 		spring::VectorErase(baseQuads[qi].units, unit);
 		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
+		StampQuad(qi);
 	}
 
 	unit->quads.clear();
@@ -450,10 +463,12 @@ void CQuadField::MovedRepulser(CPlasmaRepulser* repulser)
 
 	for (const int qi: repulserQuads) {
 		spring::VectorErase(baseQuads[qi].repulsers, repulser);
+		StampQuad(qi);
 	}
 
 	for (const int qi: *qfQuery.quads) {
 		spring::VectorInsertUnique(baseQuads[qi].repulsers, repulser, false);
+		StampQuad(qi);
 	}
 
 	repulser->SetQuads(std::move(*qfQuery.quads));
@@ -464,6 +479,7 @@ void CQuadField::RemoveRepulser(CPlasmaRepulser* repulser)
 	RECOIL_DETAILED_TRACY_ZONE;
 	for (const int qi: repulser->GetQuads()) {
 		spring::VectorErase(baseQuads[qi].repulsers, repulser);
+		StampQuad(qi);
 	}
 
 	repulser->ClearQuads();
@@ -486,6 +502,7 @@ void CQuadField::AddFeature(CFeature* feature)
 
 	for (const int qi: *qfQuery.quads) {
 		spring::VectorInsertUnique(baseQuads[qi].features, feature, false);
+		StampQuad(qi);
 	}
 }
 
@@ -497,6 +514,7 @@ void CQuadField::RemoveFeature(CFeature* feature)
 
 	for (const int qi: *qfQuery.quads) {
 		spring::VectorErase(baseQuads[qi].features, feature);
+		StampQuad(qi);
 	}
 
 	#ifdef DEBUG_QUADFIELD
@@ -513,6 +531,8 @@ void CQuadField::RemoveFeature(CFeature* feature)
 void CQuadField::MovedProjectile(CProjectile* p)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	FlushMovedProjectiles();
+
 	if (!p->synced)
 		return;
 	// hit-scan projectiles do NOT move!
@@ -531,6 +551,8 @@ void CQuadField::AddProjectile(CProjectile* p)
 	RECOIL_DETAILED_TRACY_ZONE;
 	assert(p->synced);
 
+	FlushMovedProjectiles();
+
 	if (p->hitscan) {
 		QuadFieldQuery qfQuery;
 		GetQuadsOnRay(qfQuery, p->pos, p->dir, p->speed.w);
@@ -553,6 +575,8 @@ void CQuadField::RemoveProjectile(CProjectile* p)
 	RECOIL_DETAILED_TRACY_ZONE;
 	assert(p->synced);
 
+	FlushMovedProjectiles();
+
 	for (const int qi: p->quads) {
 		spring::VectorErase(baseQuads[qi].projectiles, p);
 	}
@@ -560,6 +584,35 @@ void CQuadField::RemoveProjectile(CProjectile* p)
 	p->quads.clear();
 }
 
+void CQuadField::FlushMovedProjectiles()
+{
+	if (movedProjectiles.empty())
+		return;
+
+	ZoneScoped;
+
+	// relinks exactly like MovedProjectile would have, one projectile after
+	// the other, so the cells end up in the same (synced) order as before
+	for (CProjectile* p: movedProjectiles) {
+		// hit-scan projectiles do NOT move!
+		if (!p->synced || p->hitscan)
+			continue;
+
+		const int oldQuad = p->quads.back();
+		const int newQuad = WorldPosToQuadFieldIdx(p->pos);
+
+		if (newQuad == oldQuad)
+			continue;
+
+		spring::VectorErase(baseQuads[oldQuad].projectiles, p);
+		spring::VectorInsertUnique(baseQuads[newQuad].projectiles, p, false);
+
+		p->quads.back() = newQuad;
+	}
+
+	movedProjectiles.clear();
+}
+
 
 
 
@@ -720,6 +773,8 @@ void CQuadField::GetFeaturesExact(QuadFieldQuery& qfq, const float3& mins, const
 void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& pos, float radius)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	FlushMovedProjectiles();
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, pos, radius);
 	const int tempNum = gs->GetTempNum();
@@ -745,6 +800,8 @@ void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& pos, flo
 void CQuadField::GetProjectilesExact(QuadFieldQuery& qfq, const float3& mins, const float3& maxs)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	FlushMovedProjectiles();
+
 	QuadFieldQuery qfQuery;
 	GetQuadsRectangle(qfQuery, mins, maxs);
 	const int tempNum = gs->GetTempNum();
@@ -833,16 +890,18 @@ bool CQuadField::NoSolidsExact(
 	const unsigned int collisionStateBits
 ) {
 	RECOIL_DETAILED_TRACY_ZONE;
+	const int curThread = ThreadPool::GetThreadNum();
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = curThread;
 	GetQuads(qfQuery, pos, radius);
-	const int tempNum = gs->GetTempNum();
+	const int tempNum = gs->GetMtTempNum(curThread);
 
 	for (const int qi: *qfQuery.quads) {
 		for (CUnit* u: baseQuads[qi].units) {
-			if (u->tempNum == tempNum)
+			if (u->mtTempNum[curThread] == tempNum)
 				continue;
 
-			u->tempNum = tempNum;
+			u->mtTempNum[curThread] = tempNum;
 
 			if (!u->HasPhysicalStateBit(physicalStateBits))
 				continue;
@@ -855,10 +914,10 @@ bool CQuadField::NoSolidsExact(
 		}
 
 		for (CFeature* f: baseQuads[qi].features) {
-			if (f->tempNum == tempNum)
+			if (f->mtTempNum[curThread] == tempNum)
 				continue;
 
-			f->tempNum = tempNum;
+			f->mtTempNum[curThread] = tempNum;
 
 			if (!f->HasPhysicalStateBit(physicalStateBits))
 				continue;
@@ -876,6 +935,30 @@ bool CQuadField::NoSolidsExact(
 
 
 // optimization specifically for projectile collisions
+static inline bool UnitOutOfColVolRange(const CUnit* u, const float3& pos, const float radius)
+{
+	const auto* colvol = &u->collisionVolume;
+	const float totRad = radius + colvol->GetBoundingRadius();
+
+	return (pos.SqDistance(colvol->GetWorldSpacePos(u)) >= (totRad * totRad));
+}
+
+static inline bool FeatureOutOfColVolRange(const CFeature* f, const float3& pos, const float radius)
+{
+	const auto* colvol = &f->collisionVolume;
+	const float totRad = radius + colvol->GetBoundingRadius();
+
+	return (pos.SqDistance(colvol->GetWorldSpacePos(f)) >= (totRad * totRad));
+}
+
+static inline bool RepulserOutOfColVolRange(const CPlasmaRepulser* r, const float3& pos, const float radius)
+{
+	const auto* colvol = &r->collisionVolume;
+	const float totRad = radius + colvol->GetBoundingRadius();
+
+	return (pos.SqDistance(r->weaponMuzzlePos) >= (totRad * totRad));
+}
+
 void CQuadField::GetUnitsAndFeaturesColVol(
 	const float3& pos,
 	const float radius,
@@ -884,26 +967,25 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 	std::vector<CPlasmaRepulser*>* repulsers
 ) {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const int tempNum = gs->GetTempNum();
+	const int curThread = ThreadPool::GetThreadNum();
+	const int tempNum = gs->GetMtTempNum(curThread);
+	const size_t repulsersBeg = (repulsers != nullptr)? repulsers->size(): 0;
 
 	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = curThread;
 	GetQuads(qfQuery, pos, radius);
-	// start counting from the previous object-cache sizes
 
 	for (const int qi: *qfQuery.quads) {
 		const Quad& quad = baseQuads[qi];
 
 		for (CUnit* u: quad.units) {
 			// prevent double adding
-			if (u->tempNum == tempNum)
+			if (u->mtTempNum[curThread] == tempNum)
 				continue;
 
-			u->tempNum = tempNum;
-
-			const auto* colvol = &u->collisionVolume;
-			const float totRad = radius + colvol->GetBoundingRadius();
+			u->mtTempNum[curThread] = tempNum;
 
-			if (pos.SqDistance(colvol->GetWorldSpacePos(u)) >= (totRad * totRad))
+			if (UnitOutOfColVolRange(u, pos, radius))
 				continue;
 
 			units.push_back(u);
@@ -911,31 +993,23 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 
 		for (CFeature* f: quad.features) {
 			// prevent double adding
-			if (f->tempNum == tempNum)
+			if (f->mtTempNum[curThread] == tempNum)
 				continue;
 
-			f->tempNum = tempNum;
-
-			const auto* colvol = &f->collisionVolume;
-			const float totRad = radius + colvol->GetBoundingRadius();
+			f->mtTempNum[curThread] = tempNum;
 
-			if (pos.SqDistance(colvol->GetWorldSpacePos(f)) >= (totRad * totRad))
+			if (FeatureOutOfColVolRange(f, pos, radius))
 				continue;
 
 			features.push_back(f);
 		}
 		if (repulsers != nullptr) {
 			for (CPlasmaRepulser* r: quad.repulsers) {
-				// prevent double adding
-				if (r->tempNum == tempNum)
+				// no per-thread tags, see GatherUnitsAndFeaturesColVol
+				if (std::find(repulsers->begin() + repulsersBeg, repulsers->end(), r) != repulsers->end())
 					continue;
 
-				r->tempNum = tempNum;
-
-				const auto* colvol = &r->collisionVolume;
-				const float totRad = radius + colvol->GetBoundingRadius();
-
-				if (pos.SqDistance(r->weaponMuzzlePos) >= (totRad * totRad))
+				if (RepulserOutOfColVolRange(r, pos, radius))
 					continue;
 
 				repulsers->push_back(r);
@@ -943,4 +1017,77 @@ void CQuadField::GetUnitsAndFeaturesColVol(
 		}
 	}
 }
+
+void CQuadField::GatherUnitsAndFeaturesColVol(
+	int tid,
+	const float3& pos,
+	const float radius,
+	std::vector<int>& quads,
+	std::vector<CUnit*>& units,
+	std::vector<CFeature*>& features,
+	std::vector<CPlasmaRepulser*>& repulsers
+) {
+	const int tempNum = gs->GetMtTempNum(tid);
+	const size_t repulsersBeg = repulsers.size();
+
+	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = tid;
+	GetQuads(qfQuery, pos, radius);
+
+	for (const int qi: *qfQuery.quads) {
+		const Quad& quad = baseQuads[qi];
+
+		quads.push_back(qi);
+
+		for (CUnit* u: quad.units) {
+			if (u->mtTempNum[tid] == tempNum)
+				continue;
+
+			u->mtTempNum[tid] = tempNum;
+			units.push_back(u);
+		}
+
+		for (CFeature* f: quad.features) {
+			if (f->mtTempNum[tid] == tempNum)
+				continue;
+
+			f->mtTempNum[tid] = tempNum;
+			features.push_back(f);
+		}
+
+		// repulsers have no per-thread tags, but there are only ever a few
+		for (CPlasmaRepulser* r: quad.repulsers) {
+			if (std::find(repulsers.begin() + repulsersBeg, repulsers.end(), r) != repulsers.end())
+				continue;
+
+			repulsers.push_back(r);
+		}
+	}
+}
+
+void CQuadField::FilterUnitsAndFeaturesColVol(
+	const float3& pos,
+	const float radius,
+	CUnit* const* units, size_t numUnits,
+	CFeature* const* features, size_t numFeatures,
+	CPlasmaRepulser* const* repulsers, size_t numRepulsers,
+	std::vector<CUnit*>& unitsOut,
+	std::vector<CFeature*>& featuresOut,
+	std::vector<CPlasmaRepulser*>& repulsersOut
+) {
+	for (size_t i = 0; i < numUnits; i++) {
+		if (!UnitOutOfColVolRange(units[i], pos, radius))
+			unitsOut.push_back(units[i]);
+	}
+
+	for (size_t i = 0; i < numFeatures; i++) {
+		if (!FeatureOutOfColVolRange(features[i], pos, radius))
+			featuresOut.push_back(features[i]);
+	}
+
+	for (size_t i = 0; i < numRepulsers; i++) {
+		if (!RepulserOutOfColVolRange(repulsers[i], pos, radius))
+			repulsersOut.push_back(repulsers[i]);
+	}
+}
 #endif // UNIT_TEST
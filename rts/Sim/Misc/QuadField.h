@@ -97,6 +97,11 @@ public:
 	void GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, const float3& maxs);
 	void GetQuadsOnRay(QuadFieldQuery& qfq, const float3& start, const float3& dir, float length);
 
+	/**
+	 * Dedups through the per-thread tags of the calling thread, so (like
+	 * NoSolidsExact) it can be called from ThreadPool workers as long as
+	 * no mutator runs concurrently.
+	 */
 	void GetUnitsAndFeaturesColVol(
 		const float3& pos,
 		const float radius,
@@ -105,6 +110,55 @@ public:
 		std::vector<CPlasmaRepulser*>* repulsers = nullptr
 	);
 
+	/**
+	 * Unfiltered counterpart of GetUnitsAndFeaturesColVol for parallel
+	 * pre-passes: appends the quads overlapping the query circle and every
+	 * unit, feature and repulser registered in them (without the distance
+	 * tests, see FilterUnitsAndFeaturesColVol) in the same order the serial
+	 * query would visit them. Must not run concurrently with any mutator.
+	 */
+	void GatherUnitsAndFeaturesColVol(
+		int tid,
+		const float3& pos,
+		const float radius,
+		std::vector<int>& quads,
+		std::vector<CUnit*>& units,
+		std::vector<CFeature*>& features,
+		std::vector<CPlasmaRepulser*>& repulsers
+	);
+	/**
+	 * Applies the distance tests of GetUnitsAndFeaturesColVol to the
+	 * (unfiltered) candidates of GatherUnitsAndFeaturesColVol, appending
+	 * the survivors to the output vectors
+	 */
+	static void FilterUnitsAndFeaturesColVol(
+		const float3& pos,
+		const float radius,
+		CUnit* const* units, size_t numUnits,
+		CFeature* const* features, size_t numFeatures,
+		CPlasmaRepulser* const* repulsers, size_t numRepulsers,
+		std::vector<CUnit*>& unitsOut,
+		std::vector<CFeature*>& featuresOut,
+		std::vector<CPlasmaRepulser*>& repulsersOut
+	);
+
+	/**
+	 * Every change to the unit, feature or repulser lists of a quad stamps
+	 * it with a new (strictly increasing) value; results gathered when the
+	 * global stamp was <stamp> are still valid iff none of the quads they
+	 * came from has a newer one
+	 */
+	uint64_t GetQuadStamp() const { return quadStamp; }
+	uint64_t GetQuadStampAt(int qi) const { return quadStamps[qi]; }
+	bool QuadsModifiedSince(const int* quads, size_t numQuads, uint64_t stamp) const {
+		for (size_t i = 0; i < numQuads; i++) {
+			if (quadStamps[quads[i]] > stamp)
+				return true;
+		}
+
+		return false;
+	}
+
 	/**
 	 * Returns all units within @c radius of @c pos,
 	 * and treats each unit as a 3D point object
@@ -144,6 +198,7 @@ public:
 		const unsigned int collisionStateBits = 0xFFFFFFFF
 	);
 
+	/// safe to call from ThreadPool workers, see GetUnitsAndFeaturesColVol
 	bool NoSolidsExact(
 		const float3& pos,
 		const float radius,
@@ -165,6 +220,14 @@ public:
 	void AddProjectile(CProjectile* projectile);
 	void RemoveProjectile(CProjectile* projectile);
 
+	/**
+	 * Batched alternative to MovedProjectile: the projectile is relinked
+	 * on the next FlushMovedProjectiles, which every projectile query and
+	 * insertion or removal does implicitly (so the deferral is invisible)
+	 */
+	void DeferMovedProjectile(CProjectile* projectile) { movedProjectiles.push_back(projectile); }
+	void FlushMovedProjectiles();
+
 	void MovedRepulser(CPlasmaRepulser* repulser);
 	void RemoveRepulser(CPlasmaRepulser* repulser);
 
@@ -238,6 +301,8 @@ private:
 	int2 WorldPosToQuadField(const float3 p) const;
 	int WorldPosToQuadFieldIdx(const float3 p) const;
 
+	void StampQuad(int qi) { quadStamps[qi] = ++quadStamp; }
+
 private:
 	std::vector<Quad> baseQuads;
 
@@ -248,6 +313,13 @@ private:
 	std::array< QueryVectorCache<CSolidObject*>, ThreadPool::MAX_THREADS > tempSolids;
 	std::array< QueryVectorCache<int>, ThreadPool::MAX_THREADS > tempQuads;
 
+	// state for DeferMovedProjectile
+	std::vector<CProjectile*> movedProjectiles;
+
+	// per-quad modification stamps, see QuadsModifiedSince
+	std::vector<uint64_t> quadStamps;
+	uint64_t quadStamp = 0;
+
 	float2 invQuadSize;
 
 	int numQuadsX;
@@ -380,13 +380,6 @@ public:
 	///< mobility information about this object (if NULL, object is either static or aircraft)
 	MoveDef* moveDef = nullptr;
 
-	LocalModel localModel;
-	CollisionVolume collisionVolume;
-	CollisionVolume selectionVolume;
-
-	///< pieces that were last hit by a {[0] := unsynced, [1] := synced} projectile
-	const LocalModelPiece* hitModelPieces[2];
-
 	///< object-local {z,x,y}-axes (in WS)
 	SyncedFloat3 frontdir =  FwdVector;
 	SyncedFloat3 rightdir = -RgtVector;
@@ -414,6 +407,19 @@ public:
 
 	bool objectUsable = true;
 
+	// NOTE:
+	//   the members above are read by the per-frame movement and physics
+	//   loops, those below are bulky and only accessed by less frequent
+	//   code (hit tests, piece scripts, Lua); keep them in this order so
+	//   the hot state of a unit or feature spans as few cache lines as
+	//   possible
+	LocalModel localModel;
+	CollisionVolume collisionVolume;
+	CollisionVolume selectionVolume;
+
+	///< pieces that were last hit by a {[0] := unsynced, [1] := synced} projectile
+	const LocalModelPiece* hitModelPieces[2];
+
 	/**
 	 * @brief mod controlled parameters
 	 * This is a set of parameters that is initialized
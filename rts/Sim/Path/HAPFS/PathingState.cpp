@@ -2,8 +2,7 @@
 
 #include "PathingState.h"
 
-#include "zlib.h"
-#include "minizip/zip.h"
+#include <fstream>
 
 #include "Game/GlobalUnsynced.h"
 #include "Game/LoadScreen.h"
@@ -21,13 +20,13 @@
 #include "PathMemPool.h"
 
 #include "System/Config/ConfigHandler.h"
-#include "System/FileSystem/Archives/IArchive.h"
-#include "System/FileSystem/ArchiveLoader.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/MemoryMappedFile.h"
 #include "System/Platform/Threading.h"
 #include "System/StringUtil.h"
+#include "System/Sync/SHA512.hpp"
 #include "System/Threading/ThreadPool.h" // for_mt
 
 #include "System/Misc/TracyDefs.h"
@@ -53,7 +52,32 @@ static const std::string GetPathCacheDir() {
 
 static const std::string GetCacheFileName(const std::string& fileHashCode, const std::string& peFileName, const std::string& mapFileName) {
 	RECOIL_DETAILED_TRACY_ZONE;
-	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".zip");
+	return (GetPathCacheDir() + mapFileName + "." + peFileName + "-" + fileHashCode + ".bin");
+}
+
+static constexpr std::uint32_t CACHE_FILE_MAGIC = 0x31434550; // "PEC1"
+static constexpr size_t CACHE_CHUNK_ALIGNMENT = 64;
+
+// layout: header | offsets[0] | costs[0] | ... | offsets[N-1] | costs[N-1],
+// each section padded to CACHE_CHUNK_ALIGNMENT bytes
+struct CacheFileHeader {
+	std::uint32_t magic;
+	std::uint32_t hashCode;
+	std::uint32_t numPathTypes;
+	std::uint32_t offsetsSize;
+	std::uint32_t costsSize;
+};
+
+static constexpr size_t AlignCacheChunk(size_t size) {
+	return ((size + CACHE_CHUNK_ALIGNMENT - 1) & ~(CACHE_CHUNK_ALIGNMENT - 1));
+}
+
+static size_t GetCacheChunkOffset(unsigned int pathType, size_t offsetsSize, size_t costsSize) {
+	return (AlignCacheChunk(sizeof(CacheFileHeader)) + pathType * (AlignCacheChunk(offsetsSize) + AlignCacheChunk(costsSize)));
+}
+
+static size_t GetCacheFileSize(unsigned int numPathTypes, size_t offsetsSize, size_t costsSize) {
+	return (GetCacheChunkOffset(numPathTypes, offsetsSize, costsSize));
 }
 
 void PathingState::KillStatic() { pathingStates = 0; }
@@ -503,9 +527,10 @@ bool PathingState::ReadFile(const std::string& peFileName, const std::string& ma
 	if (!FileSystem::FileExists(cacheFileName))
 		return false;
 
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
+	CMemoryMappedFile file(dataDirsAccess.LocateFile(cacheFileName));
 
-	if (upfile == nullptr || !upfile->IsOpen()) {
+	if (!file.IsOpen() || file.GetSize() < sizeof(CacheFileHeader)) {
+		file.Close();
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
@@ -514,46 +539,36 @@ bool PathingState::ReadFile(const std::string& peFileName, const std::string& ma
 	sprintf(calcMsg, "Reading Estimate PathCosts [%d]", BLOCK_SIZE);
 	loadscreen->SetLoadMessage(calcMsg);
 
-	const unsigned fid = upfile->FindFile("pathinfo");
-	if (fid >= upfile->NumFiles()) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
-
-	std::vector<std::uint8_t> buffer;
-
-	if (!upfile->GetFile(fid, buffer) || buffer.size() < 4) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	const unsigned int numPathTypes = moveDefHandler.GetNumMoveDefs();
+	const unsigned int offsetsSize = blockStates.GetSize() * sizeof(short2);
+	const unsigned int costsSize = blockStates.GetSize() * PATH_DIRECTION_VERTICES * sizeof(float);
 
-	const unsigned int filehash = *(reinterpret_cast<unsigned int*>(&buffer[0]));
-	const unsigned int blockSize = blockStates.GetSize() * sizeof(short2);
-	unsigned int pos = sizeof(unsigned);
+	CacheFileHeader header;
+	std::memcpy(&header, file.GetData(), sizeof(header));
 
-	if (filehash != fileHashCode) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+	const bool validHeader =
+		(header.magic == CACHE_FILE_MAGIC) &&
+		(header.hashCode == fileHashCode) &&
+		(header.numPathTypes == numPathTypes) &&
+		(header.offsetsSize == offsetsSize) &&
+		(header.costsSize == costsSize) &&
+		(file.GetSize() == GetCacheFileSize(numPathTypes, offsetsSize, costsSize));
 
-	if (buffer.size() < (pos + blockSize * moveDefHandler.GetNumMoveDefs())) {
+	if (!validHeader) {
+		file.Close();
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	// read center-offset data
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		std::memcpy(&blockStates.peNodeOffsets[pathType][0], &buffer[pos], blockSize);
-		pos += blockSize;
-	}
+	// every path-type occupies its own aligned chunk, so they are copied out
+	// of the mapping independently and only the pages actually read are paged in
+	for_mt(0, numPathTypes, [&](const int pathType) {
+		const std::uint8_t* chunk = file.GetData() + GetCacheChunkOffset(pathType, offsetsSize, costsSize);
 
-	// read vertex-cost data
-	if (buffer.size() < (pos + vertexCosts.size() * sizeof(float))) {
-		FileSystem::Remove(cacheFileName);
-		return false;
-	}
+		std::memcpy(&blockStates.peNodeOffsets[pathType][0], chunk, offsetsSize);
+		std::memcpy(&vertexCosts[pathType * blockStates.GetSize() * PATH_DIRECTION_VERTICES], chunk + AlignCacheChunk(offsetsSize), costsSize);
+	});
 
-	std::memcpy(&vertexCosts[0], &buffer[pos], vertexCosts.size() * sizeof(float));
 	return true;
 }
 
@@ -574,37 +589,45 @@ bool PathingState::WriteFile(const std::string& peFileName, const std::string& m
 	LOG("[PathEstimator::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
 
 	// open file for writing in a suitable location
-	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
+	std::ofstream ofs(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE), std::ios::out | std::ios::binary | std::ios::trunc);
 
-	if (file == nullptr)
+	if (!ofs.good())
 		return false;
 
-	zipOpenNewFileInZip(file, "pathinfo", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_COMPRESSION);
+	const unsigned int numPathTypes = moveDefHandler.GetNumMoveDefs();
+	const unsigned int offsetsSize = blockStates.GetSize() * sizeof(short2);
+	const unsigned int costsSize = blockStates.GetSize() * PATH_DIRECTION_VERTICES * sizeof(float);
 
-	// write hash-code (NOTE: this also affects the CRC!)
-	zipWriteInFileInZip(file, (const void*) &fileHashCode, 4);
+	CacheFileHeader header = {};
+	header.magic = CACHE_FILE_MAGIC;
+	header.hashCode = fileHashCode;
+	header.numPathTypes = numPathTypes;
+	header.offsetsSize = offsetsSize;
+	header.costsSize = costsSize;
 
-	// write center-offsets
-	for (int pathType = 0; pathType < moveDefHandler.GetNumMoveDefs(); ++pathType) {
-		zipWriteInFileInZip(file, (const void*) &blockStates.peNodeOffsets[pathType][0], blockStates.peNodeOffsets[pathType].size() * sizeof(short2));
-	}
+	const std::array<char, CACHE_CHUNK_ALIGNMENT> padding = {};
 
-	// write vertex-costs
-	zipWriteInFileInZip(file, vertexCosts.data(), vertexCosts.size() * sizeof(float));
+	const auto WritePadded = [&](const void* data, size_t size) {
+		ofs.write(reinterpret_cast<const char*>(data), size);
+		ofs.write(padding.data(), AlignCacheChunk(size) - size);
+	};
 
-	zipCloseFileInZip(file);
-	zipClose(file, nullptr);
+	// write header, then offsets and vertex-costs chunk-wise per path-type
+	WritePadded(&header, sizeof(header));
 
+	for (unsigned int pathType = 0; pathType < numPathTypes; ++pathType) {
+		WritePadded(&blockStates.peNodeOffsets[pathType][0], offsetsSize);
+		WritePadded(&vertexCosts[pathType * blockStates.GetSize() * PATH_DIRECTION_VERTICES], costsSize);
+	}
 
-	// get the CRC over the written path data
-	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
+	ofs.close();
 
-	if (upfile == nullptr || !upfile->IsOpen()) {
+	// a partially written file fails the size-check in ReadFile
+	if (ofs.fail()) {
 		FileSystem::Remove(cacheFileName);
 		return false;
 	}
 
-	assert(upfile->FindFile("pathinfo") < upfile->NumFiles());
 	return true;
 }
 
@@ -28,6 +28,11 @@ namespace QTPFS {
 	struct SearchNode;
 	struct UpdateThreadData;
 
+	namespace NodeLayerCache {
+		struct WriteBuffer;
+		struct ReadBuffer;
+	}
+
 	struct INode {
 			friend SearchNode;
 	public:
@@ -83,7 +88,8 @@ namespace QTPFS {
 
 		void PreTesselate(NodeLayer& nl, const SRectangle& r, SRectangle& ur, unsigned int depth, const UpdateThreadData* threadData);
 		void Tesselate(NodeLayer& nl, const SRectangle& r, unsigned int depth, const UpdateThreadData* threadData);
-		void Serialize(std::fstream& fStream, NodeLayer& nodeLayer, unsigned int* streamSize, unsigned int depth, bool readMode);
+		void WriteCache(NodeLayerCache::WriteBuffer& buf) const;
+		bool ReadCache(NodeLayerCache::ReadBuffer& buf);
 
 		bool IsLeaf() const { return (childBaseIndex == -1u); }
 		bool CanSplit(unsigned int depth, bool forced) const;
@@ -22,6 +22,7 @@ inline int __bsfd (int mask)
 #include "NodeLayer.h"
 #include "PathManager.h"
 #include "Node.h"
+#include "NodeLayerCache.h"
 
 #include "Map/MapInfo.h"
 #include "Sim/Misc/ModInfo.h"
@@ -81,8 +82,177 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 
 void QTPFS::NodeLayer::Clear() {
 	RECOIL_DETAILED_TRACY_ZONE;
+	for (auto& chunk: poolNodes) {
+		chunk.clear();
+	}
+
+	nodeIndcs.clear();
 	curSpeedMods.clear();
 	curSpeedBins.clear();
+
+	layerNumber = 0;
+	numLeafNodes = 0;
+	updateCounter = 0;
+	numOpenNodes = 0;
+	numClosedNodes = 0;
+
+	maxNodesAlloced = 0;
+	numRootNodes = 0;
+	xRootNodes = 0;
+	zRootNodes = 0;
+	rootNodeSize = 0;
+	rootMask = 0;
+
+	xsize = 0;
+	zsize = 0;
+
+	maxRelSpeedMod = 0.0f;
+	avgRelSpeedMod = 0.0f;
+}
+
+
+void QTPFS::NodeLayer::WriteCache(NodeLayerCache::WriteBuffer& buf) const {
+	RECOIL_DETAILED_TRACY_ZONE;
+	buf.Write(layerNumber);
+	buf.Write(numLeafNodes);
+	buf.Write(updateCounter);
+	buf.Write(numOpenNodes);
+	buf.Write(numClosedNodes);
+
+	buf.Write(maxNodesAlloced);
+	buf.Write(numRootNodes);
+	buf.Write(xRootNodes);
+	buf.Write(zRootNodes);
+	buf.Write(rootNodeSize);
+	buf.Write(rootMask);
+
+	buf.Write(xsize);
+	buf.Write(zsize);
+
+	buf.Write(maxRelSpeedMod);
+	buf.Write(avgRelSpeedMod);
+
+	buf.WriteArray(curSpeedMods.data(), curSpeedMods.size());
+	buf.WriteArray(curSpeedBins.data(), curSpeedBins.size());
+
+	{
+		// the free-list starts out as [POOL_TOTAL_SIZE - 1, ..., 0] and only its
+		// tail changes, so store the length of the untouched prefix instead of
+		// the ~2MB of indices it consists of
+		std::uint32_t numOrderedIndcs = 0;
+
+		while (numOrderedIndcs < nodeIndcs.size() && nodeIndcs[numOrderedIndcs] == (POOL_TOTAL_SIZE - 1 - numOrderedIndcs)) {
+			numOrderedIndcs++;
+		}
+
+		buf.Write(std::uint32_t(nodeIndcs.size()));
+		buf.Write(numOrderedIndcs);
+		buf.WriteArray(nodeIndcs.data() + numOrderedIndcs, nodeIndcs.size() - numOrderedIndcs);
+	}
+
+	// only nodes below maxNodesAlloced were ever Init'ed, the rest of each
+	// chunk is still default-constructed and gets recreated as such on load
+	for (unsigned int i = 0; i < NUM_POOL_CHUNKS; i++) {
+		const unsigned int chunkBase = i * POOL_CHUNK_SIZE;
+		const unsigned int numNodes = std::clamp(int(maxNodesAlloced - chunkBase), 0, int(POOL_CHUNK_SIZE));
+
+		buf.Write(std::uint8_t(!poolNodes[i].empty()));
+
+		if (poolNodes[i].empty())
+			continue;
+
+		for (unsigned int j = 0; j < numNodes; j++) {
+			poolNodes[i][j].WriteCache(buf);
+		}
+	}
+}
+
+bool QTPFS::NodeLayer::ReadCache(NodeLayerCache::ReadBuffer& buf) {
+	RECOIL_DETAILED_TRACY_ZONE;
+	unsigned int cachedLayerNumber = 0;
+
+	if (!buf.Read(cachedLayerNumber) || cachedLayerNumber != layerNumber)
+		return false;
+
+	bool ok = true;
+
+	ok = ok && buf.Read(numLeafNodes);
+	ok = ok && buf.Read(updateCounter);
+	ok = ok && buf.Read(numOpenNodes);
+	ok = ok && buf.Read(numClosedNodes);
+
+	ok = ok && buf.Read(maxNodesAlloced);
+	ok = ok && buf.Read(numRootNodes);
+	ok = ok && buf.Read(xRootNodes);
+	ok = ok && buf.Read(zRootNodes);
+	ok = ok && buf.Read(rootNodeSize);
+	ok = ok && buf.Read(rootMask);
+
+	ok = ok && buf.Read(xsize);
+	ok = ok && buf.Read(zsize);
+
+	ok = ok && buf.Read(maxRelSpeedMod);
+	ok = ok && buf.Read(avgRelSpeedMod);
+
+	if (!ok || xsize != unsigned(mapDims.mapx) || zsize != unsigned(mapDims.mapy))
+		return false;
+	if (maxNodesAlloced < numRootNodes || maxNodesAlloced > int32_t(POOL_TOTAL_SIZE))
+		return false;
+
+	curSpeedMods.resize(xsize * zsize);
+	curSpeedBins.resize(xsize * zsize);
+
+	if (!buf.ReadArray(curSpeedMods.data(), curSpeedMods.size()) || !buf.ReadArray(curSpeedBins.data(), curSpeedBins.size()))
+		return false;
+
+	{
+		std::uint32_t numIndcs = 0;
+		std::uint32_t numOrderedIndcs = 0;
+
+		if (!buf.Read(numIndcs) || !buf.Read(numOrderedIndcs))
+			return false;
+		if (numIndcs > POOL_TOTAL_SIZE || numOrderedIndcs > numIndcs)
+			return false;
+
+		nodeIndcs.resize(numIndcs);
+
+		for (std::uint32_t i = 0; i < numOrderedIndcs; i++) {
+			nodeIndcs[i] = POOL_TOTAL_SIZE - 1 - i;
+		}
+
+		if (!buf.ReadArray(nodeIndcs.data() + numOrderedIndcs, numIndcs - numOrderedIndcs))
+			return false;
+	}
+
+	for (unsigned int i = 0; i < NUM_POOL_CHUNKS; i++) {
+		const unsigned int chunkBase = i * POOL_CHUNK_SIZE;
+		const unsigned int numNodes = std::clamp(int(maxNodesAlloced - chunkBase), 0, int(POOL_CHUNK_SIZE));
+
+		std::uint8_t allocated = 0;
+
+		if (!buf.Read(allocated))
+			return false;
+
+		poolNodes[i].clear();
+
+		if (allocated == 0)
+			continue;
+
+		poolNodes[i].resize(POOL_CHUNK_SIZE);
+
+		for (unsigned int j = 0; j < numNodes; j++) {
+			QTNode& node = poolNodes[i][j];
+
+			if (!node.ReadCache(buf))
+				return false;
+
+			// guard the tree-walks done by the caller's checksum validation
+			if (!node.IsLeaf() && (node.GetChildBaseIndex() + QTNODE_CHILD_COUNT) > (unsigned int) maxNodesAlloced)
+				return false;
+		}
+	}
+
+	return true;
 }
 
 
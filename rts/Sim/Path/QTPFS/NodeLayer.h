@@ -42,6 +42,9 @@ namespace QTPFS {
 		void Init(unsigned int layerNum);
 		void Clear();
 
+		void WriteCache(NodeLayerCache::WriteBuffer& buf) const;
+		bool ReadCache(NodeLayerCache::ReadBuffer& buf);
+
 		bool Update(UpdateThreadData& threadData);
 
 		void ExecNodeNeighborCacheUpdates(const SRectangle& ur, UpdateThreadData& threadData);
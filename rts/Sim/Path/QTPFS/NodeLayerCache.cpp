@@ -0,0 +1,255 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <algorithm>
+#include <fstream>
+
+#include "NodeLayerCache.h"
+#include "NodeLayer.h"
+#include "Node.h"
+
+#include "Game/GameSetup.h"
+#include "Map/MapInfo.h"
+#include "Map/ReadMap.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "Sim/Misc/GroundBlockingObjectMap.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
+#include "Sim/Objects/SolidObject.h"
+#include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/FileSystem.h"
+#include "System/FileSystem/MemoryMappedFile.h"
+#include "System/Log/ILog.h"
+#include "System/Sync/SHA512.hpp"
+
+#include "System/Misc/TracyDefs.h"
+
+namespace QTPFS::NodeLayerCache {
+	static constexpr std::uint32_t CACHE_MAGIC = 0x43505451; // "QTPC"
+	static constexpr std::uint32_t KEY_LENGTH = 16;
+	// files of the same map with other keys (game updates, modoptions, ...)
+	// are evicted on write, only this many of the newest are kept around
+	static constexpr size_t MAX_FILES_PER_MAP = 4;
+
+	struct FileHeader {
+		std::uint32_t magic;
+		std::uint32_t version;
+		// same as the hash in the file-name
+		char key[KEY_LENGTH];
+
+		std::uint32_t numLayers;
+		std::uint32_t mapx;
+		std::uint32_t mapy;
+		std::uint32_t pad;
+
+		// sum over all layer root-nodes (see PathManager::Load) at write-time,
+		// compared against the sum over the loaded trees as the final check
+		std::uint64_t treeCheckSum;
+		std::uint64_t dataSize;
+	};
+
+
+	static std::string GetCacheDir() {
+		return (FileSystem::GetCacheDir() + FileSystemAbstraction::GetNativePathSeparator() + "paths" + FileSystemAbstraction::GetNativePathSeparator());
+	}
+
+	template<typename T> static void AppendKey(sha512::msg_vector& key, const T& v) {
+		const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&v);
+		key.insert(key.end(), p, p + sizeof(T));
+	}
+
+	static void CalcKeyDigest(std::uint32_t rootSize, sha512::raw_digest& keyDigest) {
+		RECOIL_DETAILED_TRACY_ZONE;
+		const auto& pfsConsts = mapInfo->pfs.qtpfs_constants;
+
+		sha512::msg_vector key;
+		key.reserve(1024);
+
+		AppendKey(key, CACHE_VERSION);
+		AppendKey(key, archiveScanner->GetArchiveCompleteChecksumBytes(gameSetup->mapName));
+		AppendKey(key, archiveScanner->GetArchiveCompleteChecksumBytes(gameSetup->modName));
+
+		// map- and modoptions (or Lua) can change any of these without touching the archives
+		AppendKey(key, readMap->CalcHeightmapChecksum());
+		AppendKey(key, readMap->CalcTypemapChecksum());
+		AppendKey(key, moveDefHandler.GetCheckSum());
+		AppendKey(key, moveDefHandler.GetNumMoveDefs());
+
+		AppendKey(key, mapDims.mapx);
+		AppendKey(key, mapDims.mapy);
+		AppendKey(key, rootSize);
+		AppendKey(key, pfsConsts.minNodeSizeX);
+		AppendKey(key, pfsConsts.minNodeSizeZ);
+		AppendKey(key, pfsConsts.maxNodeDepth);
+		AppendKey(key, pfsConsts.numSpeedModBins);
+		AppendKey(key, pfsConsts.minSpeedModVal);
+		AppendKey(key, pfsConsts.maxSpeedModVal);
+
+		// objects placed before the pathing system initializes (map features,
+		// units spawned by gadgets) are tesselated into the initial layers
+		for (int sqr = 0, numSqrs = mapDims.mapx * mapDims.mapy; sqr < numSqrs; sqr++) {
+			const CGroundBlockingObjectMap::BlockingMapCell& cell = groundBlockingObjectMap.GetCellUnsafeConst(sqr);
+
+			for (size_t i = 0, n = cell.size(); i < n; i++) {
+				const CSolidObject* obj = cell[i];
+
+				AppendKey(key, sqr);
+				AppendKey(key, obj->id);
+				AppendKey(key, obj->pos);
+				AppendKey(key, obj->height);
+				AppendKey(key, obj->crushResistance);
+				AppendKey(key, obj->immobile);
+				AppendKey(key, obj->physicalState);
+				AppendKey(key, obj->collidableState);
+			}
+		}
+
+		sha512::calc_digest(key, keyDigest);
+	}
+
+
+	static void EvictFiles(const std::string& cacheFileName) {
+		RECOIL_DETAILED_TRACY_ZONE;
+		// map names can contain glob characters, so match the prefix by hand
+		const std::string prefix = mapInfo->map.name + ".qtpfs-";
+		const std::string keepName = FileSystem::GetFilename(cacheFileName);
+
+		std::vector<std::pair<unsigned int, std::string>> files;
+
+		for (const std::string& file: dataDirsAccess.FindFiles(GetCacheDir(), "*.qtpfs-*.bin")) {
+			const std::string name = FileSystem::GetFilename(file);
+
+			if (name.compare(0, prefix.size(), prefix) != 0 || name == keepName)
+				continue;
+
+			files.emplace_back(FileSystemAbstraction::GetFileModificationTime(dataDirsAccess.LocateFile(file)), file);
+		}
+
+		// the file just written is one of those kept
+		if (files.size() < MAX_FILES_PER_MAP)
+			return;
+
+		std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return (a.first > b.first); });
+
+		for (size_t i = MAX_FILES_PER_MAP - 1; i < files.size(); i++) {
+			LOG("[QTPFS::NodeLayerCache::%s] removing old cache-file \"%s\"", __func__, files[i].second.c_str());
+			FileSystem::Remove(dataDirsAccess.LocateFile(files[i].second, FileQueryFlags::WRITE));
+		}
+	}
+
+
+	std::string GetFileName(const std::string& hashHexString) {
+		return (GetCacheDir() + mapInfo->map.name + ".qtpfs-" + hashHexString + ".bin");
+	}
+
+	std::string CalcHashHexString(std::uint32_t rootSize) {
+		sha512::raw_digest keyDigest;
+		sha512::hex_digest keyDigestHex;
+
+		CalcKeyDigest(rootSize, keyDigest);
+		sha512::dump_digest(keyDigest, keyDigestHex);
+
+		// 64 bits are plenty to tell cache-files apart
+		return (std::string(keyDigestHex.data(), KEY_LENGTH));
+	}
+
+
+	bool Read(std::vector<NodeLayer>& nodeLayers, const std::string& hashHexString, std::uint64_t& treeCheckSum) {
+		RECOIL_DETAILED_TRACY_ZONE;
+		const std::string cacheFileName = GetFileName(hashHexString);
+
+		LOG("[QTPFS::NodeLayerCache::%s] hash=%s file=\"%s\" (exists=%d)", __func__, hashHexString.c_str(), cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
+
+		if (!FileSystem::FileExists(cacheFileName))
+			return false;
+
+		CMemoryMappedFile file(dataDirsAccess.LocateFile(cacheFileName));
+		FileHeader header;
+
+		ReadBuffer buf(file.GetData(), file.GetData() + file.GetSize());
+
+		if (!file.IsOpen() || !buf.Read(header))
+			return false;
+
+		bool valid = true;
+
+		// cheap checks first, the payload is only touched if all of these pass
+		valid = valid && (header.magic == CACHE_MAGIC);
+		valid = valid && (header.version == CACHE_VERSION);
+		valid = valid && (hashHexString.compare(0, KEY_LENGTH, header.key, KEY_LENGTH) == 0);
+		valid = valid && (header.numLayers == nodeLayers.size());
+		valid = valid && (header.mapx == unsigned(mapDims.mapx) && header.mapy == unsigned(mapDims.mapy));
+		valid = valid && (header.dataSize == buf.Remaining());
+
+		if (!valid) {
+			LOG_L(L_WARNING, "[QTPFS::NodeLayerCache::%s] stale or truncated cache-file \"%s\"", __func__, cacheFileName.c_str());
+			file.Close();
+			FileSystem::Remove(cacheFileName);
+			return false;
+		}
+
+		for (NodeLayer& nodeLayer: nodeLayers) {
+			if (nodeLayer.ReadCache(buf))
+				continue;
+
+			LOG_L(L_WARNING, "[QTPFS::NodeLayerCache::%s] corrupt data for layer %d in \"%s\"", __func__, nodeLayer.GetNodelayer(), cacheFileName.c_str());
+			file.Close();
+			FileSystem::Remove(cacheFileName);
+			return false;
+		}
+
+		treeCheckSum = header.treeCheckSum;
+		return true;
+	}
+
+	bool Write(const std::vector<NodeLayer>& nodeLayers, const std::string& hashHexString, std::uint64_t treeCheckSum) {
+		RECOIL_DETAILED_TRACY_ZONE;
+		// we need this directory to exist
+		if (!FileSystem::CreateDirectory(GetCacheDir()))
+			return false;
+
+		const std::string cacheFileName = GetFileName(hashHexString);
+
+		LOG("[QTPFS::NodeLayerCache::%s] hash=%s file=\"%s\"", __func__, hashHexString.c_str(), cacheFileName.c_str());
+
+		std::ofstream ofs(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!ofs.good())
+			return false;
+
+		FileHeader header = {};
+		header.magic = CACHE_MAGIC;
+		header.version = CACHE_VERSION;
+		header.numLayers = nodeLayers.size();
+		header.mapx = mapDims.mapx;
+		header.mapy = mapDims.mapy;
+		header.treeCheckSum = treeCheckSum;
+
+		hashHexString.copy(header.key, KEY_LENGTH);
+
+		// dataSize is patched in once all layers are written; a file that was
+		// cut short (crash, full disk) will therefore never pass validation
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		// serialize one layer at a time, the whole set can run into hundreds of MB
+		std::vector<std::uint8_t> data;
+		WriteBuffer buf(data);
+
+		for (const NodeLayer& nodeLayer: nodeLayers) {
+			data.clear();
+			nodeLayer.WriteCache(buf);
+
+			ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+			header.dataSize += data.size();
+		}
+
+		ofs.seekp(0);
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		if (!ofs.good())
+			return false;
+
+		EvictFiles(cacheFileName);
+		return true;
+	}
+}
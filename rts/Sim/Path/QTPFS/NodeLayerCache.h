@@ -0,0 +1,85 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef QTPFS_NODELAYERCACHE_H_
+#define QTPFS_NODELAYERCACHE_H_
+
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace QTPFS {
+	struct NodeLayer;
+
+	// on-disk cache of fully tesselated node-layers; the data is only reused
+	// when every input of the tesselation (terrain, movedefs, pfs constants,
+	// blocking objects present at init) hashes to the same key
+	namespace NodeLayerCache {
+		// bump whenever the serialized layout of NodeLayer or INode changes
+		// or the tesselation code starts producing different trees
+		static constexpr std::uint32_t CACHE_VERSION = 1;
+
+		struct WriteBuffer {
+		public:
+			WriteBuffer(std::vector<std::uint8_t>& buf): data(buf) {}
+
+			template<typename T> void Write(const T& v) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				WriteBytes(&v, sizeof(T));
+			}
+			template<typename T> void WriteArray(const T* v, size_t n) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				WriteBytes(v, n * sizeof(T));
+			}
+
+			void WriteBytes(const void* src, size_t n) {
+				const size_t pos = data.size();
+
+				data.resize(pos + n);
+				std::memcpy(data.data() + pos, src, n);
+			}
+
+		private:
+			std::vector<std::uint8_t>& data;
+		};
+
+		// NOTE: the source is usually a memory-mapped file, so reads are unaligned
+		struct ReadBuffer {
+		public:
+			ReadBuffer(const std::uint8_t* beg, const std::uint8_t* end): cur(beg), end(end) {}
+
+			template<typename T> bool Read(T& v) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				return (ReadBytes(&v, sizeof(T)));
+			}
+			template<typename T> bool ReadArray(T* v, size_t n) {
+				static_assert(std::is_trivially_copyable_v<T>);
+				return (n <= (Remaining() / sizeof(T)) && ReadBytes(v, n * sizeof(T)));
+			}
+
+			bool ReadBytes(void* dst, size_t n) {
+				if (n > Remaining())
+					return false;
+
+				std::memcpy(dst, cur, n);
+				cur += n;
+				return true;
+			}
+
+			size_t Remaining() const { return (end - cur); }
+
+		private:
+			const std::uint8_t* cur;
+			const std::uint8_t* end;
+		};
+
+		std::string GetFileName(const std::string& hashHexString);
+		std::string CalcHashHexString(std::uint32_t rootSize);
+
+		bool Read(std::vector<NodeLayer>& nodeLayers, const std::string& hashHexString, std::uint64_t& treeCheckSum);
+		bool Write(const std::vector<NodeLayer>& nodeLayers, const std::string& hashHexString, std::uint64_t treeCheckSum);
+	}
+}
+
+#endif
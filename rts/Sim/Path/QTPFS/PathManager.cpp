@@ -15,6 +15,7 @@
 
 #include "PathDefines.h"
 #include "PathManager.h"
+#include "NodeLayerCache.h"
 
 #include "Utils/PathSpeedModInfoSystemUtils.h"
 
@@ -57,6 +58,7 @@
 #define MAP_RECTANGLE SRectangle(0, 0,  mapDims.mapx, mapDims.mapy)
 
 CONFIG(int, PathingThreadCount).defaultValue(0).safemodeValue(1).minimumValue(0);
+CONFIG(bool, QTPFSNodeLayerCache).defaultValue(true).safemodeValue(false).description("Store tesselated QTPFS node-layers on disk and reuse them when map, game, movedefs and initial obstacles are unchanged.");
 
 namespace QTPFS {
 	struct PMLoadScreen {
@@ -322,7 +324,16 @@ void QTPFS::PathManager::Load() {
 		sha512::dump_digest(mapCheckSum, mapCheckSumHex);
 		sha512::dump_digest(modCheckSum, modCheckSumHex);
 
-		InitNodeLayersThreaded(MAP_RECTANGLE);
+		const bool useNodeLayerCache = configHandler->GetBool("QTPFSNodeLayerCache");
+		const std::string cacheHash = (useNodeLayerCache)? NodeLayerCache::CalcHashHexString(rootSize): "";
+
+		if (!useNodeLayerCache || !LoadNodeLayersCached(MAP_RECTANGLE, cacheHash)) {
+			InitNodeLayersThreaded(MAP_RECTANGLE);
+
+			if (useNodeLayerCache)
+				NodeLayerCache::Write(nodeLayers, cacheHash, CalcNodeLayersCheckSum());
+		}
+
 		PathSpeedModInfoSystem::Init();
 		RemoveDeadPathsSystem::Init();
 		RequeuePathsSystem::Init();
@@ -340,12 +351,9 @@ void QTPFS::PathManager::Load() {
 			// ((mapCheckSum[0] << 24) | (mapCheckSum[1] << 16) | (mapCheckSum[2] << 8) | (mapCheckSum[3] << 0)) ^
 			// ((modCheckSum[0] << 24) | (modCheckSum[1] << 16) | (modCheckSum[2] << 8) | (modCheckSum[3] << 0));
 
+		pfsCheckSum ^= CalcNodeLayersCheckSum();
+
 		for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
-			auto& nodeLayer = nodeLayers[layerNum];
-			for (int i = 0; i < nodeLayer.GetRootNodeCount(); ++i){
-				auto curRootNode = nodeLayer.GetPoolNode(i);
-				pfsCheckSum ^= curRootNode->GetCheckSum(nodeLayers[layerNum]);
-			}
 			maxAllocedNodes = std::max(nodeLayers[layerNum].GetMaxNodesAlloced(), maxAllocedNodes);
 		}
 
@@ -467,6 +475,46 @@ void QTPFS::PathManager::InitNodeLayersThreaded(const SRectangle& rect) {
 	streflop::streflop_init<streflop::Simple>();
 }
 
+bool QTPFS::PathManager::LoadNodeLayersCached(const SRectangle& rect, const std::string& cacheHash) {
+	RECOIL_DETAILED_TRACY_ZONE;
+	std::uint64_t cachedCheckSum = 0;
+
+	// root-nodes and static node parameters are set up as usual, everything
+	// produced by the (expensive) initial tesselation is then overwritten
+	for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
+		InitNodeLayer(layerNum, rect);
+		pathCache.SetLayerPathCount(layerNum, INITIAL_PATH_RESERVE);
+	}
+
+	if (NodeLayerCache::Read(nodeLayers, cacheHash, cachedCheckSum) && CalcNodeLayersCheckSum() == cachedCheckSum) {
+		char loadMsg[512] = {'\0'};
+		const char* fmtString = "[PathManager::%s] loaded %u node-layers from cache";
+		snprintf(loadMsg, sizeof(loadMsg), fmtString, __func__, nodeLayers.size());
+		pmLoadScreen.AddMessage(loadMsg);
+		return true;
+	}
+
+	// partially read layers must not leak into the regular initialization
+	for (NodeLayer& nodeLayer: nodeLayers) {
+		nodeLayer.Clear();
+	}
+
+	return false;
+}
+
+std::uint64_t QTPFS::PathManager::CalcNodeLayersCheckSum() const {
+	RECOIL_DETAILED_TRACY_ZONE;
+	std::uint64_t checkSum = 0;
+
+	for (const NodeLayer& nodeLayer: nodeLayers) {
+		for (int i = 0; i < nodeLayer.GetRootNodeCount(); ++i) {
+			checkSum ^= nodeLayer.GetPoolNode(i)->GetCheckSum(nodeLayer);
+		}
+	}
+
+	return checkSum;
+}
+
 void QTPFS::PathManager::InitRootSize(const SRectangle& r) {
 	RECOIL_DETAILED_TRACY_ZONE;
 	// setup the root node system
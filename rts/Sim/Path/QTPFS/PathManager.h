@@ -118,6 +118,8 @@ namespace QTPFS {
 
 		void InitNodeLayersThreaded(const SRectangle& rect);
 		void InitNodeLayer(unsigned int layerNum, const SRectangle& r);
+		bool LoadNodeLayersCached(const SRectangle& rect, const std::string& cacheHash);
+		std::uint64_t CalcNodeLayersCheckSum() const;
 		void InitRootSize(const SRectangle& r);
 		void UpdateNodeLayer(unsigned int layerNum, const SRectangle& r, int currentThread);
 
@@ -0,0 +1,372 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+#include "ExplosionGenerator.h"
+#include "Game/GlobalUnsynced.h" // guRNG
+#include "System/float3.h"
+#include "System/SafeUtil.h"
+#include "System/SpringMath.h"
+
+#include "System/Misc/TracyDefs.h"
+
+void CCustomExplosionGenerator::CompileExplosionCode(ProjectileSpawnInfo* psi, const std::string& code)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// Turns the byte-code produced by ParseExplosionCode into a list of
+	// pre-decoded ops, evaluating every operation whose inputs are known
+	// at load-time: values start at zero after each store, so properties
+	// like "3" or "0.5 0.25" become single constant stores and only the
+	// random, damage and index dependent tails remain to be executed per
+	// explosion. Folded ops are evaluated in the same order and with the
+	// same functions as at runtime, so results do not change.
+	std::vector<SpawnOp>& program = psi->program;
+
+	float knownBuffers[NUM_BUFFERS];
+	bool isKnownBuffer[NUM_BUFFERS];
+
+	std::fill(std::begin(knownBuffers), std::end(knownBuffers), 0.0f);
+	std::fill(std::begin(isKnownBuffer), std::end(isKnownBuffer), true);
+
+	// value of the accumulator while it is known at load-time
+	float knownVal = 0.0f;
+	bool isKnownVal = true;
+
+	void* ptr = nullptr;
+
+	program.clear();
+	psi->usesBuffers = false;
+
+	const auto EmitOp = [&](std::uint8_t op, float arg = 0.0f, int slot = 0) {
+		SpawnOp& sop = program.emplace_back();
+		sop.op = op;
+		sop.arg = arg;
+		sop.slot = slot;
+		return &sop;
+	};
+	// switch from folding to runtime evaluation of the accumulator
+	const auto EmitLoad = [&]() {
+		if (!isKnownVal)
+			return;
+
+		EmitOp(OP_LOADC, knownVal);
+		isKnownVal = false;
+	};
+
+	const char* cur = code.data();
+	const char* end = code.data() + code.size();
+
+	const auto ReadFloat = [&]() { float  v; std::memcpy(&v, cur, sizeof(v)); cur += sizeof(v); return v; };
+	const auto ReadInt   = [&]() { int    v; std::memcpy(&v, cur, sizeof(v)); cur += sizeof(v); return v; };
+	const auto ReadPtr   = [&]() { void*  v; std::memcpy(&v, cur, sizeof(v)); cur += sizeof(v); return v; };
+	const auto ReadU16   = [&]() { std::uint16_t v; std::memcpy(&v, cur, sizeof(v)); cur += sizeof(v); return v; };
+
+	while (cur < end) {
+		const char opcode = *(cur++);
+
+		switch (opcode) {
+			case OP_END: {
+				return;
+			}
+			case OP_STOREI:
+			case OP_STOREF: {
+				const std::uint8_t  size   = *(cur++);
+				const std::uint16_t offset = ReadU16();
+
+				SpawnOp* sop = nullptr;
+
+				if (isKnownVal) {
+					sop = EmitOp((opcode == OP_STOREI)? OP_STOREIC: OP_STOREFC, knownVal);
+				} else {
+					sop = EmitOp(opcode);
+				}
+
+				sop->size = size;
+				sop->offset = offset;
+
+				knownVal = 0.0f;
+				isKnownVal = true;
+			} break;
+
+			case OP_ADD: {
+				const float v = ReadFloat();
+
+				if (isKnownVal) {
+					knownVal += v;
+				} else {
+					EmitOp(OP_ADD, v);
+				}
+			} break;
+			case OP_RAND:
+			case OP_DAMAGE:
+			case OP_INDEX: {
+				EmitLoad();
+				EmitOp(opcode, ReadFloat());
+			} break;
+
+			case OP_LOADP: {
+				ptr = ReadPtr();
+			} break;
+			case OP_STOREP: {
+				SpawnOp* sop = EmitOp(OP_STOREP);
+				sop->offset = ReadU16();
+				sop->ptr = ptr;
+				ptr = nullptr;
+			} break;
+			case OP_DIR: {
+				EmitOp(OP_DIR)->offset = ReadU16();
+			} break;
+
+			case OP_SAWTOOTH: {
+				const float v = ReadFloat();
+
+				if (isKnownVal) {
+					knownVal -= v * math::floor(knownVal / v);
+				} else {
+					EmitOp(opcode, v);
+				}
+			} break;
+			case OP_DISCRETE: {
+				const float v = ReadFloat();
+
+				if (isKnownVal) {
+					knownVal = v * math::floor(spring::SafeDivide(knownVal, v));
+				} else {
+					EmitOp(opcode, v);
+				}
+			} break;
+			case OP_SINE: {
+				const float v = ReadFloat();
+
+				if (isKnownVal) {
+					knownVal = v * math::sin(knownVal);
+				} else {
+					EmitOp(opcode, v);
+				}
+			} break;
+			case OP_POW: {
+				const float v = ReadFloat();
+
+				if (isKnownVal) {
+					knownVal = math::pow(knownVal, v);
+				} else {
+					EmitOp(opcode, v);
+				}
+			} break;
+
+			case OP_YANK: {
+				const int slot = ReadInt();
+
+				if ((isKnownBuffer[slot] = isKnownVal)) {
+					knownBuffers[slot] = knownVal;
+				} else {
+					EmitOp(opcode, 0.0f, slot);
+					psi->usesBuffers = true;
+				}
+
+				knownVal = 0.0f;
+				isKnownVal = true;
+			} break;
+			case OP_MULTIPLY: {
+				const int slot = ReadInt();
+
+				if (!isKnownBuffer[slot]) {
+					EmitLoad();
+					EmitOp(opcode, 0.0f, slot);
+				} else if (isKnownVal) {
+					knownVal *= knownBuffers[slot];
+				} else {
+					EmitOp(OP_MULC, knownBuffers[slot]);
+				}
+			} break;
+			case OP_ADDBUFF: {
+				const int slot = ReadInt();
+
+				if (!isKnownBuffer[slot]) {
+					EmitLoad();
+					EmitOp(opcode, 0.0f, slot);
+				} else if (isKnownVal) {
+					knownVal += knownBuffers[slot];
+				} else {
+					EmitOp(OP_ADD, knownBuffers[slot]);
+				}
+			} break;
+			case OP_POWBUFF: {
+				const int slot = ReadInt();
+
+				if (!isKnownBuffer[slot]) {
+					EmitLoad();
+					EmitOp(opcode, 0.0f, slot);
+				} else if (isKnownVal) {
+					knownVal = math::pow(knownVal, knownBuffers[slot]);
+				} else {
+					EmitOp(OP_POW, knownBuffers[slot]);
+				}
+			} break;
+
+			default: {
+				assert(false);
+				return;
+			}
+		}
+	}
+}
+
+void CCustomExplosionGenerator::ExecuteSpawnProgram(
+	const ProjectileSpawnInfo& psi,
+	float damage,
+	CExpGenSpawnable* const* instances,
+	const float3& dir
+) {
+	RECOIL_DETAILED_TRACY_ZONE;
+	// evaluates the program over all <count> spawnables at once, one op at
+	// a time; values and buffers are kept per spawnable in flat arrays
+	static thread_local std::vector<float> vals;
+	static thread_local std::vector<float> buffers;
+
+	const unsigned int count = psi.count;
+
+	vals.clear();
+	vals.resize(count, 0.0f);
+
+	if (psi.usesBuffers) {
+		buffers.clear();
+		buffers.resize(count * NUM_BUFFERS, 0.0f);
+	}
+
+	const auto StoreInt = [](char* instance, std::uint8_t size, std::uint16_t offset, int v) {
+		switch (size) {
+			case 1: { *(std::int8_t*)  (instance + offset) = v; } break;
+			case 2: { *(std::int16_t*) (instance + offset) = v; } break;
+			case 4: { *(std::int32_t*) (instance + offset) = v; } break;
+			case 8: { *(std::int64_t*) (instance + offset) = v; } break;
+			default: { /*no op*/ } break;
+		}
+	};
+	const auto StoreFloat = [](char* instance, std::uint8_t size, std::uint16_t offset, float v) {
+		switch (size) {
+			case 4: { *(float*)  (instance + offset) = v; } break;
+			case 8: { *(double*) (instance + offset) = v; } break;
+			default: { /*no op*/ } break;
+		}
+	};
+
+	for (const SpawnOp& sop: psi.program) {
+		const float arg = sop.arg;
+		float* buffer = buffers.data() + sop.slot * count;
+
+		switch (sop.op) {
+			case OP_STOREIC: {
+				for (unsigned int i = 0; i < count; i++) {
+					StoreInt(reinterpret_cast<char*>(instances[i]), sop.size, sop.offset, (int) arg);
+				}
+			} break;
+			case OP_STOREFC: {
+				for (unsigned int i = 0; i < count; i++) {
+					StoreFloat(reinterpret_cast<char*>(instances[i]), sop.size, sop.offset, arg);
+				}
+			} break;
+			case OP_STOREI: {
+				for (unsigned int i = 0; i < count; i++) {
+					StoreInt(reinterpret_cast<char*>(instances[i]), sop.size, sop.offset, (int) vals[i]);
+				}
+			} break;
+			case OP_STOREF: {
+				for (unsigned int i = 0; i < count; i++) {
+					StoreFloat(reinterpret_cast<char*>(instances[i]), sop.size, sop.offset, vals[i]);
+				}
+			} break;
+			case OP_STOREP: {
+				for (unsigned int i = 0; i < count; i++) {
+					*(void**) (reinterpret_cast<char*>(instances[i]) + sop.offset) = sop.ptr;
+				}
+			} break;
+			case OP_DIR: {
+				for (unsigned int i = 0; i < count; i++) {
+					*reinterpret_cast<float3*>(reinterpret_cast<char*>(instances[i]) + sop.offset) = dir;
+				}
+			} break;
+
+			case OP_LOADC: {
+				std::fill(vals.begin(), vals.end(), arg);
+			} break;
+			case OP_ADD: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] += arg;
+				}
+			} break;
+			case OP_RAND: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] += guRNG.NextFloat() * arg;
+				}
+			} break;
+			case OP_DAMAGE: {
+				const float v = damage * arg;
+
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] += v;
+				}
+			} break;
+			case OP_INDEX: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] += i * arg;
+				}
+			} break;
+			case OP_MULC: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] *= arg;
+				}
+			} break;
+
+			case OP_SAWTOOTH: {
+				// this translates to modulo except it works with floats
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] -= arg * math::floor(vals[i] / arg);
+				}
+			} break;
+			case OP_DISCRETE: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] = arg * math::floor(spring::SafeDivide(vals[i], arg));
+				}
+			} break;
+			case OP_SINE: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] = arg * math::sin(vals[i]);
+				}
+			} break;
+			case OP_POW: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] = math::pow(vals[i], arg);
+				}
+			} break;
+
+			case OP_YANK: {
+				for (unsigned int i = 0; i < count; i++) {
+					buffer[i] = vals[i];
+					vals[i] = 0.0f;
+				}
+			} break;
+			case OP_MULTIPLY: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] *= buffer[i];
+				}
+			} break;
+			case OP_ADDBUFF: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] += buffer[i];
+				}
+			} break;
+			case OP_POWBUFF: {
+				for (unsigned int i = 0; i < count; i++) {
+					vals[i] = math::pow(vals[i], buffer[i]);
+				}
+			} break;
+
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+}
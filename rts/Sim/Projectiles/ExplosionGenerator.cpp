@@ -4,6 +4,8 @@
 #include <stdexcept>
 #include <cassert>
 #include <cinttypes>
+#include <cstring>
+#include <algorithm>
 
 #include "ExplosionGenerator.h"
 #include "ExpGenSpawner.h" //!!
@@ -600,136 +602,6 @@ bool CStdExplosionGenerator::Explosion(
 
 
 
-void CCustomExplosionGenerator::ExecuteExplosionCode(const char* code, float damage, char* instance, int spawnIndex, const float3& dir)
-{
-	RECOIL_DETAILED_TRACY_ZONE;
-	float val = 0.0f;
-	float buffer[16];
-	void* ptr = nullptr;
-
-	std::memset(&buffer[0], 0, sizeof(buffer));
-
-	for (;;) {
-		switch (*(code++)) {
-			case OP_END: {
-				return;
-			}
-			case OP_STOREI: {
-				std::uint8_t  size   = *(std::uint8_t*)  code; code++;
-				std::uint16_t offset = *(std::uint16_t*) code; code += 2;
-				switch (size) {
-					case 1: { *(std::int8_t*)  (instance + offset) = (int) val; } break;
-					case 2: { *(std::int16_t*) (instance + offset) = (int) val; } break;
-					case 4: { *(std::int32_t*) (instance + offset) = (int) val; } break;
-					case 8: { *(std::int64_t*) (instance + offset) = (int) val; } break;
-					default: { /*no op*/ } break;
-				}
-				val = 0.0f;
-				break;
-			}
-			case OP_STOREF: {
-				std::uint8_t  size   = *(std::uint8_t*)  code; code++;
-				std::uint16_t offset = *(std::uint16_t*) code; code += 2;
-				switch (size) {
-					case 4: { *(float*)  (instance + offset) = val; } break;
-					case 8: { *(double*) (instance + offset) = val; } break;
-					default: { /*no op*/ } break;
-				}
-				val = 0.0f;
-				break;
-			}
-			case OP_ADD: {
-				val += *(float*) code;
-				code += 4;
-				break;
-			}
-			case OP_RAND: {
-				val += guRNG.NextFloat() * (*(float*) code);
-				code += 4;
-				break;
-			}
-			case OP_DAMAGE: {
-				val += damage * (*(float*) code);
-				code += 4;
-				break;
-			}
-			case OP_INDEX: {
-				val += spawnIndex * (*(float*) code);
-				code += 4;
-				break;
-			}
-
-			case OP_LOADP: {
-				ptr = *(void**) code;
-				code += sizeof(void*);
-				break;
-			}
-			case OP_STOREP: {
-				std::uint16_t offset = *(std::uint16_t*) code;
-				code += 2;
-				*(void**) (instance + offset) = ptr;
-				ptr = nullptr;
-				break;
-			}
-
-			case OP_DIR: {
-				std::uint16_t offset = *(std::uint16_t*) code;
-				code += 2;
-				*reinterpret_cast<float3*>(instance + offset) = dir;
-				break;
-			}
-			case OP_SAWTOOTH: {
-				// this translates to modulo except it works with floats
-				val -= (*(float*) code) * math::floor(val / (*(float*) code));
-				code += 4;
-				break;
-			}
-			case OP_DISCRETE: {
-				val = (*(float*) code) * math::floor(spring::SafeDivide(val, (*(float*) code)));
-				code += 4;
-				break;
-			}
-			case OP_SINE: {
-				val = (*(float*) code) * math::sin(val);
-				code += 4;
-				break;
-			}
-			case OP_YANK: {
-				buffer[(*(int*) code)] = val;
-				val = 0;
-				code += 4;
-				break;
-			}
-			case OP_MULTIPLY: {
-				val *= buffer[(*(int*) code)];
-				code += 4;
-				break;
-			}
-			case OP_ADDBUFF: {
-				val += buffer[(*(int*) code)];
-				code += 4;
-				break;
-			}
-			case OP_POW: {
-				val = math::pow(val, (*(float*) code));
-				code += 4;
-				break;
-			}
-			case OP_POWBUFF: {
-				val = math::pow(val, buffer[(*(int*) code)]);
-				code += 4;
-				break;
-			}
-			default: {
-				assert(false);
-				break;
-			}
-		}
-	}
-}
-
-
-
 void CCustomExplosionGenerator::ParseExplosionCode(
 	CCustomExplosionGenerator::ProjectileSpawnInfo* psi,
 	const string& script,
@@ -922,8 +794,7 @@ bool CCustomExplosionGenerator::Load(CExplosionGeneratorHandler* handler, const
 		}
 
 		code += (char)OP_END;
-		psi.code.resize(code.size());
-		copy(code.begin(), code.end(), psi.code.begin());
+		CompileExplosionCode(&psi, code);
 
 		expGenParams.projectiles.push_back(psi);
 	}
@@ -988,6 +859,9 @@ bool CCustomExplosionGenerator::Explosion(
 		assert(Threading::IsMainThread() || Threading::IsGameLoadThread());
 	}
 
+	// Init may spawn further explosions, so each call keeps its own batch
+	std::vector<CExpGenSpawnable*> spawnables;
+
 	for (int a = 0; a < spawnInfo.size(); a++) {
 		const ProjectileSpawnInfo& psi = spawnInfo[a];
 
@@ -999,9 +873,18 @@ bool CCustomExplosionGenerator::Explosion(
 		if (projectileHandler.GetParticleSaturation() > 1.0f)
 			break;
 
+		// create the whole batch first, such that the spawn program can fill
+		// in all of its members in one pass before any of them is initialized
+		spawnables.clear();
+		spawnables.reserve(psi.count);
+
 		for (unsigned int c = 0; c < psi.count; c++) {
-			CExpGenSpawnable* projectile = CExpGenSpawnable::CreateSpawnable(psi.spawnableID);
-			ExecuteExplosionCode(&psi.code[0], damage, (char*) projectile, c, dir);
+			spawnables.push_back(CExpGenSpawnable::CreateSpawnable(psi.spawnableID));
+		}
+
+		ExecuteSpawnProgram(psi, damage, spawnables.data(), dir);
+
+		for (CExpGenSpawnable* projectile: spawnables) {
 			projectile->Init(owner, pos);
 		}
 	}
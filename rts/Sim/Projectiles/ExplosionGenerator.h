@@ -3,6 +3,7 @@
 #ifndef EXPLOSION_GENERATOR_H
 #define EXPLOSION_GENERATOR_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,7 @@ class LuaParser;
 class LuaTable;
 class float3;
 class CUnit;
+class CExpGenSpawnable;
 class IExplosionGenerator;
 
 struct SExpGenSpawnableMemberInfo;
@@ -143,6 +145,20 @@ public:
 class CCustomExplosionGenerator: public IExplosionGenerator
 {
 protected:
+	/// one step of a compiled spawn program, see CompileExplosionCode
+	struct SpawnOp {
+		std::uint8_t op = OP_END;
+		std::uint8_t size = 0;
+		std::uint16_t offset = 0;
+
+		/// float operand, or the (folded) value for constant stores
+		float arg = 0.0f;
+		/// buffer index for OP_YANK, OP_MULTIPLY, OP_ADDBUFF and OP_POWBUFF
+		int slot = 0;
+
+		void* ptr = nullptr;
+	};
+
 	struct ProjectileSpawnInfo {
 		unsigned int spawnableID = 0;
 
@@ -150,8 +166,10 @@ protected:
 		unsigned int count = 0;
 		unsigned int flags = 0;
 
-		/// parsed explosion script code
-		std::vector<char> code;
+		/// explosion script code compiled into a constant-folded op list
+		std::vector<SpawnOp> program;
+		/// true if the program reads buffer values that are not known at load-time
+		bool usesBuffers = false;
 	};
 
 	struct ExpGenParams {
@@ -214,13 +232,25 @@ public:
 		OP_ADDBUFF  = 16, // Adds buffer value
 		OP_POW      = 17, // Power with code as exponent
 		OP_POWBUFF  = 18, // Power with buffer as exponent
+
+		// only produced by CompileExplosionCode
+		OP_LOADC    = 19, // Sets the value to a (folded) constant
+		OP_MULC     = 20, // Multiplies with a constant (folded buffer value)
+		OP_STOREIC  = 21, // store a constant int
+		OP_STOREFC  = 22, // store a constant float
 	};
 
+	// the parser clamps buffer indices to [0, 16]
+	static constexpr int NUM_BUFFERS = 17;
+
 private:
 	void ParseExplosionCode(ProjectileSpawnInfo* psi, const std::string& script, SExpGenSpawnableMemberInfo& memberInfo, std::string& code);
-	void ExecuteExplosionCode(const char* code, float damage, char* instance, int spawnIndex, const float3& dir);
 
 protected:
+	// see ExpGenSpawnProgram.cpp
+	static void CompileExplosionCode(ProjectileSpawnInfo* psi, const std::string& code);
+	static void ExecuteSpawnProgram(const ProjectileSpawnInfo& psi, float damage, CExpGenSpawnable* const* instances, const float3& dir);
+
 	ExpGenParams expGenParams;
 };
 
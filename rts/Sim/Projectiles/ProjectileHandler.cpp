@@ -42,6 +42,10 @@
 
 CONFIG(int, MaxParticles).defaultValue(10000).headlessValue(0).minimumValue(0);
 CONFIG(int, MaxNanoParticles).defaultValue(2000).headlessValue(0).minimumValue(0);
+CONFIG(bool, ProjectileCollisionsMT).defaultValue(true).description("Gather projectile collision candidates on all threads; hits are still applied in serial order.");
+
+// below this many projectiles the parallel candidate pass is not worth its overhead
+static constexpr size_t MT_COLLISIONS_MIN_PROJECTILES = 256;
 
 
 CR_BIND(CProjectileHandler, )
@@ -55,7 +59,12 @@ CR_REG_METADATA(CProjectileHandler, (
 	CR_MEMBER(maxNanoParticles),
 	CR_MEMBER(currentNanoParticles),
 	CR_MEMBER_UN(frameCurrentParticles),
-	CR_MEMBER_UN(frameProjectileCounts)
+	CR_MEMBER_UN(frameProjectileCounts),
+
+	CR_IGNORED(colCandidateBuffers),
+	CR_IGNORED(colCandidates),
+	CR_IGNORED(colCandidatesStamp),
+	CR_IGNORED(mtCollisions)
 ))
 
 
@@ -79,6 +88,7 @@ void CProjectileHandler::Init()
 
 	maxParticles     = configHandler->GetInt("MaxParticles");
 	maxNanoParticles = configHandler->GetInt("MaxNanoParticles");
+	mtCollisions     = configHandler->GetBool("ProjectileCollisionsMT");
 
 	projMemPool.clear();
 	projMemPool.reserve(1024);
@@ -191,6 +201,9 @@ void CProjectileHandler::UpdateProjectilesImpl()
 
 	// WARNING: same as above but for p->Update()
 	if constexpr (synced) {
+		// Update() itself has to stay serial (explosions, RNG, Lua, CEGs);
+		// their relinking is deferred to the end of the loop, any quadfield
+		// access in between flushes first
 		for (size_t i = 0; i < pc.size(); ++i) {
 			CProjectile* p = pc[i];
 			assert(p != nullptr);
@@ -198,10 +211,12 @@ void CProjectileHandler::UpdateProjectilesImpl()
 			MAPPOS_SANITY_CHECK(p->pos);
 
 			p->Update();
-			quadField.MovedProjectile(p);
+			quadField.DeferMovedProjectile(p);
 
 			MAPPOS_SANITY_CHECK(p->pos);
 		}
+
+		quadField.FlushMovedProjectiles();
 	}
 	else {
 		for_mt_chunk(0, pc.size(), [&pc](int i) {
@@ -554,6 +569,95 @@ void CProjectileHandler::CheckShieldCollisions(
 	}
 }
 
+void CProjectileHandler::GatherCollisionCandidates(bool synced)
+{
+	ZoneScoped;
+	const auto& pc = projectiles[synced];
+
+	for (CollisionCandidateBuffer& buf: colCandidateBuffers) {
+		buf.quads.clear();
+		buf.units.clear();
+		buf.features.clear();
+		buf.repulsers.clear();
+	}
+
+	colCandidates.clear();
+	colCandidates.resize(pc.size());
+	colCandidatesStamp = quadField.GetQuadStamp();
+
+	// read-only w.r.t. the quadfield and all objects except for their
+	// per-thread tags; hits are only resolved afterwards, in index order
+	for_mt_chunk(0, pc.size(), [this, &pc](const int i) {
+		const CProjectile* p = pc[i];
+		CollisionCandidates& cc = colCandidates[i];
+
+		cc.proj = nullptr;
+
+		if (!p->checkCol) return;
+		if ( p->deleteMe) return;
+
+		const int tid = ThreadPool::GetThreadNum();
+		CollisionCandidateBuffer& buf = colCandidateBuffers[tid];
+
+		cc.proj = p;
+		cc.pos = p->pos;
+		cc.radius = p->speed.w + p->radius;
+		cc.thread = tid;
+
+		cc.quadsBeg = buf.quads.size();
+		cc.unitsBeg = buf.units.size();
+		cc.featuresBeg = buf.features.size();
+		cc.repulsersBeg = buf.repulsers.size();
+
+		quadField.GatherUnitsAndFeaturesColVol(tid, cc.pos, cc.radius, buf.quads, buf.units, buf.features, buf.repulsers);
+
+		cc.quadsEnd = buf.quads.size();
+		cc.unitsEnd = buf.units.size();
+		cc.featuresEnd = buf.features.size();
+		cc.repulsersEnd = buf.repulsers.size();
+	});
+}
+
+bool CProjectileHandler::GetCollisionCandidates(
+	size_t i,
+	const CProjectile* p,
+	std::vector<CUnit*>& units,
+	std::vector<CFeature*>& features,
+	std::vector<CPlasmaRepulser*>& repulsers
+) const {
+	// projectiles added by an earlier collision were not part of the pass
+	if (i >= colCandidates.size())
+		return false;
+
+	const CollisionCandidates& cc = colCandidates[i];
+
+	if (cc.proj != p)
+		return false;
+	// a shield can reflect the projectile before its own turn comes
+	if (cc.pos != p->pos || cc.radius != (p->speed.w + p->radius))
+		return false;
+
+	const CollisionCandidateBuffer& buf = colCandidateBuffers[cc.thread];
+
+	// any object entering or leaving the queried quads since then (e.g. a
+	// unit killed by an earlier projectile) means the candidates are stale
+	if (quadField.QuadsModifiedSince(buf.quads.data() + cc.quadsBeg, cc.quadsEnd - cc.quadsBeg, colCandidatesStamp))
+		return false;
+
+	CQuadField::FilterUnitsAndFeaturesColVol(
+		cc.pos,
+		cc.radius,
+		buf.units.data() + cc.unitsBeg, cc.unitsEnd - cc.unitsBeg,
+		buf.features.data() + cc.featuresBeg, cc.featuresEnd - cc.featuresBeg,
+		buf.repulsers.data() + cc.repulsersBeg, cc.repulsersEnd - cc.repulsersBeg,
+		units,
+		features,
+		repulsers
+	);
+
+	return true;
+}
+
 void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -561,6 +665,13 @@ void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 	static std::vector<CFeature*> tempFeatures;
 	static std::vector<CPlasmaRepulser*> tempRepulsers;
 
+	colCandidates.clear();
+
+	// the candidate gathering (which dominates in large battles) can run
+	// on all threads, applying the hits has to stay serial and in order
+	if (mtCollisions && ThreadPool::HasThreads() && projectiles[synced].size() >= MT_COLLISIONS_MIN_PROJECTILES)
+		GatherCollisionCandidates(synced);
+
 	//can't use iterators here, because instructions inside the loop modify projectiles[synced]
 	for (size_t i = 0; i < projectiles[synced].size(); ++i) {
 		CProjectile* p = projectiles[synced][i];
@@ -572,7 +683,8 @@ void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 		const float3 ppos1 = p->pos + p->speed;
 		// const float3 ppos1 = p->pos + p->dir * (p->speed.w + p->radius);
 
-		quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
+		if (!GetCollisionCandidates(i, p, tempUnits, tempFeatures, tempRepulsers))
+			quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
 
 		CheckShieldCollisions (p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
 		CheckUnitCollisions   (p, tempUnits    , ppos0, ppos1); tempUnits.clear();
@@ -10,6 +10,7 @@
 #include "Rendering/Env/Particles/Classes/FlyingPiece.h"
 #include "System/float3.h"
 #include "System/FreeListMap.h"
+#include "System/Threading/ThreadPool.h"
 
 
 // bypass id and event handling for unsynced projectiles (faster)
@@ -103,6 +104,15 @@ private:
 	template<bool synced>
 	CProjectile* GetProjectileByID(int id);
 
+	void GatherCollisionCandidates(bool synced);
+	bool GetCollisionCandidates(
+		size_t i,
+		const CProjectile* p,
+		std::vector<CUnit*>& units,
+		std::vector<CFeature*>& features,
+		std::vector<CPlasmaRepulser*>& repulsers
+	) const;
+
 	template<bool synced>
 	void UpdateProjectilesImpl();
 	void UpdateProjectiles() {
@@ -115,6 +125,36 @@ private:
 	// [1] contains only projectiles that can     change simulation state
 	spring::FreeListMapCompact<CProjectile*, int> projectiles[2];
 
+	// per-thread output of the parallel collision-candidate gathering pass
+	struct CollisionCandidateBuffer {
+		std::vector<int> quads;
+		std::vector<CUnit*> units;
+		std::vector<CFeature*> features;
+		std::vector<CPlasmaRepulser*> repulsers;
+	};
+	// per-projectile slices into one of the buffers
+	struct CollisionCandidates {
+		const CProjectile* proj;
+
+		float3 pos;
+		float radius;
+
+		int thread;
+
+		uint32_t quadsBeg, quadsEnd;
+		uint32_t unitsBeg, unitsEnd;
+		uint32_t featuresBeg, featuresEnd;
+		uint32_t repulsersBeg, repulsersEnd;
+	};
+
+	std::array<CollisionCandidateBuffer, ThreadPool::MAX_THREADS> colCandidateBuffers;
+	std::vector<CollisionCandidates> colCandidates;
+
+	// QuadField stamp at the time the candidates were gathered
+	uint64_t colCandidatesStamp = 0;
+
+	bool mtCollisions = true;
+
 	static uint32_t UnsyncedRandInt(uint32_t N);
 	static uint32_t   SyncedRandInt(uint32_t N);
 
@@ -2,8 +2,10 @@
 
 #include "Command.h"
 #include "CommandParamsPool.hpp"
+#include "CommandRing.h"
 
 CommandParamsPool cmdParamsPool;
+CommandSlotPool cmdSlotPool;
 
 CR_BIND(Command, )
 CR_REG_METADATA(Command, (
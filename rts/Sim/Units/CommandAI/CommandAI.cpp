@@ -31,7 +31,6 @@
 #include "System/SafeUtil.h"
 #include "System/StringUtil.h"
 #include "System/creg/STL_Set.h"
-#include "System/creg/STL_Deque.h"
 #include <assert.h>
 
 #include "System/Misc/TracyDefs.h"
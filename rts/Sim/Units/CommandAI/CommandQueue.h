@@ -3,10 +3,10 @@
 #ifndef _COMMAND_QUEUE_H
 #define _COMMAND_QUEUE_H
 
-#include <deque>
 #include "Command.h"
+#include "CommandRing.h"
 
-/// A wrapper class for std::deque<Command> to keep track of commands
+/// A wrapper class for CommandRing to keep track of commands
 class CCommandQueue {
 
 	friend class CCommandAI;
@@ -28,7 +28,7 @@ class CCommandQueue {
 		/// limit to a float's integer range
 		static const int maxTagValue = (1 << 24); // 16777216
 
-		typedef std::deque<Command> basis;
+		typedef CommandRing basis;
 
 		typedef basis::size_type              size_type;
 		typedef basis::iterator               iterator;
@@ -44,15 +44,15 @@ class CCommandQueue {
 		inline void push_front(const Command& cmd);
 
 		void emplace_back(Command&& cmd) {
-			queue.emplace_back(cmd);
+			queue.push_back(cmd);
 			queue.back().SetTag(GetNextTag());
 		}
 		void emplace_front(Command&& cmd) {
-			queue.emplace_front(cmd);
+			queue.push_front(cmd);
 			queue.front().SetTag(GetNextTag());
 		}
 
-		inline iterator insert(iterator pos, const Command& cmd);
+		inline iterator insert(const_iterator pos, const Command& cmd);
 
 		inline void pop_back()
 		{
@@ -63,11 +63,11 @@ class CCommandQueue {
 			queue.pop_front();
 		}
 
-		inline iterator erase(iterator pos)
+		inline iterator erase(const_iterator pos)
 		{
 			return queue.erase(pos);
 		}
-		inline iterator erase(iterator first, iterator last)
+		inline iterator erase(const_iterator first, const_iterator last)
 		{
 			return queue.erase(first, last);
 		}
@@ -107,7 +107,7 @@ class CCommandQueue {
 		inline void SetQueueType(QueueType type) { queueType = type; }
 
 	private:
-		std::deque<Command> queue;
+		CommandRing queue;
 		QueueType queueType;
 		int tagCounter;
 };
@@ -137,7 +137,7 @@ inline void CCommandQueue::push_front(const Command& cmd)
 }
 
 
-inline CCommandQueue::iterator CCommandQueue::insert(iterator pos, const Command& cmd)
+inline CCommandQueue::iterator CCommandQueue::insert(const_iterator pos, const Command& cmd)
 {
 	Command tmpCmd = cmd;
 	tmpCmd.SetTag(GetNextTag());
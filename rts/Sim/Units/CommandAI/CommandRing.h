@@ -0,0 +1,339 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _COMMAND_RING_H
+#define _COMMAND_RING_H
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "Command.h"
+
+/*
+ * Fixed-address storage for queued commands that do not fit into a ring's
+ * inline slots. Slots are handed out from pages that are never released,
+ * so a recycled slot costs a free-list pop instead of an allocation; like
+ * cmdParamsPool this is only touched from the simulation thread.
+ */
+template<typename T, size_t S> struct TCommandSlotPool {
+public:
+	T* Acquire() {
+		if (freeSlots.empty()) {
+			pages.emplace_back(new Slot[S]);
+
+			for (size_t i = S; i > 0; i--) {
+				freeSlots.push_back(reinterpret_cast<T*>(&pages.back()[i - 1]));
+			}
+		}
+
+		T* slot = freeSlots.back();
+		freeSlots.pop_back();
+		return slot;
+	}
+
+	void Release(T* slot) { freeSlots.push_back(slot); }
+
+	size_t NumPages() const { return (pages.size()); }
+	size_t NumFreeSlots() const { return (freeSlots.size()); }
+
+private:
+	struct alignas(T) Slot { unsigned char bytes[sizeof(T)]; };
+
+	std::vector< std::unique_ptr<Slot[]> > pages;
+	std::vector<T*> freeSlots;
+};
+
+typedef TCommandSlotPool<Command, 256> CommandSlotPool;
+
+extern CommandSlotPool cmdSlotPool;
+
+
+
+/*
+ * Double-ended queue of commands backing CCommandQueue.
+ *
+ * Commands live in slots that never move while queued: the first
+ * NUM_INLINE_SLOTS are part of the ring itself, further ones come from
+ * cmdSlotPool. The ring proper only holds pointers to these slots, so
+ * insertions and erasures in the middle shift pointers rather than copy
+ * commands (which may own a cmdParamsPool page), and references to queued
+ * commands stay valid across push_front / push_back / insert like they did
+ * with std::deque. Iterators are (ring, index) pairs and are invalidated by
+ * any insertion or erasure, same as for std::deque.
+ */
+class CommandRing {
+public:
+	static constexpr size_t NUM_INLINE_SLOTS = 4;
+	static constexpr size_t NUM_INLINE_PTRS = 8;
+
+	template<typename R, typename V> class TIterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef Command value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef V* pointer;
+		typedef V& reference;
+
+		TIterator() = default;
+		TIterator(R* r, size_t i): ring(r), index(i) {}
+
+		// iterator -> const_iterator
+		template<typename R2, typename V2, typename = std::enable_if_t<std::is_const_v<V> && !std::is_const_v<V2>>>
+		TIterator(const TIterator<R2, V2>& it): ring(it.ring), index(it.index) {}
+
+		reference operator * () const { return (*ring)[index]; }
+		pointer operator -> () const { return &(*ring)[index]; }
+		reference operator [] (difference_type n) const { return (*ring)[index + n]; }
+
+		TIterator& operator ++ () { ++index; return *this; }
+		TIterator& operator -- () { --index; return *this; }
+		TIterator operator ++ (int) { TIterator it = *this; ++index; return it; }
+		TIterator operator -- (int) { TIterator it = *this; --index; return it; }
+
+		TIterator& operator += (difference_type n) { index += n; return *this; }
+		TIterator& operator -= (difference_type n) { index -= n; return *this; }
+		TIterator operator + (difference_type n) const { return {ring, index + n}; }
+		TIterator operator - (difference_type n) const { return {ring, index - n}; }
+		friend TIterator operator + (difference_type n, const TIterator& it) { return (it + n); }
+
+		template<typename R2, typename V2> difference_type operator - (const TIterator<R2, V2>& it) const { return (difference_type(index) - difference_type(it.index)); }
+
+		template<typename R2, typename V2> bool operator == (const TIterator<R2, V2>& it) const { return (index == it.index); }
+		template<typename R2, typename V2> bool operator != (const TIterator<R2, V2>& it) const { return (index != it.index); }
+		template<typename R2, typename V2> bool operator <  (const TIterator<R2, V2>& it) const { return (index <  it.index); }
+		template<typename R2, typename V2> bool operator >  (const TIterator<R2, V2>& it) const { return (index >  it.index); }
+		template<typename R2, typename V2> bool operator <= (const TIterator<R2, V2>& it) const { return (index <= it.index); }
+		template<typename R2, typename V2> bool operator >= (const TIterator<R2, V2>& it) const { return (index >= it.index); }
+
+	private:
+		template<typename R2, typename V2> friend class TIterator;
+		friend class CommandRing;
+
+		R* ring = nullptr;
+		size_t index = 0;
+	};
+
+	typedef Command value_type;
+	typedef size_t size_type;
+	typedef TIterator<CommandRing, Command> iterator;
+	typedef TIterator<const CommandRing, const Command> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+public:
+	CommandRing() = default;
+	CommandRing(const CommandRing&) = delete;
+	CommandRing& operator = (const CommandRing&) = delete;
+	~CommandRing() { clear(); }
+
+	bool empty() const { return (numItems == 0); }
+	size_type size() const { return numItems; }
+	size_type capacity() const { return (ringMask + 1); }
+
+	      Command& operator [] (size_type i)       { assert(i < numItems); return *ring[(head + i) & ringMask]; }
+	const Command& operator [] (size_type i) const { assert(i < numItems); return *ring[(head + i) & ringMask]; }
+
+	      Command& at(size_type i)       { CheckIndex(i); return (*this)[i]; }
+	const Command& at(size_type i) const { CheckIndex(i); return (*this)[i]; }
+
+	      Command& front()       { return (*this)[0]; }
+	const Command& front() const { return (*this)[0]; }
+	      Command& back()        { return (*this)[numItems - 1]; }
+	const Command& back()  const { return (*this)[numItems - 1]; }
+
+	iterator       begin()       { return {this, 0}; }
+	const_iterator begin() const { return {this, 0}; }
+	iterator       end()         { return {this, numItems}; }
+	const_iterator end()   const { return {this, numItems}; }
+
+	reverse_iterator       rbegin()       { return reverse_iterator(end()); }
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	reverse_iterator       rend()         { return reverse_iterator(begin()); }
+	const_reverse_iterator rend()   const { return const_reverse_iterator(begin()); }
+
+	void push_back(const Command& c) {
+		Command* slot = new (AcquireSlot()) Command(c);
+
+		Reserve(numItems + 1);
+		ring[(head + numItems++) & ringMask] = slot;
+	}
+	void push_front(const Command& c) {
+		Command* slot = new (AcquireSlot()) Command(c);
+
+		Reserve(numItems + 1);
+		ring[head = ((head - 1) & ringMask)] = slot;
+		numItems++;
+	}
+
+	void pop_back() {
+		assert(!empty());
+		DestroySlot(ring[(head + --numItems) & ringMask]);
+	}
+	void pop_front() {
+		assert(!empty());
+		DestroySlot(ring[head]);
+
+		head = (head + 1) & ringMask;
+		numItems--;
+	}
+
+	iterator insert(const_iterator pos, const Command& c) {
+		const size_t idx = pos.index;
+
+		assert(idx <= numItems);
+
+		if (idx == 0) {
+			push_front(c);
+			return begin();
+		}
+
+		push_back(c);
+
+		// rotate the new slot from the back into place
+		for (size_t i = numItems - 1; i > idx; i--) {
+			std::swap(ring[(head + i) & ringMask], ring[(head + i - 1) & ringMask]);
+		}
+
+		return {this, idx};
+	}
+
+	iterator erase(const_iterator pos) { return (erase(pos, pos + 1)); }
+	iterator erase(const_iterator first, const_iterator last) {
+		const size_t beg = first.index;
+		const size_t end = last.index;
+		const size_t num = end - beg;
+
+		assert(beg <= end && end <= numItems);
+
+		if (num == 0)
+			return {this, beg};
+
+		for (size_t i = beg; i < end; i++) {
+			DestroySlot(ring[(head + i) & ringMask]);
+		}
+
+		if (beg < (numItems - end)) {
+			// fewer commands in front of the range, shift those forward
+			for (size_t i = beg; i > 0; i--) {
+				ring[(head + i - 1 + num) & ringMask] = ring[(head + i - 1) & ringMask];
+			}
+
+			head = (head + num) & ringMask;
+		} else {
+			for (size_t i = end; i < numItems; i++) {
+				ring[(head + i - num) & ringMask] = ring[(head + i) & ringMask];
+			}
+		}
+
+		numItems -= num;
+		return {this, beg};
+	}
+
+	void clear() {
+		for (size_t i = 0; i < numItems; i++) {
+			DestroySlot(ring[(head + i) & ringMask]);
+		}
+
+		head = 0;
+		numItems = 0;
+	}
+
+	// used by creg (DynamicArrayType) when loading
+	void resize(size_type n) {
+		while (numItems > n)
+			pop_back();
+		while (numItems < n)
+			push_back(Command());
+	}
+
+private:
+	void CheckIndex(size_type i) const {
+		if (i >= numItems)
+			throw std::out_of_range("[CommandRing::at] index out of range");
+	}
+
+	void Reserve(size_t n) {
+		if (n <= capacity())
+			return;
+
+		size_t newSize = capacity() << 1;
+
+		while (newSize < n)
+			newSize <<= 1;
+
+		std::vector<Command*> newRing(newSize, nullptr);
+
+		for (size_t i = 0; i < numItems; i++) {
+			newRing[i] = ring[(head + i) & ringMask];
+		}
+
+		ringMem.swap(newRing);
+
+		ring = ringMem.data();
+		ringMask = newSize - 1;
+		head = 0;
+	}
+
+	Command* AcquireSlot() {
+		const uint32_t i = std::countr_one(inlineSlotMask);
+
+		if (i >= NUM_INLINE_SLOTS)
+			return (cmdSlotPool.Acquire());
+
+		inlineSlotMask |= (1u << i);
+		return reinterpret_cast<Command*>(&inlineSlots[i]);
+	}
+
+	void DestroySlot(Command* slot) {
+		slot->~Command();
+
+		const uintptr_t slotAddr = reinterpret_cast<uintptr_t>(slot);
+		const uintptr_t baseAddr = reinterpret_cast<uintptr_t>(&inlineSlots[0]);
+
+		if (slotAddr >= baseAddr && slotAddr < baseAddr + sizeof(inlineSlots)) {
+			inlineSlotMask &= ~(1u << ((slotAddr - baseAddr) / sizeof(InlineSlot)));
+			return;
+		}
+
+		cmdSlotPool.Release(slot);
+	}
+
+private:
+	struct alignas(Command) InlineSlot { unsigned char bytes[sizeof(Command)]; };
+
+	InlineSlot inlineSlots[NUM_INLINE_SLOTS];
+	Command* inlinePtrs[NUM_INLINE_PTRS];
+
+	// heap storage once more than NUM_INLINE_PTRS commands were queued, kept until destruction
+	std::vector<Command*> ringMem;
+
+	Command** ring = &inlinePtrs[0];
+
+	size_t head = 0;
+	size_t numItems = 0;
+	size_t ringMask = NUM_INLINE_PTRS - 1;
+
+	uint32_t inlineSlotMask = 0;
+};
+
+
+#ifdef USING_CREG
+namespace creg {
+	// same layout as the std::deque<Command> this replaced
+	template<>
+	struct DeduceType<CommandRing> {
+		static std::unique_ptr<IType> Get() {
+			return std::unique_ptr<IType>(new DynamicArrayType<CommandRing>());
+		}
+	};
+}
+#endif
+
+#endif // _COMMAND_RING_H
@@ -5,24 +5,34 @@
 #include "CobThread.h"
 #include "CobFile.h"
 
+#include <algorithm>
 #include <cstdint>
 #include "System/Misc/TracyDefs.h"
 
 CR_BIND(CCobEngine, )
 
 CR_REG_METADATA(CCobEngine, (
-	CR_MEMBER(threadInstances),
+	CR_MEMBER(threadSlots),
+	CR_MEMBER(freeThreadSlots),
+	CR_MEMBER(threadSlotPages),
+	CR_MEMBER(threadSlotPageCounts),
 	CR_MEMBER(tickAddedThreads),
 	CR_MEMBER(tickRemovedThreads),
 	CR_MEMBER(runningThreadIDs),
-	CR_MEMBER(sleepingThreadIDs),
+	CR_MEMBER(sleepNodes),
+	CR_MEMBER(wheelBuckets),
+	// not necessarily empty when saving, SleepThread can be reached
+	// outside of Tick (e.g. by threads started from Lua call-ins)
+	CR_MEMBER(dueThreadIDs),
 	// always null/empty when saving
 	CR_IGNORED(waitingThreadIDs),
 
 	CR_IGNORED(curThread),
 
+	CR_MEMBER(wheelTime),
 	CR_MEMBER(currentTime),
-	CR_MEMBER(threadCounter)
+	CR_MEMBER(threadCounter),
+	CR_MEMBER(numThreads)
 ))
 
 CR_BIND(CCobEngine::SleepingThread, )
@@ -31,8 +41,81 @@ CR_REG_METADATA(CCobEngine::SleepingThread, (
 	CR_MEMBER(wt)
 ))
 
+CR_BIND(CCobEngine::SleepNode, )
+CR_REG_METADATA(CCobEngine::SleepNode, (
+	CR_MEMBER(id),
+	CR_MEMBER(wt),
+	CR_MEMBER(prev),
+	CR_MEMBER(next),
+	CR_MEMBER(bucket)
+))
+
 static const char* const numCobThreadsPlot = "CobThreads";
 
+int CCobEngine::AllocThreadSlot(int threadID)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const unsigned int pageIdx = unsigned(threadID) >> THREAD_PAGE_BITS;
+
+	if (pageIdx >= threadSlotPages.size()) {
+		threadSlotPages.resize(pageIdx + 1);
+		threadSlotPageCounts.resize(pageIdx + 1, 0);
+	}
+	if (threadSlotPages[pageIdx].empty())
+		threadSlotPages[pageIdx].resize(THREAD_PAGE_SIZE, -1);
+
+	int slot = -1;
+
+	if (freeThreadSlots.empty()) {
+		slot = static_cast<int>(threadSlots.size());
+
+		threadSlots.emplace_back();
+		sleepNodes.emplace_back();
+	} else {
+		slot = freeThreadSlots.back();
+		freeThreadSlots.pop_back();
+	}
+
+	assert(threadSlotPages[pageIdx][threadID & (THREAD_PAGE_SIZE - 1)] == -1);
+
+	threadSlotPages[pageIdx][threadID & (THREAD_PAGE_SIZE - 1)] = slot;
+	threadSlotPageCounts[pageIdx] += 1;
+
+	sleepNodes[slot] = {};
+	sleepNodes[slot].id = threadID;
+
+	numThreads += 1;
+	return slot;
+}
+
+void CCobEngine::FreeThreadSlot(int slot)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const int threadID = threadSlots[slot].GetID();
+	const unsigned int pageIdx = unsigned(threadID) >> THREAD_PAGE_BITS;
+
+	UnlinkSleeper(slot);
+
+	threadSlotPages[pageIdx][threadID & (THREAD_PAGE_SIZE - 1)] = -1;
+
+	if ((threadSlotPageCounts[pageIdx] -= 1) == 0)
+		std::vector<int>().swap(threadSlotPages[pageIdx]);
+
+	{
+		// destroy the thread as erasing it from a map would; this runs
+		// its death-callback which may add new threads (and slots) but
+		// can no longer find this one
+		CCobThread deadThread = std::move(threadSlots[slot]);
+	}
+
+	threadSlots[slot] = CCobThread();
+	sleepNodes[slot] = {};
+	freeThreadSlots.push_back(slot);
+
+	numThreads -= 1;
+}
+
+
 int CCobEngine::AddThread(CCobThread&& thread)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -40,28 +123,34 @@ int CCobEngine::AddThread(CCobThread&& thread)
 		thread.SetID(GenThreadID());
 
 	CCobInstance* o = thread.cobInst;
-	CCobThread& t = threadInstances[thread.GetID()];
+
+	const int slot = AllocThreadSlot(thread.GetID());
+	CCobThread& t = threadSlots[slot];
 
 	// move thread into registry, hand its ID to owner
 	t = std::move(thread);
 	o->AddThreadID(t.GetID());
 
-	TracyPlot(numCobThreadsPlot, static_cast<int64_t>(threadInstances.size()));
+	// threads ticked before being registered (CCobInstance::Call) can
+	// not be linked into the wheel by ScheduleThread, do it here
+	if (t.GetState() == CCobThread::Sleep)
+		SleepThread(slot);
+
+	TracyPlot(numCobThreadsPlot, static_cast<int64_t>(numThreads));
 
 	return (t.GetID());
 }
 
 bool CCobEngine::RemoveThread(int threadID) {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const auto it = threadInstances.find(threadID);
+	const int slot = GetThreadSlot(threadID);
 
-	if (it != threadInstances.end()) {
-		threadInstances.erase(it);
-		TracyPlot(numCobThreadsPlot, static_cast<int64_t>(threadInstances.size()));
-		return true;
-	}
+	if (slot == -1)
+		return false;
 
-	return false;
+	FreeThreadSlot(slot);
+	TracyPlot(numCobThreadsPlot, static_cast<int64_t>(numThreads));
+	return true;
 }
 
 void CCobEngine::ProcessQueuedThreads() {
@@ -74,9 +163,8 @@ void CCobEngine::ProcessQueuedThreads() {
 	}
 	tickRemovedThreads.clear();
 
-	// move new threads spawned by START into threadInstances;
-	// their ID's will already have been scheduled into either
-	// waitingThreadIDs or sleepingThreadIDs
+	// move new threads spawned by START into the registry; their
+	// ID's will already have been scheduled into waitingThreadIDs
 	for (CCobThread& t: tickAddedThreads) {
 		AddThread(std::move(t));
 	}
@@ -93,7 +181,11 @@ void CCobEngine::ScheduleThread(const CCobThread* thread)
 			waitingThreadIDs.push_back(thread->GetID());
 		} break;
 		case CCobThread::Sleep: {
-			sleepingThreadIDs.push(SleepingThread{thread->GetID(), thread->GetWakeTime()});
+			const int slot = GetThreadSlot(thread->GetID());
+
+			// unregistered threads are linked by AddThread
+			if (slot != -1)
+				SleepThread(slot);
 		} break;
 		default: {
 			LOG_L(L_ERROR, "[COBEngine::%s] unknown state %d for thread %d", __func__, thread->GetState(), thread->GetID());
@@ -106,8 +198,8 @@ void CCobEngine::SanityCheckThreads(const CCobInstance* owner)
 	RECOIL_DETAILED_TRACY_ZONE;
 	if (false) {
 		// no threads belonging to owner should be left
-		for (const auto& p: threadInstances) {
-			assert(p.second.cobInst != owner);
+		for (const CCobThread& t: threadSlots) {
+			assert(t.cobInst != owner);
 		}
 		for (const CCobThread& t: tickAddedThreads) {
 			assert(t.cobInst != owner);
@@ -129,27 +221,172 @@ void CCobEngine::TickThread(CCobThread* thread)
 	curThread = nullptr;
 }
 
-void CCobEngine::WakeSleepingThreads()
+
+void CCobEngine::SleepThread(int slot)
 {
-	ZoneScoped;
-	// check on the sleeping threads, remove any whose owner died
-	while (!sleepingThreadIDs.empty()) {
-		CCobThread* zzzThread = GetThread((sleepingThreadIDs.top()).id);
+	RECOIL_DETAILED_TRACY_ZONE;
+	SleepNode& node = sleepNodes[slot];
 
-		if (zzzThread == nullptr) {
-			sleepingThreadIDs.pop();
-			continue;
+	UnlinkSleeper(slot);
+
+	node.id = threadSlots[slot].GetID();
+	node.wt = threadSlots[slot].GetWakeTime();
+
+	// already due (only possible for non-positive sleeps), runs this tick
+	if (node.wt < currentTime) {
+		dueThreadIDs.push(SleepingThread{node.id, node.wt});
+		return;
+	}
+
+	LinkSleeper(slot);
+}
+
+void CCobEngine::LinkSleeper(int slot)
+{
+	SleepNode& node = sleepNodes[slot];
+
+	const int maxDelta = (1 << (WHEEL_LEVEL_BITS * WHEEL_NUM_LEVELS)) - 1;
+	const int quantum = std::min(node.wt >> WHEEL_QUANTUM_BITS, wheelTime + maxDelta);
+	const int delta = quantum - wheelTime;
+
+	assert(delta >= 0);
+
+	// lowest level whose span still reaches <quantum>; sleepers beyond the
+	// top level's span are parked in its last bucket and re-cascaded later
+	int level = 0;
+
+	while (level < (WHEEL_NUM_LEVELS - 1) && delta >= (1 << (WHEEL_LEVEL_BITS * (level + 1))))
+		level++;
+
+	node.bucket = level * WHEEL_LEVEL_SIZE + ((quantum >> (WHEEL_LEVEL_BITS * level)) & WHEEL_LEVEL_MASK);
+	node.prev = -1;
+	node.next = wheelBuckets[node.bucket];
+
+	if (node.next != -1)
+		sleepNodes[node.next].prev = slot;
+
+	wheelBuckets[node.bucket] = slot;
+}
+
+void CCobEngine::UnlinkSleeper(int slot)
+{
+	SleepNode& node = sleepNodes[slot];
+
+	if (node.bucket == -1)
+		return;
+
+	if (node.prev != -1) {
+		sleepNodes[node.prev].next = node.next;
+	} else {
+		wheelBuckets[node.bucket] = node.next;
+	}
+
+	if (node.next != -1)
+		sleepNodes[node.next].prev = node.prev;
+
+	node.prev = -1;
+	node.next = -1;
+	node.bucket = -1;
+}
+
+void CCobEngine::DrainBucket(int bucket)
+{
+	// the last bucket visited by CollectDueSleepers can be partially due
+	for (int slot = wheelBuckets[bucket]; slot != -1; ) {
+		const SleepNode& node = sleepNodes[slot];
+		const int next = node.next;
+
+		if (node.wt < currentTime) {
+			dueThreadIDs.push(SleepingThread{node.id, node.wt});
+			UnlinkSleeper(slot);
 		}
 
-		// not yet time to execute this thread or any subsequent sleepers
-		if (zzzThread->GetWakeTime() >= currentTime)
+		slot = next;
+	}
+}
+
+void CCobEngine::CascadeBucket(int bucket)
+{
+	int slot = wheelBuckets[bucket];
+
+	wheelBuckets[bucket] = -1;
+
+	// redistribute over the lower levels, relative to the new wheelTime
+	while (slot != -1) {
+		SleepNode& node = sleepNodes[slot];
+		const int next = node.next;
+
+		node.bucket = -1;
+		LinkSleeper(slot);
+
+		slot = next;
+	}
+}
+
+void CCobEngine::CollectDueSleepers()
+{
+	ZoneScoped;
+	// quantum of the latest wake-time that is due this tick
+	const int dueQuantum = (currentTime - 1) >> WHEEL_QUANTUM_BITS;
+
+	while (true) {
+		DrainBucket(wheelTime & WHEEL_LEVEL_MASK);
+
+		if (wheelTime >= dueQuantum)
 			break;
 
+		wheelTime += 1;
+
+		// entering a new block of a level moves the matching bucket of the
+		// next level down, all of its sleepers now fall within lower spans
+		for (int level = 1; level < WHEEL_NUM_LEVELS; level++) {
+			if ((wheelTime & ((1 << (WHEEL_LEVEL_BITS * level)) - 1)) != 0)
+				break;
+
+			CascadeBucket(level * WHEEL_LEVEL_SIZE + ((wheelTime >> (WHEEL_LEVEL_BITS * level)) & WHEEL_LEVEL_MASK));
+		}
+	}
+}
+
+std::vector<CCobEngine::SleepingThread> CCobEngine::GetSleepingThreadIDs() const
+{
+	std::vector<SleepingThread> sleepers;
+	sleepers.reserve(numThreads);
+
+	for (const SleepNode& node: sleepNodes) {
+		if (node.bucket == -1)
+			continue;
+
+		sleepers.push_back(SleepingThread{node.id, node.wt});
+	}
+
+	for (auto dueThreads = dueThreadIDs; !dueThreads.empty(); dueThreads.pop()) {
+		sleepers.push_back(dueThreads.top());
+	}
+
+	// wake-up order, CCobThreadComp orders the (max-)heap in reverse
+	std::sort(sleepers.begin(), sleepers.end(), [](const SleepingThread& a, const SleepingThread& b) { return CCobThreadComp()(b, a); });
+	return sleepers;
+}
+
+void CCobEngine::WakeSleepingThreads()
+{
+	ZoneScoped;
+	CollectDueSleepers();
+
+	// wake due threads in (wake-time, ID) order, skip any whose owner died
+	while (!dueThreadIDs.empty()) {
+		const SleepingThread zzz = dueThreadIDs.top();
+		CCobThread* zzzThread = GetThread(zzz.id);
+
 		// remove executing thread from the queue
-		sleepingThreadIDs.pop();
+		dueThreadIDs.pop();
+
+		if (zzzThread == nullptr)
+			continue;
 
 		// wake up the thread and tick it (if not dead)
-		// this can quite possibly re-add the thread to <sleepingThreadIDs>
+		// this can quite possibly re-add the thread to the wheel
 		// again, but any thread is guaranteed to sleep for at least 1 tick
 		switch (zzzThread->GetState()) {
 			case CCobThread::Sleep: {
@@ -12,9 +12,8 @@
 
 #include "CobThread.h"
 #include "System/creg/creg_cond.h"
+#include "System/creg/STL_Deque.h"
 #include "System/creg/STL_Queue.h"
-#include "System/creg/STL_Map.h"
-#include "System/Cpp11Compat.hpp"
 
 class CCobThread;
 class CCobInstance;
@@ -33,6 +32,19 @@ public:
 		int wt;
 	};
 
+	// position of a sleeping thread in the timer-wheel, indexed by thread slot
+	struct SleepNode {
+		CR_DECLARE_STRUCT(SleepNode)
+
+		int id = -1;
+		int wt = 0;
+
+		int prev = -1;
+		int next = -1;
+		// -1 if not linked into any bucket
+		int bucket = -1;
+	};
+
 	struct CCobThreadComp {
 	public:
 		bool operator() (const SleepingThread& a, const SleepingThread& b) const {
@@ -40,33 +52,57 @@ public:
 		}
 	};
 
+public:
+	// wake-times are bucketed into quanta of 32ms (one sim-frame is 33ms);
+	// each level of the wheel covers 64 buckets of the level below it, so
+	// four levels span 2^29ms before sleepers have to be parked and cascaded
+	static constexpr int WHEEL_QUANTUM_BITS = 5;
+	static constexpr int WHEEL_LEVEL_BITS = 6;
+	static constexpr int WHEEL_LEVEL_SIZE = 1 << WHEEL_LEVEL_BITS;
+	static constexpr int WHEEL_LEVEL_MASK = WHEEL_LEVEL_SIZE - 1;
+	static constexpr int WHEEL_NUM_LEVELS = 4;
+
+	static constexpr int THREAD_PAGE_BITS = 10;
+	static constexpr int THREAD_PAGE_SIZE = 1 << THREAD_PAGE_BITS;
+
 public:
 	void Init() {
-		threadInstances.reserve(2048);
+		threadSlots.clear();
+		threadSlotPages.reserve(64);
+		threadSlotPageCounts.reserve(64);
+		freeThreadSlots.reserve(512);
+		sleepNodes.reserve(2048);
 		tickAddedThreads.reserve(128);
 
 		runningThreadIDs.reserve(512);
 		waitingThreadIDs.reserve(512);
 
-		sleepingThreadIDs = {};
+		wheelBuckets.clear();
+		wheelBuckets.resize(WHEEL_NUM_LEVELS * WHEEL_LEVEL_SIZE, -1);
+		dueThreadIDs = {};
 
 		curThread = nullptr;
 
+		wheelTime = 0;
 		currentTime = 0;
 		threadCounter = 0;
+		numThreads = 0;
 	}
 	void Kill() {
-		// threadInstances is never explicitly iterated in the actual code,
-		// but iterated during sync dumps, so clean it with clear_unordered_map
-		spring::clear_unordered_map(threadInstances);
+		threadSlots.clear();
+		threadSlotPages.clear();
+		threadSlotPageCounts.clear();
+		freeThreadSlots.clear();
+		sleepNodes.clear();
 		tickAddedThreads.clear();
 
 		runningThreadIDs.clear();
 		waitingThreadIDs.clear();
 
-		while (!sleepingThreadIDs.empty()) {
-			sleepingThreadIDs.pop();
-		}
+		wheelBuckets.clear();
+		dueThreadIDs = {};
+
+		numThreads = 0;
 	}
 
 	void Tick(int deltaTime);
@@ -74,12 +110,12 @@ public:
 
 
 	CCobThread* GetThread(int threadID) {
-		const auto it = threadInstances.find(threadID);
+		const int slot = GetThreadSlot(threadID);
 
-		if (it == threadInstances.end())
+		if (slot == -1)
 			return nullptr;
 
-		return &(it->second);
+		return &threadSlots[slot];
 	}
 
 	bool RemoveThread(int threadID);
@@ -93,24 +129,55 @@ public:
 	void ScheduleThread(const CCobThread* thread);
 	void SanityCheckThreads(const CCobInstance* owner);
 
-	const auto& GetThreadInstances() const { return threadInstances; }
+	// NB: contains free slots, these have an ID of -1
+	const auto& GetThreadInstances() const { return threadSlots; }
 //	const auto& GetTickAddedThreads() const { return tickAddedThreads; }
 //	const auto& GetTickRemovedThreads() const { return tickRemovedThreads; }
 //	const auto& GetRunningThreadIDs() const { return runningThreadIDs; }
 	const auto& GetWaitingThreadIDs() const { return waitingThreadIDs; }
-	const auto& GetSleepingThreadIDs() const { return sleepingThreadIDs; }
+	// sorted in wake-up order; only meant for sync dumps
+	std::vector<SleepingThread> GetSleepingThreadIDs() const;
+	const auto  GetNumThreads() const { return numThreads; }
 	const auto  GetCurrTime() const { return currentTime; }
 	const auto  GetThreadCounter() const { return threadCounter; }
 	const auto  GetCurrCounter() const { return threadCounter; }
 private:
+	int GetThreadSlot(int threadID) const {
+		const unsigned int pageIdx = unsigned(threadID) >> THREAD_PAGE_BITS;
+
+		if (pageIdx >= threadSlotPages.size() || threadSlotPages[pageIdx].empty())
+			return -1;
+
+		return threadSlotPages[pageIdx][threadID & (THREAD_PAGE_SIZE - 1)];
+	}
+
+	int AllocThreadSlot(int threadID);
+	void FreeThreadSlot(int slot);
+
+	void SleepThread(int slot);
+	void LinkSleeper(int slot);
+	void UnlinkSleeper(int slot);
+	void DrainBucket(int bucket);
+	void CascadeBucket(int bucket);
+	void CollectDueSleepers();
+
 	void TickThread(CCobThread* thread);
 
 	void WakeSleepingThreads();
 	void TickRunningThreads();
 
 private:
-	// registry of every thread across all script instances
-	spring::unordered_map<int, CCobThread> threadInstances;
+	// registry of every thread across all script instances; a deque s.t.
+	// threads do not move when new ones are added while another is running
+	// (CCobInstance::Call), removed threads leave a free slot behind
+	std::deque<CCobThread> threadSlots;
+	std::vector<int> freeThreadSlots;
+
+	// maps thread ID to slot; IDs are handed out sequentially so they are
+	// split into pages which are released once all their threads are gone
+	std::vector< std::vector<int> > threadSlotPages;
+	std::vector<int> threadSlotPageCounts;
+
 	// threads that are spawned during Tick
 	std::vector<CCobThread> tickAddedThreads;
 	// threads that are killed during Tick
@@ -119,14 +186,24 @@ private:
 	std::vector<int> runningThreadIDs;
 	std::vector<int> waitingThreadIDs;
 
-	// stores <id, waketime> pairs s.t. after waking up the ID can be checked
-	// for validity; thread owner might get removed while a thread is sleeping
-	std::priority_queue<SleepingThread, std::vector<SleepingThread>, CCobThreadComp> sleepingThreadIDs;
+	// hierarchical timer-wheel of sleeping threads; each bucket is the head
+	// of an intrusive list threaded through <sleepNodes> (one per slot), so
+	// a thread can be unlinked in constant time when it gets removed
+	std::vector<SleepNode> sleepNodes;
+	std::vector<int> wheelBuckets;
+
+	// sleepers that are due this tick (or the next one, if they went to
+	// sleep between ticks), in (wake-time, ID) order; entries are validated
+	// by ID since the thread might be killed meanwhile
+	std::priority_queue<SleepingThread, std::vector<SleepingThread>, CCobThreadComp> dueThreadIDs;
 
 	CCobThread* curThread = nullptr;
 
+	// first quantum whose bucket has not been fully drained yet
+	int wheelTime = 0;
 	int currentTime = 0;
 	int threadCounter = 0;
+	int numThreads = 0;
 };
 
 
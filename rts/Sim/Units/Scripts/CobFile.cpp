@@ -162,6 +162,8 @@ CCobFile::CCobFile(CFileHandler& in, const std::string& scriptName)
 		swabDWordInPlace(code[i]);
 	}
 
+	instructions = CobInstructionDecoder::Decode(code, scriptNames);
+
 	numStaticVars = ch.NumberOfStaticVars;
 
 	// if this is a TA:K script, read the sound names
@@ -0,0 +1,345 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "CobInstruction.h"
+
+#include "System/Misc/TracyDefs.h"
+
+
+// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
+// And some information from basm0.8 source (basm ops.txt)
+
+// Model interaction
+static constexpr int MOVE       = 0x10001000;
+static constexpr int TURN       = 0x10002000;
+static constexpr int SPIN       = 0x10003000;
+static constexpr int STOP_SPIN  = 0x10004000;
+static constexpr int SHOW       = 0x10005000;
+static constexpr int HIDE       = 0x10006000;
+static constexpr int CACHE      = 0x10007000;
+static constexpr int DONT_CACHE = 0x10008000;
+static constexpr int MOVE_NOW   = 0x1000B000;
+static constexpr int TURN_NOW   = 0x1000C000;
+static constexpr int SHADE      = 0x1000D000;
+static constexpr int DONT_SHADE = 0x1000E000;
+static constexpr int EMIT_SFX   = 0x1000F000;
+
+// Blocking operations
+static constexpr int WAIT_TURN  = 0x10011000;
+static constexpr int WAIT_MOVE  = 0x10012000;
+static constexpr int SLEEP      = 0x10013000;
+
+// Stack manipulation
+static constexpr int PUSH_CONSTANT    = 0x10021001;
+static constexpr int PUSH_LOCAL_VAR   = 0x10021002;
+static constexpr int PUSH_STATIC      = 0x10021004;
+static constexpr int CREATE_LOCAL_VAR = 0x10022000;
+static constexpr int POP_LOCAL_VAR    = 0x10023002;
+static constexpr int POP_STATIC       = 0x10023004;
+static constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
+
+// Arithmetic operations
+static constexpr int ADD         = 0x10031000;
+static constexpr int SUB         = 0x10032000;
+static constexpr int MUL         = 0x10033000;
+static constexpr int DIV         = 0x10034000;
+static constexpr int MOD		  = 0x10034001; ///< spring specific
+static constexpr int BITWISE_AND = 0x10035000;
+static constexpr int BITWISE_OR  = 0x10036000;
+static constexpr int BITWISE_XOR = 0x10037000;
+static constexpr int BITWISE_NOT = 0x10038000;
+
+// Native function calls
+static constexpr int RAND           = 0x10041000;
+static constexpr int GET_UNIT_VALUE = 0x10042000;
+static constexpr int GET            = 0x10043000;
+
+// Comparison
+static constexpr int SET_LESS             = 0x10051000;
+static constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
+static constexpr int SET_GREATER          = 0x10053000;
+static constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
+static constexpr int SET_EQUAL            = 0x10055000;
+static constexpr int SET_NOT_EQUAL        = 0x10056000;
+static constexpr int LOGICAL_AND          = 0x10057000;
+static constexpr int LOGICAL_OR           = 0x10058000;
+static constexpr int LOGICAL_XOR          = 0x10059000;
+static constexpr int LOGICAL_NOT          = 0x1005A000;
+
+// Flow control
+static constexpr int START           = 0x10061000;
+static constexpr int CALL            = 0x10062000; ///< converted when executed
+static constexpr int REAL_CALL       = 0x10062001; ///< spring custom
+static constexpr int LUA_CALL        = 0x10062002; ///< spring custom
+static constexpr int JUMP            = 0x10064000;
+static constexpr int RETURN          = 0x10065000;
+static constexpr int JUMP_NOT_EQUAL  = 0x10066000;
+static constexpr int SIGNAL          = 0x10067000;
+static constexpr int SET_SIGNAL_MASK = 0x10068000;
+
+// Piece destruction
+static constexpr int EXPLODE    = 0x10071000;
+static constexpr int PLAY_SOUND = 0x10072000;
+
+// Special functions
+static constexpr int SET    = 0x10082000;
+static constexpr int ATTACH = 0x10083000;
+static constexpr int DROP   = 0x10084000;
+
+
+#if 0
+static const char* GetOpcodeName(int opcode)
+{
+	switch (opcode) {
+		case MOVE: return "move";
+		case TURN: return "turn";
+		case SPIN: return "spin";
+		case STOP_SPIN: return "stop-spin";
+		case SHOW: return "show";
+		case HIDE: return "hide";
+		case CACHE: return "cache";
+		case DONT_CACHE: return "dont-cache";
+		case TURN_NOW: return "turn-now";
+		case MOVE_NOW: return "move-now";
+		case SHADE: return "shade";
+		case DONT_SHADE: return "dont-shade";
+		case EMIT_SFX: return "sfx";
+
+		case WAIT_TURN: return "wait-for-turn";
+		case WAIT_MOVE: return "wait-for-move";
+		case SLEEP: return "sleep";
+
+		case PUSH_CONSTANT: return "pushc";
+		case PUSH_LOCAL_VAR: return "pushl";
+		case PUSH_STATIC: return "pushs";
+		case CREATE_LOCAL_VAR: return "clv";
+		case POP_LOCAL_VAR: return "popl";
+		case POP_STATIC: return "pops";
+		case POP_STACK: return "pop-stack";
+
+		case ADD: return "add";
+		case SUB: return "sub";
+		case MUL: return "mul";
+		case DIV: return "div";
+		case MOD: return "mod";
+		case BITWISE_AND: return "and";
+		case BITWISE_OR: return "or";
+		case BITWISE_XOR: return "xor";
+		case BITWISE_NOT: return "not";
+
+		case RAND: return "rand";
+		case GET_UNIT_VALUE: return "getuv";
+		case GET: return "get";
+
+		case SET_LESS: return "setl";
+		case SET_LESS_OR_EQUAL: return "setle";
+		case SET_GREATER: return "setg";
+		case SET_GREATER_OR_EQUAL: return "setge";
+		case SET_EQUAL: return "sete";
+		case SET_NOT_EQUAL: return "setne";
+		case LOGICAL_AND: return "land";
+		case LOGICAL_OR: return "lor";
+		case LOGICAL_XOR: return "lxor";
+		case LOGICAL_NOT: return "neg";
+
+		case START: return "start";
+		case CALL: return "call";
+		case REAL_CALL: return "call";
+		case LUA_CALL: return "lua_call";
+		case JUMP: return "jmp";
+		case RETURN: return "return";
+		case JUMP_NOT_EQUAL: return "jne";
+		case SIGNAL: return "signal";
+		case SET_SIGNAL_MASK: return "mask";
+
+		case EXPLODE: return "explode";
+		case PLAY_SOUND: return "play-sound";
+
+		case SET: return "set";
+		case ATTACH: return "attach";
+		case DROP: return "drop";
+	}
+
+	return "unknown";
+}
+#endif
+
+
+namespace CobInstructionDecoder {
+	static int GetComparisonOffset(int opcode) {
+		switch (opcode) {
+			case SET_LESS            : return 0;
+			case SET_LESS_OR_EQUAL   : return 1;
+			case SET_GREATER         : return 2;
+			case SET_GREATER_OR_EQUAL: return 3;
+			case SET_EQUAL           : return 4;
+			case SET_NOT_EQUAL       : return 5;
+			default: {} break;
+		}
+
+		return -1;
+	}
+
+	std::vector<CCobInstruction> Decode(const std::vector<int>& code, const std::vector<std::string>& scriptNames)
+	{
+		RECOIL_DETAILED_TRACY_ZONE;
+		const int numWords = static_cast<int>(code.size());
+
+		// the sentinel (pc == numWords) decodes to OutOfRange, as do jumps
+		// anywhere outside the code; both fail when executed just like the
+		// bounds-checked reads of the raw interpreter did
+		std::vector<CCobInstruction> instrs(numWords + 1);
+
+		const auto ValidTarget = [&](int target) {
+			return ((target < 0 || target > numWords)? numWords: target);
+		};
+
+		// every word is decoded as if it started an instruction, since
+		// nothing prevents a jump from landing on an operand
+		for (int pc = 0; pc < numWords; pc++) {
+			CCobInstruction& instr = instrs[pc];
+
+			const int opcode = code[pc];
+			const int remaining = numWords - (pc + 1);
+
+			// returns false if the instruction would read past the end of the code
+			const auto SetOp = [&](int op, int numOperands) {
+				if (numOperands > remaining)
+					return false;
+
+				instr.op = op;
+				instr.next = pc + 1 + numOperands;
+
+				for (int i = 0; i < numOperands; i++) {
+					instr.args[i] = code[pc + 1 + i];
+				}
+
+				return true;
+			};
+
+			instr.op = CobOp::OutOfRange;
+			instr.next = pc + 1;
+
+			switch (opcode) {
+				case MOVE      : { SetOp(CobOp::Move    , 2); } break;
+				case TURN      : { SetOp(CobOp::Turn    , 2); } break;
+				case SPIN      : { SetOp(CobOp::Spin    , 2); } break;
+				case STOP_SPIN : { SetOp(CobOp::StopSpin, 2); } break;
+				case SHOW      : { SetOp(CobOp::Show    , 1); } break;
+				case HIDE      : { SetOp(CobOp::Hide    , 1); } break;
+				case CACHE     : { SetOp(CobOp::Nop1    , 1); } break;
+				case DONT_CACHE: { SetOp(CobOp::Nop1    , 1); } break;
+				case MOVE_NOW  : { SetOp(CobOp::MoveNow , 2); } break;
+				case TURN_NOW  : { SetOp(CobOp::TurnNow , 2); } break;
+				case SHADE     : { SetOp(CobOp::Nop1    , 1); } break;
+				case DONT_SHADE: { SetOp(CobOp::Nop1    , 1); } break;
+				case EMIT_SFX  : { SetOp(CobOp::EmitSfx , 1); } break;
+
+				case WAIT_TURN: { SetOp(CobOp::WaitTurn, 2); } break;
+				case WAIT_MOVE: { SetOp(CobOp::WaitMove, 2); } break;
+				case SLEEP    : { SetOp(CobOp::Sleep   , 0); } break;
+
+				case PUSH_CONSTANT: {
+					if (!SetOp(CobOp::PushConstant, 1))
+						break;
+
+					// fuse <pushc k, set-cmp, jne t>, the usual shape of "if (x < k)"
+					if (remaining < 4 || code[pc + 3] != JUMP_NOT_EQUAL)
+						break;
+
+					const int cmpOffset = GetComparisonOffset(code[pc + 2]);
+
+					if (cmpOffset == -1)
+						break;
+
+					instr.op = CobOp::JumpUnlessLessConst + cmpOffset;
+					instr.next = pc + 5;
+					instr.args[1] = ValidTarget(code[pc + 4]);
+				} break;
+				case PUSH_LOCAL_VAR  : { SetOp(CobOp::PushLocalVar  , 1); } break;
+				case PUSH_STATIC     : { SetOp(CobOp::PushStatic    , 1); } break;
+				case CREATE_LOCAL_VAR: { SetOp(CobOp::CreateLocalVar, 0); } break;
+				case POP_LOCAL_VAR   : { SetOp(CobOp::PopLocalVar   , 1); } break;
+				case POP_STATIC      : { SetOp(CobOp::PopStatic     , 1); } break;
+				case POP_STACK       : { SetOp(CobOp::PopStack      , 0); } break;
+
+				case ADD        : { SetOp(CobOp::Add       , 0); } break;
+				case SUB        : { SetOp(CobOp::Sub       , 0); } break;
+				case MUL        : { SetOp(CobOp::Mul       , 0); } break;
+				case DIV        : { SetOp(CobOp::Div       , 0); } break;
+				case MOD        : { SetOp(CobOp::Mod       , 0); } break;
+				case BITWISE_AND: { SetOp(CobOp::BitwiseAnd, 0); } break;
+				case BITWISE_OR : { SetOp(CobOp::BitwiseOr , 0); } break;
+				case BITWISE_XOR: { SetOp(CobOp::BitwiseXor, 0); } break;
+				case BITWISE_NOT: { SetOp(CobOp::BitwiseNot, 0); } break;
+
+				case RAND          : { SetOp(CobOp::Rand        , 0); } break;
+				case GET_UNIT_VALUE: { SetOp(CobOp::GetUnitValue, 0); } break;
+				case GET           : { SetOp(CobOp::Get         , 0); } break;
+
+				case SET_LESS            :
+				case SET_LESS_OR_EQUAL   :
+				case SET_GREATER         :
+				case SET_GREATER_OR_EQUAL:
+				case SET_EQUAL           :
+				case SET_NOT_EQUAL       : {
+					const int cmpOffset = GetComparisonOffset(opcode);
+
+					SetOp(CobOp::SetLess + cmpOffset, 0);
+
+					// fuse <set-cmp, jne t>
+					if (remaining < 2 || code[pc + 1] != JUMP_NOT_EQUAL)
+						break;
+
+					instr.op = CobOp::JumpUnlessLess + cmpOffset;
+					instr.next = pc + 3;
+					instr.args[0] = ValidTarget(code[pc + 2]);
+				} break;
+				case LOGICAL_AND: { SetOp(CobOp::LogicalAnd, 0); } break;
+				case LOGICAL_OR : { SetOp(CobOp::LogicalOr , 0); } break;
+				case LOGICAL_XOR: { SetOp(CobOp::LogicalXor, 0); } break;
+				case LOGICAL_NOT: { SetOp(CobOp::LogicalNot, 0); } break;
+
+				case START: { SetOp(CobOp::Start, 2); } break;
+				case CALL: {
+					if (!SetOp(CobOp::RealCall, 2))
+						break;
+
+					// the raw interpreter rewrote CALL on first execution, based on the name only
+					const int scriptID = code[pc + 1];
+
+					if (static_cast<size_t>(scriptID) < scriptNames.size() && scriptNames[scriptID].find("lua_") == 0)
+						instr.op = CobOp::LuaCall;
+
+				} break;
+				case REAL_CALL: { SetOp(CobOp::RealCall, 2); } break;
+				case LUA_CALL : { SetOp(CobOp::LuaCall , 2); } break;
+				case JUMP: {
+					if (SetOp(CobOp::Jump, 1))
+						instr.args[0] = ValidTarget(instr.args[0]);
+				} break;
+				case RETURN: { SetOp(CobOp::Return, 0); } break;
+				case JUMP_NOT_EQUAL: {
+					if (SetOp(CobOp::JumpNotEqual, 1))
+						instr.args[0] = ValidTarget(instr.args[0]);
+				} break;
+				case SIGNAL         : { SetOp(CobOp::Signal       , 0); } break;
+				case SET_SIGNAL_MASK: { SetOp(CobOp::SetSignalMask, 0); } break;
+
+				case EXPLODE   : { SetOp(CobOp::Explode  , 1); } break;
+				case PLAY_SOUND: { SetOp(CobOp::PlaySound, 1); } break;
+
+				case SET   : { SetOp(CobOp::Set   , 0); } break;
+				case ATTACH: { SetOp(CobOp::Attach, 0); } break;
+				case DROP  : { SetOp(CobOp::Drop  , 0); } break;
+
+				default: {
+					// keep the raw opcode around for the error message
+					instr.op = CobOp::Unknown;
+					instr.args[0] = opcode;
+				} break;
+			}
+		}
+
+		return instrs;
+	}
+}
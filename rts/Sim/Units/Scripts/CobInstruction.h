@@ -0,0 +1,71 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_INSTRUCTION_H
+#define COB_INSTRUCTION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Pre-decoded form of the raw COB code words, produced once per CCobFile.
+ * The stream has one entry per code word (plus a trailing sentinel), so
+ * that program counters, return addresses and jump targets keep their
+ * meaning as word offsets into the original code; this keeps savegames,
+ * error messages and scripts that jump into the middle of an instruction
+ * working exactly as before.
+ */
+
+// X-macro list of decoded operations, expanded into the enum below and
+// into the interpreter's dispatch table (CCobThread::Tick)
+#define COB_OPS(X) \
+	/* model interaction (Nop1 covers cache, dont-cache, shade and dont-shade) */ \
+	X(Move) X(Turn) X(Spin) X(StopSpin) X(Show) X(Hide) X(Nop1) X(MoveNow) X(TurnNow) X(EmitSfx) \
+	/* blocking operations */ \
+	X(WaitTurn) X(WaitMove) X(Sleep) \
+	/* stack manipulation */ \
+	X(PushConstant) X(PushLocalVar) X(PushStatic) X(CreateLocalVar) X(PopLocalVar) X(PopStatic) X(PopStack) \
+	/* arithmetic */ \
+	X(Add) X(Sub) X(Mul) X(Div) X(Mod) X(BitwiseAnd) X(BitwiseOr) X(BitwiseXor) X(BitwiseNot) \
+	/* native function calls */ \
+	X(Rand) X(GetUnitValue) X(Get) \
+	/* comparison */ \
+	X(SetLess) X(SetLessOrEqual) X(SetGreater) X(SetGreaterOrEqual) X(SetEqual) X(SetNotEqual) X(LogicalAnd) X(LogicalOr) X(LogicalXor) X(LogicalNot) \
+	/* flow control; CALL is resolved to RealCall or LuaCall */ \
+	X(Start) X(RealCall) X(LuaCall) X(Jump) X(Return) X(JumpNotEqual) X(Signal) X(SetSignalMask) \
+	/* piece destruction */ \
+	X(Explode) X(PlaySound) \
+	/* special functions */ \
+	X(Set) X(Attach) X(Drop) \
+	/* fused <set-cmp, jne>: jump unless (pop2 cmp pop1) */ \
+	X(JumpUnlessLess) X(JumpUnlessLessOrEqual) X(JumpUnlessGreater) X(JumpUnlessGreaterOrEqual) X(JumpUnlessEqual) X(JumpUnlessNotEqual) \
+	/* fused <pushc, set-cmp, jne>: jump unless (pop cmp constant) */ \
+	X(JumpUnlessLessConst) X(JumpUnlessLessOrEqualConst) X(JumpUnlessGreaterConst) X(JumpUnlessGreaterOrEqualConst) X(JumpUnlessEqualConst) X(JumpUnlessNotEqualConst) \
+	/* invalid opcode, or operands (or the opcode itself) outside the code */ \
+	X(Unknown) X(OutOfRange)
+
+namespace CobOp {
+	#define COB_OP_ENUM(name) name,
+	enum {
+		COB_OPS(COB_OP_ENUM)
+		NumOps
+	};
+	#undef COB_OP_ENUM
+}
+
+struct CCobInstruction {
+	std::int32_t op = CobOp::OutOfRange;
+	/// word offset of the next instruction, i.e. pc after operands were read
+	std::int32_t next = 0;
+	/// operands; jump targets are word offsets validated against the code size
+	std::int32_t args[2] = {0, 0};
+};
+
+namespace CobInstructionDecoder {
+	std::vector<CCobInstruction> Decode(
+		const std::vector<int>& code,
+		const std::vector<std::string>& scriptNames
+	);
+}
+
+#endif // COB_INSTRUCTION_H
@@ -8,6 +8,8 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GlobalSynced.h"
 
+#include <stdexcept>
+
 #include "System/Misc/TracyDefs.h"
 
 CR_BIND(CCobThread, )
@@ -226,86 +228,6 @@ void CCobThread::InitStack(unsigned int n, CCobThread* t)
 
 
 
-// Command documentation from http://visualta.tauniverse.com/Downloads/cob-commands.txt
-// And some information from basm0.8 source (basm ops.txt)
-
-// Model interaction
-static constexpr int MOVE       = 0x10001000;
-static constexpr int TURN       = 0x10002000;
-static constexpr int SPIN       = 0x10003000;
-static constexpr int STOP_SPIN  = 0x10004000;
-static constexpr int SHOW       = 0x10005000;
-static constexpr int HIDE       = 0x10006000;
-static constexpr int CACHE      = 0x10007000;
-static constexpr int DONT_CACHE = 0x10008000;
-static constexpr int MOVE_NOW   = 0x1000B000;
-static constexpr int TURN_NOW   = 0x1000C000;
-static constexpr int SHADE      = 0x1000D000;
-static constexpr int DONT_SHADE = 0x1000E000;
-static constexpr int EMIT_SFX   = 0x1000F000;
-
-// Blocking operations
-static constexpr int WAIT_TURN  = 0x10011000;
-static constexpr int WAIT_MOVE  = 0x10012000;
-static constexpr int SLEEP      = 0x10013000;
-
-// Stack manipulation
-static constexpr int PUSH_CONSTANT    = 0x10021001;
-static constexpr int PUSH_LOCAL_VAR   = 0x10021002;
-static constexpr int PUSH_STATIC      = 0x10021004;
-static constexpr int CREATE_LOCAL_VAR = 0x10022000;
-static constexpr int POP_LOCAL_VAR    = 0x10023002;
-static constexpr int POP_STATIC       = 0x10023004;
-static constexpr int POP_STACK        = 0x10024000; ///< Not sure what this is supposed to do
-
-// Arithmetic operations
-static constexpr int ADD         = 0x10031000;
-static constexpr int SUB         = 0x10032000;
-static constexpr int MUL         = 0x10033000;
-static constexpr int DIV         = 0x10034000;
-static constexpr int MOD		  = 0x10034001; ///< spring specific
-static constexpr int BITWISE_AND = 0x10035000;
-static constexpr int BITWISE_OR  = 0x10036000;
-static constexpr int BITWISE_XOR = 0x10037000;
-static constexpr int BITWISE_NOT = 0x10038000;
-
-// Native function calls
-static constexpr int RAND           = 0x10041000;
-static constexpr int GET_UNIT_VALUE = 0x10042000;
-static constexpr int GET            = 0x10043000;
-
-// Comparison
-static constexpr int SET_LESS             = 0x10051000;
-static constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
-static constexpr int SET_GREATER          = 0x10053000;
-static constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
-static constexpr int SET_EQUAL            = 0x10055000;
-static constexpr int SET_NOT_EQUAL        = 0x10056000;
-static constexpr int LOGICAL_AND          = 0x10057000;
-static constexpr int LOGICAL_OR           = 0x10058000;
-static constexpr int LOGICAL_XOR          = 0x10059000;
-static constexpr int LOGICAL_NOT          = 0x1005A000;
-
-// Flow control
-static constexpr int START           = 0x10061000;
-static constexpr int CALL            = 0x10062000; ///< converted when executed
-static constexpr int REAL_CALL       = 0x10062001; ///< spring custom
-static constexpr int LUA_CALL        = 0x10062002; ///< spring custom
-static constexpr int JUMP            = 0x10064000;
-static constexpr int RETURN          = 0x10065000;
-static constexpr int JUMP_NOT_EQUAL  = 0x10066000;
-static constexpr int SIGNAL          = 0x10067000;
-static constexpr int SET_SIGNAL_MASK = 0x10068000;
-
-// Piece destruction
-static constexpr int EXPLODE    = 0x10071000;
-static constexpr int PLAY_SOUND = 0x10072000;
-
-// Special functions
-static constexpr int SET    = 0x10082000;
-static constexpr int ATTACH = 0x10083000;
-static constexpr int DROP   = 0x10084000;
-
 // Indices for SET, GET, and GET_UNIT_VALUE for LUA return values
 static constexpr int LUA0 = 110; // (LUA0 returns the lua call status, 0 or 1)
 static constexpr int LUA1 = 111;
@@ -318,89 +240,26 @@ static constexpr int LUA7 = 117;
 static constexpr int LUA8 = 118;
 static constexpr int LUA9 = 119;
 
-#if 0
-#define GET_LONG_PC() (cobFile->code[pc++])
-#else
-// mantis #5981
-#define GET_LONG_PC() (cobFile->code.at(pc++))
+// threaded dispatch (computed goto) where the compiler supports it,
+// otherwise a switch over the same handlers; see COB_OPS
+#if defined(__GNUC__)
+	#define COB_THREADED_DISPATCH
 #endif
 
-
-#if 0
-static const char* GetOpcodeName(int opcode)
-{
-	switch (opcode) {
-		case MOVE: return "move";
-		case TURN: return "turn";
-		case SPIN: return "spin";
-		case STOP_SPIN: return "stop-spin";
-		case SHOW: return "show";
-		case HIDE: return "hide";
-		case CACHE: return "cache";
-		case DONT_CACHE: return "dont-cache";
-		case TURN_NOW: return "turn-now";
-		case MOVE_NOW: return "move-now";
-		case SHADE: return "shade";
-		case DONT_SHADE: return "dont-shade";
-		case EMIT_SFX: return "sfx";
-
-		case WAIT_TURN: return "wait-for-turn";
-		case WAIT_MOVE: return "wait-for-move";
-		case SLEEP: return "sleep";
-
-		case PUSH_CONSTANT: return "pushc";
-		case PUSH_LOCAL_VAR: return "pushl";
-		case PUSH_STATIC: return "pushs";
-		case CREATE_LOCAL_VAR: return "clv";
-		case POP_LOCAL_VAR: return "popl";
-		case POP_STATIC: return "pops";
-		case POP_STACK: return "pop-stack";
-
-		case ADD: return "add";
-		case SUB: return "sub";
-		case MUL: return "mul";
-		case DIV: return "div";
-		case MOD: return "mod";
-		case BITWISE_AND: return "and";
-		case BITWISE_OR: return "or";
-		case BITWISE_XOR: return "xor";
-		case BITWISE_NOT: return "not";
-
-		case RAND: return "rand";
-		case GET_UNIT_VALUE: return "getuv";
-		case GET: return "get";
-
-		case SET_LESS: return "setl";
-		case SET_LESS_OR_EQUAL: return "setle";
-		case SET_GREATER: return "setg";
-		case SET_GREATER_OR_EQUAL: return "setge";
-		case SET_EQUAL: return "sete";
-		case SET_NOT_EQUAL: return "setne";
-		case LOGICAL_AND: return "land";
-		case LOGICAL_OR: return "lor";
-		case LOGICAL_XOR: return "lxor";
-		case LOGICAL_NOT: return "neg";
-
-		case START: return "start";
-		case CALL: return "call";
-		case REAL_CALL: return "call";
-		case LUA_CALL: return "lua_call";
-		case JUMP: return "jmp";
-		case RETURN: return "return";
-		case JUMP_NOT_EQUAL: return "jne";
-		case SIGNAL: return "signal";
-		case SET_SIGNAL_MASK: return "mask";
-
-		case EXPLODE: return "explode";
-		case PLAY_SOUND: return "play-sound";
-
-		case SET: return "set";
-		case ATTACH: return "attach";
-		case DROP: return "drop";
-	}
-
-	return "unknown";
-}
+#ifdef COB_THREADED_DISPATCH
+	#define COB_OP_LABEL_ADDR(name) &&op_##name,
+	#define COB_OP(name) op_##name:
+	#define COB_DISPATCH()                \
+		do {                              \
+			if (state != Run)             \
+				goto done;                \
+			instr = &instrs[pc];          \
+			pc = instr->next;             \
+			goto *dispatchTable[instr->op]; \
+		} while (false)
+#else
+	#define COB_OP(name) case CobOp::name:
+	#define COB_DISPATCH() continue
 #endif
 
 
@@ -416,485 +275,615 @@ bool CCobThread::Tick()
 
 	state = Run;
 
+	const CCobInstruction* instrs = cobFile->instructions.data();
+	const CCobInstruction* instr = nullptr;
+
+	// pc is only set from outside the decoded stream by Start (and by
+	// RealCall below), the stream itself never leaves its bounds
+	if (static_cast<size_t>(pc) >= cobFile->instructions.size())
+		throw std::out_of_range("[COBThread::Tick] pc out of range");
+
 	int r1, r2, r3, r4, r5, r6;
 
+	#ifdef COB_THREADED_DISPATCH
+	static constexpr const void* dispatchTable[] = {COB_OPS(COB_OP_LABEL_ADDR)};
+	static_assert((sizeof(dispatchTable) / sizeof(dispatchTable[0])) == CobOp::NumOps);
+
+	COB_DISPATCH();
+	#else
 	while (state == Run) {
-		const int opcode = GET_LONG_PC();
-
-		switch (opcode) {
-			case PUSH_CONSTANT: {
-				r1 = GET_LONG_PC();
-				PushDataStack(r1);
-			} break;
-			case SLEEP: {
-				r1 = PopDataStack();
-				wakeTime = cobEngine->GetCurrTime() + r1;
-				state = Sleep;
-
-				cobEngine->ScheduleThread(this);
-				return true;
-			} break;
-			case SPIN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r3 = PopDataStack();         // speed
-				r4 = PopDataStack();         // accel
-				cobInst->Spin(r1, r2, r3, r4);
-			} break;
-			case STOP_SPIN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r3 = PopDataStack();         // decel
-
-				cobInst->StopSpin(r1, r2, r3);
-			} break;
-			case RETURN: {
-				retCode = PopDataStack();
-
-				if (LocalReturnAddr() == -1) {
-					state = Dead;
-
-					// leave values intact on stack in case caller wants to check them
-					// callStackSize -= 1;
-					return false;
-				}
-
-				// return to caller
-				pc = LocalReturnAddr();
-				if (dataStack.size() > LocalStackFrame())
-					dataStack.resize(LocalStackFrame());
-
-				callStack.pop_back();
-			} break;
-
-
-			case SHADE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case DONT_SHADE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case CACHE: {
-				r1 = GET_LONG_PC();
-			} break;
-			case DONT_CACHE: {
-				r1 = GET_LONG_PC();
-			} break;
-
-
-			case CALL: {
-				r1 = GET_LONG_PC();
-				pc--;
-
-				if (cobFile->scriptNames[r1].find("lua_") == 0) {
-					cobFile->code[pc - 1] = LUA_CALL;
-					LuaCall();
-					break;
-				}
-
-				cobFile->code[pc - 1] = REAL_CALL;
-
-				// fall-through
-			}
-			case REAL_CALL: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				// do not call zero-length functions
-				if (cobFile->scriptLengths[r1] == 0)
-					break;
-
-				CallInfo& ci = PushCallStackRef();
-				ci.functionId = r1;
-				ci.returnAddr = pc;
-				ci.stackTop = dataStack.size() - r2;
-
-				paramCount = r2;
-
-				// call cobFile->scriptNames[r1]
-				pc = cobFile->scriptOffsets[r1];
-			} break;
-			case LUA_CALL: {
-				LuaCall();
-			} break;
-
-
-			case POP_STATIC: {
-				r1 = GET_LONG_PC();
-				r2 = PopDataStack();
-
-				if (static_cast<size_t>(r1) < cobInst->staticVars.size())
-					cobInst->staticVars[r1] = r2;
-			} break;
-			case POP_STACK: {
-				PopDataStack();
-			} break;
-
-
-			case START: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				if (cobFile->scriptLengths[r1] == 0)
-					break;
-
-
-				CCobThread t(cobInst);
-
-				t.SetID(cobEngine->GenThreadID());
-				t.InitStack(r2, this);
-				t.Start(r1, signalMask, {{0}}, true);
-
-				// calling AddThread directly might move <this>, defer it
-				cobEngine->QueueAddThread(std::move(t));
-			} break;
-
-			case CREATE_LOCAL_VAR: {
-				if (paramCount == 0) {
-					PushDataStack(0);
-				} else {
-					paramCount--;
-				}
-			} break;
-			case GET_UNIT_VALUE: {
-				r1 = PopDataStack();
-				if ((r1 >= LUA0) && (r1 <= LUA9)) {
-					PushDataStack(luaArgs[r1 - LUA0]);
-					break;
-				}
-				r1 = cobInst->GetUnitVal(r1, 0, 0, 0, 0);
-				PushDataStack(r1);
-			} break;
-
-
-			case JUMP_NOT_EQUAL: {
-				r1 = GET_LONG_PC();
-				r2 = PopDataStack();
-
-				if (r2 == 0)
-					pc = r1;
-
-			} break;
-			case JUMP: {
-				r1 = GET_LONG_PC();
-				// this seem to be an error in the docs..
-				//r2 = cobFile->scriptOffsets[LocalFunctionID()] + r1;
-				pc = r1;
-			} break;
-
-
-			case POP_LOCAL_VAR: {
-				r1 = GET_LONG_PC();
-				r2 = PopDataStack();
-				dataStack[LocalStackFrame() + r1] = r2;
-			} break;
-			case PUSH_LOCAL_VAR: {
-				r1 = GET_LONG_PC();
-				r2 = dataStack[LocalStackFrame() + r1];
-				PushDataStack(r2);
-			} break;
-
-
-			case BITWISE_AND: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(r1 & r2);
-			} break;
-			case BITWISE_OR: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(r1 | r2);
-			} break;
-			case BITWISE_XOR: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(r1 ^ r2);
-			} break;
-			case BITWISE_NOT: {
-				r1 = PopDataStack();
-				PushDataStack(~r1);
-			} break;
-
-			case EXPLODE: {
-				r1 = GET_LONG_PC();
-				r2 = PopDataStack();
-				cobInst->Explode(r1, r2);
-			} break;
-
-			case PLAY_SOUND: {
-				r1 = GET_LONG_PC();
-				r2 = PopDataStack();
-				cobInst->PlayUnitSound(r1, r2);
-			} break;
-
-			case PUSH_STATIC: {
-				r1 = GET_LONG_PC();
-
-				if (static_cast<size_t>(r1) < cobInst->staticVars.size())
-					PushDataStack(cobInst->staticVars[r1]);
-			} break;
-
-			case SET_NOT_EQUAL: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-
-				PushDataStack(int(r1 != r2));
-			} break;
-			case SET_EQUAL: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-
-				PushDataStack(int(r1 == r2));
-			} break;
-
-			case SET_LESS: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 < r2));
-			} break;
-			case SET_LESS_OR_EQUAL: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 <= r2));
-			} break;
-
-			case SET_GREATER: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 > r2));
-			} break;
-			case SET_GREATER_OR_EQUAL: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				PushDataStack(int(r1 >= r2));
-			} break;
-
-			case RAND: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				r3 = gsRNG.NextInt(r2 - r1 + 1) + r1;
-				PushDataStack(r3);
-			} break;
-			case EMIT_SFX: {
-				r1 = PopDataStack();
-				r2 = GET_LONG_PC();
-				cobInst->EmitSfx(r1, r2);
-			} break;
-			case MUL: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(r1 * r2);
-			} break;
-
-
-			case SIGNAL: {
-				r1 = PopDataStack();
-				cobInst->Signal(r1);
-			} break;
-			case SET_SIGNAL_MASK: {
-				r1 = PopDataStack();
-				signalMask = r1;
-			} break;
-
-
-			case TURN: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				r3 = GET_LONG_PC(); // piece
-				r4 = GET_LONG_PC(); // axis
-
-				cobInst->Turn(r3, r4, r1, r2);
-			} break;
-			case GET: {
-				r5 = PopDataStack();
-				r4 = PopDataStack();
-				r3 = PopDataStack();
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				if ((r1 >= LUA0) && (r1 <= LUA9)) {
-					PushDataStack(luaArgs[r1 - LUA0]);
-					break;
-				}
-				r6 = cobInst->GetUnitVal(r1, r2, r3, r4, r5);
-				PushDataStack(r6);
-			} break;
-			case ADD: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				PushDataStack(r1 + r2);
-			} break;
-			case SUB: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				r3 = r1 - r2;
-				PushDataStack(r3);
-			} break;
-
-			case DIV: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				if (r2 != 0) {
-					r3 = r1 / r2;
-				} else {
-					r3 = 1000; // infinity!
-					ShowError("division by zero");
-				}
-				PushDataStack(r3);
-			} break;
-			case MOD: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				if (r2 != 0) {
-					PushDataStack(r1 % r2);
-				} else {
-					PushDataStack(0);
-					ShowError("modulo division by zero");
-				}
-			} break;
-
-
-			case MOVE: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r4 = PopDataStack();
-				r3 = PopDataStack();
-				cobInst->Move(r1, r2, r3, r4);
-			} break;
-			case MOVE_NOW: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r3 = PopDataStack();
-				cobInst->MoveNow(r1, r2, r3);
-			} break;
-			case TURN_NOW: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-				r3 = PopDataStack();
-				cobInst->TurnNow(r1, r2, r3);
-			} break;
-
-
-			case WAIT_TURN: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				if (cobInst->NeedsWait(CCobInstance::ATurn, r1, r2)) {
-					state = WaitTurn;
-					waitPiece = r1;
-					waitAxis = r2;
-					return true;
-				}
-			} break;
-			case WAIT_MOVE: {
-				r1 = GET_LONG_PC();
-				r2 = GET_LONG_PC();
-
-				if (cobInst->NeedsWait(CCobInstance::AMove, r1, r2)) {
-					state = WaitMove;
-					waitPiece = r1;
-					waitAxis = r2;
-					return true;
-				}
-			} break;
-
-
-			case SET: {
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-
-				if ((r1 >= LUA0) && (r1 <= LUA9)) {
-					luaArgs[r1 - LUA0] = r2;
-					break;
-				}
-
-				cobInst->SetUnitVal(r1, r2);
-			} break;
-
-
-			case ATTACH: {
-				r3 = PopDataStack();
-				r2 = PopDataStack();
-				r1 = PopDataStack();
-				cobInst->AttachUnit(r2, r1);
-			} break;
-			case DROP: {
-				r1 = PopDataStack();
-				cobInst->DropUnit(r1);
-			} break;
-
-			// like bitwise ops, but only on values 1 and 0
-			case LOGICAL_NOT: {
-				r1 = PopDataStack();
-				PushDataStack(int(r1 == 0));
-			} break;
-			case LOGICAL_AND: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(int(r1 && r2));
-			} break;
-			case LOGICAL_OR: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(int(r1 || r2));
-			} break;
-			case LOGICAL_XOR: {
-				r1 = PopDataStack();
-				r2 = PopDataStack();
-				PushDataStack(int((!!r1) ^ (!!r2)));
-			} break;
-
-
-			case HIDE: {
-				r1 = GET_LONG_PC();
-				cobInst->SetVisibility(r1, false);
-			} break;
-
-			case SHOW: {
-				r1 = GET_LONG_PC();
-
-				int i;
-				for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
-					if (LocalFunctionID() == cobFile->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
-						break;
-
-				// if true, we are in a Fire-script and should show a special flare effect
-				if (i < MAX_WEAPONS_PER_UNIT) {
-					cobInst->ShowFlare(r1);
-				} else {
-					cobInst->SetVisibility(r1, true);
-				}
-			} break;
-
-			default: {
-				const char* name = cobFile->name.c_str();
-				const char* func = cobFile->scriptNames[LocalFunctionID()].c_str();
-
-				LOG_L(L_ERROR, "[COBThread::%s] unknown opcode %x (in %s:%s at %x)", __func__, opcode, name, func, pc - 1);
-
-				#if 0
-				auto ei = execTrace.begin();
-				while (ei != execTrace.end()) {
-					LOG_L(L_ERROR, "\tprogctr: %3x  opcode: %s", __func__, *ei, GetOpcodeName(cobFile->code[*ei]));
-					++ei;
-				}
-				#endif
-
-				state = Dead;
-				return false;
-			} break;
+		instr = &instrs[pc];
+		pc = instr->next;
+
+		switch (instr->op) {
+	#endif
+
+	COB_OP(PushConstant) {
+		PushDataStack(instr->args[0]);
+		COB_DISPATCH();
+	}
+	COB_OP(Sleep) {
+		r1 = PopDataStack();
+		wakeTime = cobEngine->GetCurrTime() + r1;
+		state = Sleep;
+
+		cobEngine->ScheduleThread(this);
+		return true;
+	}
+	COB_OP(Spin) {
+		r3 = PopDataStack();         // speed
+		r4 = PopDataStack();         // accel
+		cobInst->Spin(instr->args[0], instr->args[1], r3, r4);
+		COB_DISPATCH();
+	}
+	COB_OP(StopSpin) {
+		r3 = PopDataStack();         // decel
+		cobInst->StopSpin(instr->args[0], instr->args[1], r3);
+		COB_DISPATCH();
+	}
+	COB_OP(Return) {
+		retCode = PopDataStack();
+
+		if (LocalReturnAddr() == -1) {
+			state = Dead;
+
+			// leave values intact on stack in case caller wants to check them
+			// callStackSize -= 1;
+			return false;
+		}
+
+		// return to caller
+		pc = LocalReturnAddr();
+		if (dataStack.size() > LocalStackFrame())
+			dataStack.resize(LocalStackFrame());
+
+		callStack.pop_back();
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Nop1) {
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(RealCall) {
+		r1 = instr->args[0];
+		r2 = instr->args[1];
+
+		// do not call zero-length functions
+		if (cobFile->scriptLengths[r1] == 0)
+			COB_DISPATCH();
+
+		CallInfo& ci = PushCallStackRef();
+		ci.functionId = r1;
+		ci.returnAddr = pc;
+		ci.stackTop = dataStack.size() - r2;
+
+		paramCount = r2;
+
+		// call cobFile->scriptNames[r1]
+		if (static_cast<size_t>(pc = cobFile->scriptOffsets[r1]) >= cobFile->instructions.size())
+			throw std::out_of_range("[COBThread::Tick] call-target out of range");
+
+		COB_DISPATCH();
+	}
+	COB_OP(LuaCall) {
+		LuaCall(instr->args[0], instr->args[1]);
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(PopStatic) {
+		r1 = instr->args[0];
+		r2 = PopDataStack();
+
+		if (static_cast<size_t>(r1) < cobInst->staticVars.size())
+			cobInst->staticVars[r1] = r2;
+
+		COB_DISPATCH();
+	}
+	COB_OP(PopStack) {
+		PopDataStack();
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Start) {
+		r1 = instr->args[0];
+		r2 = instr->args[1];
+
+		if (cobFile->scriptLengths[r1] == 0)
+			COB_DISPATCH();
+
+		{
+			CCobThread t(cobInst);
+
+			t.SetID(cobEngine->GenThreadID());
+			t.InitStack(r2, this);
+			t.Start(r1, signalMask, {{0}}, true);
+
+			// calling AddThread directly might move <this>, defer it
+			cobEngine->QueueAddThread(std::move(t));
+		}
+
+		COB_DISPATCH();
+	}
+
+	COB_OP(CreateLocalVar) {
+		if (paramCount == 0) {
+			PushDataStack(0);
+		} else {
+			paramCount--;
+		}
+		COB_DISPATCH();
+	}
+	COB_OP(GetUnitValue) {
+		r1 = PopDataStack();
+		if ((r1 >= LUA0) && (r1 <= LUA9)) {
+			PushDataStack(luaArgs[r1 - LUA0]);
+			COB_DISPATCH();
+		}
+		r1 = cobInst->GetUnitVal(r1, 0, 0, 0, 0);
+		PushDataStack(r1);
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(JumpNotEqual) {
+		if (PopDataStack() == 0)
+			pc = instr->args[0];
+
+		COB_DISPATCH();
+	}
+	COB_OP(Jump) {
+		// this seem to be an error in the docs..
+		//r2 = cobFile->scriptOffsets[LocalFunctionID()] + r1;
+		pc = instr->args[0];
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(PopLocalVar) {
+		r2 = PopDataStack();
+		dataStack[LocalStackFrame() + instr->args[0]] = r2;
+		COB_DISPATCH();
+	}
+	COB_OP(PushLocalVar) {
+		r2 = dataStack[LocalStackFrame() + instr->args[0]];
+		PushDataStack(r2);
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(BitwiseAnd) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 & r2);
+		COB_DISPATCH();
+	}
+	COB_OP(BitwiseOr) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 | r2);
+		COB_DISPATCH();
+	}
+	COB_OP(BitwiseXor) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 ^ r2);
+		COB_DISPATCH();
+	}
+	COB_OP(BitwiseNot) {
+		r1 = PopDataStack();
+		PushDataStack(~r1);
+		COB_DISPATCH();
+	}
+
+	COB_OP(Explode) {
+		r2 = PopDataStack();
+		cobInst->Explode(instr->args[0], r2);
+		COB_DISPATCH();
+	}
+
+	COB_OP(PlaySound) {
+		r2 = PopDataStack();
+		cobInst->PlayUnitSound(instr->args[0], r2);
+		COB_DISPATCH();
+	}
+
+	COB_OP(PushStatic) {
+		r1 = instr->args[0];
+
+		if (static_cast<size_t>(r1) < cobInst->staticVars.size())
+			PushDataStack(cobInst->staticVars[r1]);
+
+		COB_DISPATCH();
+	}
+
+	COB_OP(SetNotEqual) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+
+		PushDataStack(int(r1 != r2));
+		COB_DISPATCH();
+	}
+	COB_OP(SetEqual) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+
+		PushDataStack(int(r1 == r2));
+		COB_DISPATCH();
+	}
+
+	COB_OP(SetLess) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		PushDataStack(int(r1 < r2));
+		COB_DISPATCH();
+	}
+	COB_OP(SetLessOrEqual) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		PushDataStack(int(r1 <= r2));
+		COB_DISPATCH();
+	}
+
+	COB_OP(SetGreater) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		PushDataStack(int(r1 > r2));
+		COB_DISPATCH();
+	}
+	COB_OP(SetGreaterOrEqual) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		PushDataStack(int(r1 >= r2));
+		COB_DISPATCH();
+	}
+
+	// fused comparisons; the result would be consumed by the jne at once,
+	// so it is never pushed (operand order as in the unfused handlers)
+	COB_OP(JumpUnlessLess) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (!(r1 < r2))
+			pc = instr->args[0];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessLessOrEqual) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (!(r1 <= r2))
+			pc = instr->args[0];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessGreater) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (!(r1 > r2))
+			pc = instr->args[0];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessGreaterOrEqual) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (!(r1 >= r2))
+			pc = instr->args[0];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessEqual) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+
+		if (!(r1 == r2))
+			pc = instr->args[0];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessNotEqual) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+
+		if (!(r1 != r2))
+			pc = instr->args[0];
+
+		COB_DISPATCH();
+	}
+
+	// fused with a preceding pushc, the constant is the right-hand side
+	COB_OP(JumpUnlessLessConst) {
+		if (!(PopDataStack() < instr->args[0]))
+			pc = instr->args[1];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessLessOrEqualConst) {
+		if (!(PopDataStack() <= instr->args[0]))
+			pc = instr->args[1];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessGreaterConst) {
+		if (!(PopDataStack() > instr->args[0]))
+			pc = instr->args[1];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessGreaterOrEqualConst) {
+		if (!(PopDataStack() >= instr->args[0]))
+			pc = instr->args[1];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessEqualConst) {
+		if (!(PopDataStack() == instr->args[0]))
+			pc = instr->args[1];
+
+		COB_DISPATCH();
+	}
+	COB_OP(JumpUnlessNotEqualConst) {
+		if (!(PopDataStack() != instr->args[0]))
+			pc = instr->args[1];
+
+		COB_DISPATCH();
+	}
+
+	COB_OP(Rand) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		r3 = gsRNG.NextInt(r2 - r1 + 1) + r1;
+		PushDataStack(r3);
+		COB_DISPATCH();
+	}
+	COB_OP(EmitSfx) {
+		r1 = PopDataStack();
+		cobInst->EmitSfx(r1, instr->args[0]);
+		COB_DISPATCH();
+	}
+	COB_OP(Mul) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(r1 * r2);
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Signal) {
+		r1 = PopDataStack();
+		cobInst->Signal(r1);
+		COB_DISPATCH();
+	}
+	COB_OP(SetSignalMask) {
+		r1 = PopDataStack();
+		signalMask = r1;
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Turn) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		cobInst->Turn(instr->args[0], instr->args[1], r1, r2);
+		COB_DISPATCH();
+	}
+	COB_OP(Get) {
+		r5 = PopDataStack();
+		r4 = PopDataStack();
+		r3 = PopDataStack();
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		if ((r1 >= LUA0) && (r1 <= LUA9)) {
+			PushDataStack(luaArgs[r1 - LUA0]);
+			COB_DISPATCH();
+		}
+		r6 = cobInst->GetUnitVal(r1, r2, r3, r4, r5);
+		PushDataStack(r6);
+		COB_DISPATCH();
+	}
+	COB_OP(Add) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		PushDataStack(r1 + r2);
+		COB_DISPATCH();
+	}
+	COB_OP(Sub) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		r3 = r1 - r2;
+		PushDataStack(r3);
+		COB_DISPATCH();
+	}
+
+	COB_OP(Div) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (r2 != 0) {
+			r3 = r1 / r2;
+		} else {
+			r3 = 1000; // infinity!
+			ShowError("division by zero");
 		}
+		PushDataStack(r3);
+		COB_DISPATCH();
+	}
+	COB_OP(Mod) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if (r2 != 0) {
+			PushDataStack(r1 % r2);
+		} else {
+			PushDataStack(0);
+			ShowError("modulo division by zero");
+		}
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Move) {
+		r4 = PopDataStack();
+		r3 = PopDataStack();
+		cobInst->Move(instr->args[0], instr->args[1], r3, r4);
+		COB_DISPATCH();
+	}
+	COB_OP(MoveNow) {
+		r3 = PopDataStack();
+		cobInst->MoveNow(instr->args[0], instr->args[1], r3);
+		COB_DISPATCH();
+	}
+	COB_OP(TurnNow) {
+		r3 = PopDataStack();
+		cobInst->TurnNow(instr->args[0], instr->args[1], r3);
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(WaitTurn) {
+		r1 = instr->args[0];
+		r2 = instr->args[1];
+
+		if (cobInst->NeedsWait(CCobInstance::ATurn, r1, r2)) {
+			state = WaitTurn;
+			waitPiece = r1;
+			waitAxis = r2;
+			return true;
+		}
+		COB_DISPATCH();
+	}
+	COB_OP(WaitMove) {
+		r1 = instr->args[0];
+		r2 = instr->args[1];
+
+		if (cobInst->NeedsWait(CCobInstance::AMove, r1, r2)) {
+			state = WaitMove;
+			waitPiece = r1;
+			waitAxis = r2;
+			return true;
+		}
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Set) {
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+
+		if ((r1 >= LUA0) && (r1 <= LUA9)) {
+			luaArgs[r1 - LUA0] = r2;
+			COB_DISPATCH();
+		}
+
+		cobInst->SetUnitVal(r1, r2);
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Attach) {
+		r3 = PopDataStack();
+		r2 = PopDataStack();
+		r1 = PopDataStack();
+		cobInst->AttachUnit(r2, r1);
+		COB_DISPATCH();
+	}
+	COB_OP(Drop) {
+		r1 = PopDataStack();
+		cobInst->DropUnit(r1);
+		COB_DISPATCH();
 	}
 
+	// like bitwise ops, but only on values 1 and 0
+	COB_OP(LogicalNot) {
+		r1 = PopDataStack();
+		PushDataStack(int(r1 == 0));
+		COB_DISPATCH();
+	}
+	COB_OP(LogicalAnd) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int(r1 && r2));
+		COB_DISPATCH();
+	}
+	COB_OP(LogicalOr) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int(r1 || r2));
+		COB_DISPATCH();
+	}
+	COB_OP(LogicalXor) {
+		r1 = PopDataStack();
+		r2 = PopDataStack();
+		PushDataStack(int((!!r1) ^ (!!r2)));
+		COB_DISPATCH();
+	}
+
+
+	COB_OP(Hide) {
+		cobInst->SetVisibility(instr->args[0], false);
+		COB_DISPATCH();
+	}
+
+	COB_OP(Show) {
+		r1 = instr->args[0];
+
+		int i;
+		for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
+			if (LocalFunctionID() == cobFile->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
+				break;
+
+		// if true, we are in a Fire-script and should show a special flare effect
+		if (i < MAX_WEAPONS_PER_UNIT) {
+			cobInst->ShowFlare(r1);
+		} else {
+			cobInst->SetVisibility(r1, true);
+		}
+		COB_DISPATCH();
+	}
+
+	COB_OP(OutOfRange) {
+		// same outcome as the bounds-checked reads of the raw code (mantis #5981)
+		throw std::out_of_range("[COBThread::Tick] instruction out of range");
+	}
+
+	COB_OP(Unknown) {
+		const char* name = cobFile->name.c_str();
+		const char* func = cobFile->scriptNames[LocalFunctionID()].c_str();
+
+		LOG_L(L_ERROR, "[COBThread::%s] unknown opcode %x (in %s:%s at %x)", __func__, instr->args[0], name, func, pc - 1);
+
+		state = Dead;
+		return false;
+	}
+
+	#ifndef COB_THREADED_DISPATCH
+		}
+	}
+	#else
+done:
+	#endif
+
 	// can arrive here as dead, through CCobInstance::Signal()
 	return (state != Dead);
 }
 
+#undef COB_DISPATCH
+#undef COB_OP
+#undef COB_OP_LABEL_ADDR
+
 void CCobThread::ShowError(const char* msg)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -913,11 +902,10 @@ void CCobThread::ShowError(const char* msg)
 }
 
 
-void CCobThread::LuaCall()
+void CCobThread::LuaCall(int r1, int r2)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const int r1 = GET_LONG_PC(); // script id
-	const int r2 = GET_LONG_PC(); // arg count
+	// r1 is the script id, r2 the arg count
 
 	// setup the parameter array
 	const int size = static_cast<int>(dataStack.size());
@@ -52,12 +52,15 @@
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/MoveTypes/MoveTypeFactory.h"
 #include "Sim/MoveTypes/ScriptMoveType.h"
+#include "Sim/MoveTypes/StaticMoveType.h"
+#include "Sim/MoveTypes/StrafeAirMoveType.h"
 #include "Sim/Projectiles/FlareProjectile.h"
 #include "Sim/Projectiles/ProjectileMemPool.h"
 #include "Sim/Projectiles/WeaponProjectiles/MissileProjectile.h"
 #include "Sim/Weapons/Weapon.h"
 #include "Sim/Weapons/WeaponDefHandler.h"
 #include "Sim/Weapons/WeaponLoader.h"
+#include "Sim/Weapons/WeaponTargetIndex.h"
 #include "System/EventHandler.h"
 #include "System/Log/ILog.h"
 #include "System/Matrix44f.h"
@@ -94,6 +97,29 @@ CUnit::CUnit(): CSolidObject()
 	static_assert((sizeof(losStatus) / sizeof(losStatus[0])) == MAX_TEAMS, "");
 	static_assert((sizeof(posErrorMask) == 32), "");
 
+	// keep the state touched by the per-frame loops ahead of the bulky
+	// members, see the notes in SolidObject.h and at the end of Unit.h
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+	static_assert(offsetof(CUnit, objectUsable) < offsetof(CUnit, localModel), "");
+	static_assert(offsetof(CUnit, drawIcon) < offsetof(CUnit, usMemBuffer), "");
+	static_assert(offsetof(CUnit, caiMemBuffer) + sizeof(caiMemBuffer) + alignof(CUnit) > sizeof(CUnit), "");
+
+	// the in-place buffers must suit every type constructed in them
+	static_assert((offsetof(CUnit,  usMemBuffer) % alignof(CCobInstance)) == 0, "");
+	static_assert((offsetof(CUnit,  usMemBuffer) % alignof(CLuaUnitScript)) == 0, "");
+	static_assert((offsetof(CUnit, amtMemBuffer) % alignof(CGroundMoveType)) == 0, "");
+	static_assert((offsetof(CUnit, amtMemBuffer) % alignof(CStrafeAirMoveType)) == 0, "");
+	static_assert((offsetof(CUnit, amtMemBuffer) % alignof(CHoverAirMoveType)) == 0, "");
+	static_assert((offsetof(CUnit, amtMemBuffer) % alignof(CStaticMoveType)) == 0, "");
+	static_assert((offsetof(CUnit, smtMemBuffer) % alignof(CScriptMoveType)) == 0, "");
+	static_assert((offsetof(CUnit, caiMemBuffer) % alignof(CFactoryCAI)) == 0, "");
+	static_assert((offsetof(CUnit, caiMemBuffer) % alignof(CBuilderCAI)) == 0, "");
+	static_assert((offsetof(CUnit, caiMemBuffer) % alignof(CAirCAI)) == 0, "");
+	static_assert((offsetof(CUnit, caiMemBuffer) % alignof(CMobileCAI)) == 0, "");
+	static_assert((offsetof(CUnit, caiMemBuffer) % alignof(CCommandAI)) == 0, "");
+	#pragma GCC diagnostic pop
+
 	losStatus.fill(0);
 	posErrorMask.fill(0xFFFFFFFF);
 
@@ -856,6 +882,11 @@ void CUnit::SetLosStatus(int at, unsigned short newStatus)
 	const unsigned short currStatus = losStatus[at];
 	const unsigned short diffBits = (currStatus ^ newStatus);
 
+	// the target index only looks at these two bits, any other change
+	// (e.g. PREVLOS or the Lua masks) leaves its cached cells valid
+	if ((diffBits & (LOS_INLOS | LOS_INRADAR)) != 0)
+		weaponTargetIndex.LosStatusChanged();
+
 	// add to the state before running the callins
 	//
 	// note that is not symmetric: UnitEntered* and
@@ -1535,8 +1566,9 @@ bool CUnit::ChangeTeam(int newteam, ChangeType type)
 		if (teamHandler.Ally(at, allyteam)) {
 			SetLosStatus(at, LOS_ALL_MASK_BITS | LOS_INLOS | LOS_INRADAR | LOS_PREVLOS | LOS_CONTRADAR);
 		} else {
-			// re-calc LOS status
+			// re-calc LOS status; the reset bypasses SetLosStatus
 			losStatus[at] = 0;
+			weaponTargetIndex.LosStatusChanged();
 			UpdateLosStatus(at);
 		}
 	}
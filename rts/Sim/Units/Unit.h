@@ -3,6 +3,8 @@
 #ifndef UNIT_H
 #define UNIT_H
 
+#include <algorithm>
+#include <cstddef>
 #include <vector>
 
 #include "Sim/Objects/SolidObject.h"
@@ -22,6 +24,7 @@
 
 // for caiMemBuffer
 #include "Sim/Units/CommandAI/BuilderCAI.h"
+#include "Sim/Units/CommandAI/FactoryCAI.h"
 
 // for usMemBuffer
 #include "Sim/Units/Scripts/LuaUnitScript.h"
@@ -313,16 +316,49 @@ public:
 	SWeaponTarget curTarget;
 
 
-	// sufficient for the largest UnitScript (CLuaUnitScript)
-	uint8_t usMemBuffer[sizeof(CLuaUnitScript)];
-	// sufficient for the largest AMoveType (CGroundMoveType)
-	// need two buffers since ScriptMoveType might be enabled
-	uint8_t amtMemBuffer[sizeof(CGroundMoveType)];
-	uint8_t smtMemBuffer[sizeof(CScriptMoveType)];
-	// sufficient for the largest CommandAI type (CBuilderCAI)
-	// knowing the exact CAI object size here is not required;
-	// static asserts will catch any overflow
-	uint8_t caiMemBuffer[sizeof(CBuilderCAI)];
+	// if the unit is in it's 'on'-state
+	bool activated = false;
+	// prevent damage from hitting an already dead unit (causing multi wreck etc)
+	bool isDead = false;
+
+	bool armoredState = false;
+
+	bool stealth = false;
+	bool sonarStealth = false;
+
+	// used by constructing units
+	bool inBuildStance = false;
+	// tells weapons that support it to try to use a high trajectory
+	bool useHighTrajectory = false;
+	// used by landed gunships to block weapon Update()'s, also by builders to
+	// prevent weapon SlowUpdate()'s and Attack{Unit,Ground}()'s during certain
+	// commands
+	bool onTempHoldFire = false;
+
+	// Lua overrides for CanUpdateWeapons
+	bool forceUseWeapons = false;
+	bool allowUseWeapons =  true;
+
+	// signals if script has finished executing Killed and the unit can be deleted
+	bool deathScriptFinished = false;
+
+	// if true, unit will not be automatically fired upon unless attacker's fireState is set to > FIREATWILL
+	bool neutral = false;
+	// if unit is currently incompletely constructed (implies buildProgress < 1)
+	bool beingBuilt = true;
+	// if the updir is straight up or align to the ground vector
+	bool upright = true;
+	// whether the ground below this unit has been terraformed
+	bool groundLevelled = true;
+
+	// true if the unit is currently cloaked (has enough energy etc)
+	bool isCloaked = false;
+	// true if the unit currently wants to be cloaked
+	bool wantCloak = false;
+private:
+	// if we are stunned by a weapon or for other reason, access via IsStunned/SetStunned(bool)
+	bool stunned = false;
+public:
 
 
 	std::vector<CWeapon*> weapons;
@@ -509,47 +545,6 @@ public:
 	int cegDamage = 0;
 
 
-	// if the unit is in it's 'on'-state
-	bool activated = false;
-	// prevent damage from hitting an already dead unit (causing multi wreck etc)
-	bool isDead = false;
-
-	bool armoredState = false;
-
-	bool stealth = false;
-	bool sonarStealth = false;
-
-	// used by constructing units
-	bool inBuildStance = false;
-	// tells weapons that support it to try to use a high trajectory
-	bool useHighTrajectory = false;
-	// used by landed gunships to block weapon Update()'s, also by builders to
-	// prevent weapon SlowUpdate()'s and Attack{Unit,Ground}()'s during certain
-	// commands
-	bool onTempHoldFire = false;
-
-	// Lua overrides for CanUpdateWeapons
-	bool forceUseWeapons = false;
-	bool allowUseWeapons =  true;
-
-	// signals if script has finished executing Killed and the unit can be deleted
-	bool deathScriptFinished = false;
-
-	// if true, unit will not be automatically fired upon unless attacker's fireState is set to > FIREATWILL
-	bool neutral = false;
-	// if unit is currently incompletely constructed (implies buildProgress < 1)
-	bool beingBuilt = true;
-	// if the updir is straight up or align to the ground vector
-	bool upright = true;
-	// whether the ground below this unit has been terraformed
-	bool groundLevelled = true;
-
-	// true if the unit is currently cloaked (has enough energy etc)
-	bool isCloaked = false;
-	// true if the unit currently wants to be cloaked
-	bool wantCloak = false;
-
-
 	// unsynced vars
 	bool noMinimap = false;
 	bool leaveTracks = false;
@@ -562,15 +557,32 @@ public:
 
 	bool drawIcon = true;
 private:
-	// if we are stunned by a weapon or for other reason, access via IsStunned/SetStunned(bool)
-	bool stunned = false;
-
 	static float empDeclineRate;
 	static float expMultiplier;
 	static float expPowerScale;
 	static float expHealthScale;
 	static float expReloadScale;
 	static float expGrade;
+
+public:
+	// NOTE:
+	//   in-place storage for the objects behind script, moveType and
+	//   commandAI; kept behind all other members since it is larger
+	//   than the rest of the unit and would otherwise push the state
+	//   touched by the per-frame update loops onto more cache lines;
+	//   the objects are placement-new'ed, so each buffer needs to be
+	//   aligned for any of them
+	// sufficient for the largest UnitScript (CLuaUnitScript)
+	alignas(std::max_align_t) uint8_t usMemBuffer[sizeof(CLuaUnitScript)];
+	// sufficient for the largest AMoveType (CGroundMoveType)
+	// need two buffers since ScriptMoveType might be enabled
+	alignas(std::max_align_t) uint8_t amtMemBuffer[sizeof(CGroundMoveType)];
+	alignas(std::max_align_t) uint8_t smtMemBuffer[sizeof(CScriptMoveType)];
+	// sufficient for the largest CommandAI type (CBuilderCAI, or
+	// CFactoryCAI with its second command queue); knowing the exact
+	// CAI object size here is not required, static asserts will catch
+	// any overflow
+	alignas(std::max_align_t) uint8_t caiMemBuffer[std::max(sizeof(CBuilderCAI), sizeof(CFactoryCAI))];
 };
 
 #endif // UNIT_H
@@ -11,9 +11,11 @@
 #include "UnitTypes/Factory.h"
 
 #include "CommandAI/BuilderCAI.h"
+#include "Game/GameHelper.h"
 #include "Sim/Ecs/Registry.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/ModInfo.h"
+#include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
 #include "Sim/MoveTypes/Systems/GeneralMoveSystem.h"
@@ -21,6 +23,8 @@
 #include "Sim/MoveTypes/Systems/UnitTrapCheckSystem.h"
 #include "Sim/Path/IPathManager.h"
 #include "Sim/Weapons/Weapon.h"
+#include "Sim/Weapons/WeaponDef.h"
+#include "Sim/Weapons/WeaponTargetIndex.h"
 #include "System/EventHandler.h"
 #include "System/Log/ILog.h"
 #include "System/SpringMath.h"
@@ -36,6 +40,7 @@
 #include "System/Config/ConfigHandler.h"
 CONFIG(bool, UpdateWeaponVectorsMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded update of weapon vectors");
 CONFIG(bool, UpdateBoundingVolumeMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded update of unit bounding volumes");
+CONFIG(bool, PrepareSlowUpdateMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded preparation (weapon target lookups) for the units that SlowUpdate each frame");
 
 
 
@@ -352,6 +357,60 @@ void CUnitHandler::UpdateUnitLosStates()
 }
 
 
+void CUnitHandler::PrepareSlowUpdateUnits(const size_t idxBeg, const size_t idxEnd)
+{
+	ZoneScopedN("Sim::Unit::SlowUpdatePrepareMT");
+
+	// parallel compute phase for the serial SlowUpdate's below: the weapon
+	// target cells their AutoTarget calls are expected to scan are built up
+	// front (from last frame's aim positions) so those calls only find them
+	// ready; any cell that changes in between is rebuilt on use, and cells
+	// missed here are built on use as before, so targeting is unaffected
+	static std::array<std::vector<uint32_t>, ThreadPool::MAX_THREADS> threadCellKeys;
+	static std::vector<uint32_t> cellKeys;
+
+	for (auto& keys: threadCellKeys) {
+		keys.clear();
+	}
+
+	const int numQuads = quadField.GetNumQuadsX() * quadField.GetNumQuadsZ();
+
+	for_mt_chunk(idxBeg, idxEnd, [&](const int i) {
+		const CUnit* unit = activeUnits[i];
+
+		if (!unit->CanUpdateWeapons())
+			return;
+		if (unit->fireState < FIRESTATE_FIREATWILL)
+			return;
+
+		const int tid = ThreadPool::GetThreadNum();
+
+		for (const CWeapon* w: unit->weapons) {
+			// the Lua- and CAI-independent part of CWeapon::AllowWeaponAutoTarget
+			if (w->weaponDef->noAutoTarget || w->noAutoTarget)
+				continue;
+			if (w->slavedTo != nullptr || w->weaponDef->interceptor)
+				continue;
+
+			QuadFieldQuery qfQuery;
+			qfQuery.threadOwner = tid;
+			quadField.GetQuads(qfQuery, unit->pos, CGameHelper::GetWeaponTargetScanRadius(w));
+
+			for (const int qi: *qfQuery.quads) {
+				threadCellKeys[tid].push_back(CWeaponTargetIndex::GetCellKey(unit->allyteam, qi, numQuads));
+			}
+		}
+	});
+
+	cellKeys.clear();
+
+	for (const auto& keys: threadCellKeys) {
+		cellKeys.insert(cellKeys.end(), keys.begin(), keys.end());
+	}
+
+	weaponTargetIndex.PrebuildCells(cellKeys);
+}
+
 void CUnitHandler::SlowUpdateUnits()
 {
 	SCOPED_TIMER("Sim::Unit::SlowUpdate");
@@ -371,6 +430,9 @@ void CUnitHandler::SlowUpdateUnits()
 	activeSlowUpdateUnit = idxEnd;
 	// stagger the SlowUpdate's
 
+	if (configHandler->GetBool("PrepareSlowUpdateMT"))
+		PrepareSlowUpdateUnits(idxBeg, idxEnd);
+
 	static std::vector<CUnit*> updateBoundingVolumeList;
 	updateBoundingVolumeList.clear();
 	{
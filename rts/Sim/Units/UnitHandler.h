@@ -80,6 +80,7 @@ private:
 	void QueueDeleteUnits();
 	void DeleteUnit(CUnit* unit);
 	void DeleteUnits();
+	void PrepareSlowUpdateUnits(const size_t idxBeg, const size_t idxEnd);
 	void SlowUpdateUnits();
 	void UpdateUnitPathing(const size_t idxBeg, const size_t idxEnd);
 	void UpdateUnitMoveTypes();
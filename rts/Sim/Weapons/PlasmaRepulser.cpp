@@ -18,7 +18,6 @@
 
 CR_BIND_DERIVED(CPlasmaRepulser, CWeapon, )
 CR_REG_METADATA(CPlasmaRepulser, (
-	CR_MEMBER(tempNum),
 	CR_MEMBER(scIndex),
 
 	CR_MEMBER(hitFrameCount),
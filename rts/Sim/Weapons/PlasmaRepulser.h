@@ -64,7 +64,6 @@ private:
 public:
 	CollisionVolume collisionVolume;
 
-	int tempNum = 0;
 	int scIndex = 0;
 
 private:
@@ -0,0 +1,112 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "WeaponTargetIndex.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/QuadField.h"
+#include "Sim/Misc/TeamHandler.h"
+#include "Sim/Units/Unit.h"
+#include "System/Threading/ThreadPool.h"
+
+#include "System/Misc/TracyDefs.h"
+
+CWeaponTargetIndex weaponTargetIndex;
+
+
+void CWeaponTargetIndex::Init()
+{
+	// sized on first use, teams and quads are not known yet
+	allyTeamQuads.clear();
+
+	losEpoch = 0;
+}
+
+void CWeaponTargetIndex::Kill()
+{
+	allyTeamQuads.clear();
+}
+
+
+void CWeaponTargetIndex::BuildQuad(int allyTeam, int quadIdx, QuadTargets& qt) const
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const CQuadField::Quad& quad = quadField.GetQuad(quadIdx);
+
+	qt.targets.clear();
+	qt.offsets.clear();
+
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		qt.offsets.push_back(qt.targets.size());
+
+		if (teamHandler.Ally(allyTeam, t))
+			continue;
+
+		for (CUnit* u: quad.teamUnits[t]) {
+			// units neither in LOS nor in radar can never be auto-targeted
+			if ((u->losStatus[allyTeam] & (LOS_INLOS | LOS_INRADAR)) == 0)
+				continue;
+
+			qt.targets.push_back(u);
+		}
+	}
+
+	qt.offsets.push_back(qt.targets.size());
+
+	qt.quadStamp = quadField.GetQuadStampAt(quadIdx);
+	qt.losEpoch = losEpoch;
+	qt.frame = gs->frameNum;
+}
+
+CWeaponTargetIndex::QuadTargets& CWeaponTargetIndex::GetQuadTargets(int allyTeam, int quadIdx)
+{
+	if (allyTeamQuads.empty())
+		allyTeamQuads.resize(teamHandler.ActiveAllyTeams());
+
+	std::vector<QuadTargets>& quads = allyTeamQuads[allyTeam];
+
+	if (quads.empty())
+		quads.resize(quadField.GetNumQuadsX() * quadField.GetNumQuadsZ());
+
+	return quads[quadIdx];
+}
+
+bool CWeaponTargetIndex::IsStale(const QuadTargets& qt, int quadIdx) const
+{
+	return
+		(qt.frame != gs->frameNum) ||
+		(qt.losEpoch != losEpoch) ||
+		(qt.quadStamp != quadField.GetQuadStampAt(quadIdx));
+}
+
+CWeaponTargetIndex::TargetRange CWeaponTargetIndex::GetTargets(int allyTeam, int quadIdx, int enemyAllyTeam)
+{
+	QuadTargets& qt = GetQuadTargets(allyTeam, quadIdx);
+
+	if (IsStale(qt, quadIdx))
+		BuildQuad(allyTeam, quadIdx, qt);
+
+	return {qt.targets.data() + qt.offsets[enemyAllyTeam], qt.targets.data() + qt.offsets[enemyAllyTeam + 1]};
+}
+
+void CWeaponTargetIndex::PrebuildCells(std::vector<uint32_t>& cellKeys)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const int numQuads = quadField.GetNumQuadsX() * quadField.GetNumQuadsZ();
+
+	std::sort(cellKeys.begin(), cellKeys.end());
+	cellKeys.erase(std::unique(cellKeys.begin(), cellKeys.end()), cellKeys.end());
+
+	// (re)size serially and drop the cells that are still fresh, so
+	// the workers below only ever write to their own QuadTargets
+	const auto IsFresh = [&](uint32_t key) {
+		return !IsStale(GetQuadTargets(key / numQuads, key % numQuads), key % numQuads);
+	};
+
+	cellKeys.erase(std::remove_if(cellKeys.begin(), cellKeys.end(), IsFresh), cellKeys.end());
+
+	for_mt(0, cellKeys.size(), [&](const int i) {
+		const int allyTeam = cellKeys[i] / numQuads;
+		const int quadIdx = cellKeys[i] % numQuads;
+
+		BuildQuad(allyTeam, quadIdx, allyTeamQuads[allyTeam][quadIdx]);
+	});
+}
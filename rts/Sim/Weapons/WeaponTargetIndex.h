@@ -0,0 +1,79 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef WEAPON_TARGET_INDEX_H
+#define WEAPON_TARGET_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+class CUnit;
+
+/**
+ * Per-allyteam cache of the enemy units (LOS or radar contacts only) in
+ * each QuadField cell, shared by all weapons auto-targeting in a frame.
+ * Cells are (re)built lazily and only reused while the frame, the cell's
+ * QuadField stamp and the global LOS-status epoch are unchanged, so the
+ * targets seen are always exactly those a direct QuadField scan yields.
+ */
+class CWeaponTargetIndex
+{
+public:
+	struct TargetRange {
+		CUnit* const* begin() const { return b; }
+		CUnit* const* end() const { return e; }
+
+		CUnit* const* b;
+		CUnit* const* e;
+	};
+
+	void Init();
+	void Kill();
+
+	/// must be called whenever a LOS_INLOS or LOS_INRADAR bit of any unit's losStatus changes
+	void LosStatusChanged() { losEpoch++; }
+
+	/**
+	 * Returns the LOS or radar contacts of <allyTeam> that belong to
+	 * <enemyAllyTeam> in quad <quadIdx>, in QuadField teamUnits order.
+	 * The range is invalidated by the next call for the same cell.
+	 */
+	TargetRange GetTargets(int allyTeam, int quadIdx, int enemyAllyTeam);
+
+	static uint32_t GetCellKey(int allyTeam, int quadIdx, int numQuads) { return (allyTeam * numQuads + quadIdx); }
+
+	/**
+	 * Builds the stale cells among <cellKeys> (see GetCellKey) ahead of
+	 * their first GetTargets call, in parallel; GetTargets still checks
+	 * each cell when it is used, so this only moves work off the serial
+	 * path. <cellKeys> is sorted and made unique in the process.
+	 */
+	void PrebuildCells(std::vector<uint32_t>& cellKeys);
+
+private:
+	struct QuadTargets {
+		// targets of every enemy allyteam, grouped by allyteam
+		std::vector<CUnit*> targets;
+		// first index into <targets> per allyteam, plus the end
+		std::vector<uint32_t> offsets;
+
+		uint64_t quadStamp = 0;
+		uint32_t losEpoch = 0;
+
+		int frame = -1;
+	};
+
+	void BuildQuad(int allyTeam, int quadIdx, QuadTargets& qt) const;
+
+	QuadTargets& GetQuadTargets(int allyTeam, int quadIdx);
+	bool IsStale(const QuadTargets& qt, int quadIdx) const;
+
+private:
+	// [allyTeam][quadIdx]
+	std::vector< std::vector<QuadTargets> > allyTeamQuads;
+
+	uint32_t losEpoch = 0;
+};
+
+extern CWeaponTargetIndex weaponTargetIndex;
+
+#endif
@@ -0,0 +1,118 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "MemoryMappedFile.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#else
+	#include <windows.h>
+#endif
+
+
+CMemoryMappedFile& CMemoryMappedFile::operator = (CMemoryMappedFile&& f) noexcept
+{
+	if (this == &f)
+		return *this;
+
+	Close();
+
+	std::swap(data, f.data);
+	std::swap(size, f.size);
+
+	#ifdef _WIN32
+	std::swap(fileHandle, f.fileHandle);
+	std::swap(mapHandle, f.mapHandle);
+	#endif
+
+	return *this;
+}
+
+
+bool CMemoryMappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	#ifndef _WIN32
+	const int fd = open(filePath.c_str(), O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	void* ptr = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+
+	if (ptr == MAP_FAILED)
+		return false;
+
+	data = reinterpret_cast<const std::uint8_t*>(ptr);
+	size = info.st_size;
+
+	#else
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (ptr == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	data = reinterpret_cast<const std::uint8_t*>(ptr);
+	size = fileSize.QuadPart;
+
+	fileHandle = file;
+	mapHandle = mapping;
+	#endif
+
+	return true;
+}
+
+void CMemoryMappedFile::Close()
+{
+	if (data == nullptr)
+		return;
+
+	#ifndef _WIN32
+	munmap(const_cast<std::uint8_t*>(data), size);
+	#else
+	UnmapViewOfFile(data);
+	CloseHandle(mapHandle);
+	CloseHandle(fileHandle);
+
+	fileHandle = nullptr;
+	mapHandle = nullptr;
+	#endif
+
+	data = nullptr;
+	size = 0;
+}
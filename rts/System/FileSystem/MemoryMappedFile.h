@@ -0,0 +1,48 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef MEMORY_MAPPED_FILE_H
+#define MEMORY_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+/**
+ * Read-only view of a (raw filesystem, not VFS) file mapped into memory.
+ * Meant for large cache-files that are only partially touched or copied
+ * straight into their destination, so that no intermediate buffer holding
+ * the whole file has to be allocated.
+ */
+class CMemoryMappedFile
+{
+public:
+	CMemoryMappedFile() = default;
+	CMemoryMappedFile(const std::string& filePath) { Open(filePath); }
+	CMemoryMappedFile(const CMemoryMappedFile&) = delete;
+	CMemoryMappedFile(CMemoryMappedFile&& f) noexcept { *this = std::move(f); }
+	~CMemoryMappedFile() { Close(); }
+
+	CMemoryMappedFile& operator = (const CMemoryMappedFile&) = delete;
+	CMemoryMappedFile& operator = (CMemoryMappedFile&& f) noexcept;
+
+	/// <filePath> must be an absolute path; returns false if the file can not be mapped
+	bool Open(const std::string& filePath);
+	void Close();
+
+	bool IsOpen() const { return (data != nullptr); }
+
+	const std::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	const std::uint8_t* data = nullptr;
+	size_t size = 0;
+
+	#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mapHandle = nullptr;
+	#endif
+};
+
+#endif // MEMORY_MAPPED_FILE_H
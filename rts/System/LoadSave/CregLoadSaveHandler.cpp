@@ -1,11 +1,13 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <algorithm>
+#include <fstream>
 #include <sstream>
-#include <zlib.h>
 
 #include "ExternalAI/SkirmishAIHandler.h"
 #include "ExternalAI/EngineOutHandler.h"
 #include "CregLoadSaveHandler.h"
+#include "SaveGameBlocks.h"
 #include "Map/ReadMap.h"
 #include "Game/Game.h"
 #include "Game/GameSetup.h"
@@ -224,7 +226,7 @@ static void ReadString(std::istream& s, std::string& str)
 }
 
 
-static void SaveLuaState(CSplitLuaHandle* handle, creg::COutputStreamSerializer& os, std::stringstream& oss)
+static void SaveLuaState(CSplitLuaHandle* handle, creg::COutputStreamSerializer& os, std::ostream& oss)
 {
 	CLuaStateCollector lsc;
 	lsc.Read(handle);
@@ -260,7 +262,9 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 	selectedUnitsHandler.ClearSelected();
 
 	try {
-		std::stringstream oss;
+		// the sim only pauses for capturing the state, compression happens in the background
+		CSaveGameBlockBuffer saveBuffer;
+		std::ostream oss(&saveBuffer);
 
 		// write our own header. SavePackage() will add its own
 		WriteString(oss, SpringVersion::GetSync());
@@ -303,23 +307,35 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 		}
 
 		{
-			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
+			std::ofstream file(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE), std::ios::out | std::ios::binary);
 
-			if (file == nullptr) {
+			if (!file.is_open()) {
 				LOG_L(L_ERROR, "[LSH::%s] could not open save-file", __func__);
 				return;
 			}
 
-			std::string data = oss.str();
-			std::function<void(gzFile, std::string&&)> func = [](gzFile file, std::string&& data) {
-				gzwrite(file, data.c_str(), data.size());
-				gzflush(file, Z_FINISH);
-				gzclose(file);
+			// leave some cores to the simulation
+			const int numThreads = std::clamp(int(spring::thread::hardware_concurrency()) / 2, 1, 4);
+
+			const auto func = [numThreads](std::ofstream&& file, std::vector<CSaveGameBlockBuffer::Block>&& blocks, std::function<void()>&& onSaved) {
+				if (!SaveGameBlocks::Write(file, std::move(blocks), 5, numThreads)) {
+					LOG_L(L_ERROR, "[LSH::SaveGame] could not write save-file");
+					return;
+				}
+
+				file.close();
+
+				if (file.fail()) {
+					LOG_L(L_ERROR, "[LSH::SaveGame] could not close save-file");
+					return;
+				}
+
+				if (onSaved)
+					onSaved();
 			};
 
-			// gzFile is just a plain typedef (struct gzFile_s {}* gzFile), can be copied
 			// need to keep a reference to the future around or its destructor will block
-			ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::move(data))));
+			ThreadPool::AddExtJob(std::move(std::async(std::launch::async, func, std::move(file), saveBuffer.ReleaseBlocks(), std::move(onSaved))));
 		}
 
 		//FIXME add lua state
@@ -342,16 +358,30 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 /// loads the data (map&mod-name,setup-script) needed by PreGame
 bool CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 {
-	CGZFileHandler saveFile(dataDirsAccess.LocateFile(FindSaveFile(path)), SPRING_VFS_RAW_FIRST);
+	const std::string saveFilePath = dataDirsAccess.LocateFile(FindSaveFile(path));
 
 	std::stringbuf* sbuf = iss.rdbuf();
 	std::string saveVersion;
 	std::string syncVersion = SpringVersion::GetSync();
 
-	char buf[4096];
-	int len;
-	while ((len = saveFile.Read(buf, sizeof(buf))) > 0)
-		sbuf->sputn(buf, len);
+	{
+		CFileHandler rawFile(saveFilePath, SPRING_VFS_RAW_FIRST);
+
+		std::vector<std::uint8_t> rawData(std::max(rawFile.FileSize(), 0));
+		std::vector<std::uint8_t> saveData;
+
+		// saves written in blocks are uncompressed in parallel, older ones by gzread
+		if (!rawData.empty() && rawFile.Read(rawData.data(), rawData.size()) == int(rawData.size()) && SaveGameBlocks::Read(rawData.data(), rawData.size(), saveData)) {
+			sbuf->sputn(reinterpret_cast<const char*>(saveData.data()), saveData.size());
+		} else {
+			CGZFileHandler saveFile(saveFilePath, SPRING_VFS_RAW_FIRST);
+
+			char buf[4096];
+			int len;
+			while ((len = saveFile.Read(buf, sizeof(buf))) > 0)
+				sbuf->sputn(buf, len);
+		}
+	}
 
 	ReadString(iss, saveVersion);
 
@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "Demo.h"
+#include "Net/Protocol/NetMessageTypes.h"
 
 #include <cstring>
 
@@ -9,3 +10,22 @@ CDemo::CDemo():
 {
 	memset(&fileHeader, 0, sizeof(DemoFileHeader));
 }
+
+
+void CDemo::UpdateFrameNum(const unsigned char* msg, unsigned msgSize)
+{
+	if (msgSize == 0)
+		return;
+
+	switch (msg[0]) {
+		case NETMSG_KEYFRAME: {
+			if (msgSize >= (1 + sizeof(std::int32_t)))
+				memcpy(&demoFrameNum, msg + 1, sizeof(std::int32_t));
+		} break;
+		case NETMSG_NEWFRAME: {
+			demoFrameNum += 1;
+		} break;
+		default: {
+		} break;
+	}
+}
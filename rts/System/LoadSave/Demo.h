@@ -19,9 +19,16 @@ public:
 
 	const DemoFileHeader& GetFileHeader() const { return fileHeader; }
 
+protected:
+	/// follow the sim frame through a demo packet, as clients do when running the demo
+	void UpdateFrameNum(const unsigned char* msg, unsigned msgSize);
+
 protected:
 	DemoFileHeader fileHeader;
 	std::string demoName;
+
+	/// sim frame reached by the packets read or written so far
+	int demoFrameNum = -1;
 };
 
 #endif // _DEMO_H
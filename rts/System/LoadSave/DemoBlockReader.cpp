@@ -0,0 +1,140 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "DemoBlockReader.h"
+#include "SaveGameBlocks.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+bool CDemoBlockReader::Open(const std::string& filePath)
+{
+	Close();
+
+	if (!file.Open(filePath))
+		return false;
+
+	const std::uint8_t* src = file.GetData();
+	const size_t srcSize = file.GetSize();
+
+	hasIndex = true;
+
+	for (size_t srcPos = 0; srcPos < srcSize; ) {
+		SaveGameBlocks::MemberInfo info;
+
+		// a demo that was being written when the engine died can end in
+		// a partial member; everything before it is still usable
+		if (!SaveGameBlocks::ParseMember(src + srcPos, srcSize - srcPos, info))
+			break;
+
+		Block& block = blocks.emplace_back();
+		block.srcOffset = srcPos;
+		block.dataOffset = dataSize;
+		block.dataSize = info.dataSize;
+		block.memberHeaderSize = info.headerSize;
+		block.memberSize = info.memberSize;
+
+		size_t indexSize = 0;
+		const std::uint8_t* indexData = SaveGameBlocks::FindSubfield(info, 'D', 'F', indexSize);
+
+		if ((block.hasIndex = (indexData != nullptr && indexSize == sizeof(DemoBlockIndex)))) {
+			std::memcpy(&block.index, indexData, sizeof(DemoBlockIndex));
+			block.index.swab();
+		} else {
+			block.index.Clear();
+		}
+
+		// the first block holds the file header, which has no index
+		hasIndex &= (block.hasIndex || blocks.size() == 1);
+
+		srcPos += info.memberSize;
+		dataSize += info.dataSize;
+	}
+
+	if (blocks.empty()) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void CDemoBlockReader::Close()
+{
+	file.Close();
+
+	blocks.clear();
+	blockData.clear();
+
+	loadedBlock = size_t(-1);
+	dataSize = 0;
+	pos = 0;
+
+	hasIndex = false;
+}
+
+
+size_t CDemoBlockReader::Read(void* dst, size_t size)
+{
+	size_t numRead = 0;
+
+	while (numRead < size && pos < dataSize) {
+		const size_t blockIdx = FindBlock(pos);
+		const Block& block = blocks[blockIdx];
+		const std::uint8_t* data = LoadBlock(blockIdx);
+
+		if (data == nullptr)
+			break;
+
+		const size_t blockPos = pos - block.dataOffset;
+		const size_t count = std::min(size - numRead, block.dataSize - blockPos);
+
+		std::memcpy(static_cast<std::uint8_t*>(dst) + numRead, data + blockPos, count);
+
+		numRead += count;
+		pos += count;
+	}
+
+	return numRead;
+}
+
+bool CDemoBlockReader::Seek(size_t newPos)
+{
+	if (newPos > dataSize)
+		return false;
+
+	// nothing to decompress until the next Read
+	pos = newPos;
+	return true;
+}
+
+
+size_t CDemoBlockReader::FindBlock(size_t dataPos) const
+{
+	const auto pred = [](size_t p, const Block& b) { return (p < b.dataOffset); };
+	const auto iter = std::upper_bound(blocks.begin(), blocks.end(), dataPos, pred);
+
+	return (std::max(iter, blocks.begin() + 1) - blocks.begin() - 1);
+}
+
+const std::uint8_t* CDemoBlockReader::LoadBlock(size_t blockIdx)
+{
+	if (blockIdx == loadedBlock)
+		return blockData.data();
+
+	const Block& block = blocks[blockIdx];
+
+	SaveGameBlocks::MemberInfo info;
+	info.headerSize = block.memberHeaderSize;
+	info.memberSize = block.memberSize;
+	info.dataSize = block.dataSize;
+
+	blockData.resize(block.dataSize);
+	loadedBlock = size_t(-1);
+
+	if (!SaveGameBlocks::InflateMember(file.GetData() + block.srcOffset, info, blockData.data()))
+		return nullptr;
+
+	loadedBlock = blockIdx;
+	return blockData.data();
+}
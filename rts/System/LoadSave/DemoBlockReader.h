@@ -0,0 +1,75 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_BLOCK_READER_H
+#define DEMO_BLOCK_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "demofile.h"
+#include "System/FileSystem/MemoryMappedFile.h"
+
+/**
+ * Random-access view of a demo written by CDemoStreamWriter. The file is
+ * memory-mapped and its blocks are located from their gzip headers alone;
+ * a block is only decompressed once data inside it is read, and only the
+ * most recently read block is kept around.
+ *
+ * Demos written as a single gzip stream (by older versions) can not be
+ * opened this way and have to go through CGZFileHandler.
+ */
+class CDemoBlockReader
+{
+public:
+	struct Block {
+		/// offset of the gzip member within the file
+		size_t srcOffset = 0;
+		/// offset and size of the block within the uncompressed demo
+		size_t dataOffset = 0;
+		size_t dataSize = 0;
+
+		size_t memberHeaderSize = 0;
+		size_t memberSize = 0;
+
+		// packed, keep it aligned
+		DemoBlockIndex index;
+		bool hasIndex = false;
+	};
+
+	/// <filePath> must be an absolute path; returns false if the file was not written by CDemoStreamWriter
+	bool Open(const std::string& filePath);
+	void Close();
+
+	bool IsOpen() const { return (!blocks.empty()); }
+	/// true if every block after the header carries a DemoBlockIndex
+	bool HasIndex() const { return hasIndex; }
+
+	size_t Read(void* dst, size_t size);
+	bool Seek(size_t pos);
+
+	size_t GetPos() const { return pos; }
+	size_t GetSize() const { return dataSize; }
+
+	const std::vector<Block>& GetBlocks() const { return blocks; }
+	/// index of the block holding uncompressed byte <pos>
+	size_t FindBlock(size_t pos) const;
+
+private:
+	const std::uint8_t* LoadBlock(size_t blockIdx);
+
+private:
+	CMemoryMappedFile file;
+
+	std::vector<Block> blocks;
+	std::vector<std::uint8_t> blockData;
+
+	size_t loadedBlock = size_t(-1);
+	size_t dataSize = 0;
+	size_t pos = 0;
+
+	bool hasIndex = false;
+};
+
+#endif // DEMO_BLOCK_READER_H
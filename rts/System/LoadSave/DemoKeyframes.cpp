@@ -0,0 +1,78 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "DemoKeyframes.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+
+
+void CDemoKeyframeIndex::Parse(const std::string& indexText)
+{
+	std::istringstream stream(indexText);
+	std::string line;
+
+	keyframes.clear();
+
+	// one "<frame> <savefile>" pair per line
+	while (std::getline(stream, line)) {
+		const size_t sep = line.find(' ');
+
+		if (sep == std::string::npos || sep == 0 || (sep + 1) >= line.size())
+			continue;
+		if (line.find_first_not_of("0123456789") != sep)
+			continue;
+
+		int frameNum = 0;
+
+		// out of range for int
+		if (std::from_chars(line.data(), line.data() + sep, frameNum).ec != std::errc())
+			continue;
+
+		Insert(frameNum, line.substr(sep + 1));
+	}
+}
+
+bool CDemoKeyframeIndex::Append(const std::string& indexPath, int frameNum, const std::string& saveFile)
+{
+	if (frameNum < 0 || saveFile.empty() || saveFile.find('\n') != std::string::npos)
+		return false;
+
+	std::ofstream file(indexPath, std::ios::out | std::ios::app | std::ios::binary);
+
+	if (!file.is_open())
+		return false;
+
+	file << frameNum << ' ' << saveFile << '\n';
+	file.close();
+
+	Insert(frameNum, saveFile);
+	return (!file.fail());
+}
+
+
+const CDemoKeyframeIndex::Keyframe* CDemoKeyframeIndex::FindKeyframe(int frameNum) const
+{
+	const auto pred = [](int f, const Keyframe& k) { return (f < k.frameNum); };
+	const auto iter = std::upper_bound(keyframes.begin(), keyframes.end(), frameNum, pred);
+
+	if (iter == keyframes.begin())
+		return nullptr;
+
+	return &*(iter - 1);
+}
+
+void CDemoKeyframeIndex::Insert(int frameNum, const std::string& saveFile)
+{
+	const auto pred = [](const Keyframe& k, int f) { return (k.frameNum < f); };
+	const auto iter = std::lower_bound(keyframes.begin(), keyframes.end(), frameNum, pred);
+
+	// a later keyframe for the same frame (e.g. from watching the demo again) replaces the earlier one
+	if (iter != keyframes.end() && iter->frameNum == frameNum) {
+		iter->saveFile = saveFile;
+		return;
+	}
+
+	keyframes.insert(iter, {frameNum, saveFile});
+}
@@ -0,0 +1,44 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_KEYFRAMES_H
+#define DEMO_KEYFRAMES_H
+
+#include <string>
+#include <vector>
+
+/**
+ * Index of the savegames ("keyframes") written while a demo was recorded
+ * or watched. It lives in a sidecar file next to the demo so that neither
+ * the demo format nor older readers are affected, and is appended to one
+ * line per keyframe so an interrupted game keeps all keyframes written up
+ * to that point.
+ */
+class CDemoKeyframeIndex
+{
+public:
+	struct Keyframe {
+		int frameNum;
+		std::string saveFile;
+	};
+
+	static std::string GetIndexFileName(const std::string& demoName) { return (demoName + ".keyframes"); }
+
+	/// parses the contents of an index file, malformed lines are skipped
+	void Parse(const std::string& indexText);
+	/// adds a keyframe and appends it to the index file at <indexPath>
+	bool Append(const std::string& indexPath, int frameNum, const std::string& saveFile);
+	void Clear() { keyframes.clear(); }
+
+	/// latest keyframe at or before <frameNum>, or nullptr if there is none
+	const Keyframe* FindKeyframe(int frameNum) const;
+	const std::vector<Keyframe>& GetKeyframes() const { return keyframes; }
+
+private:
+	void Insert(int frameNum, const std::string& saveFile);
+
+private:
+	/// sorted by frame
+	std::vector<Keyframe> keyframes;
+};
+
+#endif // DEMO_KEYFRAMES_H
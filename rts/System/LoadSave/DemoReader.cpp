@@ -7,9 +7,12 @@
 
 #ifndef TOOLS
 #include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/Platform/Misc.h"
 CONFIG(bool, DisableDemoVersionCheck).defaultValue(false).description("Allow to play every replay file (may crash / cause undefined behaviour in replays)");
 #endif
 #include "System/Exceptions.h"
+#include "System/FileSystem/FileHandler.h"
 #include "System/FileSystem/GZFileHandler.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
@@ -48,17 +51,35 @@ static bool CheckDemoHeader(const DemoFileHeader& fileHeader)
 	return true;
 }
 
+// same search order as CGZFileHandler; demos inside archives are never mapped
+static bool OpenDemoBlocks(CDemoBlockReader& reader, const std::string& filename)
+{
+#ifndef TOOLS
+	if (!FileSystem::IsAbsolutePath(filename) && reader.Open(Platform::GetOrigCWD() + filename))
+		return true;
 
-CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDemo(new CGZFileHandler(filename, SPRING_VFS_PWD_ALL))
+	return (reader.Open(dataDirsAccess.LocateFile(filename)));
+#else
+	return (reader.Open(filename));
+#endif
+}
+
+
+CDemoReader::CDemoReader(const std::string& filename, float curTime)
 {
 	if (FileSystem::GetExtension(filename) != "sdfz")
 		throw content_error("Unknown demo extension: " + FileSystem::GetExtension(filename));
 
-	// file not found -> exception
-	if (!playbackDemo->FileExists())
-		throw user_error("Demofile not found: " + filename);
+	// demos written as a single gzip stream have to be decompressed as a whole
+	if (!OpenDemoBlocks(blockDemo, filename)) {
+		playbackDemo = new CGZFileHandler(filename, SPRING_VFS_PWD_ALL);
 
-	playbackDemo->Read((char*)&fileHeader, sizeof(fileHeader));
+		// file not found -> exception
+		if (!playbackDemo->FileExists())
+			throw user_error("Demofile not found: " + filename);
+	}
+
+	ReadDemo(&fileHeader, sizeof(fileHeader));
 	fileHeader.swab();
 
 	if (!CheckDemoHeader(fileHeader)) {
@@ -66,7 +87,7 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 			const char* fmt = "[%s] demo-file \"%s\" (%d bytes, magic \"%s\") corrupt or created by a different Spring version, expected \"%s\"";
 
 			memset(buf, 0, sizeof(buf));
-			snprintf(buf, sizeof(buf) - 1, fmt, __func__, filename.c_str(), playbackDemo->FileSize(), fileHeader.magic, fileHeader.versionString);
+			snprintf(buf, sizeof(buf) - 1, fmt, __func__, filename.c_str(), GetDemoSize(), fileHeader.magic, fileHeader.versionString);
 
 #ifndef TOOLS
 			if (!configHandler->GetBool("DisableDemoVersionCheck"))
@@ -77,18 +98,17 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 
 	if (fileHeader.scriptSize != 0) {
 		setupScript.resize(fileHeader.scriptSize, 0);
-		playbackDemo->Read(const_cast<char*>(setupScript.data()), setupScript.size());
+		ReadDemo(const_cast<char*>(setupScript.data()), setupScript.size());
 	}
 
-	playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader));
+	ReadDemo(&chunkHeader, sizeof(chunkHeader));
 	chunkHeader.swab();
 
 	demoTimeOffset = curTime - chunkHeader.modGameTime - 0.1f;
 	nextDemoReadTime = curTime - 0.01f;
 
-	const long curPos = playbackDemo->GetPos();
-	playbackDemo->Seek(0, std::ios::end);
-	playbackDemoSize = playbackDemo->GetPos();
+	const int curPos = GetDemoPos();
+	playbackDemoSize = GetDemoSize();
 
 	if (fileHeader.demoStreamSize != 0) {
 		bytesRemaining = fileHeader.demoStreamSize;
@@ -99,7 +119,15 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 		// (if this had still used CFileHandler that would have been easier ;-))
 		bytesRemaining = playbackDemoSize - curPos;
 	}
-	playbackDemo->Seek(curPos);
+
+	{
+		// keyframes written by earlier runs, if any
+		CFileHandler indexFile(CDemoKeyframeIndex::GetIndexFileName(filename), SPRING_VFS_PWD_ALL);
+		std::string indexText;
+
+		if (indexFile.LoadStringData(indexText))
+			keyframeIndex.Parse(indexText);
+	}
 }
 
 
@@ -118,25 +146,11 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 	// always pass the same readTime value) so no seperate
 	// check needed
 	if (readTime >= nextDemoReadTime) {
-		netcode::RawPacket* buf = new netcode::RawPacket(chunkHeader.length);
-		if (playbackDemo->Read((char*)(buf->data), chunkHeader.length) < chunkHeader.length) {
-			delete buf;
-			bytesRemaining = 0;
+		netcode::RawPacket* buf = ReadChunk();
+
+		if (buf == nullptr)
 			return nullptr;
-		}
-		bytesRemaining -= chunkHeader.length;
 
-		if (!ReachedEnd()) {
-			// read next chunk header
-			if (playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader)) < sizeof(chunkHeader)) {
-				delete buf;
-				bytesRemaining = 0;
-				return nullptr;
-			}
-			chunkHeader.swab();
-			nextDemoReadTime = chunkHeader.modGameTime + demoTimeOffset;
-			bytesRemaining -= sizeof(chunkHeader);
-		}
 		if (readTime < 0) {
 			delete buf;
 			return nullptr;
@@ -147,9 +161,190 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 	return nullptr;
 }
 
+netcode::RawPacket* CDemoReader::GetNextPacket(const DemoMsgTypeMask& msgTypes)
+{
+	const auto& blocks = blockDemo.GetBlocks();
+
+	while (!ReachedEnd()) {
+		if (blockDemo.HasIndex()) {
+			// nothing of interest left in the block the current chunk starts in, continue
+			// at the first chunk of the next block that has any (or at the end)
+			size_t blockIdx = blockDemo.FindBlock(GetDemoPos() - sizeof(chunkHeader));
+
+			if (!blocks[blockIdx].index.msgTypes.Intersects(msgTypes)) {
+				while ((++blockIdx) < blocks.size() && !blocks[blockIdx].index.msgTypes.Intersects(msgTypes));
+
+				if (blockIdx == blocks.size()) {
+					bytesRemaining = 0;
+					break;
+				}
+
+				const DemoBlockIndex& index = blocks[blockIdx].index;
+
+				if (!JumpToChunk(blocks[blockIdx].dataOffset + index.firstChunkOffset, index.firstChunkFrame))
+					break;
+				if (ReachedEnd())
+					break;
+			}
+		}
+
+		const int payloadPos = GetDemoPos();
+		unsigned char msgType = 0;
+
+		if (chunkHeader.length > 0) {
+			if (ReadDemo(&msgType, sizeof(msgType)) < int(sizeof(msgType))) {
+				bytesRemaining = 0;
+				break;
+			}
+
+			SeekDemo(payloadPos);
+
+			if (msgTypes.Contains(msgType))
+				return ReadChunk();
+		}
+
+		if (!SkipChunk())
+			break;
+	}
+
+	return nullptr;
+}
+
+bool CDemoReader::SeekToFrame(int frameNum)
+{
+	if (blockDemo.HasIndex() && (frameNum < demoFrameNum || frameNum > demoFrameNum + 1)) {
+		// continue at the last block starting before the frame, unless the current chunk is closer
+		const auto& blocks = blockDemo.GetBlocks();
+		const size_t chunkPos = GetDemoPos() - sizeof(chunkHeader);
+
+		for (size_t i = blocks.size() - 1; i > 0; i--) {
+			const DemoBlockIndex& index = blocks[i].index;
+
+			if (index.firstChunkOffset == DemoBlockIndex::NO_CHUNK)
+				continue;
+			if (index.firstChunkFrame >= frameNum && i > 1)
+				continue;
+
+			if (frameNum < demoFrameNum || (blocks[i].dataOffset + index.firstChunkOffset) > chunkPos) {
+				if (!JumpToChunk(blocks[i].dataOffset + index.firstChunkOffset, index.firstChunkFrame))
+					return false;
+			}
+
+			break;
+		}
+	}
+
+	while (demoFrameNum < frameNum && !ReachedEnd()) {
+		if (!SkipChunk())
+			return false;
+	}
+
+	return (demoFrameNum == frameNum);
+}
+
+
+netcode::RawPacket* CDemoReader::ReadChunk()
+{
+	netcode::RawPacket* buf = new netcode::RawPacket(chunkHeader.length);
+
+	if (ReadDemo(buf->data, chunkHeader.length) < int(chunkHeader.length)) {
+		delete buf;
+		bytesRemaining = 0;
+		return nullptr;
+	}
+	bytesRemaining -= chunkHeader.length;
+
+	UpdateFrameNum(buf->data, chunkHeader.length);
+
+	if (!ReachedEnd() && !ReadChunkHeader()) {
+		delete buf;
+		return nullptr;
+	}
+
+	return buf;
+}
+
+bool CDemoReader::ReadChunkHeader()
+{
+	if (ReadDemo(&chunkHeader, sizeof(chunkHeader)) < int(sizeof(chunkHeader))) {
+		bytesRemaining = 0;
+		return false;
+	}
+
+	chunkHeader.swab();
+	nextDemoReadTime = chunkHeader.modGameTime + demoTimeOffset;
+	bytesRemaining -= sizeof(chunkHeader);
+	return true;
+}
+
+bool CDemoReader::SkipChunk()
+{
+	// only the message type and a keyframe's frame number are needed
+	unsigned char msg[1 + sizeof(std::int32_t)];
+
+	const int msgSize = std::min(int(chunkHeader.length), int(sizeof(msg)));
+	const int chunkEnd = GetDemoPos() + chunkHeader.length;
+
+	if (chunkEnd > playbackDemoSize || ReadDemo(msg, msgSize) < msgSize) {
+		bytesRemaining = 0;
+		return false;
+	}
+
+	UpdateFrameNum(msg, msgSize);
+	SeekDemo(chunkEnd);
+
+	bytesRemaining -= chunkHeader.length;
+	return (ReachedEnd() || ReadChunkHeader());
+}
+
+bool CDemoReader::JumpToChunk(size_t chunkPos, int frameNum)
+{
+	// we are past the current chunk's header, chunkPos is the next one's
+	bytesRemaining -= (int(chunkPos) - GetDemoPos());
+	SeekDemo(chunkPos);
+
+	demoFrameNum = frameNum;
+	return (ReachedEnd() || ReadChunkHeader());
+}
+
+
+int CDemoReader::ReadDemo(void* dst, int size)
+{
+	if (blockDemo.IsOpen())
+		return (int(blockDemo.Read(dst, size)));
+
+	return (playbackDemo->Read(dst, size));
+}
+
+void CDemoReader::SeekDemo(int pos)
+{
+	if (blockDemo.IsOpen()) {
+		blockDemo.Seek(pos);
+	} else {
+		playbackDemo->Seek(pos);
+	}
+}
+
+int CDemoReader::GetDemoPos()
+{
+	if (blockDemo.IsOpen())
+		return (int(blockDemo.GetPos()));
+
+	return (playbackDemo->GetPos());
+}
+
+int CDemoReader::GetDemoSize()
+{
+	if (blockDemo.IsOpen())
+		return (int(blockDemo.GetSize()));
+
+	return (playbackDemo->FileSize());
+}
+
+
 bool CDemoReader::ReachedEnd()
 {
-	return (bytesRemaining <= 0 || playbackDemo->Eof() || (playbackDemo->GetPos() > playbackDemoSize));
+	return (bytesRemaining <= 0 || GetDemoPos() >= playbackDemoSize);
 }
 
 
@@ -159,8 +354,9 @@ void CDemoReader::LoadStats()
 	if (fileHeader.demoStreamSize == 0)
 		return;
 
-	const int curPos = playbackDemo->GetPos();
-	playbackDemo->Seek(fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize);
+	// with a memory-mapped demo only the last blocks get decompressed
+	const int curPos = GetDemoPos();
+	SeekDemo(fileHeader.headerSize + fileHeader.scriptSize + fileHeader.demoStreamSize);
 
 	winningAllyTeams.clear();
 	playerStats.clear();
@@ -168,13 +364,13 @@ void CDemoReader::LoadStats()
 
 	for (int allyTeamNum = 0; allyTeamNum < fileHeader.winningAllyTeamsSize; ++allyTeamNum) {
 		unsigned char winnerAllyTeam;
-		playbackDemo->Read((char*) &winnerAllyTeam, sizeof(unsigned char));
+		ReadDemo(&winnerAllyTeam, sizeof(unsigned char));
 		winningAllyTeams.push_back(winnerAllyTeam);
 	}
 
 	for (int playerNum = 0; playerNum < fileHeader.numPlayers; ++playerNum) {
 		PlayerStatistics buf;
-		playbackDemo->Read(reinterpret_cast<char*>(&buf), sizeof(PlayerStatistics));
+		ReadDemo(&buf, sizeof(PlayerStatistics));
 		buf.swab();
 		playerStats.push_back(buf);
 	}
@@ -186,17 +382,17 @@ void CDemoReader::LoadStats()
 
 		assert(fileHeader.numTeams <= numStatsPerTeam.size());
 		numStatsPerTeam.fill(0);
-		playbackDemo->Read(reinterpret_cast<char*>(numStatsPerTeam.data()), fileHeader.numTeams);
+		ReadDemo(numStatsPerTeam.data(), fileHeader.numTeams);
 
 		for (int teamNum = 0; teamNum < fileHeader.numTeams; ++teamNum) {
 			for (int i = 0; i < numStatsPerTeam[teamNum]; ++i) {
 				TeamStatistics buf;
-				playbackDemo->Read(reinterpret_cast<char*>(&buf), sizeof(TeamStatistics));
+				ReadDemo(&buf, sizeof(TeamStatistics));
 				buf.swab();
 				teamStats[teamNum].push_back(buf);
 			}
 		}
 	}
 
-	playbackDemo->Seek(curPos);
+	SeekDemo(curPos);
 }
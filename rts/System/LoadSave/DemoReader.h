@@ -7,6 +7,8 @@
 #include <vector>
 
 #include "Demo.h"
+#include "DemoBlockReader.h"
+#include "DemoKeyframes.h"
 
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
@@ -39,6 +41,24 @@ public:
 	*/
 	bool ReachedEnd();
 
+	/**
+	@brief read the next packet of one of the given message types, regardless of demo time
+	Blocks without any such packets are skipped without decompressing them if the demo has a block index.
+	@return The packet (or 0 at the end of the demo), don't forget to delete it
+	*/
+	netcode::RawPacket* GetNextPacket(const DemoMsgTypeMask& msgTypes);
+
+	/**
+	@brief continue reading right after the packet that starts sim frame <frameNum>
+	Without a block index this has to read through the demo and can only move forward.
+	Demo time is not adjusted, use GetNextPacket afterwards.
+	@return false if the demo has no such frame
+	*/
+	bool SeekToFrame(int frameNum);
+
+	/// sim frame reached by the packets read so far
+	int GetFrameNum() const { return demoFrameNum; }
+
 	float GetModGameTime() const { return chunkHeader.modGameTime; }
 	float GetDemoTimeOffset() const { return demoTimeOffset; }
 	float GetNextDemoReadTime() const { return nextDemoReadTime; }
@@ -52,11 +72,27 @@ public:
 	const std::vector< std::vector<TeamStatistics> >& GetTeamStats() const { return teamStats; }
 	const std::vector< unsigned char >& GetWinningAllyTeams() const { return winningAllyTeams; }
 
+	/// savegames from the demo's sidecar keyframe index, see CDemoKeyframeIndex
+	const CDemoKeyframeIndex& GetKeyframeIndex() const { return keyframeIndex; }
+
 	/// Not needed for normal demo watching
 	void LoadStats();
 
 private:
-	CFileHandler* playbackDemo;
+	netcode::RawPacket* ReadChunk();
+	bool ReadChunkHeader();
+	bool SkipChunk();
+	bool JumpToChunk(size_t chunkPos, int frameNum);
+
+	// dispatch to blockDemo if the demo could be memory-mapped, otherwise to playbackDemo
+	int ReadDemo(void* dst, int size);
+	void SeekDemo(int pos);
+	int GetDemoPos();
+	int GetDemoSize();
+
+private:
+	CDemoBlockReader blockDemo;
+	CFileHandler* playbackDemo = nullptr;
 
 	float demoTimeOffset;
 	float nextDemoReadTime;
@@ -70,6 +106,8 @@ private:
 	std::vector<PlayerStatistics> playerStats; // one stat per player
 	std::vector< std::vector<TeamStatistics> > teamStats; // many stats per team
 	std::vector<unsigned char> winningAllyTeams;
+
+	CDemoKeyframeIndex keyframeIndex;
 };
 
 #endif
@@ -27,26 +27,27 @@
 #endif
 
 
-// server and client memory-streams
-static std::string demoStreams[2];
-static spring::mutex demoMutex;
-
-
 CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
 {
-	std::lock_guard<spring::mutex> lock(demoMutex);
-
-	SetStream();
 	SetName(mapName, modName);
 	SetFileHeader();
-	WriteFileHeader(false);
 
-	file = gzopen(demoName.c_str(), "wb9");
+	DemoFileHeader tmpHeader;
+	memcpy(&tmpHeader, &fileHeader, sizeof(fileHeader));
+	tmpHeader.swab();
+
+	writer = std::make_unique<CDemoStreamWriter>(demoName, &tmpHeader, sizeof(tmpHeader), 9);
+
+	if (writer->IsOpen())
+		return;
+
+	LOG_L(L_ERROR, "[DemoRecorder::%s] could not open \"%s\" for writing", __func__, demoName.c_str());
+	writer.reset();
 }
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (writer == nullptr)
 		return;
 
 	WriteWinnerList();
@@ -57,12 +58,6 @@ CDemoRecorder::~CDemoRecorder()
 }
 
 
-void CDemoRecorder::SetStream()
-{
-	demoStreams[isServerDemo].clear();
-	demoStreams[isServerDemo].reserve(8 * 1024 * 1024);
-}
-
 void CDemoRecorder::SetFileHeader()
 {
 	memset(&fileHeader, 0, sizeof(DemoFileHeader));
@@ -79,31 +74,32 @@ void CDemoRecorder::SetFileHeader()
 
 void CDemoRecorder::WriteDemoFile()
 {
-	// zlib FAQ claims the lib is thread-safe, "however any library routines that zlib uses and
-	// any application-provided memory allocation routines must also be thread-safe. zlib's gz*
-	// functions use stdio library routines, and most of zlib's functions use the library memory
-	// allocation routines by default" (so code below should be OK)
-	// gz* should usually be finished before ctor runs again when reloading, but take no chances
-	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
-		std::lock_guard<spring::mutex> lock(demoMutex);
-
-		gzwrite(file, data.c_str(), data.size());
-		gzflush(file, Z_FINISH);
-		gzclose(file);
+	// all but the last few blocks are already on disk; the writer
+	// still has to compress those and put the final header in place
+	const auto func = [](std::unique_ptr<CDemoStreamWriter>&& writer, std::string&& name) {
+		if (!writer->Close())
+			LOG_L(L_ERROR, "[DemoRecorder::WriteDemoFile] error writing demo \"%s\"", name.c_str());
 	};
 
-	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size());
+	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), writer->GetDataSize());
 
 	#ifndef _WIN32
 	// NOTE: can not use ThreadPool for this directly here, workers are already gone
 	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
+	ThreadPool::AddExtJob(spring::thread(func, std::move(writer), std::string(demoName)));
 	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
+	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, func, std::move(writer), std::string(demoName))));
 	#endif
 }
 
+void CDemoRecorder::Write(const void* data, size_t size)
+{
+	if (writer == nullptr)
+		return;
+
+	writer->Write(data, size);
+}
+
 void CDemoRecorder::WriteSetupText(const std::string& text)
 {
 	LOG_L(L_INFO, "[CDemoRecorder::%s] SetupText=\"%s\"", __func__,
@@ -120,7 +116,9 @@ void CDemoRecorder::WriteSetupText(const std::string& text)
 	}
 
 	fileHeader.scriptSize = length;
-	demoStreams[isServerDemo].append(text.c_str(), length);
+	Write(text.c_str(), length);
+	// keep the file readable if the game never ends cleanly
+	WriteFileHeader(false);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
@@ -130,8 +128,16 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	chunkHeader.modGameTime = modGameTime;
 	chunkHeader.length = length;
 	chunkHeader.swab();
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
+
+	if (writer != nullptr && length > 0)
+		writer->MarkChunk(modGameTime, demoFrameNum, buf[0]);
+
+	Write(&chunkHeader, sizeof(chunkHeader));
+	Write(buf, length);
+
+	// the block index needs the frame of the next chunk
+	UpdateFrameNum(buf, length);
+
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
 }
 
@@ -229,9 +235,9 @@ void CDemoRecorder::SetWinningAllyTeams(const std::vector<unsigned char>& winnin
 }
 
 /** @brief Write DemoFileHeader
-Write the DemoFileHeader at the start of the file and restores the original
-position in the file afterwards. */
-unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
+Replaces the DemoFileHeader at the start of the file, once the data written
+before this call is on disk. */
+void CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 {
 	DemoFileHeader tmpHeader;
 	memcpy(&tmpHeader, &fileHeader, sizeof(fileHeader));
@@ -242,28 +248,24 @@ unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 	// to little endian
 	tmpHeader.swab();
 
-	if (demoStreams[isServerDemo].empty()) {
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
-	} else {
-		assert(demoStreams[isServerDemo].size() >= sizeof(tmpHeader));
-		memcpy(&demoStreams[isServerDemo][0], reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)); // no non-const .data() until C++17
-	}
+	if (writer == nullptr)
+		return;
 
-	return (demoStreams[isServerDemo].size());
+	writer->SetHeader(&tmpHeader, sizeof(tmpHeader));
 }
 
 /** @brief Write the CPlayer::Statistics at the current position in the file. */
 void CDemoRecorder::WritePlayerStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = writer->GetDataSize();
 
 	for (PlayerStatistics& stats: playerStats) {
 		stats.swab();
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
+		Write(&stats, sizeof(PlayerStatistics));
 	}
 
 	fileHeader.numPlayers = playerStats.size();
-	fileHeader.playerStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.playerStatSize = int(writer->GetDataSize() - pos);
 
 	playerStats.clear();
 }
@@ -276,38 +278,38 @@ void CDemoRecorder::WriteWinnerList()
 	if (fileHeader.numTeams == 0)
 		return;
 
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = writer->GetDataSize();
 
 	// Write the array of winningAllyTeams.
 	for (size_t i = 0; i < winningAllyTeams.size(); i++) { // NOLINT{modernize-loop-convert}
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
+		Write(&winningAllyTeams[i], sizeof(unsigned char));
 	}
 
 	winningAllyTeams.clear();
 
-	fileHeader.winningAllyTeamsSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.winningAllyTeamsSize = int(writer->GetDataSize() - pos);
 }
 
 /** @brief Write the TeamStatistics at the current position in the file. */
 void CDemoRecorder::WriteTeamStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	const size_t pos = writer->GetDataSize();
 
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
+		Write(&c, sizeof(unsigned int));
 	}
 
 	// Write big array of TeamStatistics.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		for (TeamStatistics& stats: history) {
 			stats.swab();
-			demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
+			Write(&stats, sizeof(TeamStatistics));
 		}
 	}
 
-	fileHeader.teamStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.teamStatSize = int(writer->GetDataSize() - pos);
 
 	teamStats.clear();
 }
@@ -3,11 +3,12 @@
 #ifndef DEMO_RECORDER
 #define DEMO_RECORDER
 
+#include <memory>
 #include <vector>
 #include <sstream>
-#include <zlib.h>
 
 #include "Demo.h"
+#include "DemoStreamWriter.h"
 #include "Game/Players/PlayerStatistics.h"
 #include "Sim/Misc/TeamStatistics.h"
 
@@ -32,24 +33,24 @@ public:
 		memcpy(&fileHeader, &r.fileHeader, sizeof(fileHeader));
 		memset(&r.fileHeader, 0, sizeof(fileHeader));
 
-		std::swap(file, r.file);
+		std::swap(writer, r.writer);
 
 		std::swap(demoName, r.demoName);
 		std::swap(playerStats, r.playerStats);
 		std::swap(teamStats, r.teamStats);
 		std::swap(winningAllyTeams, r.winningAllyTeams);
 
+		std::swap(demoFrameNum, r.demoFrameNum);
 		std::swap(isServerDemo, r.isServerDemo);
 		return *this;
 	}
 
 
-	bool IsValid() const { return (file != nullptr); }
+	bool IsValid() const { return (writer != nullptr); }
 
 	void WriteSetupText(const std::string& text);
 	void SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime);
 
-	void SetStream();
 	void SetName(const std::string& mapName, const std::string& modName);
 	const std::string& GetName() const { return demoName; }
 
@@ -63,15 +64,16 @@ public:
 	void SetWinningAllyTeams(const std::vector<unsigned char>& winningAllyTeams);
 
 private:
-	unsigned int WriteFileHeader(bool updateStreamLength);
+	void WriteFileHeader(bool updateStreamLength);
 	void SetFileHeader();
 	void WritePlayerStats();
 	void WriteTeamStats();
 	void WriteWinnerList();
 	void WriteDemoFile();
+	void Write(const void* data, size_t size);
 
 private:
-	gzFile file = nullptr;
+	std::unique_ptr<CDemoStreamWriter> writer;
 
 	std::vector<PlayerStatistics> playerStats;
 	std::vector< std::vector<TeamStatistics> > teamStats;
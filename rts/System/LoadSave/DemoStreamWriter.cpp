@@ -0,0 +1,203 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "DemoStreamWriter.h"
+#include "SaveGameBlocks.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+CDemoStreamWriter::CDemoStreamWriter(const std::string& fileName, const void* header, size_t headerSize, int level_): level(level_)
+{
+	std::vector<std::uint8_t> headerMember;
+
+	// stored, so later versions of the header compress to the same size
+	if (!SaveGameBlocks::CompressBlock(header, headerSize, 0, headerMember))
+		return;
+
+	if ((file = std::fopen(fileName.c_str(), "wb")) == nullptr)
+		return;
+
+	if (std::fwrite(headerMember.data(), 1, headerMember.size(), file) != headerMember.size() || std::fflush(file) != 0) {
+		std::fclose(file);
+		file = nullptr;
+		return;
+	}
+
+	headerMemberSize = headerMember.size();
+	lastFlushTime = spring_gettime();
+
+	curBlock.data.reserve(BLOCK_SIZE);
+	curBlock.index.Clear();
+
+	thread = spring::thread(&CDemoStreamWriter::WriteThread, this);
+}
+
+
+void CDemoStreamWriter::MarkChunk(float modGameTime, int frameNum, std::uint8_t msgType)
+{
+	DemoBlockIndex& index = curBlock.index;
+
+	// full blocks are flushed right away, so the chunk always starts in this one
+	if (index.firstChunkOffset == DemoBlockIndex::NO_CHUNK) {
+		index.firstChunkOffset = curBlock.data.size();
+		index.firstChunkFrame = frameNum;
+		index.firstChunkTime = modGameTime;
+	}
+
+	index.msgTypes.Add(msgType);
+}
+
+
+void CDemoStreamWriter::Write(const void* data, size_t size)
+{
+	if (file == nullptr)
+		return;
+
+	for (size_t written = 0; written < size; ) {
+		const size_t count = std::min(size - written, BLOCK_SIZE - curBlock.data.size());
+		const char* src = static_cast<const char*>(data) + written;
+
+		curBlock.data.insert(curBlock.data.end(), src, src + count);
+		written += count;
+
+		if (curBlock.data.size() == BLOCK_SIZE)
+			Flush();
+	}
+
+	dataSize += size;
+
+	if ((spring_gettime() - lastFlushTime) >= spring_secs(FLUSH_INTERVAL))
+		Flush();
+}
+
+void CDemoStreamWriter::Flush()
+{
+	lastFlushTime = spring_gettime();
+
+	if (file == nullptr || curBlock.data.empty())
+		return;
+
+	{
+		std::unique_lock<spring::mutex> lock(mutex);
+
+		// the writer thread could not keep up, wait instead of growing the queue
+		queueCond.wait(lock, [&]() { return (queue.size() < MAX_QUEUED_BLOCKS); });
+		queue.emplace_back(std::move(curBlock));
+	}
+
+	queueCond.notify_all();
+
+	curBlock = {};
+	curBlock.data.reserve(BLOCK_SIZE);
+	curBlock.index.Clear();
+}
+
+void CDemoStreamWriter::SetHeader(const void* header, size_t size)
+{
+	if (file == nullptr)
+		return;
+
+	// the header describes everything written so far (e.g. the stream size),
+	// so the data it covers has to reach the writer thread before it does
+	Flush();
+
+	std::vector<std::uint8_t> headerMember;
+	SaveGameBlocks::CompressBlock(header, size, 0, headerMember);
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+		pendingHeader = std::move(headerMember);
+	}
+
+	queueCond.notify_all();
+}
+
+
+bool CDemoStreamWriter::Close()
+{
+	if (file == nullptr)
+		return false;
+
+	Flush();
+
+	{
+		std::lock_guard<spring::mutex> lock(mutex);
+		closing = true;
+	}
+
+	queueCond.notify_all();
+	thread.join();
+
+	const bool ret = (std::fclose(file) == 0 && !failed);
+
+	file = nullptr;
+	return ret;
+}
+
+
+void CDemoStreamWriter::WriteThread()
+{
+	Block block;
+	std::vector<std::uint8_t> member;
+	std::vector<std::uint8_t> header;
+
+	// 'D','F' subfield holding the block index
+	std::uint8_t indexField[4 + sizeof(DemoBlockIndex)] = {'D', 'F', sizeof(DemoBlockIndex) & 0xFF, sizeof(DemoBlockIndex) >> 8};
+
+	while (true) {
+		{
+			std::unique_lock<spring::mutex> lock(mutex);
+
+			queueCond.wait(lock, [&]() { return (!queue.empty() || !pendingHeader.empty() || closing); });
+
+			// header changes are applied after the data queued before them,
+			// so it never describes more than what is already in the file
+			if (queue.empty()) {
+				header.swap(pendingHeader);
+
+				if (header.empty())
+					break;
+			} else {
+				block = std::move(queue.front());
+				queue.pop_front();
+			}
+		}
+
+		queueCond.notify_all();
+
+		if (!header.empty()) {
+			failed |= !WriteHeader(header);
+			header.clear();
+			continue;
+		}
+
+		// to little endian
+		block.index.swab();
+		std::memcpy(indexField + 4, &block.index, sizeof(DemoBlockIndex));
+
+		if (!SaveGameBlocks::CompressBlock(block.data.data(), block.data.size(), level, member, indexField, sizeof(indexField))) {
+			failed = true;
+			continue;
+		}
+
+		// one member at a time, a crash loses at most the member being written
+		failed |= (std::fwrite(member.data(), 1, member.size(), file) != member.size());
+		failed |= (std::fflush(file) != 0);
+
+		block.data.clear();
+	}
+}
+
+bool CDemoStreamWriter::WriteHeader(const std::vector<std::uint8_t>& header)
+{
+	if (header.size() != headerMemberSize)
+		return false;
+
+	if (std::fseek(file, 0, SEEK_SET) != 0)
+		return false;
+
+	const bool written = (std::fwrite(header.data(), 1, header.size(), file) == header.size());
+
+	return (std::fseek(file, 0, SEEK_END) == 0 && std::fflush(file) == 0 && written);
+}
@@ -0,0 +1,89 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEMO_STREAM_WRITER_H
+#define DEMO_STREAM_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "demofile.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Threading/SpringThreading.h"
+
+/**
+ * Writes a demo to disk while it is being recorded. Data is collected into
+ * blocks which a background thread compresses and appends to the file as
+ * separate gzip members (see SaveGameBlocks), so memory use stays bounded
+ * and the file is readable up to the last written block at any time.
+ *
+ * The file header is kept uncompressed in its own member at the start of
+ * the file and is rewritten in place whenever it changes. Every other
+ * member carries a DemoBlockIndex built from the MarkChunk calls.
+ */
+class CDemoStreamWriter
+{
+public:
+	static constexpr size_t BLOCK_SIZE = 256 * 1024;
+	/// Write blocks once this many blocks are waiting for the writer thread
+	static constexpr size_t MAX_QUEUED_BLOCKS = 16;
+	/// partial blocks are flushed after this many seconds, bounds what a crash can lose
+	static constexpr int FLUSH_INTERVAL = 10;
+
+	CDemoStreamWriter(const std::string& fileName, const void* header, size_t headerSize, int level);
+	CDemoStreamWriter(const CDemoStreamWriter&) = delete;
+	~CDemoStreamWriter() { Close(); }
+
+	CDemoStreamWriter& operator = (const CDemoStreamWriter&) = delete;
+
+	bool IsOpen() const { return (file != nullptr); }
+
+	/// announces that the next Write starts a demo stream chunk, for the block index
+	void MarkChunk(float modGameTime, int frameNum, std::uint8_t msgType);
+	void Write(const void* data, size_t size);
+	/// hands the current block to the writer thread even if it is not full
+	void Flush();
+	/// flushes, then replaces the header; <size> must equal the size passed to the constructor
+	void SetHeader(const void* header, size_t size);
+
+	/// writes all remaining data and the latest header, returns false if anything failed
+	bool Close();
+
+	/// number of uncompressed bytes passed to Write so far
+	size_t GetDataSize() const { return dataSize; }
+
+private:
+	struct Block {
+		std::vector<char> data;
+		DemoBlockIndex index;
+	};
+
+	void WriteThread();
+	bool WriteHeader(const std::vector<std::uint8_t>& header);
+
+private:
+	std::FILE* file = nullptr;
+
+	int level = 0;
+	size_t dataSize = 0;
+	size_t headerMemberSize = 0;
+
+	Block curBlock;
+	spring_time lastFlushTime;
+
+	spring::thread thread;
+	spring::mutex mutex;
+	spring::condition_variable_any queueCond;
+
+	// shared with the writer thread, guarded by mutex
+	std::deque<Block> queue;
+	std::vector<std::uint8_t> pendingHeader;
+
+	bool closing = false;
+	bool failed = false;
+};
+
+#endif // DEMO_STREAM_WRITER_H
@@ -3,9 +3,15 @@
 #include "LoadSaveHandler.h"
 #include "CregLoadSaveHandler.h"
 #include "LuaLoadSaveHandler.h"
+#include "DemoKeyframes.h"
 #include "Game/GameSetup.h"
+#include "Game/SelectedUnitsHandler.h"
+#include "Sim/Units/UnitHandler.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
+#include "System/Threading/SpringThreading.h"
+
+#include <vector>
 
 SaveFileData globalSaveFileData;
 
@@ -26,7 +32,8 @@ ILoadSaveHandler* ILoadSaveHandler::CreateHandler(const std::string& saveFile)
 
 bool ILoadSaveHandler::CreateSave(
 	const std::string& saveFile,
-	const std::string& saveArgs
+	const std::string& saveArgs,
+	std::function<void()> onSaved
 ) {
 	if (!FileSystem::CreateDirectory("Saves"))
 		return false;
@@ -39,12 +46,44 @@ bool ILoadSaveHandler::CreateSave(
 	ILoadSaveHandler* ls = CreateHandler(saveFile);
 
 	ls->SaveInfo(gameSetup->mapName, gameSetup->mapName);
+	ls->SetSaveCallback(std::move(onSaved));
 	ls->SaveGame(saveFile);
 	LOG("[ILoadSaveHandler::%s] saved game to file \"%s\"", __func__, saveFile.c_str());
 	delete ls;
 	return true;
 }
 
+bool ILoadSaveHandler::CreateKeyframeSave(const SaveFileData& fileData)
+{
+	// saving clears the selection, which would otherwise be lost every DemoKeyframeInterval seconds
+	const std::vector<int> selectedUnitIDs(selectedUnitsHandler.selectedUnits.begin(), selectedUnitsHandler.selectedUnits.end());
+
+	// the save is compressed and written in the background; a keyframe only
+	// enters the index once its file is complete, otherwise a demo started
+	// from it (or a crash before the write finished) would hit a partial save
+	const auto appendKeyframe = [fileData]() {
+		static spring::mutex indexMutex;
+		std::lock_guard<spring::mutex> lock(indexMutex);
+
+		CDemoKeyframeIndex keyframes;
+
+		if (!keyframes.Append(fileData.keyframeIndex, fileData.keyframeNum, fileData.name))
+			LOG_L(L_WARNING, "[ILoadSaveHandler::CreateKeyframeSave] could not add keyframe \"%s\" to \"%s\"", fileData.name.c_str(), fileData.keyframeIndex.c_str());
+	};
+
+	if (!CreateSave(fileData.name, fileData.args, appendKeyframe))
+		return false;
+
+	for (const int unitID: selectedUnitIDs) {
+		CUnit* unit = unitHandler.GetUnit(unitID);
+
+		if (unit != nullptr)
+			selectedUnitsHandler.AddUnit(unit);
+	}
+
+	return true;
+}
+
 std::string ILoadSaveHandler::FindSaveFile(const std::string& file)
 {
 	if (FileSystem::FileExists(file))
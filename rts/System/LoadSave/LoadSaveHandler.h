@@ -3,12 +3,17 @@
 #ifndef _LOAD_SAVE_HANDLER_H
 #define _LOAD_SAVE_HANDLER_H
 
+#include <functional>
 #include <string>
 
 
 struct SaveFileData {
 	std::string name; // "saves/quicksave.ssf"
 	std::string args; // "-y"
+
+	// set for keyframes of a watched demo, see CDemoKeyframeIndex
+	std::string keyframeIndex; // "demos/20240101_120000_map_105.sdfz.keyframes"
+	int keyframeNum = -1;
 };
 
 class ILoadSaveHandler
@@ -16,15 +21,19 @@ class ILoadSaveHandler
 public:
 	static ILoadSaveHandler* CreateHandler(const std::string& saveFile);
 
-	static bool CreateSave(const std::string& saveFile, const std::string& saveArgs);
+	static bool CreateSave(const std::string& saveFile, const std::string& saveArgs, std::function<void()> onSaved = nullptr);
 	static bool CreateSave(SaveFileData fileData) {
 		if (fileData.name.empty())
 			return false;
+		if (!fileData.keyframeIndex.empty())
+			return (CreateKeyframeSave(fileData));
 
 		return (CreateSave(fileData.name, fileData.args));
 	}
 
 protected:
+	static bool CreateKeyframeSave(const SaveFileData& fileData);
+
 	static std::string FindSaveFile(const std::string& file);
 
 public:
@@ -40,6 +49,8 @@ public:
 		mapName = _mapName;
 		modName = _modName;
 	}
+	/// <func> runs once SaveGame has completely written the file, possibly on another thread
+	void SetSaveCallback(std::function<void()>&& func) { onSaved = std::move(func); }
 
 	const std::string& GetScriptText() const { return scriptText; }
 
@@ -47,6 +58,8 @@ protected:
 	std::string scriptText;
 	std::string mapName;
 	std::string modName;
+
+	std::function<void()> onSaved;
 };
 
 
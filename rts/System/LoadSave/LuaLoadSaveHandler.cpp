@@ -80,6 +80,8 @@ void CLuaLoadSaveHandler::SaveGame(const std::string& file)
 		// Close zip file.
 		if (Z_OK != zipClose(savefile, "Spring save file, visit https://springrts.com/ for details.")) {
 			LOG_L(L_ERROR, "Unable to close save file \"%s\"", filename.c_str());
+		} else if (onSaved) {
+			onSaved();
 		}
 		return; // Success
 	}
@@ -0,0 +1,318 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "SaveGameBlocks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <zlib.h>
+
+#include "System/Threading/SpringThreading.h"
+#include "System/Threading/ThreadPool.h"
+
+// fixed gzip header (10 bytes) followed by XLEN and an 'S','B' subfield holding the member size,
+// optionally followed by more subfields
+static constexpr size_t MEMBER_HEADER_SIZE = 10 + 2 + 8;
+static constexpr size_t MAX_EXTRA_SIZE = 0xFFFF - 8;
+// CRC32 and ISIZE
+static constexpr size_t MEMBER_TRAILER_SIZE = 8;
+
+static constexpr std::uint8_t GZIP_FLAG_EXTRA = 4;
+static constexpr std::uint8_t GZIP_OS_UNKNOWN = 255;
+
+
+static void PutLE16(std::uint8_t* p, std::uint32_t v) { p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; }
+static void PutLE32(std::uint8_t* p, std::uint32_t v) { PutLE16(p, v); PutLE16(p + 2, v >> 16); }
+
+static std::uint32_t GetLE16(const std::uint8_t* p) { return (p[0] | (p[1] << 8)); }
+static std::uint32_t GetLE32(const std::uint8_t* p) { return (GetLE16(p) | (GetLE16(p + 2) << 16)); }
+
+
+
+std::vector<CSaveGameBlockBuffer::Block> CSaveGameBlockBuffer::ReleaseBlocks()
+{
+	std::vector<Block> released;
+
+	if (!blocks.empty()) {
+		if ((blocks.back().size = pptr() - pbase()) == 0)
+			blocks.pop_back();
+	}
+
+	released.swap(blocks);
+	setp(nullptr, nullptr);
+
+	prevBlocksSize = 0;
+	return released;
+}
+
+void CSaveGameBlockBuffer::NextBlock()
+{
+	if (!blocks.empty())
+		prevBlocksSize += (blocks.back().size = pptr() - pbase());
+
+	Block& block = blocks.emplace_back();
+	block.data.reset(new char[BLOCK_SIZE]);
+
+	setp(block.data.get(), block.data.get() + BLOCK_SIZE);
+}
+
+CSaveGameBlockBuffer::int_type CSaveGameBlockBuffer::overflow(int_type c)
+{
+	if (traits_type::eq_int_type(c, traits_type::eof()))
+		return traits_type::not_eof(c);
+
+	NextBlock();
+
+	*pptr() = traits_type::to_char_type(c);
+	pbump(1);
+	return c;
+}
+
+std::streamsize CSaveGameBlockBuffer::xsputn(const char* s, std::streamsize n)
+{
+	for (std::streamsize written = 0; written < n; ) {
+		if (pptr() == epptr())
+			NextBlock();
+
+		const std::streamsize count = std::min<std::streamsize>(n - written, epptr() - pptr());
+
+		std::memcpy(pptr(), s + written, count);
+		pbump(count);
+
+		written += count;
+	}
+
+	return n;
+}
+
+CSaveGameBlockBuffer::pos_type CSaveGameBlockBuffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+	if (off != 0 || dir != std::ios_base::cur || (which & std::ios_base::out) == 0)
+		return pos_type(off_type(-1));
+
+	return pos_type(off_type(prevBlocksSize + (pptr() - pbase())));
+}
+
+
+
+bool SaveGameBlocks::CompressBlock(
+	const void* data,
+	size_t size,
+	int level,
+	std::vector<std::uint8_t>& member,
+	const std::uint8_t* extra,
+	size_t extraSize
+) {
+	if (extraSize > MAX_EXTRA_SIZE)
+		return false;
+
+	z_stream zs;
+	std::memset(&zs, 0, sizeof(zs));
+
+	// raw deflate, the gzip framing is written by hand to include the member size
+	if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+
+	const size_t headerSize = MEMBER_HEADER_SIZE + extraSize;
+
+	member.resize(headerSize + deflateBound(&zs, size) + MEMBER_TRAILER_SIZE);
+
+	zs.next_in = reinterpret_cast<Bytef*>(const_cast<void*>(data));
+	zs.avail_in = size;
+	zs.next_out = member.data() + headerSize;
+	zs.avail_out = member.size() - headerSize - MEMBER_TRAILER_SIZE;
+
+	const int ret = deflate(&zs, Z_FINISH);
+	const size_t memberSize = headerSize + zs.total_out + MEMBER_TRAILER_SIZE;
+
+	deflateEnd(&zs);
+
+	if (ret != Z_STREAM_END)
+		return false;
+
+	std::uint8_t* header = member.data();
+	std::uint8_t* trailer = header + memberSize - MEMBER_TRAILER_SIZE;
+
+	header[0] = 0x1F;
+	header[1] = 0x8B;
+	header[2] = Z_DEFLATED;
+	header[3] = GZIP_FLAG_EXTRA;
+	PutLE32(header + 4, 0); // mtime
+	header[8] = 0;
+	header[9] = GZIP_OS_UNKNOWN;
+	PutLE16(header + 10, 8 + extraSize);
+	header[12] = 'S';
+	header[13] = 'B';
+	PutLE16(header + 14, 4);
+	PutLE32(header + 16, memberSize);
+
+	if (extraSize > 0)
+		std::memcpy(header + MEMBER_HEADER_SIZE, extra, extraSize);
+
+	PutLE32(trailer    , crc32(0, reinterpret_cast<const Bytef*>(data), size));
+	PutLE32(trailer + 4, size);
+
+	member.resize(memberSize);
+	return true;
+}
+
+
+bool SaveGameBlocks::Write(std::ostream& out, std::vector<CSaveGameBlockBuffer::Block>&& blocks, int level, int numThreads)
+{
+	enum { MEMBER_PENDING = 0, MEMBER_DONE = 1, MEMBER_FAILED = 2 };
+
+	std::vector< std::vector<std::uint8_t> > members(blocks.size());
+	std::vector<std::uint8_t> memberStates(blocks.size(), MEMBER_PENDING);
+
+	std::atomic<size_t> nextBlock = {0};
+
+	spring::mutex mutex;
+	spring::condition_variable_any memberDone;
+
+	const auto CompressBlocks = [&]() {
+		for (size_t i = nextBlock.fetch_add(1); i < blocks.size(); i = nextBlock.fetch_add(1)) {
+			const bool compressed = CompressBlock(blocks[i].data.get(), blocks[i].size, level, members[i]);
+
+			// not needed anymore, keep peak memory down
+			blocks[i].data.reset();
+
+			{
+				std::lock_guard<spring::mutex> lock(mutex);
+				memberStates[i] = compressed? MEMBER_DONE: MEMBER_FAILED;
+			}
+
+			memberDone.notify_all();
+		}
+	};
+
+	std::vector<spring::thread> threads;
+	threads.reserve(std::max(1, numThreads));
+
+	for (size_t i = 0, n = std::max(1, numThreads); i < std::min(n, blocks.size()); i++) {
+		threads.emplace_back(CompressBlocks);
+	}
+
+	// write each member as soon as it and all before it are done
+	bool ret = true;
+
+	for (size_t i = 0; i < members.size(); i++) {
+		{
+			std::unique_lock<spring::mutex> lock(mutex);
+			memberDone.wait(lock, [&]() { return (memberStates[i] != MEMBER_PENDING); });
+		}
+
+		if ((ret &= (memberStates[i] == MEMBER_DONE)))
+			out.write(reinterpret_cast<const char*>(members[i].data()), members[i].size());
+
+		members[i] = {};
+	}
+
+	for (spring::thread& t: threads) {
+		t.join();
+	}
+
+	return (ret && out.good());
+}
+
+
+bool SaveGameBlocks::ParseMember(const std::uint8_t* src, size_t srcSize, MemberInfo& info)
+{
+	if (srcSize < (MEMBER_HEADER_SIZE + MEMBER_TRAILER_SIZE))
+		return false;
+	if (src[0] != 0x1F || src[1] != 0x8B || src[2] != Z_DEFLATED || src[3] != GZIP_FLAG_EXTRA)
+		return false;
+	if (GetLE16(src + 10) < 8 || src[12] != 'S' || src[13] != 'B' || GetLE16(src + 14) != 4)
+		return false;
+
+	info.headerSize = 12 + GetLE16(src + 10);
+	info.memberSize = GetLE32(src + 16);
+
+	if (info.memberSize < (info.headerSize + MEMBER_TRAILER_SIZE) || info.memberSize > srcSize)
+		return false;
+
+	info.dataSize = GetLE32(src + info.memberSize - 4);
+	info.extra = src + MEMBER_HEADER_SIZE;
+	info.extraSize = info.headerSize - MEMBER_HEADER_SIZE;
+
+	return (info.dataSize > 0 && info.dataSize <= CSaveGameBlockBuffer::BLOCK_SIZE);
+}
+
+const std::uint8_t* SaveGameBlocks::FindSubfield(const MemberInfo& info, char id1, char id2, size_t& size)
+{
+	for (size_t pos = 0; (pos + 4) <= info.extraSize; ) {
+		const std::uint8_t* subfield = info.extra + pos;
+		const size_t subfieldSize = GetLE16(subfield + 2);
+
+		if ((pos += (4 + subfieldSize)) > info.extraSize)
+			break;
+		if (subfield[0] != std::uint8_t(id1) || subfield[1] != std::uint8_t(id2))
+			continue;
+
+		size = subfieldSize;
+		return (subfield + 4);
+	}
+
+	return nullptr;
+}
+
+bool SaveGameBlocks::InflateMember(const std::uint8_t* src, const MemberInfo& info, std::uint8_t* dst)
+{
+	z_stream zs;
+	std::memset(&zs, 0, sizeof(zs));
+
+	if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+		return false;
+
+	zs.next_in = const_cast<Bytef*>(src + info.headerSize);
+	zs.avail_in = info.memberSize - info.headerSize - MEMBER_TRAILER_SIZE;
+	zs.next_out = dst;
+	zs.avail_out = info.dataSize;
+
+	const int ret = inflate(&zs, Z_FINISH);
+	const bool inflated = (ret == Z_STREAM_END && zs.avail_out == 0);
+
+	inflateEnd(&zs);
+
+	return (inflated && crc32(0, dst, info.dataSize) == GetLE32(src + info.memberSize - MEMBER_TRAILER_SIZE));
+}
+
+
+bool SaveGameBlocks::Read(const std::uint8_t* src, size_t srcSize, std::vector<std::uint8_t>& dst)
+{
+	struct Member {
+		size_t srcOffset;
+		size_t dstOffset;
+		MemberInfo info;
+	};
+
+	std::vector<Member> members;
+	size_t dstSize = 0;
+
+	// every member has to carry its size, otherwise leave it to gzread
+	for (size_t pos = 0; pos < srcSize; ) {
+		Member& m = members.emplace_back();
+
+		if (!ParseMember(src + pos, srcSize - pos, m.info))
+			return false;
+
+		m.srcOffset = pos;
+		m.dstOffset = dstSize;
+
+		pos += m.info.memberSize;
+		dstSize += m.info.dataSize;
+	}
+
+	if (members.empty())
+		return false;
+
+	dst.clear();
+	dst.resize(dstSize);
+
+	std::vector<std::uint8_t> validMembers(members.size(), 0);
+
+	for_mt(0, members.size(), [&](const int i) {
+		validMembers[i] = InflateMember(src + members[i].srcOffset, members[i].info, dst.data() + members[i].dstOffset);
+	});
+
+	return (std::find(validMembers.begin(), validMembers.end(), 0) == validMembers.end());
+}
@@ -0,0 +1,94 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SAVEGAME_BLOCKS_H
+#define SAVEGAME_BLOCKS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+/**
+ * Output buffer the game state is captured into when saving. Data goes
+ * into fixed-size blocks instead of one growing string, so capturing a
+ * large state never copies what was already written and the blocks can
+ * be handed to the compressor threads as they are.
+ */
+class CSaveGameBlockBuffer : public std::streambuf
+{
+public:
+	static constexpr size_t BLOCK_SIZE = 1 << 20;
+
+	struct Block {
+		std::unique_ptr<char[]> data;
+		size_t size = 0;
+	};
+
+	/// finishes the current block, the buffer is empty afterwards
+	std::vector<Block> ReleaseBlocks();
+
+protected:
+	int_type overflow(int_type c) override;
+	std::streamsize xsputn(const char* s, std::streamsize n) override;
+	/// only supports querying the put position (tellp)
+	pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+
+private:
+	void NextBlock();
+
+private:
+	std::vector<Block> blocks;
+	/// number of bytes in all blocks before the current one
+	size_t prevBlocksSize = 0;
+};
+
+
+/**
+ * Savegames are stored as a series of independent gzip members, one per
+ * block, so they can be compressed and uncompressed in parallel. Every
+ * member carries its compressed size in a gzip extra field; files written
+ * this way remain plain concatenated gzip and load through gzread too.
+ * Demos are streamed to disk in the same format, see CDemoStreamWriter.
+ */
+namespace SaveGameBlocks {
+	struct MemberInfo {
+		/// gzip header including all extra subfields
+		size_t headerSize = 0;
+		size_t memberSize = 0;
+		/// uncompressed size
+		size_t dataSize = 0;
+
+		/// subfields following the 'S','B' one
+		const std::uint8_t* extra = nullptr;
+		size_t extraSize = 0;
+	};
+
+	/// compresses <size> bytes (at most BLOCK_SIZE) into a single member; level 0 gives a member
+	/// whose size only depends on <size>, so it can be overwritten in place later. <extra> holds
+	/// additional gzip extra subfields (two id bytes, LE16 length, data) to store in the header
+	bool CompressBlock(
+		const void* data,
+		size_t size,
+		int level,
+		std::vector<std::uint8_t>& member,
+		const std::uint8_t* extra = nullptr,
+		size_t extraSize = 0
+	);
+
+	/// reads the header of the member at <src>, returns false if it was not written by CompressBlock
+	bool ParseMember(const std::uint8_t* src, size_t srcSize, MemberInfo& info);
+	/// returns the data of the extra subfield <id1>,<id2> or nullptr if the member has none
+	const std::uint8_t* FindSubfield(const MemberInfo& info, char id1, char id2, size_t& size);
+	/// uncompresses a parsed member into <dst> (info.dataSize bytes) and checks its CRC
+	bool InflateMember(const std::uint8_t* src, const MemberInfo& info, std::uint8_t* dst);
+
+	/// compresses <blocks> on up to <numThreads> threads and writes the members to <out> in order
+	bool Write(std::ostream& out, std::vector<CSaveGameBlockBuffer::Block>&& blocks, int level, int numThreads);
+
+	/// uncompresses the members in parallel, returns false if <src> was not written by Write
+	bool Read(const std::uint8_t* src, size_t srcSize, std::vector<std::uint8_t>& dst);
+}
+
+#endif // SAVEGAME_BLOCKS_H
@@ -115,6 +115,63 @@ struct DemoStreamChunkHeader
 	}
 };
 
+
+/** Set of network message types, one bit per type (types >= 128 share bits). */
+struct DemoMsgTypeMask
+{
+	std::uint32_t bits[4];
+
+	void Clear() { bits[0] = bits[1] = bits[2] = bits[3] = 0; }
+	void Add(std::uint8_t msgType) { bits[(msgType & 127) >> 5] |= (1u << (msgType & 31)); }
+
+	bool Contains(std::uint8_t msgType) const { return ((bits[(msgType & 127) >> 5] & (1u << (msgType & 31))) != 0); }
+	bool Intersects(const DemoMsgTypeMask& m) const {
+		return (((bits[0] & m.bits[0]) | (bits[1] & m.bits[1]) | (bits[2] & m.bits[2]) | (bits[3] & m.bits[3])) != 0);
+	}
+
+	void swab() {
+		swabDWordInPlace(bits[0]);
+		swabDWordInPlace(bits[1]);
+		swabDWordInPlace(bits[2]);
+		swabDWordInPlace(bits[3]);
+	}
+};
+
+/**
+ * @brief Index of a compressed demo block
+ *
+ * Demos are written as a series of gzip members (blocks), so the whole file
+ * still decompresses as one stream. The first member holds the uncompressed
+ * DemoFileHeader, every following one up to 256 KB of the remaining data.
+ * Besides its own size (see SaveGameBlocks), each block carries this index
+ * in an 'D','F' gzip extra subfield, which lets readers find the block a
+ * frame starts in, or skip blocks without any interesting messages, without
+ * decompressing anything.
+ */
+struct DemoBlockIndex
+{
+	static constexpr std::uint32_t NO_CHUNK = 0xFFFFFFFF;
+
+	std::uint32_t firstChunkOffset; ///< Offset within the block of the first DemoStreamChunkHeader starting in it, or NO_CHUNK.
+	std::int32_t firstChunkFrame;   ///< Sim frame reached before that chunk (-1 before the first frame).
+	float firstChunkTime;           ///< modGameTime of that chunk.
+	DemoMsgTypeMask msgTypes;       ///< Message types of all chunks starting in this block.
+
+	void Clear() {
+		firstChunkOffset = NO_CHUNK;
+		firstChunkFrame = -1;
+		firstChunkTime = 0.0f;
+		msgTypes.Clear();
+	}
+
+	void swab() {
+		swabDWordInPlace(firstChunkOffset);
+		swabDWordInPlace(firstChunkFrame);
+		swabFloatInPlace(firstChunkTime);
+		msgTypes.swab();
+	}
+};
+
 #pragma pack(pop)
 
 #endif // DEMO_FILE_H
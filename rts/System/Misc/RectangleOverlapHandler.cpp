@@ -3,6 +3,7 @@
 #include "RectangleOverlapHandler.h"
 #include "System/Log/ILog.h"
 
+#include <algorithm>
 #include <cassert>
 
 CR_BIND(CRectangleOverlapHandler, )
@@ -70,7 +71,10 @@ void CRectangleOverlapHandler::StageDedup()
 
 void CRectangleOverlapHandler::StageMerge()
 {
-	std::sort(begin(), end());
+	// SRectangle::operator< only compares the top-left corner; a stable sort
+	// keeps ties in insertion order s.t. the result does not depend on the
+	// standard library, which matters when the output feeds synced code
+	std::stable_sort(begin(), end());
 
 	for (size_t i = frontIdx, n = rectangles.size(); i < n; i++) {
 		if (rectangles[i].GetArea() == 0)
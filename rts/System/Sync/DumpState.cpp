@@ -452,10 +452,13 @@ void DumpState(int newMinFrameNum, int newMaxFrameNum, int newFramePeriod, std::
 	{
 		file << "\tCobEngine:\n";
 		file << "\t\tcurrentTime: " << cobEngine->GetCurrTime();
-		file << "\t\tCobThreads: " << cobEngine->GetThreadInstances().size() << "\n";
-		for (const auto& [tid, thread] : cobEngine->GetThreadInstances()) {
+		file << "\t\tCobThreads: " << cobEngine->GetNumThreads() << "\n";
+		for (const auto& thread : cobEngine->GetThreadInstances()) {
+			if (thread.GetID() == -1)
+				continue;
+
 			auto ownerID = thread.cobInst->GetUnit() ? thread.cobInst->GetUnit()->id : -1;
-			file << "\t\t\tid: " << tid << " t.id " << thread.GetID() << " t.wt " << thread.GetWakeTime()
+			file << "\t\t\tt.id " << thread.GetID() << " t.wt " << thread.GetWakeTime()
 				 << " owner " << ownerID
 				 << " t.state " << +thread.GetState() << " t.sigmask " << thread.GetSignalMask()
 				 << " t.retc " << thread.GetRetCode()
@@ -468,13 +471,11 @@ void DumpState(int newMinFrameNum, int newMaxFrameNum, int newFramePeriod, std::
 		}
 		file << "\n";
 
-		auto zzzThreads = cobEngine->GetSleepingThreadIDs(); //copied on purpose
+		const auto zzzThreads = cobEngine->GetSleepingThreadIDs();
 		file << "\t\tSleepingThreads: " << zzzThreads.size();
 		file << "\t\t\twts|ids:";
-		while (!zzzThreads.empty()) {
-			const auto& zt = zzzThreads.top();
+		for (const auto& zt : zzzThreads) {
 			file << " " << zt.wt << "|" << zt.id;
-			zzzThreads.pop();
 		}
 		file << "\n";
 	}
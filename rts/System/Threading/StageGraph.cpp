@@ -0,0 +1,131 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "StageGraph.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "System/Misc/TracyDefs.h"
+
+
+void CStageGraph::Clear()
+{
+	stages.clear();
+	waves.clear();
+
+	dirty = true;
+}
+
+size_t CStageGraph::AddStage(const char* name, ResourceMask reads, ResourceMask writes, StageFunc&& func, unsigned int flags)
+{
+	stages.push_back({name, reads, writes, std::move(func), flags, 0});
+
+	dirty = true;
+	return (stages.size() - 1);
+}
+
+
+void CStageGraph::Build()
+{
+	if (!dirty)
+		return;
+
+	waves.clear();
+
+	for (size_t j = 0; j < stages.size(); j++) {
+		Stage& sj = stages[j];
+
+		sj.wave = 0;
+
+		// a stage has to wait for every earlier stage it conflicts with
+		for (size_t i = 0; i < j; i++) {
+			const Stage& si = stages[i];
+
+			if (!Conflicts(si, sj))
+				continue;
+
+			sj.wave = std::max(sj.wave, si.wave + 1);
+		}
+
+		if (sj.wave >= waves.size())
+			waves.resize(sj.wave + 1);
+
+		// indices within a wave stay sorted by declaration order
+		waves[sj.wave].push_back(j);
+	}
+
+	dirty = false;
+}
+
+
+void CStageGraph::Run(bool concurrent)
+{
+	if (!concurrent || !ThreadPool::HasThreads()) {
+		for (Stage& s: stages) {
+			s.func();
+		}
+
+		return;
+	}
+
+	Build();
+
+	for (const std::vector<size_t>& wave: waves) {
+		RunWave(wave);
+	}
+}
+
+void CStageGraph::RunWave(const std::vector<size_t>& wave)
+{
+	ZoneScoped;
+
+	if (wave.size() == 1) {
+		stages[wave[0]].func();
+		return;
+	}
+
+	workerStages.clear();
+	mainStages.clear();
+
+	for (const size_t i: wave) {
+		if ((stages[i].flags & STAGE_FLAG_MAIN_THREAD) != 0) {
+			mainStages.push_back(i);
+		} else {
+			workerStages.push_back(i);
+		}
+	}
+
+	#ifdef THREADPOOL
+	typedef std::function<void(const int)> StageIndexFunc;
+
+	// same scheme as for_mt, except the caller runs the main-thread
+	// stages between pushing the slices and helping out in WFF
+	static TaskPool<ForTaskGroup, StageIndexFunc> pool;
+
+	std::shared_ptr< ForTaskGroup<StageIndexFunc> > taskGroup;
+
+	if (!workerStages.empty()) {
+		StageIndexFunc func = [this](const int i) { stages[workerStages[i]].func(); };
+
+		taskGroup = pool.GetTaskGroup();
+		taskGroup->Enqueue(0, workerStages.size(), 1, func);
+		taskGroup->UpdateId();
+
+		for (int i = 1, n = ThreadPool::GetNumThreads(); i < n; ++i) {
+			taskGroup->wantedThread.store(i);
+			ThreadPool::PushTaskGroup(taskGroup);
+		}
+	}
+
+	for (const size_t i: mainStages) {
+		stages[i].func();
+	}
+
+	if (taskGroup != nullptr)
+		ThreadPool::WaitForFinished(taskGroup);
+
+	#else
+	assert(false);
+	#endif
+}
@@ -0,0 +1,80 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _STAGE_GRAPH_H
+#define _STAGE_GRAPH_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * Ordered list of work stages, each declaring the resources it reads and
+ * writes. Two stages conflict when either writes a resource the other one
+ * reads or writes. Every stage is placed in a wave strictly after the wave
+ * of each earlier stage it conflicts with, and the stages sharing a wave
+ * are executed concurrently on the ThreadPool.
+ *
+ * Conflicting stages therefore always run in declaration order, so (given
+ * complete read/write masks) the outcome is identical to running the list
+ * serially. Stages that must stay on the calling thread (Lua, CEG spawning,
+ * ...) can be flagged as such and still overlap with worker stages.
+ */
+class CStageGraph {
+public:
+	typedef uint64_t ResourceMask;
+	typedef std::function<void()> StageFunc;
+
+	static constexpr ResourceMask RESOURCE_ALL = ~ResourceMask(0);
+
+	enum StageFlags {
+		STAGE_FLAG_NONE        = 0,
+		STAGE_FLAG_MAIN_THREAD = 1,
+	};
+
+	struct Stage {
+		const char* name;
+
+		ResourceMask reads;
+		ResourceMask writes;
+
+		StageFunc func;
+
+		unsigned int flags;
+		unsigned int wave;
+	};
+
+public:
+	void Clear();
+
+	/// returns the index of the new stage
+	size_t AddStage(const char* name, ResourceMask reads, ResourceMask writes, StageFunc&& func, unsigned int flags = STAGE_FLAG_NONE);
+
+	/// executes all stages; strictly serial in declaration order if <concurrent> is false
+	void Run(bool concurrent);
+
+	size_t GetNumStages() const { return stages.size(); }
+	size_t GetNumWaves() { Build(); return waves.size(); }
+
+	const Stage& GetStage(size_t i) const { return stages[i]; }
+	const std::vector<size_t>& GetWave(size_t i) { Build(); return waves[i]; }
+
+	static bool Conflicts(const Stage& a, const Stage& b) {
+		return (((a.writes & (b.reads | b.writes)) | (b.writes & a.reads)) != 0);
+	}
+
+private:
+	void Build();
+	void RunWave(const std::vector<size_t>& wave);
+
+private:
+	std::vector<Stage> stages;
+	std::vector< std::vector<size_t> > waves;
+
+	// scratch-buffers used by RunWave
+	std::vector<size_t> workerStages;
+	std::vector<size_t> mainStages;
+
+	bool dirty = true;
+};
+
+#endif
@@ -20,7 +20,8 @@ using HashNamMutexType = spring::mutex; //spring::spinlock
 static ProfileMutexType profileMutex;
 static HashNamMutexType hashToNameMutex;
 static spring::unordered_map<unsigned, std::string> hashToName;
-static spring::unordered_map<unsigned, int> refCounters;
+// per-thread, ScopedTimer's can be live on workers (CStageGraph)
+static thread_local spring::unordered_map<unsigned, int> refCounters;
 
 static CGlobalUnsyncedRNG profileColorRNG;
 
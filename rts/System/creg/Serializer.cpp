@@ -72,12 +72,6 @@ static std::string ReadZStr(std::istream& file)
 	return std::string(cstr);
 }
 
-static void WriteZStr(std::ostream& file, const std::string& str)
-{
-	assert(str.length() < 1024); // check func above!
-	file.write(str.c_str(), str.length() + 1);
-}
-
 
 template<typename T>
 void ReadVarSizeUInt(std::istream* stream, T* buf)
@@ -138,63 +132,89 @@ bool COutputStreamSerializer::IsWriting()
 
 COutputStreamSerializer::ObjectRef* COutputStreamSerializer::FindObjectRef(void* inst, creg::Class* objClass, bool isEmbedded)
 {
-	std::vector<ObjectRef*>& refs = ptrToId[inst];
-	for (auto& obj: refs) {
+	const auto it = ptrToId.find(inst);
+
+	if (it == ptrToId.end())
+		return nullptr;
+
+	for (ObjectRef* obj = it->second; obj != nullptr; obj = obj->next) {
 		if (obj->isThisObject(inst, objClass, isEmbedded))
 			return obj;
 	}
 	return nullptr;
 }
 
+COutputStreamSerializer::ObjectRef* COutputStreamSerializer::AddObjectRef(void* inst, creg::Class* objClass, bool isEmbedded)
+{
+	objects.emplace_back(inst, objects.size(), isEmbedded, objClass);
+
+	ObjectRef* obj = &objects.back();
+	ObjectRef** ref = &ptrToId[inst];
+
+	// append, FindObjectRef has to return the earliest registered match
+	while (*ref != nullptr)
+		ref = &(*ref)->next;
+
+	return (*ref = obj);
+}
+
+const std::vector<COutputStreamSerializer::ObjectMember>& COutputStreamSerializer::GetClassMembers(Class* c)
+{
+	const auto it = classMembers.find(c);
+
+	if (it != classMembers.end())
+		return *(it->second);
+
+	std::vector<ObjectMember>& members = classMemberTables.emplace_back();
+	members.reserve(c->members.size());
+
+	for (creg::Class::Member& m: c->members) {
+		if (m.flags & CM_NoSerialize)
+			continue;
+
+		const BasicType* basicType = dynamic_cast<const BasicType*>(m.type.get());
+		members.push_back({&m, (basicType != nullptr)? int(basicType->GetSize()): 0});
+	}
+
+	classMembers[c] = &members;
+	return members;
+}
+
 void COutputStreamSerializer::SerializeObject(Class* c, void* ptr, ObjectRef* objr)
 {
-	const unsigned objstart = stream->tellp();
+	const size_t objstart = Tell();
 
 	if (c->base())
 		SerializeObject(c->base(), ptr, objr);
 
-	ObjectMemberGroup omg;
-	omg.membersClass = c;
-	omg.size = 0;
+	for (const ObjectMember& om: GetClassMembers(c)) {
+		const creg::Class::Member* m = om.member;
+		void* memberAddr = ((char*)ptr) + m->offset;
 
-	for (uint a = 0; a < c->members.size(); a++)
-	{
-		creg::Class::Member* m = &c->members[a];
-		if (m->flags & CM_NoSerialize)
+		// ints and floats make up most members, skip the virtual call for them
+		if (om.basicSize != 0) {
+			SerializeInt(memberAddr, om.basicSize);
 			continue;
+		}
 
-		ObjectMember om;
-		om.member = m;
-		om.memberId = a;
-		void* memberAddr = ((char*)ptr) + m->offset;
-		unsigned mstart = stream->tellp();
+		if (!gatherClassSizes) {
+			m->type->Serialize(this, memberAddr);
+			continue;
+		}
+
+		const size_t mstart = Tell();
 		LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s::%s type:%s", c->name, m->name, m->type->GetName().c_str());
 		m->type->Serialize(this, memberAddr);
-		unsigned mend = stream->tellp();
-		om.size = mend - mstart;
-		omg.members.push_back(om);
-		omg.size += om.size;
-		LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s::%s type:%s size:%d", c->name, m->name, m->type->GetName().c_str(), om.size);
+		LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s::%s type:%s size:%d", c->name, m->name, m->type->GetName().c_str(), int(Tell() - mstart));
 	}
 
-
-	if (c->HasSerialize()) {
-		ObjectMember om;
-		om.member = nullptr;
-		om.memberId = -1;
-		unsigned mstart = stream->tellp();
+	if (c->HasSerialize())
 		c->CallSerializeProc(ptr, this);
-		unsigned mend = stream->tellp();
-		om.size = mend - mstart;
-		omg.members.push_back(om);
-		omg.size += om.size;
-	}
 
-	objr->memberGroups.push_back(omg);
+	if (!gatherClassSizes)
+		return;
 
-	const unsigned objend = stream->tellp();
-	const int sz = objend - objstart;
-	classSizes[c] += sz;
+	classSizes[c] += (Tell() - objstart);
 	classCounts[c]++;
 }
 
@@ -203,24 +223,20 @@ void COutputStreamSerializer::SerializeObjectInstance(void* inst, creg::Class* o
 	// register the object, and mark it as embedded if a pointer was already referencing it
 	ObjectRef* obj = FindObjectRef(inst, objClass, true);
 	if (!obj) {
-		objects.emplace_back(inst, objects.size(), true, objClass);
-		obj = &objects.back();
-		ptrToId[inst].push_back(obj);
+		obj = AddObjectRef(inst, objClass, true);
 	} else if (obj->isEmbedded) {
 		throw std::string("Reserialization of embedded object (") + objClass->name + ")";
+	} else if (!obj->isPending) {
+		throw std::string("Object pointer was serialized (") + objClass->name + ")";
 	} else {
-		std::vector<ObjectRef*>::iterator it = std::find(pendingObjects.begin(), pendingObjects.end(), obj);
-		if (it == pendingObjects.end()) {
-			throw std::string("Object pointer was serialized (") + objClass->name + ")";
-		} else {
-			pendingObjects.erase(it);
-		}
+		// still in pendingObjects, SavePackage skips it
+		obj->isPending = false;
 	}
 	obj->class_ = objClass;
 	obj->isEmbedded = true;
 
 	// write an object ID
-	WriteVarSizeUInt(stream, obj->id);
+	WriteVarUInt(obj->id);
 
 	// write the object
 	SerializeObject(objClass, inst, obj);
@@ -230,26 +246,23 @@ void COutputStreamSerializer::SerializeObjectPtr(void** ptr, creg::Class* objCla
 {
 	if (*ptr) {
 		// valid pointer, write a one and the object ID
-		int id;
 		ObjectRef* obj = FindObjectRef(*ptr, objClass, false);
 		if (!obj) {
-			objects.emplace_back(*ptr, objects.size(), false, objClass);
-			obj = &objects.back();
-			ptrToId[*ptr].push_back(obj);
+			obj = AddObjectRef(*ptr, objClass, false);
+			obj->isPending = true;
 			pendingObjects.push_back(obj);
 		}
-		id = obj->id;
 
-		WriteVarSizeUInt(stream, id);
+		WriteVarUInt(obj->id);
 	} else {
 		// null pointer, write a zero
-		WriteVarSizeUInt(stream, 0);
+		WriteVarUInt(0);
 	}
 }
 
 void COutputStreamSerializer::Serialize(void* data, int byteSize)
 {
-	stream->write((char*)data, byteSize);
+	Write(data, byteSize);
 }
 
 void COutputStreamSerializer::SerializeInt(void* data, int byteSize)
@@ -267,7 +280,7 @@ void COutputStreamSerializer::SerializeInt(void* data, int byteSize)
 			throw "Unknown int type";
 		}
 	}
-	WriteVarSizeUInt(stream, x);
+	WriteVarUInt(x);
 }
 
 
@@ -282,10 +295,13 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 	PackageHeader ph;
 
 	stream = s;
-	unsigned startOffset = stream->tellp();
-	stream->write((char*)&ph, sizeof(PackageHeader));
-	stream->seekp(startOffset + sizeof(PackageHeader));
-	ph.objDataOffset = (int)stream->tellp();
+	bufferBase = stream->tellp();
+	gatherClassSizes = LOG_IS_ENABLED(L_DEBUG) || LOG_IS_ENABLED_S(LOG_SECTION_CREG_SERIALIZER, L_DEBUG);
+
+	// header is filled in last
+	buffer.clear();
+	buffer.resize(sizeof(PackageHeader));
+	ph.objDataOffset = (int)Tell();
 
 	// Insert dummy object with id 0
 	objects.emplace_back(nullptr, 0, true, nullptr);
@@ -293,20 +309,26 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 	obj->classIndex = 0;
 
 	// Insert the first object that will provide references to everything
-	objects.emplace_back(rootObj, objects.size(), false, rootObjClass);
-	obj = &objects.back();
-	ptrToId[rootObj].push_back(obj);
+	obj = AddObjectRef(rootObj, rootObjClass, false);
+	obj->isPending = true;
 	pendingObjects.push_back(obj);
 
 	// Save until all the referenced objects have been stored
+	std::vector<ObjectRef*> po;
+
 	while (!pendingObjects.empty())
 	{
-		const std::vector<ObjectRef*> po = pendingObjects;
+		po.swap(pendingObjects);
 		pendingObjects.clear();
 
+		// objects that were embedded in the meantime are no longer pending
+		po.erase(std::remove_if(po.begin(), po.end(), [](const ObjectRef* o) { return !o->isPending; }), po.end());
+
+		for (ObjectRef* obj: po) {
+			obj->isPending = false;
+		}
 		for (ObjectRef* obj: po) {
 			SerializeObject(obj->class_, obj->ptr, obj);
-			//LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG, "Serialized %s size:%i", obj->class_->name.c_str(), sz);
 		}
 	}
 
@@ -340,43 +362,43 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 					it.first->name,
 					classCounts[it.first],
 					it.second);
-			it.second = 0;
-			classCounts[it.first] = 0;
 		}
 	}
 
 
 	// Write the class references & calc their checksum
 	ph.numObjClassRefs = classRefs.size();
-	ph.objClassRefOffset = (int)stream->tellp();
+	ph.objClassRefOffset = (int)Tell();
 	for (auto& classRef: classRefs) {
-		Class* c = classRef->class_;
-		WriteZStr(*stream, c->name);
+		const Class* c = classRef->class_;
+		const size_t len = strlen(c->name);
+		assert(len < 1024); // check ReadZStr!
+		Write(c->name, len + 1);
 	};
 
 	// Write object info
-	ph.objTableOffset = (int)stream->tellp();
+	ph.objTableOffset = (int)Tell();
 	ph.numObjects = objects.size();
 	for (ObjectRef& oRef: objects) {
 		int classRefIndex = oRef.classIndex;
 		char isEmbedded = oRef.isEmbedded ? 1 : 0;
-		WriteVarSizeUInt(stream, classRefIndex);
-		stream->write((char*)&isEmbedded, sizeof(char));
+		WriteVarUInt(classRefIndex);
+		Write(&isEmbedded, sizeof(char));
 
 		if (isEmbedded || oRef.class_ == nullptr)
 			continue;
 		if (oRef.class_->HasGetSize())
-			WriteVarSizeUInt(stream, oRef.class_->CallGetSizeProc(oRef.ptr));
+			WriteVarUInt(oRef.class_->CallGetSizeProc(oRef.ptr));
 
 		if (oRef.class_->HasPrealloc()) {
 			void* container = oRef.class_->CallGetPreallocProc(oRef.ptr);
 			const auto it = ptrToId.find(container);
 			if (container == nullptr || it == ptrToId.end())
 				throw std::string("Preallocation container of (") + oRef.class_->name + ") doesn't exist";
-			ObjectRef* objCont = it->second.front();
+			ObjectRef* objCont = it->second;
 			// write container ID and offset of placement-new location
-			WriteVarSizeUInt(stream, objCont->id);
-			WriteVarSizeUInt(stream, (char*)oRef.ptr - (char*)container);
+			WriteVarUInt(objCont->id);
+			WriteVarUInt((char*)oRef.ptr - (char*)container);
 		}
 	}
 
@@ -387,21 +409,23 @@ void COutputStreamSerializer::SavePackage(std::ostream* s, void* rootObj, Class*
 		c->CalculateChecksum(ph.metadataChecksum);
 	}
 
-	int endOffset = stream->tellp();
-	stream->seekp(startOffset);
 	memcpy(ph.magic, CREG_PACKAGE_FILE_ID, 4);
 	ph.SwapBytes();
-	stream->write((const char*)&ph, sizeof(PackageHeader));
+	memcpy(buffer.data(), &ph, sizeof(PackageHeader));
+
+	stream->write(buffer.data(), buffer.size());
 
 	LOG_SL(LOG_SECTION_CREG_SERIALIZER, L_DEBUG,
 			"Checksum: %X\nNumber of objects saved: %i\nNumber of classes involved: %i",
 			ph.metadataChecksum, int(objects.size()), int(classRefs.size()));
 
-	stream->seekp(endOffset);
+	// keep the buffer and member tables around for the next package
+	buffer.clear();
 	ptrToId.clear();
 	pendingObjects.clear();
 	objects.clear();
 	classSizes.clear();
+	classCounts.clear();
 }
 
 //-------------------------------------------------------------------------
@@ -8,11 +8,14 @@
 
 #ifdef USING_CREG
 
+#include <cstdint>
 #include <map>
 #include <vector>
 #include <deque>
 #include <istream>
 
+#include "System/UnorderedMap.hpp"
+
 namespace creg {
 
 	/**
@@ -23,43 +26,24 @@ namespace creg {
 	class COutputStreamSerializer : public ISerializer
 	{
 	protected:
-		struct ObjectMember {
-			Class::Member* member;
-			int memberId;
-			int size;
-		};
-		struct ObjectMemberGroup {
-			Class* membersClass;
-			std::vector<COutputStreamSerializer::ObjectMember> members;
-			int size;
-		};
 		struct ObjectRef {
-			ObjectRef() {
-				ptr = 0;
-				id=0;
-				classIndex=0;
-				isEmbedded=false;
-				class_=0;
-			}
-			ObjectRef(void* ptr, int id, bool isEmbedded, Class* class_) {
-				this->ptr = ptr;
-				this->id=id;
-				classIndex=0;
-				this->isEmbedded=isEmbedded;
-				this->class_=class_;
-			}
-			ObjectRef(const ObjectRef&src) :memberGroups(src.memberGroups){
-				ptr=src.ptr;
-				id=src.id;
-				classIndex=src.classIndex;
-				isEmbedded=src.isEmbedded;
-				class_=src.class_;
-			}
-			void* ptr;
-			int id, classIndex;
-			bool isEmbedded;
-			Class* class_;
-			std::vector<COutputStreamSerializer::ObjectMemberGroup> memberGroups;
+			ObjectRef(void* ptr, int id, bool isEmbedded, Class* class_)
+				: ptr(ptr)
+				, id(id)
+				, isEmbedded(isEmbedded)
+				, class_(class_)
+			{}
+
+			void* ptr = nullptr;
+			int id = 0;
+			int classIndex = 0;
+			bool isEmbedded = false;
+			/// true while this object is referenced by pointer but not yet saved
+			bool isPending = false;
+			Class* class_ = nullptr;
+			/// next object registered at the same address (e.g. an embedded first member)
+			ObjectRef* next = nullptr;
+
 			bool isThisObject(void* objPtr, Class* objClass, bool objEmbedded) const
 			{
 				if (ptr != objPtr) return false;
@@ -77,15 +61,38 @@ namespace creg {
 			}
 		};
 
+		/// serializable member of a class; basicSize is non-zero for
+		/// BasicType members, which SerializeObject encodes inline
+		struct ObjectMember {
+			Class::Member* member;
+			int basicSize;
+		};
+
 		// Temporary class reference
 		struct ClassRef;
 
 		std::ostream* stream;
-		std::map<void*,std::vector<ObjectRef*> > ptrToId;
+
+		/// package data; assembled in memory and written to <stream> at
+		/// the end of SavePackage instead of one (varint) byte at a time
+		std::vector<char> buffer;
+		/// stream position that buffer[0] will be written to
+		size_t bufferBase = 0;
+
+		/// first ObjectRef registered at each address, others are chained via ObjectRef::next
+		spring::unordered_map<void*, ObjectRef*> ptrToId;
+		/// serializable members per class, built on first use; the tables
+		/// live in a deque since SerializeObject recurses while iterating one
+		spring::unordered_map<Class*, const std::vector<ObjectMember>*> classMembers;
+		std::deque< std::vector<ObjectMember> > classMemberTables;
+
 		std::deque<ObjectRef> objects;
 		std::vector<ObjectRef*> pendingObjects; // these objects still have to be saved
+
+		// only gathered when debug-logging is enabled
 		std::map<Class*, int> classSizes;
 		std::map<Class*, int> classCounts;
+		bool gatherClassSizes = false;
 
 		// Serialize all class names
 		void WriteObjectInfo();
@@ -93,9 +100,29 @@ namespace creg {
 		void WriteObjectRef(void* inst, Class* cls, bool embedded);
 
 		ObjectRef* FindObjectRef(void* inst, Class* objClass, bool isEmbedded);
+		ObjectRef* AddObjectRef(void* inst, Class* objClass, bool isEmbedded);
+
+		const std::vector<ObjectMember>& GetClassMembers(Class* c);
 
 		void SerializeObject(Class* c, void* ptr, ObjectRef* objr);
 
+		size_t Tell() const { return (bufferBase + buffer.size()); }
+		void Write(const void* data, size_t size) {
+			buffer.insert(buffer.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+		}
+		void WriteVarUInt(std::uint64_t val) {
+			char bytes[10];
+			size_t n = 0;
+
+			do {
+				bytes[n] = val & 0x7F;
+				val >>= 7;
+				bytes[n++] |= ((val > 0) << 7);
+			} while (val > 0);
+
+			Write(bytes, n);
+		}
+
 	public:
 		COutputStreamSerializer();
 
@@ -0,0 +1,203 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/InterceptGrid.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using PairList = std::vector< std::pair<int, int> >;
+
+static constexpr float MAP_SIZE = 16384.0f;
+
+
+// stand-in for CGround::LineGroundCol on a flat map at height 0
+static float GetImpactDist(const CInterceptGrid::Interceptor& w, const CInterceptGrid::Target& p)
+{
+	const float weaponDist = w.aimFromPos.distance(p.pos);
+
+	if (p.dir.y >= 0.0f)
+		return -1.0f;
+
+	const float groundDist = p.pos.y / -p.dir.y;
+
+	if (groundDist > weaponDist)
+		return -1.0f;
+
+	return groundDist;
+}
+
+static float3 RandomDir(std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	switch (rng() % 8) {
+		// flight paths parallel to the grid axes
+		case 0: return float3((rng() & 1)? 1.0f: -1.0f, 0.0f, 0.0f);
+		case 1: return float3(0.0f, 0.0f, (rng() & 1)? 1.0f: -1.0f);
+		case 2: return float3(0.0f, (rng() & 1)? 1.0f: -1.0f, 0.0f);
+		case 3: return float3(0.0f, unit(rng), unit(rng)).SafeNormalize();
+		default: {} break;
+	}
+
+	return float3(unit(rng), unit(rng), unit(rng)).SafeNormalize();
+}
+
+
+TEST_CASE("InterceptGrid")
+{
+	std::mt19937 rng(2718);
+	std::uniform_real_distribution<float> mapCoord(0.0f, MAP_SIZE);
+	std::uniform_real_distribution<float> wideCoord(-4096.0f, MAP_SIZE + 4096.0f);
+
+	CInterceptGrid grid;
+
+	std::vector<CInterceptGrid::Interceptor> interceptors;
+	std::vector<CInterceptGrid::Target> targets;
+
+	size_t numCovered = 0;
+	size_t numCoveredNoImpact = 0;
+	size_t numCoveredAxisParallel = 0;
+
+	for (int round = 0; round < 40; round++) {
+		const int numInterceptors = (round < 4)? (1 + round): (50 + rng() % 250);
+		const int numTargets = 50 + rng() % 250;
+
+		interceptors.clear();
+		targets.clear();
+
+		for (int i = 0; i < numInterceptors; i++) {
+			CInterceptGrid::Interceptor& w = interceptors.emplace_back();
+
+			w.aimFromPos = float3(mapCoord(rng), std::uniform_real_distribution<float>(0.0f, 300.0f)(rng), mapCoord(rng));
+			// roughly 10% nuke-sized coverage areas, the rest point-defense
+			w.coverageRange = ((rng() % 10) == 0)?
+				std::uniform_real_distribution<float>(2000.0f, 4000.0f)(rng):
+				std::uniform_real_distribution<float>(0.0f, 800.0f)(rng);
+		}
+
+		for (int i = 0; i < numTargets; i++) {
+			CInterceptGrid::Target& p = targets.emplace_back();
+
+			p.pos = float3(wideCoord(rng), std::uniform_real_distribution<float>(0.0f, 3000.0f)(rng), wideCoord(rng));
+			p.dir = RandomDir(rng);
+
+			if ((rng() % 4) == 0) {
+				p.targetPos = float3(wideCoord(rng), 0.0f, wideCoord(rng));
+			} else {
+				p.targetPos = p.pos + p.dir * std::uniform_real_distribution<float>(0.0f, 12000.0f)(rng);
+			}
+		}
+
+		// the loop CInterceptHandler::Update ran before culling
+		PairList allPairs;
+
+		for (size_t wIdx = 0; wIdx < interceptors.size(); wIdx++) {
+			for (size_t pIdx = 0; pIdx < targets.size(); pIdx++) {
+				const CInterceptGrid::Interceptor& w = interceptors[wIdx];
+				const CInterceptGrid::Target& p = targets[pIdx];
+				const float impactDist = GetImpactDist(w, p);
+
+				if (!CInterceptGrid::IsTargetCovered(w, p, impactDist))
+					continue;
+
+				allPairs.emplace_back(wIdx, pIdx);
+
+				numCovered += 1;
+				numCoveredNoImpact += (impactDist == -1.0f);
+				numCoveredAxisParallel += (p.dir.x == 0.0f || p.dir.z == 0.0f);
+			}
+		}
+
+		// the culled loop, as in CInterceptHandler::Update
+		PairList candidatePairs;
+		PairList culledPairs;
+
+		grid.Clear();
+
+		for (const CInterceptGrid::Interceptor& w: interceptors) {
+			grid.AddInterceptor(w);
+		}
+
+		grid.Build();
+
+		for (size_t pIdx = 0; pIdx < targets.size(); pIdx++) {
+			grid.AddCandidates(targets[pIdx], pIdx, candidatePairs);
+		}
+
+		std::sort(candidatePairs.begin(), candidatePairs.end());
+
+		// no duplicates
+		CHECK(std::adjacent_find(candidatePairs.begin(), candidatePairs.end()) == candidatePairs.end());
+
+		for (const auto& pair: candidatePairs) {
+			const CInterceptGrid::Interceptor& w = interceptors[pair.first];
+			const CInterceptGrid::Target& p = targets[pair.second];
+
+			if (!CInterceptGrid::IsTargetCovered(w, p, GetImpactDist(w, p)))
+				continue;
+
+			culledPairs.push_back(pair);
+		}
+
+		REQUIRE(culledPairs == allPairs);
+
+		// the grid walk misses none of the pairs the reach test accepts
+		size_t numReachable = 0;
+
+		for (size_t wIdx = 0; wIdx < interceptors.size(); wIdx++) {
+			for (size_t pIdx = 0; pIdx < targets.size(); pIdx++) {
+				numReachable += CInterceptGrid::CanReachTarget(interceptors[wIdx], targets[pIdx]);
+			}
+		}
+
+		CHECK(candidatePairs.size() == numReachable);
+	}
+
+	// make sure the interesting cases were exercised at all
+	CHECK(numCovered > 0);
+	CHECK(numCoveredNoImpact > 0);
+	CHECK(numCoveredAxisParallel > 0);
+}
+
+TEST_CASE("InterceptGridNoImpact")
+{
+	const CInterceptGrid::Interceptor w = {float3(1000.0f, 0.0f, 1000.0f), 300.0f};
+
+	// without a ground impact, case 4 degenerates to the point p.pos - p.dir;
+	// here it is just inside the coverage circle while p.pos is not
+	const CInterceptGrid::Target p = {float3(1300.5f, 0.0f, 1000.0f), float3(1.0f, 0.0f, 0.0f), float3(9000.0f, 0.0f, 1000.0f)};
+
+	CHECK(CInterceptGrid::IsTargetCovered(w, p, -1.0f));
+	CHECK(!CInterceptGrid::IsTargetCovered(w, p, 5000.0f));
+	CHECK(CInterceptGrid::CanReachTarget(w, p));
+
+	// passing over the interceptor, which only the full path test notices
+	const CInterceptGrid::Target q = {float3(0.0f, 100.0f, 1000.0f), float3(1.0f, 0.0f, 0.0f), float3(9000.0f, 100.0f, 1000.0f)};
+
+	CHECK(!CInterceptGrid::IsTargetCovered(w, q, -1.0f));
+	CHECK(CInterceptGrid::IsTargetCovered(w, q, 5000.0f));
+	CHECK(CInterceptGrid::CanReachTarget(w, q));
+
+	// moving away from the interceptor
+	const CInterceptGrid::Target r = {float3(2000.0f, 100.0f, 1000.0f), float3(1.0f, 0.0f, 0.0f), float3(9000.0f, 100.0f, 1000.0f)};
+
+	CHECK(!CInterceptGrid::IsTargetCovered(w, r, -1.0f));
+	CHECK(!CInterceptGrid::IsTargetCovered(w, r, 5000.0f));
+	CHECK(!CInterceptGrid::CanReachTarget(w, r));
+
+	CInterceptGrid grid;
+	PairList pairs;
+
+	grid.AddInterceptor(w);
+	grid.Build();
+	grid.AddCandidates(p, 0, pairs);
+	grid.AddCandidates(q, 1, pairs);
+	grid.AddCandidates(r, 2, pairs);
+
+	CHECK(pairs == PairList{{0, 0}, {0, 1}});
+}
@@ -0,0 +1,119 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosRaycastKernel.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+
+// same construction as CLosTableHelper::GetRay
+static std::vector<int2> GetRay(int xf, int yf)
+{
+	std::vector<int2> ray;
+
+	if (xf > yf) {
+		const float m = (float) yf / (float) xf;
+		for (int x = 1; x <= xf; x++) {
+			ray.emplace_back(x, int(std::round(m * x)));
+		}
+	} else {
+		const float m = (float) xf / (float) yf;
+		for (int y = 1; y <= yf; y++) {
+			ray.emplace_back(int(std::round(m * y)), y);
+		}
+	}
+
+	return ray;
+}
+
+
+// same row widths as MidpointCircleAlgoPerLine in LosMap.cpp
+static std::vector<int> GetRowWidths(int radius)
+{
+	std::vector<int> rowWidths(radius + 1, 0);
+
+	int x = radius;
+	int y = 0;
+	int decisionOver2 = 1 - x;
+
+	while (x >= y) {
+		rowWidths[y] = x;
+
+		if (decisionOver2 <= 0) {
+			y++;
+			decisionOver2 += 2 * y + 1;
+		} else {
+			if (x != y)
+				rowWidths[x] = y;
+
+			y++;
+			x--;
+			decisionOver2 += 2 * (y - x) + 1;
+		}
+	}
+
+	return rowWidths;
+}
+
+
+TEST_CASE("LosRaycastKernels")
+{
+	std::mt19937 rng(12345);
+	std::uniform_real_distribution<float> heights(-50.0f, 150.0f);
+
+	for (int radius = 1; radius <= 64; radius++) {
+		const int diam = 2 * radius + 1;
+		const int stride = diam + 7;
+		const int2 pos(radius + 3, radius + 2);
+		const float losHeight = heights(rng);
+
+		std::vector<float> heightMap(stride * (diam + 5));
+		std::vector<float> isqrtTable((radius + 1) * (radius + 1) * 2);
+		std::vector<int> rowWidths = GetRowWidths(radius);
+
+		std::vector<float> angles(diam * diam, -1e8);
+		std::vector<char> scalarSquares(diam * diam, false);
+		std::vector<char> vectorSquares(diam * diam, false);
+
+		for (float& h: heightMap) {
+			h = heights(rng);
+		}
+		for (size_t i = 0; i < isqrtTable.size(); i++) {
+			isqrtTable[i] = 1.0f / std::sqrt(float(std::max<size_t>(i, 1)));
+		}
+
+		std::vector< std::vector<int2> > rays;
+
+		for (int a = 0; a <= radius; a++) {
+			rays.push_back(GetRay(radius, a));
+			rays.push_back(GetRay(a, radius));
+		}
+
+		LosRaycast::FillAngles(heightMap.data(), stride, pos, losHeight, radius, rowWidths.data(), isqrtTable.data(), angles.data(), scalarSquares.data());
+
+		for (const auto& ray: rays) {
+			LosRaycast::CastRay(ray.data(), ray.size(), radius, isqrtTable.data(), angles.data(), scalarSquares.data());
+		}
+
+		#if (LOS_RAYCAST_SIMD == 1)
+		std::vector<float> quadAngles((radius + 1) * (radius + 1) * 4, -1e8);
+		std::vector<float> quadVisible((radius + 1) * (radius + 1) * 4, 0.0f);
+
+		LosRaycast::FillQuadAngles(heightMap.data(), stride, pos, losHeight, radius, rowWidths.data(), isqrtTable.data(), quadAngles.data(), quadVisible.data());
+
+		for (const auto& ray: rays) {
+			LosRaycast::CastQuadRay(ray.data(), ray.size(), radius, isqrtTable.data(), quadAngles.data(), quadVisible.data());
+		}
+
+		LosRaycast::QuadToSquares(radius, rowWidths.data(), quadVisible.data(), vectorSquares.data());
+		#else
+		vectorSquares = scalarSquares;
+		#endif
+
+		CHECK(scalarSquares == vectorSquares);
+	}
+}
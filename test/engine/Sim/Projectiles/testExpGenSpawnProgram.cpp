@@ -0,0 +1,422 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Game/GlobalUnsynced.h"
+#include "Sim/Projectiles/ExplosionGenerator.h"
+#include "System/float3.h"
+#include "System/SafeUtil.h"
+#include "System/SpringMath.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+CGlobalUnsyncedRNG guRNG;
+
+
+namespace {
+	using CCEG = CCustomExplosionGenerator;
+
+	// exposes the spawn program to the test
+	class CTestExplosionGenerator: public CCustomExplosionGenerator {
+	public:
+		using CCustomExplosionGenerator::SpawnOp;
+		using CCustomExplosionGenerator::ProjectileSpawnInfo;
+
+		using CCustomExplosionGenerator::CompileExplosionCode;
+		using CCustomExplosionGenerator::ExecuteSpawnProgram;
+	};
+
+	using SpawnOp = CTestExplosionGenerator::SpawnOp;
+	using ProjectileSpawnInfo = CTestExplosionGenerator::ProjectileSpawnInfo;
+
+	// raw memory standing in for a spawnable, only written through offsets
+	struct alignas(8) SInstance {
+		std::array<std::uint8_t, 64> bytes;
+
+		bool operator == (const SInstance& i) const { return (bytes == i.bytes); }
+	};
+
+	constexpr std::uint16_t PTR_OFFSET = 56;
+	constexpr int NUM_SLOTS = CCEG::NUM_BUFFERS;
+
+
+	/// assembles byte-code the way ParseExplosionCode emits it
+	class CCegCode {
+	public:
+		CCegCode& Op(char opcode, float v) { code.push_back(opcode); Append(v); return *this; }
+		CCegCode& Buf(char opcode, int slot) { code.push_back(opcode); Append(slot); return *this; }
+
+		CCegCode& Add(float v) { return Op(CCEG::OP_ADD, v); }
+		CCegCode& Rand(float v) { return Op(CCEG::OP_RAND, v); }
+		CCegCode& Damage(float v) { return Op(CCEG::OP_DAMAGE, v); }
+		CCegCode& Index(float v) { return Op(CCEG::OP_INDEX, v); }
+
+		CCegCode& StoreF(std::uint16_t offset) { return Store(CCEG::OP_STOREF, 4, offset); }
+		CCegCode& StoreI(std::uint8_t size, std::uint16_t offset) { return Store(CCEG::OP_STOREI, size, offset); }
+		CCegCode& Store(char opcode, std::uint8_t size, std::uint16_t offset) {
+			code.push_back(opcode);
+			code.push_back(size);
+			Append(offset);
+			return *this;
+		}
+
+		CCegCode& Dir(std::uint16_t offset) { code.push_back(CCEG::OP_DIR); Append(offset); return *this; }
+		CCegCode& Ptr(void* ptr, std::uint16_t offset) {
+			code.push_back(CCEG::OP_LOADP);
+			Append(ptr);
+			code.push_back(CCEG::OP_STOREP);
+			Append(offset);
+			return *this;
+		}
+
+		const std::string& Get() const { return code; }
+
+	private:
+		template<typename T> void Append(const T& v) { code.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+	private:
+		std::string code;
+	};
+
+
+	/**
+	 * The per-spawnable interpreter CompileExplosionCode replaced. Random
+	 * draws are taken from <randVals> (one row per OP_RAND, one column per
+	 * spawnable) since the program draws per op across the whole batch.
+	 */
+	void ExecuteReference(
+		const std::string& script,
+		float damage,
+		SInstance& inst,
+		int spawnIndex,
+		const float3& dir,
+		const std::vector<std::vector<float>>& randVals
+	) {
+		const char* code = script.data();
+		const char* end = script.data() + script.size();
+		char* instance = reinterpret_cast<char*>(inst.bytes.data());
+
+		float val = 0.0f;
+		float buffer[NUM_SLOTS] = {0.0f};
+		void* ptr = nullptr;
+
+		size_t randOp = 0;
+
+		const auto ReadFloat = [&]() { float v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+		const auto ReadInt   = [&]() { int   v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+		const auto ReadPtr   = [&]() { void* v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+		const auto ReadU16   = [&]() { std::uint16_t v; std::memcpy(&v, code, sizeof(v)); code += sizeof(v); return v; };
+
+		while (code < end) {
+			switch (*(code++)) {
+				case CCEG::OP_STOREI: {
+					const std::uint8_t  size   = *(code++);
+					const std::uint16_t offset = ReadU16();
+
+					switch (size) {
+						case 1: { *(std::int8_t*)  (instance + offset) = (int) val; } break;
+						case 2: { *(std::int16_t*) (instance + offset) = (int) val; } break;
+						case 4: { *(std::int32_t*) (instance + offset) = (int) val; } break;
+						default: { FAIL("bad int size"); } break;
+					}
+					val = 0.0f;
+				} break;
+				case CCEG::OP_STOREF: {
+					const std::uint8_t  size   = *(code++);
+					const std::uint16_t offset = ReadU16();
+
+					REQUIRE(size == 4);
+					*(float*) (instance + offset) = val;
+					val = 0.0f;
+				} break;
+
+				case CCEG::OP_ADD   : { val += ReadFloat(); } break;
+				case CCEG::OP_RAND  : { val += randVals[randOp++][spawnIndex] * ReadFloat(); } break;
+				case CCEG::OP_DAMAGE: { val += damage * ReadFloat(); } break;
+				case CCEG::OP_INDEX : { val += spawnIndex * ReadFloat(); } break;
+
+				case CCEG::OP_LOADP : { ptr = ReadPtr(); } break;
+				case CCEG::OP_STOREP: { *(void**) (instance + ReadU16()) = ptr; ptr = nullptr; } break;
+				case CCEG::OP_DIR   : { *reinterpret_cast<float3*>(instance + ReadU16()) = dir; } break;
+
+				case CCEG::OP_SAWTOOTH: { const float v = ReadFloat(); val -= v * math::floor(val / v); } break;
+				case CCEG::OP_DISCRETE: { const float v = ReadFloat(); val = v * math::floor(spring::SafeDivide(val, v)); } break;
+				case CCEG::OP_SINE    : { val = ReadFloat() * math::sin(val); } break;
+				case CCEG::OP_POW     : { val = math::pow(val, ReadFloat()); } break;
+
+				case CCEG::OP_YANK    : { buffer[ReadInt()] = val; val = 0.0f; } break;
+				case CCEG::OP_MULTIPLY: { val *= buffer[ReadInt()]; } break;
+				case CCEG::OP_ADDBUFF : { val += buffer[ReadInt()]; } break;
+				case CCEG::OP_POWBUFF : { val = math::pow(val, buffer[ReadInt()]); } break;
+
+				default: {
+					FAIL("bad opcode");
+				} break;
+			}
+		}
+	}
+
+
+	int CountOps(const ProjectileSpawnInfo& psi, int op) {
+		int n = 0;
+
+		for (const SpawnOp& sop: psi.program) {
+			n += (sop.op == op);
+		}
+
+		return n;
+	}
+
+	struct SResult {
+		std::vector<SInstance> compiled;
+		std::vector<SInstance> reference;
+	};
+
+	/// runs <code> for <count> spawnables both compiled and interpreted
+	SResult Run(const std::string& code, unsigned int count, float damage, const float3& dir, ProjectileSpawnInfo* psiOut = nullptr) {
+		ProjectileSpawnInfo psi;
+		psi.count = count;
+
+		CTestExplosionGenerator::CompileExplosionCode(&psi, code);
+
+		SResult res;
+		res.compiled.resize(count, SInstance{});
+		res.reference.resize(count, SInstance{});
+
+		// replay the draws the program is about to make, in the same order
+		CGlobalUnsyncedRNG rng = guRNG;
+		std::vector<std::vector<float>> randVals(CountOps(psi, CCEG::OP_RAND), std::vector<float>(count));
+
+		for (auto& row: randVals) {
+			for (float& v: row) {
+				v = rng.NextFloat();
+			}
+		}
+
+		std::vector<CExpGenSpawnable*> instances(count);
+
+		for (unsigned int i = 0; i < count; i++) {
+			instances[i] = reinterpret_cast<CExpGenSpawnable*>(res.compiled[i].bytes.data());
+		}
+
+		CTestExplosionGenerator::ExecuteSpawnProgram(psi, damage, instances.data(), dir);
+
+		for (unsigned int i = 0; i < count; i++) {
+			ExecuteReference(code, damage, res.reference[i], i, dir, randVals);
+		}
+
+		if (psiOut != nullptr)
+			*psiOut = psi;
+
+		return res;
+	}
+
+
+	/**
+	 * Generates random property scripts over all opcodes; operands come
+	 * from a small pool so that folds, buffer hits and edge cases (zero
+	 * divisors, negative bases) come up often.
+	 */
+	class CScriptGenerator {
+	public:
+		CScriptGenerator(unsigned int seed): rng(seed) {}
+
+		std::string Generate() {
+			CCegCode code;
+
+			const int numProps = Pick(1, 8);
+
+			for (int i = 0; i < numProps; i++) {
+				switch (Pick(0, 9)) {
+					case 0: { code.Dir(4 * Pick(0, 6)); continue; } break;
+					case 1: { code.Ptr(reinterpret_cast<void*>(std::uintptr_t(Pick(1, 1 << 20))), PTR_OFFSET); continue; } break;
+					default: {} break;
+				}
+
+				const int numOps = Pick(0, 6);
+
+				for (int j = 0; j < numOps; j++) {
+					switch (Pick(0, 11)) {
+						case  0: { code.Add(Operand()); } break;
+						case  1: { code.Rand(Operand()); } break;
+						case  2: { code.Damage(Operand()); } break;
+						case  3: { code.Index(Operand()); } break;
+						case  4: { code.Op(CCEG::OP_SAWTOOTH, Operand()); } break;
+						case  5: { code.Op(CCEG::OP_DISCRETE, Operand()); } break;
+						case  6: { code.Op(CCEG::OP_SINE, Operand()); } break;
+						case  7: { code.Op(CCEG::OP_POW, Operand()); } break;
+						case  8: { code.Buf(CCEG::OP_YANK, Slot()); } break;
+						case  9: { code.Buf(CCEG::OP_MULTIPLY, Slot()); } break;
+						case 10: { code.Buf(CCEG::OP_ADDBUFF, Slot()); } break;
+						case 11: { code.Buf(CCEG::OP_POWBUFF, Slot()); } break;
+					}
+				}
+
+				switch (Pick(0, 4)) {
+					case 0: { code.StoreI(1, 28 + Pick(0, 3)); } break;
+					case 1: { code.StoreI(2, 32 + 2 * Pick(0, 3)); } break;
+					case 2: { code.StoreI(4, 40 + 4 * Pick(0, 3)); } break;
+					default: { code.StoreF(4 * Pick(0, 6)); } break;
+				}
+			}
+
+			return code.Get();
+		}
+
+	private:
+		int Pick(int a, int b) { return std::uniform_int_distribution<int>(a, b)(rng); }
+
+		float Operand() {
+			static constexpr float operands[] = {0.0f, 1.0f, 2.0f, 0.5f, -1.0f, -2.5f, 3.25f, 10.0f, 0.1f};
+			return operands[Pick(0, std::size(operands) - 1)];
+		}
+		// favour a few slots, including the last one the parser allows
+		int Slot() { return std::array<int, 4>{0, 1, 2, NUM_SLOTS - 1}[Pick(0, 3)]; }
+
+	private:
+		std::mt19937 rng;
+	};
+}
+
+
+TEST_CASE("ExpGenSpawnProgramFolding")
+{
+	guRNG.Seed(1234);
+
+	const float3 dir = {0.25f, 0.5f, -0.75f};
+
+	SECTION("constants") {
+		// "3"; "2.7" as int; "1 2 m1.5"; "4 k3"
+		const std::string code = CCegCode()
+			.Add(3.0f).StoreF(0)
+			.Add(2.7f).StoreI(4, 40)
+			.Add(1.0f).Add(2.0f).Op(CCEG::OP_SAWTOOTH, 1.5f).StoreF(4)
+			.Add(4.0f).Op(CCEG::OP_DISCRETE, 3.0f).StoreF(8)
+			.Get();
+
+		ProjectileSpawnInfo psi;
+		const SResult res = Run(code, 5, 100.0f, dir, &psi);
+
+		REQUIRE(psi.program.size() == 4);
+		CHECK(CountOps(psi, CCEG::OP_STOREFC) == 3);
+		CHECK(CountOps(psi, CCEG::OP_STOREIC) == 1);
+		CHECK(psi.program[0].arg == 3.0f);
+		CHECK(psi.program[2].arg == 0.0f);
+		CHECK(psi.program[3].arg == 3.0f);
+		CHECK(!psi.usesBuffers);
+		CHECK(res.compiled == res.reference);
+
+		std::int32_t i;
+		std::memcpy(&i, &res.compiled[4].bytes[40], sizeof(i));
+		CHECK(i == 2);
+	}
+
+	SECTION("constant buffers") {
+		// "2 y0"; "r1 x0"; "3 a0"; "2 q0"
+		const std::string code = CCegCode()
+			.Add(2.0f).Buf(CCEG::OP_YANK, 0).StoreF(0)
+			.Rand(1.0f).Buf(CCEG::OP_MULTIPLY, 0).StoreF(4)
+			.Add(3.0f).Buf(CCEG::OP_ADDBUFF, 0).StoreF(8)
+			.Add(2.0f).Buf(CCEG::OP_POWBUFF, 0).StoreF(12)
+			.Get();
+
+		ProjectileSpawnInfo psi;
+		const SResult res = Run(code, 7, 100.0f, dir, &psi);
+
+		CHECK(CountOps(psi, CCEG::OP_YANK) == 0);
+		CHECK(CountOps(psi, CCEG::OP_MULTIPLY) == 0);
+		CHECK(CountOps(psi, CCEG::OP_MULC) == 1);
+		CHECK(CountOps(psi, CCEG::OP_RAND) == 1);
+		CHECK(CountOps(psi, CCEG::OP_STOREFC) == 3);
+		CHECK(!psi.usesBuffers);
+		CHECK(res.compiled == res.reference);
+	}
+
+	SECTION("runtime buffers") {
+		// "r1 y16"; "d0.5 a16 x16"; "i1 q16"
+		const std::string code = CCegCode()
+			.Rand(1.0f).Buf(CCEG::OP_YANK, NUM_SLOTS - 1).StoreF(0)
+			.Damage(0.5f).Buf(CCEG::OP_ADDBUFF, NUM_SLOTS - 1).Buf(CCEG::OP_MULTIPLY, NUM_SLOTS - 1).StoreF(4)
+			.Index(1.0f).Buf(CCEG::OP_POWBUFF, NUM_SLOTS - 1).StoreF(8)
+			.Get();
+
+		ProjectileSpawnInfo psi;
+		const SResult res = Run(code, 9, 40.0f, dir, &psi);
+
+		CHECK(psi.usesBuffers);
+		CHECK(CountOps(psi, CCEG::OP_YANK) == 1);
+		CHECK(CountOps(psi, CCEG::OP_ADDBUFF) == 1);
+		CHECK(CountOps(psi, CCEG::OP_MULTIPLY) == 1);
+		CHECK(CountOps(psi, CCEG::OP_POWBUFF) == 1);
+		CHECK(res.compiled == res.reference);
+	}
+
+	SECTION("damage, index and dir") {
+		// "1 d0.5"; "i2 3"; dir; "d1 i1 s2"
+		const std::string code = CCegCode()
+			.Add(1.0f).Damage(0.5f).StoreF(0)
+			.Index(2.0f).Add(3.0f).StoreI(2, 32)
+			.Dir(12)
+			.Damage(1.0f).Index(1.0f).Op(CCEG::OP_SINE, 2.0f).StoreF(24)
+			.Ptr(reinterpret_cast<void*>(std::uintptr_t(0x1234)), PTR_OFFSET)
+			.Get();
+
+		ProjectileSpawnInfo psi;
+		const SResult res = Run(code, 4, 30.0f, dir, &psi);
+
+		CHECK(CountOps(psi, CCEG::OP_LOADC) == 3);
+		CHECK(CountOps(psi, CCEG::OP_DAMAGE) == 2);
+		CHECK(CountOps(psi, CCEG::OP_INDEX) == 2);
+		CHECK(CountOps(psi, CCEG::OP_DIR) == 1);
+		CHECK(CountOps(psi, CCEG::OP_STOREP) == 1);
+		CHECK(res.compiled == res.reference);
+
+		float f;
+		std::memcpy(&f, &res.compiled[3].bytes[0], sizeof(f));
+		CHECK(f == 16.0f);
+		std::memcpy(&f, &res.compiled[2].bytes[16], sizeof(f));
+		CHECK(f == dir.y);
+	}
+}
+
+TEST_CASE("ExpGenSpawnProgramEquivalence")
+{
+	CScriptGenerator generator(42);
+
+	std::array<int, CCEG::OP_STOREFC + 1> opCounts = {};
+
+	guRNG.Seed(5678);
+
+	for (int n = 0; n < 2000; n++) {
+		const std::string code = generator.Generate();
+		const unsigned int count = std::array<unsigned int, 4>{1, 2, 7, 33}[n % 4];
+		const float damage = (n % 5) * 17.5f;
+		const float3 dir = {0.1f * (n % 7), -0.5f, 0.3f};
+
+		ProjectileSpawnInfo psi;
+		const SResult res = Run(code, count, damage, dir, &psi);
+
+		for (const SpawnOp& sop: psi.program) {
+			opCounts[sop.op]++;
+		}
+
+		INFO("program " << n);
+		CHECK(res.compiled == res.reference);
+	}
+
+	// every kind of op, folded or not, has to have been exercised
+	for (int op = CCEG::OP_STOREI; op < int(opCounts.size()); op++) {
+		if (op == 3 || op == CCEG::OP_LOADP)
+			continue;
+
+		INFO("op " << op);
+		CHECK(opCounts[op] > 0);
+	}
+}
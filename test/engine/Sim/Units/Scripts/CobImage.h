@@ -0,0 +1,153 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_IMAGE_H
+#define COB_IMAGE_H
+
+#include "System/FileSystem/FileHandler.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// raw opcodes, from the COB format documentation
+namespace CobOpcode {
+	static constexpr int MOVE                 = 0x10001000;
+	static constexpr int TURN                 = 0x10002000;
+	static constexpr int HIDE                 = 0x10006000;
+	static constexpr int SLEEP                = 0x10013000;
+
+	static constexpr int PUSH_CONSTANT        = 0x10021001;
+	static constexpr int PUSH_LOCAL_VAR       = 0x10021002;
+	static constexpr int PUSH_STATIC          = 0x10021004;
+	static constexpr int CREATE_LOCAL_VAR     = 0x10022000;
+	static constexpr int POP_LOCAL_VAR        = 0x10023002;
+	static constexpr int POP_STATIC           = 0x10023004;
+	static constexpr int POP_STACK            = 0x10024000;
+
+	static constexpr int ADD                  = 0x10031000;
+	static constexpr int SUB                  = 0x10032000;
+	static constexpr int MUL                  = 0x10033000;
+	static constexpr int DIV                  = 0x10034000;
+	static constexpr int MOD                  = 0x10034001;
+	static constexpr int BITWISE_AND          = 0x10035000;
+	static constexpr int BITWISE_OR           = 0x10036000;
+	static constexpr int BITWISE_XOR          = 0x10037000;
+	static constexpr int BITWISE_NOT          = 0x10038000;
+
+	static constexpr int RAND                 = 0x10041000;
+	static constexpr int GET_UNIT_VALUE       = 0x10042000;
+
+	static constexpr int SET_LESS             = 0x10051000;
+	static constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
+	static constexpr int SET_GREATER          = 0x10053000;
+	static constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
+	static constexpr int SET_EQUAL            = 0x10055000;
+	static constexpr int SET_NOT_EQUAL        = 0x10056000;
+	static constexpr int LOGICAL_AND          = 0x10057000;
+	static constexpr int LOGICAL_OR           = 0x10058000;
+	static constexpr int LOGICAL_XOR          = 0x10059000;
+	static constexpr int LOGICAL_NOT          = 0x1005A000;
+
+	static constexpr int CALL                 = 0x10062000;
+	static constexpr int JUMP                 = 0x10064000;
+	static constexpr int RETURN               = 0x10065000;
+	static constexpr int JUMP_NOT_EQUAL       = 0x10066000;
+	static constexpr int SET_SIGNAL_MASK      = 0x10068000;
+
+	static constexpr int SET                  = 0x10082000;
+}
+
+
+/**
+ * Assembles a .cob file image laid out like the compilers emit them: the
+ * header, the code of all scripts, then the script offset, script name and
+ * piece name tables followed by the names themselves.
+ */
+class CCobImage {
+public:
+	struct Script {
+		std::string name;
+		std::vector<int> code;
+	};
+
+public:
+	/// returns the word offset of the script's code within the image
+	int AddScript(const std::string& name, const std::vector<int>& code) {
+		scripts.push_back({name, code});
+		return (codeSize += code.size()) - code.size();
+	}
+
+	int GetCodeOffset() const { return codeSize; }
+
+	void SetNumStaticVars(int n) { numStaticVars = n; }
+	void AddPiece(const std::string& name) { pieces.push_back(name); }
+
+	std::vector<std::uint8_t> Build() const {
+		constexpr int HEADER_SIZE = 13 * 4;
+
+		const int numScripts = scripts.size();
+		const int numPieces = pieces.size();
+
+		const int codeOfs = HEADER_SIZE;
+		const int scriptIndexOfs = codeOfs + codeSize * 4;
+		const int scriptNameIndexOfs = scriptIndexOfs + numScripts * 4;
+		const int pieceNameIndexOfs = scriptNameIndexOfs + numScripts * 4;
+		const int namesOfs = pieceNameIndexOfs + numPieces * 4;
+
+		std::vector<std::uint8_t> data(namesOfs, 0);
+
+		const auto PutWord = [&](int ofs, int v) { std::memcpy(&data[ofs], &v, 4); };
+		const auto PutName = [&](int indexOfs, const std::string& name) {
+			PutWord(indexOfs, data.size());
+			data.insert(data.end(), name.begin(), name.end());
+			data.push_back(0);
+		};
+
+		PutWord( 0 * 4, 4); // TA
+		PutWord( 1 * 4, numScripts);
+		PutWord( 2 * 4, numPieces);
+		PutWord( 3 * 4, codeSize);
+		PutWord( 4 * 4, numStaticVars);
+		PutWord( 6 * 4, scriptIndexOfs);
+		PutWord( 7 * 4, scriptNameIndexOfs);
+		PutWord( 8 * 4, pieceNameIndexOfs);
+		PutWord( 9 * 4, codeOfs);
+
+		for (int i = 0, ofs = 0; i < numScripts; ofs += scripts[i++].code.size()) {
+			for (size_t j = 0; j < scripts[i].code.size(); j++) {
+				PutWord(codeOfs + (ofs + j) * 4, scripts[i].code[j]);
+			}
+
+			PutWord(scriptIndexOfs + i * 4, ofs);
+		}
+
+		for (int i = 0; i < numScripts; i++) {
+			PutName(scriptNameIndexOfs + i * 4, scripts[i].name);
+		}
+		for (int i = 0; i < numPieces; i++) {
+			PutName(pieceNameIndexOfs + i * 4, pieces[i]);
+		}
+
+		return data;
+	}
+
+private:
+	std::vector<Script> scripts;
+	std::vector<std::string> pieces;
+
+	int codeSize = 0;
+	int numStaticVars = 0;
+};
+
+
+/// hands a .cob image to CCobFile as if it had been buffered from the VFS
+class CCobImageFileHandler: public CFileHandler {
+public:
+	CCobImageFileHandler(std::vector<std::uint8_t>&& data) {
+		fileBuffer = std::move(data);
+		fileSize = fileBuffer.size();
+	}
+};
+
+#endif // COB_IMAGE_H
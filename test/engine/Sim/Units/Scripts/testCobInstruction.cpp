@@ -0,0 +1,218 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobInstruction.h"
+
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+// raw opcodes, from the COB format documentation
+static constexpr int PUSH_CONSTANT        = 0x10021001;
+static constexpr int SET_LESS             = 0x10051000;
+static constexpr int SET_LESS_OR_EQUAL    = 0x10052000;
+static constexpr int SET_GREATER          = 0x10053000;
+static constexpr int SET_GREATER_OR_EQUAL = 0x10054000;
+static constexpr int SET_EQUAL            = 0x10055000;
+static constexpr int SET_NOT_EQUAL        = 0x10056000;
+static constexpr int CALL                 = 0x10062000;
+static constexpr int REAL_CALL            = 0x10062001;
+static constexpr int LUA_CALL             = 0x10062002;
+static constexpr int JUMP                 = 0x10064000;
+static constexpr int RETURN               = 0x10065000;
+static constexpr int JUMP_NOT_EQUAL       = 0x10066000;
+
+static constexpr int SET_CMP_OPS[] = {SET_LESS, SET_LESS_OR_EQUAL, SET_GREATER, SET_GREATER_OR_EQUAL, SET_EQUAL, SET_NOT_EQUAL};
+
+
+static std::vector<CCobInstruction> Decode(const std::vector<int>& code)
+{
+	return CobInstructionDecoder::Decode(code, {});
+}
+
+
+TEST_CASE("CobInstructionSentinel")
+{
+	const std::vector<int> code = {RETURN, RETURN};
+	const std::vector<CCobInstruction> instrs = Decode(code);
+
+	// one entry per code word plus the sentinel
+	REQUIRE(instrs.size() == code.size() + 1);
+	CHECK(instrs[0].op == CobOp::Return);
+	CHECK(instrs[0].next == 1);
+	CHECK(instrs[2].op == CobOp::OutOfRange);
+
+	// operands reaching past the end of the code do not decode either
+	CHECK(Decode({JUMP})[0].op == CobOp::OutOfRange);
+	CHECK(Decode({PUSH_CONSTANT})[0].op == CobOp::OutOfRange);
+	CHECK(Decode({CALL, 0})[0].op == CobOp::OutOfRange);
+
+	// unknown opcodes keep the raw word for the error message
+	CHECK(Decode({0x12345678})[0].op == CobOp::Unknown);
+	CHECK(Decode({0x12345678})[0].args[0] == 0x12345678);
+}
+
+TEST_CASE("CobInstructionFuseSetCmpJne")
+{
+	for (int i = 0; i < 6; i++) {
+		// setX; jne 4; return; return
+		const std::vector<int> code = {SET_CMP_OPS[i], JUMP_NOT_EQUAL, 4, RETURN, RETURN};
+		const std::vector<CCobInstruction> instrs = Decode(code);
+
+		CHECK(instrs[0].op == CobOp::JumpUnlessLess + i);
+		CHECK(instrs[0].next == 3);
+		CHECK(instrs[0].args[0] == 4);
+
+		// the jne word still decodes on its own
+		CHECK(instrs[1].op == CobOp::JumpNotEqual);
+		CHECK(instrs[1].next == 3);
+		CHECK(instrs[1].args[0] == 4);
+	}
+
+	// no fusion without a following jne, or with its target cut off
+	CHECK(Decode({SET_LESS, RETURN})[0].op == CobOp::SetLess);
+	CHECK(Decode({SET_LESS, RETURN})[0].next == 1);
+	CHECK(Decode({SET_GREATER, JUMP_NOT_EQUAL})[0].op == CobOp::SetGreater);
+	CHECK(Decode({SET_GREATER, JUMP_NOT_EQUAL})[0].next == 1);
+}
+
+TEST_CASE("CobInstructionFusePushcSetCmpJne")
+{
+	for (int i = 0; i < 6; i++) {
+		// pushc 7; setX; jne 6; return; return
+		const std::vector<int> code = {PUSH_CONSTANT, 7, SET_CMP_OPS[i], JUMP_NOT_EQUAL, 6, RETURN, RETURN};
+		const std::vector<CCobInstruction> instrs = Decode(code);
+
+		CHECK(instrs[0].op == CobOp::JumpUnlessLessConst + i);
+		CHECK(instrs[0].next == 5);
+		CHECK(instrs[0].args[0] == 7);
+		CHECK(instrs[0].args[1] == 6);
+
+		// the <set-cmp, jne> tail is fused by itself as well
+		CHECK(instrs[2].op == CobOp::JumpUnlessLess + i);
+		CHECK(instrs[2].next == 5);
+		CHECK(instrs[2].args[0] == 6);
+	}
+
+	// falls back to a plain push when the pattern is incomplete
+	CHECK(Decode({PUSH_CONSTANT, 7, SET_LESS, RETURN, 0})[0].op == CobOp::PushConstant);
+	CHECK(Decode({PUSH_CONSTANT, 7, SET_LESS, RETURN, 0})[0].next == 2);
+	CHECK(Decode({PUSH_CONSTANT, 7, RETURN, JUMP_NOT_EQUAL, 0})[0].op == CobOp::PushConstant);
+	CHECK(Decode({PUSH_CONSTANT, 7, SET_LESS, JUMP_NOT_EQUAL})[0].op == CobOp::PushConstant);
+	CHECK(Decode({PUSH_CONSTANT, 7, SET_LESS, JUMP_NOT_EQUAL})[0].args[0] == 7);
+}
+
+TEST_CASE("CobInstructionJumpIntoFusedOperand")
+{
+	// 0: pushc RETURN; 2: setl; 3: jne 9; 5: jmp 1; 7: jmp 3; 9: return
+	const std::vector<int> code = {
+		PUSH_CONSTANT, RETURN,
+		SET_LESS,
+		JUMP_NOT_EQUAL, 9,
+		JUMP, 1,
+		JUMP, 3,
+		RETURN,
+	};
+	const std::vector<CCobInstruction> instrs = Decode(code);
+
+	REQUIRE(instrs[0].op == CobOp::JumpUnlessLessConst);
+	REQUIRE(instrs[0].next == 5);
+
+	// a jump landing on the constant executes it as an opcode
+	CHECK(instrs[5].args[0] == 1);
+	CHECK(instrs[1].op == CobOp::Return);
+	CHECK(instrs[1].next == 2);
+
+	// a jump landing on the jne executes it unfused
+	CHECK(instrs[7].args[0] == 3);
+	CHECK(instrs[3].op == CobOp::JumpNotEqual);
+	CHECK(instrs[3].next == 5);
+	CHECK(instrs[3].args[0] == 9);
+
+	// the jne target word decodes as an (unknown) opcode too
+	CHECK(instrs[4].op == CobOp::Unknown);
+	CHECK(instrs[4].args[0] == 9);
+}
+
+TEST_CASE("CobInstructionJumpTargetRange")
+{
+	const std::vector<int> code = {
+		JUMP, -1,
+		JUMP, 8,
+		JUMP, 9,
+		JUMP, 1000,
+		JUMP_NOT_EQUAL, -5,
+		SET_EQUAL, JUMP_NOT_EQUAL, 0x7FFFFFFF,
+		PUSH_CONSTANT, 0, SET_LESS, JUMP_NOT_EQUAL, -0x7FFFFFFF - 1,
+		RETURN,
+	};
+	const std::vector<CCobInstruction> instrs = Decode(code);
+	const int sentinel = static_cast<int>(code.size());
+
+	REQUIRE(instrs.size() == code.size() + 1);
+	REQUIRE(instrs[sentinel].op == CobOp::OutOfRange);
+
+	CHECK(instrs[0].args[0] == sentinel);
+	// in-range targets are kept, including the sentinel itself
+	CHECK(instrs[2].args[0] == 8);
+	CHECK(instrs[4].args[0] == 9);
+	CHECK(instrs[6].args[0] == sentinel);
+	CHECK(instrs[8].op == CobOp::JumpNotEqual);
+	CHECK(instrs[8].args[0] == sentinel);
+
+	CHECK(instrs[10].op == CobOp::JumpUnlessEqual);
+	CHECK(instrs[10].args[0] == sentinel);
+
+	CHECK(instrs[13].op == CobOp::JumpUnlessLessConst);
+	CHECK(instrs[13].args[0] == 0);
+	CHECK(instrs[13].args[1] == sentinel);
+
+	// a jump to the very end lands on the sentinel as well
+	const std::vector<int> tail = {JUMP, 2};
+	CHECK(Decode(tail)[0].args[0] == 2);
+	CHECK(Decode(tail)[2].op == CobOp::OutOfRange);
+}
+
+TEST_CASE("CobInstructionCallResolution")
+{
+	const std::vector<std::string> names = {"Create", "lua_Explode", "Killed"};
+	const std::vector<int> code = {
+		CALL, 0, 2,
+		CALL, 1, 0,
+		CALL, 2, 1,
+		CALL, 3, 0,
+		CALL, -1, 0,
+		REAL_CALL, 1, 0,
+		LUA_CALL, 0, 3,
+		RETURN,
+	};
+	const std::vector<CCobInstruction> instrs = CobInstructionDecoder::Decode(code, names);
+
+	// resolved by name only, like the raw interpreter did on first execution
+	CHECK(instrs[0].op == CobOp::RealCall);
+	CHECK(instrs[0].next == 3);
+	CHECK(instrs[0].args[0] == 0);
+	CHECK(instrs[0].args[1] == 2);
+
+	CHECK(instrs[3].op == CobOp::LuaCall);
+	CHECK(instrs[3].args[0] == 1);
+	CHECK(instrs[3].args[1] == 0);
+
+	CHECK(instrs[6].op == CobOp::RealCall);
+	CHECK(instrs[6].args[0] == 2);
+	CHECK(instrs[6].args[1] == 1);
+
+	// script indices outside the name table never resolve to a Lua call
+	CHECK(instrs[9].op == CobOp::RealCall);
+	CHECK(instrs[9].args[0] == 3);
+	CHECK(instrs[12].op == CobOp::RealCall);
+	CHECK(instrs[12].args[0] == -1);
+
+	// already-converted calls are taken as they are
+	CHECK(instrs[15].op == CobOp::RealCall);
+	CHECK(instrs[15].args[0] == 1);
+	CHECK(instrs[18].op == CobOp::LuaCall);
+	CHECK(instrs[18].args[0] == 0);
+	CHECK(instrs[18].args[1] == 3);
+}
@@ -0,0 +1,712 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "CobImage.h"
+
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobInstance.h"
+#include "Sim/Units/Scripts/CobInstruction.h"
+#include "Sim/Units/Scripts/CobScriptNames.h"
+#include "Sim/Units/Scripts/CobThread.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using namespace CobOpcode;
+
+static constexpr int SET_CMP_OPS[] = {SET_LESS, SET_LESS_OR_EQUAL, SET_GREATER, SET_GREATER_OR_EQUAL, SET_EQUAL, SET_NOT_EQUAL};
+
+
+namespace {
+	/**
+	 * The switch-dispatch interpreter CCobThread::Tick replaced, reduced to
+	 * the opcodes that do not leave the thread (no sleeps, waits or starts).
+	 * Runs straight off the raw code words and records every pc it executes.
+	 */
+	class CRefThread {
+	public:
+		CRefThread(const CCobFile& f, std::vector<int>& sv): cobFile(f), staticVars(sv) {}
+
+		void Start(int functionId, const std::vector<int>& args) {
+			pc = cobFile.scriptOffsets[functionId];
+			paramCount = args.size();
+
+			callStack.push_back({functionId, -1, 0});
+			dataStack = args;
+		}
+
+		bool Run() {
+			int r1, r2;
+
+			while (true) {
+				trace.push_back(pc);
+
+				switch (GetLongPC()) {
+					case PUSH_CONSTANT: {
+						PushDataStack(GetLongPC());
+					} break;
+					case PUSH_LOCAL_VAR: {
+						r1 = GetLongPC();
+						PushDataStack(dataStack[callStack.back().stackTop + r1]);
+					} break;
+					case PUSH_STATIC: {
+						r1 = GetLongPC();
+
+						if (static_cast<size_t>(r1) < staticVars.size())
+							PushDataStack(staticVars[r1]);
+					} break;
+					case CREATE_LOCAL_VAR: {
+						if (paramCount == 0) {
+							PushDataStack(0);
+						} else {
+							paramCount--;
+						}
+					} break;
+					case POP_LOCAL_VAR: {
+						r1 = GetLongPC();
+						r2 = PopDataStack();
+						dataStack[callStack.back().stackTop + r1] = r2;
+					} break;
+					case POP_STATIC: {
+						r1 = GetLongPC();
+						r2 = PopDataStack();
+
+						if (static_cast<size_t>(r1) < staticVars.size())
+							staticVars[r1] = r2;
+					} break;
+					case POP_STACK: {
+						PopDataStack();
+					} break;
+
+					case ADD: { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(r1 + r2); } break;
+					case SUB: { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(r1 - r2); } break;
+					case MUL: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 * r2); } break;
+					case DIV: {
+						r2 = PopDataStack();
+						r1 = PopDataStack();
+						PushDataStack((r2 != 0)? (r1 / r2): 1000);
+					} break;
+					case MOD: {
+						r2 = PopDataStack();
+						r1 = PopDataStack();
+						PushDataStack((r2 != 0)? (r1 % r2): 0);
+					} break;
+
+					case BITWISE_AND: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 & r2); } break;
+					case BITWISE_OR : { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 | r2); } break;
+					case BITWISE_XOR: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(r1 ^ r2); } break;
+					case BITWISE_NOT: { r1 = PopDataStack(); PushDataStack(~r1); } break;
+
+					case RAND: {
+						r2 = PopDataStack();
+						r1 = PopDataStack();
+						PushDataStack(gsRNG.NextInt(r2 - r1 + 1) + r1);
+					} break;
+					case GET_UNIT_VALUE: {
+						// NullCobInstance answers every unit value with 0
+						PopDataStack();
+						PushDataStack(0);
+					} break;
+
+					case SET_LESS            : { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(int(r1 <  r2)); } break;
+					case SET_LESS_OR_EQUAL   : { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(int(r1 <= r2)); } break;
+					case SET_GREATER         : { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(int(r1 >  r2)); } break;
+					case SET_GREATER_OR_EQUAL: { r2 = PopDataStack(); r1 = PopDataStack(); PushDataStack(int(r1 >= r2)); } break;
+					case SET_EQUAL           : { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(int(r1 == r2)); } break;
+					case SET_NOT_EQUAL       : { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(int(r1 != r2)); } break;
+
+					case LOGICAL_AND: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(int(r1 && r2)); } break;
+					case LOGICAL_OR : { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(int(r1 || r2)); } break;
+					case LOGICAL_XOR: { r1 = PopDataStack(); r2 = PopDataStack(); PushDataStack(int((!!r1) ^ (!!r2))); } break;
+					case LOGICAL_NOT: { r1 = PopDataStack(); PushDataStack(int(r1 == 0)); } break;
+
+					case MOVE:
+					case TURN: {
+						GetLongPC();
+						GetLongPC();
+						PopDataStack();
+						PopDataStack();
+					} break;
+					case HIDE: {
+						GetLongPC();
+					} break;
+					case SET_SIGNAL_MASK: {
+						PopDataStack();
+					} break;
+
+					case CALL: {
+						r1 = GetLongPC();
+						r2 = GetLongPC();
+
+						// do not call zero-length functions
+						if (cobFile.scriptLengths[r1] == 0)
+							break;
+
+						callStack.push_back({r1, pc, int(dataStack.size()) - r2});
+						paramCount = r2;
+						pc = cobFile.scriptOffsets[r1];
+					} break;
+					case JUMP: {
+						pc = GetLongPC();
+					} break;
+					case JUMP_NOT_EQUAL: {
+						r1 = GetLongPC();
+						r2 = PopDataStack();
+
+						if (r2 == 0)
+							pc = r1;
+					} break;
+					case RETURN: {
+						retCode = PopDataStack();
+
+						if (callStack.back().returnAddr == -1)
+							return true;
+
+						pc = callStack.back().returnAddr;
+
+						if (dataStack.size() > static_cast<size_t>(callStack.back().stackTop))
+							dataStack.resize(callStack.back().stackTop);
+
+						callStack.pop_back();
+					} break;
+
+					default: {
+						return false;
+					} break;
+				}
+			}
+		}
+
+	private:
+		int GetLongPC() { return cobFile.code[pc++]; }
+
+		void PushDataStack(int v) { dataStack.push_back(v); }
+		int PopDataStack() {
+			if (dataStack.empty())
+				return 0;
+
+			const int v = dataStack.back();
+			dataStack.pop_back();
+			return v;
+		}
+
+	public:
+		struct CallInfo {
+			int functionId;
+			int returnAddr;
+			int stackTop;
+		};
+
+		const CCobFile& cobFile;
+
+		std::vector<int>& staticVars;
+		std::vector<int> dataStack;
+		std::vector<CallInfo> callStack;
+		std::vector<int> trace;
+
+		int pc = 0;
+		int paramCount = 0;
+		int retCode = -1;
+	};
+
+
+	/**
+	 * Emits random but well-formed scripts the way the BOS compilers lay
+	 * them out: locals created up front, expressions leaving exactly one
+	 * value, conditions ending in setX/jne (which the decoder fuses), and
+	 * bounded loops. Calls only go to higher-numbered scripts, so every
+	 * program terminates.
+	 */
+	class CScriptGenerator {
+	public:
+		static constexpr int NUM_SCRIPTS = 6;
+		static constexpr int NUM_STATICS = 4;
+		static constexpr int NUM_LOCALS = 4;
+		static constexpr int MAX_LOOP_DEPTH = 2;
+
+		CScriptGenerator(unsigned int seed): rng(seed) {}
+
+		std::vector<std::uint8_t> Generate() {
+			CCobImage image;
+
+			image.SetNumStaticVars(NUM_STATICS);
+			image.AddPiece("base");
+
+			for (int i = 0; i < NUM_SCRIPTS; i++) {
+				numArgs[i] = Rand(0, 2);
+			}
+			for (int i = 0; i < NUM_SCRIPTS; i++) {
+				code.clear();
+				base = image.GetCodeOffset();
+				curScript = i;
+				loopDepth = 0;
+
+				// <numArgs> of the locals are taken by the arguments
+				for (int j = 0; j < NUM_LOCALS + MAX_LOOP_DEPTH; j++) {
+					Emit({CREATE_LOCAL_VAR});
+				}
+
+				Block(3);
+				Expr(3);
+				Emit({RETURN});
+
+				image.AddScript("Script" + std::to_string(i), code);
+			}
+
+			return image.Build();
+		}
+
+		int GetNumArgs(int script) const { return numArgs[script]; }
+
+	private:
+		int Rand(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+		bool Chance(int pct) { return (Rand(0, 99) < pct); }
+
+		int Here() const { return base + code.size(); }
+		void Emit(std::initializer_list<int> words) { code.insert(code.end(), words); }
+		void Patch(size_t idx, int addr) { code[idx] = addr; }
+
+		// jump targets are absolute word offsets, emitted as placeholders
+		size_t EmitJump(int op) {
+			Emit({op, 0});
+			return code.size() - 1;
+		}
+
+		// locals above NUM_LOCALS are reserved for loop counters
+		int AnyLocal() { return Rand(0, NUM_LOCALS - 1); }
+
+		void Expr(int depth) {
+			if (depth <= 0 || Chance(25)) {
+				switch (Rand(0, 3)) {
+					case 0: { Emit({PUSH_CONSTANT, Rand(-8, 8)}); } break;
+					case 1: { Emit({PUSH_CONSTANT, int(rng())}); } break;
+					case 2: { Emit({PUSH_LOCAL_VAR, AnyLocal()}); } break;
+					case 3: { Emit({PUSH_STATIC, Rand(0, NUM_STATICS - 1)}); } break;
+				}
+				return;
+			}
+
+			switch (Rand(0, 11)) {
+				case 0: {
+					// keep the operands small, signed overflow is UB in either interpreter
+					const int op = (Chance(50)? ADD: SUB);
+					Expr(depth - 1); Emit({PUSH_CONSTANT, 0xFFFF, BITWISE_AND});
+					Expr(depth - 1); Emit({PUSH_CONSTANT, 0xFFFF, BITWISE_AND, op});
+				} break;
+				case 1: {
+					Expr(depth - 1); Emit({PUSH_CONSTANT, 0x7FF, BITWISE_AND});
+					Expr(depth - 1); Emit({PUSH_CONSTANT, 0x7FF, BITWISE_AND, MUL});
+				} break;
+				case 2: {
+					// nonzero divisor, non-negative dividend (INT_MIN / -1)
+					const int op = (Chance(50)? DIV: MOD);
+					Expr(depth - 1); Emit({PUSH_CONSTANT, 0x7FFFFFFF, BITWISE_AND});
+					Expr(depth - 1); Emit({PUSH_CONSTANT, 1, BITWISE_OR, op});
+				} break;
+				case 3: {
+					// division by zero, answered with 1000 and 0
+					Expr(depth - 1); Emit({PUSH_CONSTANT, 0, (Chance(50)? DIV: MOD)});
+				} break;
+				case 4: {
+					static constexpr int OPS[] = {BITWISE_AND, BITWISE_OR, BITWISE_XOR};
+					Expr(depth - 1); Expr(depth - 1); Emit({OPS[Rand(0, 2)]});
+				} break;
+				case 5: {
+					static constexpr int OPS[] = {BITWISE_NOT, LOGICAL_NOT};
+					Expr(depth - 1); Emit({OPS[Rand(0, 1)]});
+				} break;
+				case 6: {
+					static constexpr int OPS[] = {LOGICAL_AND, LOGICAL_OR, LOGICAL_XOR};
+					Expr(depth - 1); Expr(depth - 1); Emit({OPS[Rand(0, 2)]});
+				} break;
+				case 7: {
+					Expr(depth - 1); Expr(depth - 1); Emit({SET_CMP_OPS[Rand(0, 5)]});
+				} break;
+				case 8: {
+					Expr(depth - 1); Emit({PUSH_CONSTANT, Rand(-4, 4), SET_CMP_OPS[Rand(0, 5)]});
+				} break;
+				case 9: {
+					const int lo = Rand(-100, 100);
+					Emit({PUSH_CONSTANT, lo, PUSH_CONSTANT, lo + Rand(1, 100), RAND});
+				} break;
+				case 10: {
+					Emit({PUSH_CONSTANT, Rand(1, 20), GET_UNIT_VALUE});
+				} break;
+				default: {
+					Expr(depth - 1);
+				} break;
+			}
+		}
+
+		// mostly small values, so that comparisons often hit their boundaries
+		void CmpOperand(int depth) {
+			switch (Rand(0, 2)) {
+				case 0: { Emit({PUSH_CONSTANT, Rand(-4, 4)}); } break;
+				case 1: { Emit({PUSH_LOCAL_VAR, AnyLocal()}); } break;
+				default: { Expr(depth); } break;
+			}
+		}
+
+		// leaves the jne's target operand to be patched by the caller
+		size_t Cond(int depth) {
+			switch (Rand(0, 3)) {
+				case 0: {
+					// <pushc, setX, jne>
+					CmpOperand(depth);
+					Emit({PUSH_CONSTANT, Rand(-4, 4), SET_CMP_OPS[Rand(0, 5)]});
+				} break;
+				case 1: {
+					// <setX, jne>
+					CmpOperand(depth);
+					CmpOperand(depth);
+					Emit({SET_CMP_OPS[Rand(0, 5)]});
+				} break;
+				case 2: {
+					// both jump into the middle of a fused sequence, either onto
+					// its setX (two operands pushed) or its jne (one pushed)
+					const bool constCmp = Chance(50);
+					const bool ontoJne = Chance(50);
+
+					Expr(depth);
+					const size_t skipIdx = EmitJump(JUMP_NOT_EQUAL);
+
+					Expr(depth);
+					if (!ontoJne)
+						Expr(depth);
+					const size_t intoIdx = EmitJump(JUMP);
+
+					Patch(skipIdx, Here());
+					Expr(depth);
+
+					const int setAddr = Here() + (constCmp? 2: 0);
+					if (constCmp) {
+						Emit({PUSH_CONSTANT, Rand(-4, 4)});
+					} else {
+						Expr(depth);
+					}
+
+					Emit({SET_CMP_OPS[Rand(0, 5)]});
+					Patch(intoIdx, ontoJne? Here(): setAddr);
+				} break;
+				default: {
+					// plain jne
+					Expr(depth);
+				} break;
+			}
+
+			return EmitJump(JUMP_NOT_EQUAL);
+		}
+
+		void Statement(int depth) {
+			switch (Rand(0, 9)) {
+				case 0:
+				case 1: {
+					Expr(2);
+					Emit({POP_LOCAL_VAR, AnyLocal()});
+				} break;
+				case 2: {
+					// out of range statics are popped but not stored
+					Expr(2);
+					Emit({POP_STATIC, Rand(0, NUM_STATICS)});
+				} break;
+				case 3: {
+					if (depth <= 0)
+						break;
+
+					const size_t elseIdx = Cond(2);
+					Block(depth - 1);
+
+					if (Chance(50)) {
+						Patch(elseIdx, Here());
+						break;
+					}
+
+					const size_t endIdx = EmitJump(JUMP);
+					Patch(elseIdx, Here());
+					Block(depth - 1);
+					Patch(endIdx, Here());
+				} break;
+				case 4: {
+					if (depth <= 0 || loopDepth >= MAX_LOOP_DEPTH)
+						break;
+
+					// while (i < n) { ...; i = i + 1; }, a <pushc, setl, jne> head
+					const int counter = NUM_LOCALS + loopDepth++;
+					Emit({PUSH_CONSTANT, 0, POP_LOCAL_VAR, counter});
+
+					const int head = Here();
+					Emit({PUSH_LOCAL_VAR, counter, PUSH_CONSTANT, Rand(1, 4), SET_LESS});
+					const size_t endIdx = EmitJump(JUMP_NOT_EQUAL);
+
+					Block(depth - 1);
+					Emit({PUSH_LOCAL_VAR, counter, PUSH_CONSTANT, 1, ADD, POP_LOCAL_VAR, counter, JUMP, head});
+					Patch(endIdx, Here());
+
+					loopDepth--;
+				} break;
+				case 5: {
+					if (curScript + 1 >= NUM_SCRIPTS)
+						break;
+
+					const int callee = Rand(curScript + 1, NUM_SCRIPTS - 1);
+
+					for (int i = 0; i < numArgs[callee]; i++) {
+						Expr(2);
+					}
+
+					Emit({CALL, callee, numArgs[callee]});
+				} break;
+				case 6: {
+					if (depth <= 0 || !Chance(30))
+						break;
+
+					// early return from inside an if
+					const size_t endIdx = Cond(1);
+					Expr(2);
+					Emit({RETURN});
+					Patch(endIdx, Here());
+				} break;
+				case 7: {
+					Expr(1);
+					Expr(1);
+					Emit({(Chance(50)? MOVE: TURN), 0, Rand(0, 2)});
+				} break;
+				case 8: {
+					Expr(1);
+					Emit({SET_SIGNAL_MASK, HIDE, 0});
+				} break;
+				default: {
+					Expr(2);
+					Emit({POP_STACK});
+				} break;
+			}
+		}
+
+		void Block(int depth) {
+			for (int n = Rand(1, 4); n > 0; n--) {
+				Statement(depth);
+			}
+		}
+
+	private:
+		std::mt19937 rng;
+		std::vector<int> code;
+		std::array<int, NUM_SCRIPTS> numArgs = {};
+
+		int base = 0;
+		int curScript = 0;
+		int loopDepth = 0;
+	};
+
+
+	struct CobScript {
+		CobScript(std::vector<std::uint8_t>&& data): file(std::move(data)), cobFile(InitScriptNames(file), "test.cob") {
+			inst.cobFile = &cobFile;
+		}
+
+		// CCobFile maps the call-ins by name, normally set up by CUnitScriptFactory
+		static CCobImageFileHandler& InitScriptNames(CCobImageFileHandler& f) {
+			CCobUnitScriptNames::InitScriptNames();
+			return f;
+		}
+
+		CCobImageFileHandler file;
+		CCobFile cobFile;
+		CCobInstance inst;
+	};
+
+	struct ThreadResult {
+		int retCode;
+		std::vector<int> dataStack;
+		std::vector<int> staticVars;
+	};
+
+
+	ThreadResult RunTick(CobScript& s, int functionId, const std::vector<int>& args, const std::vector<int>& staticVars, unsigned int rngSeed) {
+		std::array<int, 1 + MAX_COB_ARGS> startArgs = {};
+
+		startArgs[0] = args.size();
+		std::copy(args.begin(), args.end(), startArgs.begin() + 1);
+
+		s.inst.staticVars = staticVars;
+		gsRNG.Seed(rngSeed);
+
+		CCobThread t(&s.inst);
+		t.Start(functionId, 0, startArgs, false);
+
+		while (t.Tick());
+
+		ThreadResult r;
+		r.retCode = t.GetRetCode();
+		r.staticVars = s.inst.staticVars;
+
+		// CheckStack clamps to the stack size
+		for (int i = 0, n = t.CheckStack(1 << 20, false); i < n; i++) {
+			r.dataStack.push_back(t.GetStackVal(i));
+		}
+
+		CHECK(t.GetState() == CCobThread::Dead);
+		return r;
+	}
+
+	ThreadResult RunRef(CobScript& s, int functionId, const std::vector<int>& args, const std::vector<int>& staticVars, unsigned int rngSeed, std::vector<int>* trace = nullptr) {
+		ThreadResult r;
+		r.staticVars = staticVars;
+		gsRNG.Seed(rngSeed);
+
+		CRefThread t(s.cobFile, r.staticVars);
+		t.Start(functionId, args);
+
+		REQUIRE(t.Run());
+
+		r.retCode = t.retCode;
+		r.dataStack = t.dataStack;
+
+		if (trace != nullptr)
+			trace->insert(trace->end(), t.trace.begin(), t.trace.end());
+
+		return r;
+	}
+
+
+	bool IsFused(int op) {
+		return (op >= CobOp::JumpUnlessLess && op <= CobOp::JumpUnlessNotEqualConst);
+	}
+
+	// maps the pcs the reference executed onto the instructions Tick dispatches:
+	// words inside a fused sequence are only visited by the reference when it
+	// runs straight through from the sequence's first word
+	void CountFusedOps(const CCobFile& cobFile, const std::vector<int>& trace, std::vector<int>& counts) {
+		int fusedPC = -1;
+		int prevPC = -1;
+
+		for (const int pc: trace) {
+			if (fusedPC >= 0 && pc > prevPC && pc <= prevPC + 2 && pc < cobFile.instructions[fusedPC].next) {
+				prevPC = pc;
+				continue;
+			}
+
+			const int op = cobFile.instructions[pc].op;
+
+			fusedPC = IsFused(op)? pc: -1;
+			prevPC = pc;
+
+			if (fusedPC >= 0)
+				counts[op - CobOp::JumpUnlessLess] += 1;
+		}
+	}
+}
+
+
+TEST_CASE("CobThreadScript")
+{
+	// static-var total;
+	// Sum(n) { var i, s; i = 0; s = 0; while (i < n) { s = s + i; i = i + 1; } total = s; return (s); }
+	// Div(a, b) { return (a / b); }
+	// Mod(a, b) { return (a % b); }
+	// Main() { call-script Sum(10); return (total * 2); }
+	CCobImage image;
+
+	image.SetNumStaticVars(1);
+	image.AddPiece("base");
+
+	const int sum = image.GetCodeOffset();
+	image.AddScript("Sum", {
+		CREATE_LOCAL_VAR, CREATE_LOCAL_VAR, CREATE_LOCAL_VAR,
+		PUSH_CONSTANT, 0, POP_LOCAL_VAR, 1,
+		PUSH_CONSTANT, 0, POP_LOCAL_VAR, 2,
+		PUSH_LOCAL_VAR, 1, PUSH_LOCAL_VAR, 0, SET_LESS, JUMP_NOT_EQUAL, sum + 34,
+		PUSH_LOCAL_VAR, 2, PUSH_LOCAL_VAR, 1, ADD, POP_LOCAL_VAR, 2,
+		PUSH_LOCAL_VAR, 1, PUSH_CONSTANT, 1, ADD, POP_LOCAL_VAR, 1,
+		JUMP, sum + 11,
+		PUSH_LOCAL_VAR, 2, POP_STATIC, 0,
+		PUSH_LOCAL_VAR, 2, RETURN,
+	});
+	image.AddScript("Div", {
+		CREATE_LOCAL_VAR, CREATE_LOCAL_VAR,
+		PUSH_LOCAL_VAR, 0, PUSH_LOCAL_VAR, 1, DIV, RETURN,
+	});
+	image.AddScript("Mod", {
+		CREATE_LOCAL_VAR, CREATE_LOCAL_VAR,
+		PUSH_LOCAL_VAR, 0, PUSH_LOCAL_VAR, 1, MOD, RETURN,
+	});
+	image.AddScript("Main", {
+		PUSH_CONSTANT, 10, CALL, 0, 1,
+		PUSH_STATIC, 0, PUSH_CONSTANT, 2, MUL, RETURN,
+	});
+
+	CobScript s(image.Build());
+
+	REQUIRE(s.cobFile.scriptNames.size() == 4);
+	CHECK(s.cobFile.instructions[sum + 15].op == CobOp::JumpUnlessLess);
+
+	const auto Run = [&](int functionId, const std::vector<int>& args) {
+		const ThreadResult ref = RunRef(s, functionId, args, {0}, 1);
+		const ThreadResult res = RunTick(s, functionId, args, {0}, 1);
+
+		CHECK(res.retCode == ref.retCode);
+		CHECK(res.dataStack == ref.dataStack);
+		CHECK(res.staticVars == ref.staticVars);
+		return res;
+	};
+
+	CHECK(Run(0, {10}).retCode == 45);
+	CHECK(Run(0, {10}).staticVars[0] == 45);
+	CHECK(Run(0, {0}).retCode == 0);
+	CHECK(Run(1, {7, 2}).retCode == 3);
+	CHECK(Run(1, {-7, 2}).retCode == -3);
+	CHECK(Run(1, {7, 0}).retCode == 1000);
+	CHECK(Run(2, {7, 3}).retCode == 1);
+	CHECK(Run(2, {7, 0}).retCode == 0);
+	CHECK(Run(3, {}).retCode == 90);
+}
+
+TEST_CASE("CobThreadEquivalence")
+{
+	static constexpr int NUM_PROGRAMS = 300;
+
+	std::vector<int> fusedCounts(CobOp::JumpUnlessNotEqualConst - CobOp::JumpUnlessLess + 1, 0);
+	std::mt19937 argRNG(1234);
+
+	for (int p = 0; p < NUM_PROGRAMS; p++) {
+		CScriptGenerator gen(p);
+		CobScript s(gen.Generate());
+
+		REQUIRE(s.cobFile.scriptNames.size() == CScriptGenerator::NUM_SCRIPTS);
+
+		for (int f = 0; f < CScriptGenerator::NUM_SCRIPTS; f++) {
+			std::vector<int> args(gen.GetNumArgs(f));
+			std::vector<int> statics(CScriptGenerator::NUM_STATICS);
+			std::vector<int> trace;
+
+			for (int& a: args) {
+				a = std::uniform_int_distribution<int>(-10, 10)(argRNG);
+			}
+			for (int& v: statics) {
+				v = std::uniform_int_distribution<int>(-10, 10)(argRNG);
+			}
+
+			const ThreadResult ref = RunRef(s, f, args, statics, p * 31 + f, &trace);
+			const ThreadResult res = RunTick(s, f, args, statics, p * 31 + f);
+
+			INFO("program " << p << " script " << f);
+			CHECK(res.retCode == ref.retCode);
+			CHECK(res.dataStack == ref.dataStack);
+			CHECK(res.staticVars == ref.staticVars);
+
+			CountFusedOps(s.cobFile, trace, fusedCounts);
+		}
+	}
+
+	// every fused instruction has to have been dispatched at least once
+	for (size_t i = 0; i < fusedCounts.size(); i++) {
+		INFO("fused op " << (CobOp::JumpUnlessLess + i));
+		CHECK(fusedCounts[i] > 0);
+	}
+}
@@ -0,0 +1,128 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/CommandAI/CommandRing.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+static Command MakeCommand(unsigned int tag, unsigned int numParams)
+{
+	Command c(CMD_MOVE);
+
+	for (unsigned int i = 0; i < numParams; i++) {
+		c.PushParam(tag * 100.0f + i);
+	}
+
+	c.SetTag(tag);
+	return c;
+}
+
+static bool SameAs(const CommandRing& ring, const std::deque<unsigned int>& tags)
+{
+	if (ring.size() != tags.size())
+		return false;
+
+	// exercise both indexing and iteration
+	for (size_t i = 0; i < tags.size(); i++) {
+		if (ring[i].GetTag() != tags[i])
+			return false;
+	}
+
+	return (std::equal(ring.begin(), ring.end(), tags.begin(), [](const Command& c, unsigned int t) { return (c.GetTag() == t); }));
+}
+
+TEST_CASE("CommandRing")
+{
+	std::mt19937 rng(42);
+
+	CommandRing ring;
+	std::deque<unsigned int> tags;
+
+	unsigned int nextTag = 1;
+
+	for (int n = 0; n < 20000; n++) {
+		// params beyond MAX_COMMAND_PARAMS go through cmdParamsPool
+		const unsigned int numParams = rng() % (MAX_COMMAND_PARAMS + 4);
+		const size_t pos = tags.empty()? 0: (rng() % (tags.size() + 1));
+
+		switch (rng() % ((tags.size() < 40)? 6: 8)) {
+			case 0: { ring.push_back(MakeCommand(nextTag, numParams)); tags.push_back(nextTag++); } break;
+			case 1: { ring.push_front(MakeCommand(nextTag, numParams)); tags.push_front(nextTag++); } break;
+			case 2: {
+				const auto it = ring.insert(ring.begin() + pos, MakeCommand(nextTag, numParams));
+				CHECK(it->GetTag() == nextTag);
+				tags.insert(tags.begin() + pos, nextTag++);
+			} break;
+			case 3: {
+				if (tags.empty())
+					break;
+
+				const size_t end = std::min(tags.size(), pos + (rng() % 4));
+				const size_t beg = std::min(pos, end);
+
+				const auto it = ring.erase(ring.begin() + beg, ring.begin() + end);
+				CHECK(size_t(it - ring.begin()) == beg);
+				tags.erase(tags.begin() + beg, tags.begin() + end);
+			} break;
+			case 4:
+			case 6: { if (!tags.empty()) { ring.pop_front(); tags.pop_front(); } } break;
+			case 5:
+			case 7: { if (!tags.empty()) { ring.pop_back(); tags.pop_back(); } } break;
+		}
+
+		REQUIRE(SameAs(ring, tags));
+	}
+
+	// params survive the pointer shuffling
+	for (const Command& c: ring) {
+		for (unsigned int i = 0; i < c.GetNumParams(); i++) {
+			CHECK(c.GetParam(i) == c.GetTag() * 100.0f + i);
+		}
+	}
+
+	// remove_if + erase moves commands through iterator assignment
+	ring.erase(std::remove_if(ring.begin(), ring.end(), [](const Command& c) { return ((c.GetTag() & 1) != 0); }), ring.end());
+	tags.erase(std::remove_if(tags.begin(), tags.end(), [](unsigned int t) { return ((t & 1) != 0); }), tags.end());
+	CHECK(SameAs(ring, tags));
+
+	ring.clear();
+	CHECK(ring.empty());
+}
+
+TEST_CASE("CommandRingReferenceStability")
+{
+	CommandRing ring;
+
+	ring.push_back(MakeCommand(1, 3));
+
+	const Command& first = ring.front();
+
+	// grow past the inline slots and the inline pointer ring
+	for (unsigned int i = 2; i < 64; i++) {
+		if ((i & 1) != 0) {
+			ring.push_front(MakeCommand(i, 0));
+		} else {
+			ring.insert(ring.begin() + (ring.size() / 2), MakeCommand(i, 0));
+		}
+	}
+
+	CHECK(ring.size() == 63);
+	CHECK(first.GetTag() == 1);
+	CHECK(first.GetParam(2) == 102.0f);
+
+	const size_t numFreeSlots = cmdSlotPool.NumFreeSlots();
+
+	// pool slots are recycled rather than released
+	ring.clear();
+	CHECK(cmdSlotPool.NumFreeSlots() == numFreeSlots + 63 - CommandRing::NUM_INLINE_SLOTS);
+
+	for (unsigned int i = 0; i < 63; i++) {
+		ring.push_back(MakeCommand(i, 0));
+	}
+
+	CHECK(cmdSlotPool.NumFreeSlots() == numFreeSlots);
+}
@@ -0,0 +1,59 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/LoadSave/DemoKeyframes.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+TEST_CASE("DemoKeyframesFind")
+{
+	CDemoKeyframeIndex index;
+
+	// unordered, duplicate frame and garbage lines
+	index.Parse("1800 Saves/a_1800.ssf\n900 Saves/a_900.ssf\nnonsense\n-5 Saves/x.ssf\n2700\n1800 Saves/b_1800.ssf\n");
+
+	REQUIRE(index.GetKeyframes().size() == 2);
+
+	CHECK(index.FindKeyframe(0) == nullptr);
+	CHECK(index.FindKeyframe(899) == nullptr);
+	CHECK(index.FindKeyframe(900)->saveFile == "Saves/a_900.ssf");
+	CHECK(index.FindKeyframe(1799)->frameNum == 900);
+	CHECK(index.FindKeyframe(1800)->saveFile == "Saves/b_1800.ssf");
+	CHECK(index.FindKeyframe(1 << 30)->frameNum == 1800);
+
+	// frame numbers that do not fit an int
+	index.Parse("99999999999 Saves/x.ssf\n2147483648 Saves/y.ssf\n2147483647 Saves/z.ssf\n");
+
+	REQUIRE(index.GetKeyframes().size() == 1);
+	CHECK(index.FindKeyframe(2147483647)->saveFile == "Saves/z.ssf");
+}
+
+TEST_CASE("DemoKeyframesAppend")
+{
+	const std::string indexPath = CDemoKeyframeIndex::GetIndexFileName("testDemoKeyframes.sdfz");
+	std::remove(indexPath.c_str());
+
+	CDemoKeyframeIndex index;
+	CHECK(index.Append(indexPath, 300, "Saves/k_300.ssf"));
+	CHECK(index.Append(indexPath, 600, "Saves/k_600.ssf"));
+	CHECK_FALSE(index.Append(indexPath, 900, "Saves/bad\nname.ssf"));
+
+	std::ifstream file(indexPath, std::ios::in | std::ios::binary);
+	std::stringstream text;
+	text << file.rdbuf();
+
+	CDemoKeyframeIndex loaded;
+	loaded.Parse(text.str());
+
+	REQUIRE(loaded.GetKeyframes().size() == 2);
+	CHECK(loaded.FindKeyframe(599)->saveFile == "Saves/k_300.ssf");
+	CHECK(loaded.FindKeyframe(600)->saveFile == "Saves/k_600.ssf");
+
+	file.close();
+	std::remove(indexPath.c_str());
+}
@@ -0,0 +1,242 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/LoadSave/Demo.h"
+#include "System/LoadSave/DemoReader.h"
+#include "System/LoadSave/DemoStreamWriter.h"
+#include "Game/GameVersion.h"
+#include "Net/Protocol/NetMessageTypes.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Net/RawPacket.h"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+static const char* TEST_FILE = "testDemoReader.sdfz";
+
+static constexpr int NUM_FRAMES = 20000;
+
+
+struct RecordedPacket {
+	int frameNum;
+	int packetNum;
+	std::uint8_t msgType;
+};
+
+/// records chunks the same way CDemoRecorder::SaveToDemo does
+class CTestDemoRecorder : public CDemo
+{
+public:
+	CTestDemoRecorder() {
+		memcpy(fileHeader.magic, DEMOFILE_MAGIC, sizeof(DEMOFILE_MAGIC));
+		strncpy(fileHeader.versionString, SpringVersion::GetSync().c_str(), sizeof(fileHeader.versionString) - 1);
+
+		fileHeader.version = DEMOFILE_VERSION;
+		fileHeader.headerSize = sizeof(DemoFileHeader);
+		fileHeader.scriptSize = setupScript.size();
+		fileHeader.playerStatElemSize = sizeof(PlayerStatistics);
+		fileHeader.teamStatElemSize = sizeof(TeamStatistics);
+
+		writer = std::make_unique<CDemoStreamWriter>(TEST_FILE, &fileHeader, sizeof(fileHeader), 1);
+		writer->Write(setupScript.data(), setupScript.size());
+	}
+
+	void SaveToDemo(const unsigned char* buf, unsigned length, float modGameTime) {
+		const DemoStreamChunkHeader chunkHeader = {modGameTime, length};
+
+		if (length > 0)
+			writer->MarkChunk(modGameTime, demoFrameNum, buf[0]);
+
+		writer->Write(&chunkHeader, sizeof(chunkHeader));
+		writer->Write(buf, length);
+
+		UpdateFrameNum(buf, length);
+
+		fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
+	}
+
+	void Close() {
+		// stand-in for the stats CDemoReader::LoadStats expects after the stream
+		const std::vector<char> trailer(64, char(NETMSG_NEWFRAME));
+
+		writer->Write(trailer.data(), trailer.size());
+		writer->SetHeader(&fileHeader, sizeof(fileHeader));
+		writer->Close();
+	}
+
+	int GetFrameNum() const { return demoFrameNum; }
+
+private:
+	std::unique_ptr<CDemoStreamWriter> writer;
+	std::string setupScript = std::string(1000, 's');
+};
+
+
+// frames with a few keyframes, sync responses large enough to fill
+// several blocks, chat messages in only some of the blocks and the
+// occasional empty chunk
+static std::vector<RecordedPacket> RecordDemo()
+{
+	std::vector<RecordedPacket> packets;
+	CTestDemoRecorder recorder;
+
+	for (int packetNum = 0; recorder.GetFrameNum() < (NUM_FRAMES - 1); packetNum++) {
+		unsigned char buf[48];
+		unsigned length = 1;
+
+		memset(buf, packetNum, sizeof(buf));
+
+		if ((packetNum % 3) == 0) {
+			const int frameNum = recorder.GetFrameNum() + 1;
+
+			buf[0] = NETMSG_NEWFRAME;
+
+			if ((frameNum % 1024) == 0) {
+				buf[0] = NETMSG_KEYFRAME;
+				memcpy(buf + 1, &frameNum, sizeof(frameNum));
+				length = 1 + sizeof(frameNum);
+			}
+		} else if ((packetNum % 9973) == 0) {
+			buf[0] = NETMSG_CHAT;
+			memcpy(buf + 1, &packetNum, sizeof(packetNum));
+			length = sizeof(buf);
+		} else if ((packetNum % 1001) == 0) {
+			length = 0;
+		} else {
+			buf[0] = NETMSG_SYNCRESPONSE;
+			length = sizeof(buf);
+		}
+
+		recorder.SaveToDemo(buf, length, packetNum * 0.01f);
+
+		if (length > 0)
+			packets.push_back({recorder.GetFrameNum(), packetNum, buf[0]});
+	}
+
+	recorder.Close();
+	return packets;
+}
+
+static DemoMsgTypeMask MakeMask(std::initializer_list<std::uint8_t> msgTypes)
+{
+	DemoMsgTypeMask mask;
+	mask.Clear();
+
+	for (const std::uint8_t msgType: msgTypes) {
+		mask.Add(msgType);
+	}
+
+	return mask;
+}
+
+// first chat message sent at or after <frameNum>
+static const RecordedPacket* FindChat(const std::vector<RecordedPacket>& packets, int frameNum)
+{
+	for (const RecordedPacket& p: packets) {
+		if (p.msgType == NETMSG_CHAT && p.frameNum >= frameNum)
+			return &p;
+	}
+
+	return nullptr;
+}
+
+static int GetChatNum(const netcode::RawPacket* packet)
+{
+	int packetNum = -1;
+	memcpy(&packetNum, packet->data + 1, sizeof(packetNum));
+	return packetNum;
+}
+
+
+TEST_CASE("DemoReaderGetData")
+{
+	const std::vector<RecordedPacket> packets = RecordDemo();
+
+	CDemoReader reader(TEST_FILE, 0.0f);
+	std::vector<std::uint8_t> recordedTypes;
+	std::vector<std::uint8_t> msgTypes;
+
+	for (const RecordedPacket& p: packets) {
+		recordedTypes.push_back(p.msgType);
+	}
+
+	// stream size includes empty chunks, nothing after the stream is read
+	while (!reader.ReachedEnd()) {
+		std::unique_ptr<netcode::RawPacket> packet(reader.GetData(1e30f));
+
+		if (packet != nullptr && packet->length > 0)
+			msgTypes.push_back(packet->data[0]);
+	}
+
+	CHECK(msgTypes == recordedTypes);
+	CHECK(reader.GetFrameNum() == (NUM_FRAMES - 1));
+	std::remove(TEST_FILE);
+}
+
+TEST_CASE("DemoReaderGetNextPacket")
+{
+	const std::vector<RecordedPacket> packets = RecordDemo();
+
+	for (const DemoMsgTypeMask& mask: {MakeMask({NETMSG_CHAT}), MakeMask({NETMSG_CHAT, NETMSG_KEYFRAME}), MakeMask({NETMSG_AI_CREATED})}) {
+		CDemoReader reader(TEST_FILE, 0.0f);
+
+		for (const RecordedPacket& p: packets) {
+			if (!mask.Contains(p.msgType))
+				continue;
+
+			std::unique_ptr<netcode::RawPacket> packet(reader.GetNextPacket(mask));
+
+			REQUIRE(packet != nullptr);
+			REQUIRE(packet->data[0] == p.msgType);
+			CHECK(reader.GetFrameNum() == p.frameNum);
+
+			if (p.msgType == NETMSG_CHAT)
+				CHECK(GetChatNum(packet.get()) == p.packetNum);
+		}
+
+		CHECK(reader.GetNextPacket(mask) == nullptr);
+		CHECK(reader.ReachedEnd());
+	}
+
+	std::remove(TEST_FILE);
+}
+
+TEST_CASE("DemoReaderSeekToFrame")
+{
+	const std::vector<RecordedPacket> packets = RecordDemo();
+	const DemoMsgTypeMask chatMask = MakeMask({NETMSG_CHAT});
+
+	CDemoReader reader(TEST_FILE, 0.0f);
+
+	// forward, within the current block, backward and back to the start
+	for (const int frameNum: {5000, 5001, 5016, 12345, 100, 7000, 0, NUM_FRAMES - 1}) {
+		REQUIRE(reader.SeekToFrame(frameNum));
+		CHECK(reader.GetFrameNum() == frameNum);
+
+		const RecordedPacket* chat = FindChat(packets, frameNum);
+		std::unique_ptr<netcode::RawPacket> packet(reader.GetNextPacket(chatMask));
+
+		if (chat == nullptr) {
+			CHECK(packet == nullptr);
+			continue;
+		}
+
+		REQUIRE(packet != nullptr);
+		CHECK(GetChatNum(packet.get()) == chat->packetNum);
+		CHECK(reader.GetFrameNum() == chat->frameNum);
+	}
+
+	// past the end
+	CHECK_FALSE(reader.SeekToFrame(NUM_FRAMES + 100));
+	CHECK(reader.ReachedEnd());
+	CHECK(reader.GetFrameNum() == (NUM_FRAMES - 1));
+
+	std::remove(TEST_FILE);
+}
@@ -0,0 +1,183 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/LoadSave/DemoBlockReader.h"
+#include "System/LoadSave/DemoStreamWriter.h"
+#include "System/LoadSave/SaveGameBlocks.h"
+#include "System/Misc/SpringTime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+InitSpringTime ist;
+
+static const char* TEST_FILE = "testDemoStreamWriter.sdfz";
+
+static std::vector<std::uint8_t> ReadDemoFile()
+{
+	std::ifstream file(TEST_FILE, std::ios::in | std::ios::binary);
+	std::vector<std::uint8_t> compressed((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::vector<std::uint8_t> data;
+
+	if (!SaveGameBlocks::Read(compressed.data(), compressed.size(), data))
+		data.clear();
+
+	return data;
+}
+
+static std::string MakeDemoData(size_t size)
+{
+	std::string data(size, 0);
+
+	for (size_t i = 0; i < size; i++) {
+		data[i] = char((i * 7) ^ (i >> 9));
+	}
+
+	return data;
+}
+
+
+TEST_CASE("DemoStreamWriter")
+{
+	const std::string header0(64, 'h');
+	const std::string header1(64, 'H');
+	const std::string data = MakeDemoData(CDemoStreamWriter::BLOCK_SIZE * 2 + 12345);
+
+	{
+		CDemoStreamWriter writer(TEST_FILE, header0.data(), header0.size(), 9);
+		REQUIRE(writer.IsOpen());
+
+		// full blocks are written in the background while recording goes on
+		writer.Write(data.data(), CDemoStreamWriter::BLOCK_SIZE * 2);
+
+		std::vector<std::uint8_t> partial;
+
+		for (int i = 0; i < 500 && partial.size() < (header0.size() + CDemoStreamWriter::BLOCK_SIZE * 2); i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			partial = ReadDemoFile();
+		}
+
+		REQUIRE(partial.size() == (header0.size() + CDemoStreamWriter::BLOCK_SIZE * 2));
+		CHECK(std::string(partial.begin(), partial.begin() + header0.size()) == header0);
+		CHECK(std::string(partial.begin() + header0.size(), partial.end()) == data.substr(0, CDemoStreamWriter::BLOCK_SIZE * 2));
+
+		// small writes, as the recorder does per packet
+		for (size_t pos = CDemoStreamWriter::BLOCK_SIZE * 2; pos < data.size(); pos += 100) {
+			writer.Write(data.data() + pos, std::min<size_t>(100, data.size() - pos));
+		}
+
+		CHECK(writer.GetDataSize() == data.size());
+
+		writer.SetHeader(header1.data(), header1.size());
+
+		// the new header never lands before the data it describes
+		for (int i = 0; i < 500 && (partial.size() < header1.size() || !std::equal(header1.begin(), header1.end(), partial.begin())); i++) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			partial = ReadDemoFile();
+		}
+
+		REQUIRE(partial.size() == (header1.size() + data.size()));
+		CHECK(std::string(partial.begin(), partial.begin() + header1.size()) == header1);
+
+		CHECK(writer.Close());
+		CHECK_FALSE(writer.IsOpen());
+	}
+
+	const std::vector<std::uint8_t> complete = ReadDemoFile();
+
+	REQUIRE(complete.size() == (header1.size() + data.size()));
+	CHECK(std::string(complete.begin(), complete.begin() + header1.size()) == header1);
+	CHECK(std::string(complete.begin() + header1.size(), complete.end()) == data);
+
+	std::remove(TEST_FILE);
+}
+
+TEST_CASE("DemoBlockReader")
+{
+	constexpr size_t CHUNK_SIZE = 100;
+	constexpr size_t NUM_CHUNKS = (CDemoStreamWriter::BLOCK_SIZE * 5) / CHUNK_SIZE;
+	constexpr std::uint8_t RARE_MSG = 7;
+	constexpr std::uint8_t FRAME_MSG = 2;
+
+	const std::string header(64, 'h');
+	std::string data = MakeDemoData(NUM_CHUNKS * CHUNK_SIZE);
+
+	{
+		CDemoStreamWriter writer(TEST_FILE, header.data(), header.size(), 5);
+		REQUIRE(writer.IsOpen());
+
+		// one chunk per frame, every 1000th one of a rare type
+		for (size_t i = 0; i < NUM_CHUNKS; i++) {
+			data[i * CHUNK_SIZE] = ((i % 1000) == 0)? RARE_MSG: FRAME_MSG;
+
+			writer.MarkChunk(i * 0.1f, i, data[i * CHUNK_SIZE]);
+			writer.Write(data.data() + i * CHUNK_SIZE, CHUNK_SIZE);
+		}
+
+		CHECK(writer.Close());
+	}
+
+	CDemoBlockReader reader;
+	REQUIRE(reader.Open(TEST_FILE));
+	REQUIRE(reader.HasIndex());
+	CHECK(reader.GetSize() == (header.size() + data.size()));
+
+	// the index matches the chunks without decompressing anything
+	for (const CDemoBlockReader::Block& block: reader.GetBlocks()) {
+		if (block.dataOffset == 0)
+			continue;
+
+		const size_t firstChunk = (block.dataOffset - header.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		const size_t endChunk = (block.dataOffset + block.dataSize - header.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+		REQUIRE(block.index.firstChunkOffset != DemoBlockIndex::NO_CHUNK);
+		CHECK((block.dataOffset + block.index.firstChunkOffset) == (header.size() + firstChunk * CHUNK_SIZE));
+		CHECK(block.index.firstChunkFrame == int(firstChunk));
+		CHECK(block.index.msgTypes.Contains(FRAME_MSG));
+		CHECK(block.index.msgTypes.Contains(RARE_MSG) == ((firstChunk + 999) / 1000 < (endChunk + 999) / 1000));
+	}
+
+	// random access
+	for (size_t pos: {size_t(0), size_t(63), CDemoStreamWriter::BLOCK_SIZE * 3 - 50, data.size() - 10, size_t(1000), data.size() + 64}) {
+		std::string buf(100, 0);
+
+		REQUIRE(reader.Seek(pos));
+		buf.resize(reader.Read(&buf[0], buf.size()));
+
+		const std::string file = header + data;
+		CHECK(buf == file.substr(pos, 100));
+		CHECK(reader.GetPos() == (pos + buf.size()));
+	}
+
+	CHECK_FALSE(reader.Seek(reader.GetSize() + 1));
+	reader.Close();
+
+	{
+		// a crash while writing the last block leaves everything before it readable
+		std::vector<std::uint8_t> truncated;
+
+		{
+			std::ifstream file(TEST_FILE, std::ios::in | std::ios::binary);
+			truncated.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+		{
+			std::ofstream file(TEST_FILE, std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(truncated.data()), truncated.size() - 10);
+		}
+
+		REQUIRE(reader.Open(TEST_FILE));
+		CHECK(reader.GetSize() == (header.size() + CDemoStreamWriter::BLOCK_SIZE * 4));
+		reader.Close();
+	}
+
+	std::remove(TEST_FILE);
+}
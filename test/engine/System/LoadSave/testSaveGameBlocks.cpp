@@ -0,0 +1,127 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/LoadSave/SaveGameBlocks.h"
+
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+static std::string MakeSaveData(size_t size)
+{
+	std::mt19937 rng(size);
+	std::string data(size, 0);
+
+	// compressible, but not trivially so
+	for (size_t i = 0; i < size; i++) {
+		data[i] = 'a' + (rng() % 8);
+	}
+
+	return data;
+}
+
+static std::string CompressSaveData(const std::string& data, int numThreads)
+{
+	CSaveGameBlockBuffer buffer;
+	std::ostream os(&buffer);
+
+	// mix of small and large writes, as the savegame code does
+	for (size_t pos = 0, n = 1; pos < data.size(); pos += n, n = (n * 7) % 300007 + 1) {
+		n = std::min(n, data.size() - pos);
+		os.write(data.data() + pos, n);
+		CHECK(size_t(os.tellp()) == (pos + n));
+	}
+
+	std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+	CHECK(SaveGameBlocks::Write(ss, buffer.ReleaseBlocks(), 5, numThreads));
+	CHECK(os.tellp() == 0);
+
+	return ss.str();
+}
+
+// what gzread does with concatenated members
+static std::string GUnzip(const std::string& compressed)
+{
+	std::string data;
+	std::vector<char> buf(65536);
+
+	z_stream zs;
+	std::memset(&zs, 0, sizeof(zs));
+	inflateInit2(&zs, 15 + 16);
+
+	zs.next_in = (Bytef*) compressed.data();
+	zs.avail_in = compressed.size();
+
+	while (zs.avail_in > 0) {
+		zs.next_out = (Bytef*) buf.data();
+		zs.avail_out = buf.size();
+
+		const int ret = inflate(&zs, Z_NO_FLUSH);
+
+		if (ret != Z_OK && ret != Z_STREAM_END)
+			break;
+
+		data.append(buf.data(), buf.size() - zs.avail_out);
+
+		if (ret == Z_STREAM_END)
+			inflateReset(&zs);
+	}
+
+	inflateEnd(&zs);
+	return data;
+}
+
+
+TEST_CASE("SaveGameBlocks")
+{
+	for (const size_t size: {size_t(1), CSaveGameBlockBuffer::BLOCK_SIZE, CSaveGameBlockBuffer::BLOCK_SIZE * 3 + 12345}) {
+		const std::string data = MakeSaveData(size);
+		const std::string compressed = CompressSaveData(data, 3);
+
+		// thread count must not influence the output
+		CHECK(compressed == CompressSaveData(data, 1));
+
+		std::vector<std::uint8_t> uncompressed;
+
+		CHECK(SaveGameBlocks::Read((const std::uint8_t*) compressed.data(), compressed.size(), uncompressed));
+		CHECK(std::string(uncompressed.begin(), uncompressed.end()) == data);
+
+		// still readable as plain gzip
+		CHECK(GUnzip(compressed) == data);
+
+		// corruption is detected instead of returning garbage
+		std::string corrupted = compressed;
+		corrupted[corrupted.size() - 8] ^= 1;
+		CHECK_FALSE(SaveGameBlocks::Read((const std::uint8_t*) corrupted.data(), corrupted.size(), uncompressed));
+	}
+}
+
+TEST_CASE("SaveGameBlocksLegacy")
+{
+	const std::string data = MakeSaveData(4096);
+
+	std::vector<std::uint8_t> compressed(compressBound(data.size()) + 32);
+	std::vector<std::uint8_t> uncompressed;
+
+	// regular gzip stream, as written by older engine versions
+	z_stream zs;
+	std::memset(&zs, 0, sizeof(zs));
+	deflateInit2(&zs, 5, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+
+	zs.next_in = (Bytef*) data.data();
+	zs.avail_in = data.size();
+	zs.next_out = compressed.data();
+	zs.avail_out = compressed.size();
+
+	REQUIRE(deflate(&zs, Z_FINISH) == Z_STREAM_END);
+	compressed.resize(zs.total_out);
+	deflateEnd(&zs);
+
+	CHECK_FALSE(SaveGameBlocks::Read(compressed.data(), compressed.size(), uncompressed));
+	CHECK_FALSE(SaveGameBlocks::Read(compressed.data(), 0, uncompressed));
+}
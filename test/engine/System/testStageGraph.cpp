@@ -0,0 +1,109 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Game/SimFrameStages.h"
+#include "System/Threading/StageGraph.h"
+#include "System/Threading/ThreadPool.h"
+#include "System/Platform/Threading.h"
+#include "System/Misc/SpringTime.h"
+
+#include <atomic>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+struct do_once {
+	do_once() { Threading::DetectCores(); }
+};
+
+InitSpringTime ist;
+do_once doonce;
+
+
+enum {
+	RES_A = 1 << 0,
+	RES_B = 1 << 1,
+	RES_C = 1 << 2,
+};
+
+TEST_CASE("StageGraphWaves")
+{
+	CStageGraph graph;
+
+	graph.AddStage("s0", RES_A, RES_A, []() {});
+	graph.AddStage("s1", RES_B, RES_B, []() {}); // independent of s0
+	graph.AddStage("s2", RES_A | RES_B, RES_C, []() {}); // reads what s0 and s1 write
+	graph.AddStage("s3", RES_A, 0, []() {}); // read-only, may share with s2
+	graph.AddStage("s4", 0, RES_A, []() {}); // must wait for s3
+
+	CHECK(graph.GetNumWaves() == 3);
+	CHECK(graph.GetWave(0) == std::vector<size_t>{0, 1});
+	CHECK(graph.GetWave(1) == std::vector<size_t>{2, 3});
+	CHECK(graph.GetWave(2) == std::vector<size_t>{4});
+
+	graph.AddStage("s5", CStageGraph::RESOURCE_ALL, CStageGraph::RESOURCE_ALL, []() {});
+	graph.AddStage("s6", RES_B, 0, []() {});
+
+	CHECK(graph.GetNumWaves() == 5);
+	CHECK(graph.GetStage(5).wave == 3);
+	CHECK(graph.GetStage(6).wave == 4);
+}
+
+TEST_CASE("StageGraphOrder")
+{
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	CStageGraph graph;
+	std::vector<int> order;
+	std::atomic<int> numIndependent = {0};
+
+	// each stage appends to <order> (RES_A), interleaved with independent stages
+	for (int i = 0; i < 16; i++) {
+		graph.AddStage("ordered", RES_A, RES_A, [&order, i]() { order.push_back(i); }, CStageGraph::STAGE_FLAG_MAIN_THREAD * (i & 1));
+		graph.AddStage("independent", RES_B, 0, [&numIndependent]() { numIndependent += 1; });
+	}
+
+	for (int n = 0; n < 100; n++) {
+		for (const bool concurrent: {false, true}) {
+			order.clear();
+			numIndependent = 0;
+
+			graph.Run(concurrent);
+
+			CHECK(numIndependent == 16);
+			REQUIRE(order.size() == 16);
+
+			for (int i = 0; i < 16; i++) {
+				CHECK(order[i] == i);
+			}
+		}
+	}
+
+	ThreadPool::SetThreadCount(0);
+	CHECK(ThreadPool::GetNumThreads() == 1);
+}
+
+TEST_CASE("SimFrameStages")
+{
+	CStageGraph graph;
+
+	for (const SimStageDef& def: SIM_STAGE_DEFS) {
+		graph.AddStage(def.name, def.reads, def.writes, []() {}, def.flags);
+	}
+
+	REQUIRE(graph.GetNumStages() == SIM_STAGE_COUNT);
+	// also assigns Stage::wave
+	REQUIRE(graph.GetNumWaves() > 0);
+
+	// AllowWeaponInterceptTarget can query LOS state from Lua
+	CHECK(graph.GetStage(SIM_STAGE_INTERCEPT).wave != graph.GetStage(SIM_STAGE_LOS).wave);
+	CHECK(graph.GetStage(SIM_STAGE_INTERCEPT).wave > graph.GetStage(SIM_STAGE_LOS).wave);
+
+	// stages reaching Lua or unit scripts run on their own
+	for (const SimStage s: {SIM_STAGE_FEATURES, SIM_STAGE_SCRIPTS, SIM_STAGE_ENVRESOURCES, SIM_STAGE_INTERCEPT}) {
+		const CStageGraph::Stage& stage = graph.GetStage(s);
+
+		CHECK((stage.flags & CStageGraph::STAGE_FLAG_MAIN_THREAD) != 0);
+		CHECK(graph.GetWave(stage.wave) == std::vector<size_t>{size_t(s)});
+	}
+}
@@ -0,0 +1,277 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+// Times CCobThread::Tick on a script shaped like the per-frame unit scripts
+// (a loop over locals and statics, compare-and-branch, animation call-outs)
+// and CobInstructionDecoder::Decode, the pass CCobFile makes once per loaded
+// script, over the COB scripts of a game. For the latter point it at a
+// directory of .cob files, e.g. the extracted scripts/ of a game archive:
+//
+//   COB_BENCHMARK_DIR=/path/to/game/scripts ./test_benchmarkCobInterpreter
+//
+// The threads run against the stubs in NullCobInstance.cpp, so call-outs
+// cost nothing and only the interpreter itself is measured; its results are
+// checked by test/engine/Sim/Units/Scripts/testCobThread.cpp. Besides timing
+// the decoder, the benchmark reports how much of each function's
+// straight-line code the fused compare-and-branch instructions account for.
+
+#include "../engine/Sim/Units/Scripts/CobImage.h"
+
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobInstance.h"
+#include "Sim/Units/Scripts/CobInstruction.h"
+#include "Sim/Units/Scripts/CobScriptNames.h"
+#include "Sim/Units/Scripts/CobThread.h"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+	struct Script {
+		std::vector<int> code;
+		std::vector<std::string> names;
+		std::vector<int> offsets;
+		std::vector<int> lengths;
+	};
+
+	bool LoadScript(const std::filesystem::path& path, Script& s) {
+		std::ifstream ifs(path, std::ios::binary);
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+		if (data.size() < 13 * 4)
+			return false;
+
+		// header fields are little-endian, as are the code words
+		const auto Word = [&](size_t ofs) {
+			int32_t v = 0;
+			if (ofs + 4 <= data.size())
+				std::memcpy(&v, &data[ofs], 4);
+			return v;
+		};
+
+		const int numScripts = Word(1 * 4);
+		const int totalLen = Word(3 * 4);
+		const int codeIndexOfs = Word(6 * 4);
+		const int nameIndexOfs = Word(7 * 4);
+		const int codeOfs = Word(9 * 4);
+
+		if (numScripts <= 0 || codeOfs <= 0 || size_t(codeOfs) >= data.size())
+			return false;
+
+		for (int i = 0; i < numScripts; i++) {
+			const size_t nameOfs = Word(nameIndexOfs + i * 4);
+
+			if (nameOfs >= data.size())
+				return false;
+
+			s.names.emplace_back(reinterpret_cast<const char*>(&data[nameOfs]), strnlen(reinterpret_cast<const char*>(&data[nameOfs]), data.size() - nameOfs));
+			s.offsets.push_back(Word(codeIndexOfs + i * 4));
+		}
+		for (int i = 0; i < numScripts; i++) {
+			s.lengths.push_back(((i + 1) < numScripts? s.offsets[i + 1]: totalLen) - s.offsets[i]);
+		}
+
+		// same padding as CCobFile
+		s.code.resize((data.size() - codeOfs) / 4 + 4, 0);
+		std::memcpy(s.code.data(), &data[codeOfs], data.size() - codeOfs);
+
+		return true;
+	}
+
+
+	struct Game {
+		Game() {
+			const char* dir = std::getenv("COB_BENCHMARK_DIR");
+
+			if (dir == nullptr || !std::filesystem::is_directory(dir))
+				return;
+
+			for (const auto& entry: std::filesystem::recursive_directory_iterator(dir)) {
+				if (entry.path().extension() != ".cob" && entry.path().extension() != ".COB")
+					continue;
+
+				Script s;
+
+				if (LoadScript(entry.path(), s))
+					scripts.emplace_back(std::move(s));
+			}
+		}
+
+		std::vector<Script> scripts;
+	};
+
+	Game* game = nullptr;
+
+
+	// Walk(n) {
+	//   var i, a;
+	//   i = 0;
+	//   while (i < n) {
+	//     a = (i * 3) % 7;
+	//     if (a == 2) { turn base to y-axis 100 speed 200; }
+	//     else if (a > 4) { move base to z-axis 100 speed 200; }
+	//     total = total + a;
+	//     i = i + 1;
+	//   }
+	//   return (total);
+	// }
+	std::vector<int> WalkScript() {
+		using namespace CobOpcode;
+
+		std::vector<int> code;
+
+		const auto Emit = [&](std::initializer_list<int> words) { code.insert(code.end(), words); };
+		const auto Here = [&]() { return int(code.size()); };
+
+		Emit({CREATE_LOCAL_VAR, CREATE_LOCAL_VAR, CREATE_LOCAL_VAR});
+		Emit({PUSH_CONSTANT, 0, POP_LOCAL_VAR, 1});
+
+		const int head = Here();
+		Emit({PUSH_LOCAL_VAR, 1, PUSH_LOCAL_VAR, 0, SET_LESS, JUMP_NOT_EQUAL, 0});
+		const int endIdx = Here() - 1;
+
+		Emit({PUSH_LOCAL_VAR, 1, PUSH_CONSTANT, 3, MUL, PUSH_CONSTANT, 7, MOD, POP_LOCAL_VAR, 2});
+		Emit({PUSH_LOCAL_VAR, 2, PUSH_CONSTANT, 2, SET_EQUAL, JUMP_NOT_EQUAL, 0});
+		const int elseIdx = Here() - 1;
+
+		Emit({PUSH_CONSTANT, 100, PUSH_CONSTANT, 200, TURN, 0, 1, JUMP, 0});
+		const int endIfIdx = Here() - 1;
+
+		code[elseIdx] = Here();
+		Emit({PUSH_LOCAL_VAR, 2, PUSH_CONSTANT, 4, SET_GREATER, JUMP_NOT_EQUAL, 0});
+		const int endElseIdx = Here() - 1;
+
+		Emit({PUSH_CONSTANT, 100, PUSH_CONSTANT, 200, MOVE, 0, 2});
+
+		code[endIfIdx] = Here();
+		code[endElseIdx] = Here();
+		Emit({PUSH_STATIC, 0, PUSH_LOCAL_VAR, 2, ADD, POP_STATIC, 0});
+		Emit({PUSH_LOCAL_VAR, 1, PUSH_CONSTANT, 1, ADD, POP_LOCAL_VAR, 1, JUMP, head});
+
+		code[endIdx] = Here();
+		Emit({PUSH_STATIC, 0, RETURN});
+
+		return code;
+	}
+
+	struct TickScript {
+		TickScript(std::vector<std::uint8_t>&& data): file(std::move(data)), cobFile(file, "walk.cob") {
+			inst.cobFile = &cobFile;
+			inst.staticVars.resize(cobFile.numStaticVars, 0);
+		}
+
+		CCobImageFileHandler file;
+		CCobFile cobFile;
+		CCobInstance inst;
+	};
+
+	std::unique_ptr<TickScript> walk;
+
+
+	bool IsFused(int op) {
+		return (op >= CobOp::JumpUnlessLess && op <= CobOp::JumpUnlessNotEqualConst);
+	}
+
+	// walks each function linearly from its entry point the way Tick
+	// would without taking jumps, counting decoded and fused instructions
+	void CountInstructions(const Script& s, const std::vector<CCobInstruction>& instrs, size_t& numInstrs, size_t& numFused) {
+		for (size_t f = 0; f < s.offsets.size(); f++) {
+			const int end = s.offsets[f] + s.lengths[f];
+
+			for (int pc = s.offsets[f]; pc >= 0 && pc < end && static_cast<size_t>(pc) < s.code.size(); pc = instrs[pc].next) {
+				numInstrs += 1;
+				numFused += IsFused(instrs[pc].op);
+			}
+		}
+	}
+}
+
+
+static void SetupGame(const benchmark::State& state) {
+	if (game != nullptr)
+		return;
+
+	game = new Game();
+}
+
+static void TeardownGame(const benchmark::State& state) {
+	delete game;
+	game = nullptr;
+}
+
+
+static void BenchDecode(benchmark::State& state) {
+	if (game->scripts.empty()) {
+		state.SkipWithError("no .cob files found, set COB_BENCHMARK_DIR");
+		return;
+	}
+
+	size_t numWords = 0;
+	size_t numInstrs = 0;
+	size_t numFused = 0;
+
+	for (const Script& s: game->scripts) {
+		numWords += s.code.size();
+		CountInstructions(s, CobInstructionDecoder::Decode(s.code, s.names), numInstrs, numFused);
+	}
+
+	for (auto _ : state) {
+		for (const Script& s: game->scripts) {
+			benchmark::DoNotOptimize(CobInstructionDecoder::Decode(s.code, s.names));
+		}
+	}
+
+	state.counters["words"] = benchmark::Counter(numWords, benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["fused"] = (numInstrs > 0)? (numFused * 1.0 / numInstrs): 0.0;
+}
+
+BENCHMARK(BenchDecode)->Setup(SetupGame)->Teardown(TeardownGame);
+
+
+static void SetupWalk(const benchmark::State& state) {
+	CCobImage image;
+
+	image.SetNumStaticVars(1);
+	image.AddPiece("base");
+	image.AddScript("Walk", WalkScript());
+
+	CCobUnitScriptNames::InitScriptNames();
+	walk = std::make_unique<TickScript>(image.Build());
+}
+
+static void TeardownWalk(const benchmark::State& state) {
+	walk.reset();
+}
+
+
+static void BenchTick(benchmark::State& state) {
+	std::array<int, 1 + MAX_COB_ARGS> args = {};
+
+	args[0] = 1;
+	args[1] = state.range(0);
+
+	for (auto _ : state) {
+		walk->inst.staticVars[0] = 0;
+
+		CCobThread t(&walk->inst);
+		t.Start(0, 0, args, false);
+
+		while (t.Tick());
+
+		benchmark::DoNotOptimize(t.GetRetCode());
+	}
+
+	state.counters["loops"] = benchmark::Counter(state.range(0), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK(BenchTick)->Setup(SetupWalk)->Teardown(TeardownWalk)->Arg(8)->Arg(64)->Arg(512);
+
+BENCHMARK_MAIN();
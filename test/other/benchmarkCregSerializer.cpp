@@ -0,0 +1,146 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/creg/creg_cond.h"
+#include "System/creg/Serializer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <sstream>
+#include <vector>
+
+// rough stand-in for a simulation object graph: many small objects that are
+// mostly ints and floats, point at each other and embed a few sub-objects
+struct BenchMoveData {
+	CR_DECLARE_STRUCT(BenchMoveData)
+
+	float speed = 0.0f;
+	float maxSpeed = 0.0f;
+	float turnRate = 0.0f;
+	int pathID = 0;
+	int numIdling = 0;
+};
+
+CR_BIND(BenchMoveData, )
+CR_REG_METADATA(BenchMoveData, (
+	CR_MEMBER(speed),
+	CR_MEMBER(maxSpeed),
+	CR_MEMBER(turnRate),
+	CR_MEMBER(pathID),
+	CR_MEMBER(numIdling)
+))
+
+struct BenchObject {
+	CR_DECLARE(BenchObject)
+
+	virtual ~BenchObject() {}
+
+	int id = 0;
+	int team = 0;
+	int allyTeam = 0;
+	float health = 0.0f;
+	float maxHealth = 0.0f;
+	float pos[3] = {0.0f, 0.0f, 0.0f};
+	float dir[3] = {0.0f, 0.0f, 0.0f};
+	bool isDead = false;
+	bool isCloaked = false;
+
+	BenchMoveData moveData;
+	std::vector<int> weaponReloads;
+
+	BenchObject* target = nullptr;
+	BenchObject* transporter = nullptr;
+	std::vector<BenchObject*> neighbours;
+};
+
+CR_BIND(BenchObject, )
+CR_REG_METADATA(BenchObject, (
+	CR_MEMBER(id),
+	CR_MEMBER(team),
+	CR_MEMBER(allyTeam),
+	CR_MEMBER(health),
+	CR_MEMBER(maxHealth),
+	CR_MEMBER(pos),
+	CR_MEMBER(dir),
+	CR_MEMBER(isDead),
+	CR_MEMBER(isCloaked),
+	CR_MEMBER(moveData),
+	CR_MEMBER(weaponReloads),
+	CR_MEMBER(target),
+	CR_MEMBER(transporter),
+	CR_MEMBER(neighbours)
+))
+
+struct BenchRoot {
+	CR_DECLARE_STRUCT(BenchRoot)
+
+	std::vector<BenchObject*> objects;
+};
+
+CR_BIND(BenchRoot, )
+CR_REG_METADATA(BenchRoot, (
+	CR_MEMBER(objects)
+))
+
+
+namespace {
+	struct BenchGraph {
+		explicit BenchGraph(int numObjects) {
+			std::mt19937 rng(numObjects);
+
+			storage.resize(numObjects);
+
+			for (int i = 0; i < numObjects; i++) {
+				BenchObject& o = storage[i];
+
+				o.id = i;
+				o.team = rng() % 16;
+				o.allyTeam = o.team / 2;
+				o.health = o.maxHealth = 100.0f + (rng() % 1000);
+				o.pos[0] = rng() % 8192;
+				o.pos[2] = rng() % 8192;
+				o.moveData.maxSpeed = 1.0f + (rng() % 4);
+				o.weaponReloads.resize(rng() % 4, i);
+
+				root.objects.push_back(&o);
+			}
+
+			for (int i = 0; i < numObjects; i++) {
+				BenchObject& o = storage[i];
+
+				o.target = ((rng() % 4) == 0)? &storage[rng() % numObjects]: nullptr;
+
+				for (int n = rng() % 8; n > 0; n--) {
+					o.neighbours.push_back(&storage[rng() % numObjects]);
+				}
+			}
+		}
+
+		BenchRoot root;
+		std::vector<BenchObject> storage;
+	};
+
+
+	void BenchSavePackage(benchmark::State& state) {
+		const BenchGraph graph(state.range(0));
+
+		creg::COutputStreamSerializer os;
+		size_t numBytes = 0;
+
+		for (auto _: state) {
+			std::stringstream oss(std::ios::in | std::ios::out | std::ios::binary);
+			os.SavePackage(&oss, const_cast<BenchRoot*>(&graph.root), graph.root.GetClass());
+			numBytes = oss.tellp();
+
+			benchmark::DoNotOptimize(numBytes);
+		}
+
+		state.counters["bytes"] = numBytes;
+		state.SetBytesProcessed(state.iterations() * numBytes);
+	}
+}
+
+BENCHMARK(BenchSavePackage)->RangeMultiplier(4)->Range(256, 16384)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
+
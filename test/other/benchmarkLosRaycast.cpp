@@ -0,0 +1,119 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosRaycastKernel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+	struct RaycastData {
+		explicit RaycastData(int r): radius(r) {
+			const int diam = 2 * radius + 1;
+
+			std::mt19937 rng(radius);
+			std::uniform_real_distribution<float> heights(-50.0f, 50.0f);
+
+			stride = diam;
+
+			heightMap.resize(diam * diam);
+			isqrtTable.resize((radius + 1) * (radius + 1) * 2);
+			rowWidths.resize(radius + 1, 0);
+			angles.resize(diam * diam);
+			squares.resize(diam * diam);
+			quadAngles.resize((radius + 1) * (radius + 1) * 4);
+			quadVisible.resize((radius + 1) * (radius + 1) * 4);
+
+			for (float& h: heightMap) {
+				h = heights(rng);
+			}
+			for (size_t i = 0; i < isqrtTable.size(); i++) {
+				isqrtTable[i] = 1.0f / std::sqrt(float(std::max<size_t>(i, 1)));
+			}
+			for (int y = 0; y <= radius; y++) {
+				rowWidths[y] = int(std::sqrt(float(radius * radius - y * y)));
+			}
+
+			// one ray per octant-pair surface point, as CLosTableHelper does
+			for (int a = 0; a <= radius; a++) {
+				rays.push_back(GetRay(radius, a));
+				rays.push_back(GetRay(a, radius));
+			}
+		}
+
+		static std::vector<int2> GetRay(int xf, int yf) {
+			std::vector<int2> ray;
+
+			if (xf > yf) {
+				const float m = (float) yf / (float) xf;
+				for (int x = 1; x <= xf; x++) {
+					ray.emplace_back(x, int(std::round(m * x)));
+				}
+			} else {
+				const float m = (float) xf / (float) yf;
+				for (int y = 1; y <= yf; y++) {
+					ray.emplace_back(int(std::round(m * y)), y);
+				}
+			}
+
+			return ray;
+		}
+
+		int radius;
+		int stride;
+
+		std::vector<float> heightMap;
+		std::vector<float> isqrtTable;
+		std::vector<int> rowWidths;
+		std::vector<float> angles;
+		std::vector<char> squares;
+		std::vector<float> quadAngles;
+		std::vector<float> quadVisible;
+		std::vector< std::vector<int2> > rays;
+	};
+}
+
+// full UnsafeLosAdd pipeline: angle precalculation, raycasting and (for SIMD) scattering back
+template<bool simd>
+static void BenchLosRaycast(benchmark::State& state) {
+	RaycastData data(state.range(0));
+
+	const int2 pos(data.radius, data.radius);
+
+	for (auto _ : state) {
+		std::fill(data.squares.begin(), data.squares.end(), false);
+
+		if constexpr (simd) {
+			#if (LOS_RAYCAST_SIMD == 1)
+			std::fill(data.quadAngles.begin(), data.quadAngles.end(), -1e8f);
+			std::fill(data.quadVisible.begin(), data.quadVisible.end(), 0.0f);
+
+			LosRaycast::FillQuadAngles(data.heightMap.data(), data.stride, pos, 0.0f, data.radius, data.rowWidths.data(), data.isqrtTable.data(), data.quadAngles.data(), data.quadVisible.data());
+
+			for (const auto& ray: data.rays) {
+				LosRaycast::CastQuadRay(ray.data(), ray.size(), data.radius, data.isqrtTable.data(), data.quadAngles.data(), data.quadVisible.data());
+			}
+
+			LosRaycast::QuadToSquares(data.radius, data.rowWidths.data(), data.quadVisible.data(), data.squares.data());
+			#endif
+		} else {
+			std::fill(data.angles.begin(), data.angles.end(), -1e8f);
+
+			LosRaycast::FillAngles(data.heightMap.data(), data.stride, pos, 0.0f, data.radius, data.rowWidths.data(), data.isqrtTable.data(), data.angles.data(), data.squares.data());
+
+			for (const auto& ray: data.rays) {
+				LosRaycast::CastRay(ray.data(), ray.size(), data.radius, data.isqrtTable.data(), data.angles.data(), data.squares.data());
+			}
+		}
+
+		benchmark::DoNotOptimize(data.squares.data());
+		benchmark::ClobberMemory();
+	}
+}
+
+BENCHMARK(BenchLosRaycast<false>)->RangeMultiplier(2)->Range(1, 64);
+BENCHMARK(BenchLosRaycast< true>)->RangeMultiplier(2)->Range(1, 64);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,185 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+// Measures what the CUnit/CSolidObject member order costs the per-frame
+// unit loops: 5000 (or 8000) pool-allocated units are walked the way the
+// GroundMoveSystem and UpdateUnits passes do, touching only the members
+// those read and write every frame.
+//
+// The offsets are taken with offsetof from the real classes, so the
+// benchmark follows any change to them. The baseline is the order before
+// the hot members were moved forward; it is derived from the same classes
+// by putting the cold blocks back where they were (LocalModel, collision
+// volumes and hitModelPieces ahead of frontdir..objectUsable, the in-place
+// script/moveType/CAI buffers ahead of the weapons and flags), which is
+// exact up to alignment padding between the blocks.
+
+#include "Sim/Units/Unit.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+	struct Layout {
+		size_t size;
+
+		size_t pos;
+		size_t speed;
+		size_t health;
+		size_t heading;
+		size_t physicalState;
+		size_t moveDef;
+		size_t frontdir;
+		size_t rightdir;
+		size_t updir;
+		size_t relMidPos;
+		size_t midPos;
+		size_t aimPos;
+		size_t mapPos;
+		size_t transporter;
+		size_t moveType;
+		size_t isDead;
+		size_t beingBuilt;
+		// stand-in for the private <stunned>, which sits in the same block
+		size_t neutral;
+	};
+
+	#pragma GCC diagnostic push
+	#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+	constexpr Layout HOT_COLD_LAYOUT = {
+		sizeof(CUnit),
+		offsetof(CUnit, pos), offsetof(CUnit, speed), offsetof(CUnit, health), offsetof(CUnit, heading), offsetof(CUnit, physicalState), offsetof(CUnit, moveDef),
+		offsetof(CUnit, frontdir), offsetof(CUnit, rightdir), offsetof(CUnit, updir), offsetof(CUnit, relMidPos), offsetof(CUnit, midPos), offsetof(CUnit, aimPos), offsetof(CUnit, mapPos),
+		offsetof(CUnit, transporter), offsetof(CUnit, moveType), offsetof(CUnit, isDead), offsetof(CUnit, beingBuilt), offsetof(CUnit, neutral),
+	};
+
+	// CSolidObject::{localModel, collisionVolume, selectionVolume, hitModelPieces}
+	constexpr size_t SOLID_COLD_SIZE = offsetof(CUnit, hitModelPieces) + sizeof(CUnit::hitModelPieces) - offsetof(CUnit, localModel);
+	// CUnit::{us, amt, smt, cai}MemBuffer
+	constexpr size_t UNIT_COLD_SIZE = sizeof(CUnit::usMemBuffer) + sizeof(CUnit::amtMemBuffer) + sizeof(CUnit::smtMemBuffer) + sizeof(CUnit::caiMemBuffer);
+	// CUnit::weapons up to the unsynced members, which the flags used to follow
+	constexpr size_t UNIT_WARM_SIZE = offsetof(CUnit, noMinimap) - offsetof(CUnit, weapons);
+
+	constexpr Layout BASELINE_LAYOUT = {
+		HOT_COLD_LAYOUT.size,
+		HOT_COLD_LAYOUT.pos, HOT_COLD_LAYOUT.speed, HOT_COLD_LAYOUT.health, HOT_COLD_LAYOUT.heading, HOT_COLD_LAYOUT.physicalState, HOT_COLD_LAYOUT.moveDef,
+		HOT_COLD_LAYOUT.frontdir  + SOLID_COLD_SIZE,
+		HOT_COLD_LAYOUT.rightdir  + SOLID_COLD_SIZE,
+		HOT_COLD_LAYOUT.updir     + SOLID_COLD_SIZE,
+		HOT_COLD_LAYOUT.relMidPos + SOLID_COLD_SIZE,
+		HOT_COLD_LAYOUT.midPos    + SOLID_COLD_SIZE,
+		HOT_COLD_LAYOUT.aimPos    + SOLID_COLD_SIZE,
+		HOT_COLD_LAYOUT.mapPos    + SOLID_COLD_SIZE,
+		HOT_COLD_LAYOUT.transporter, HOT_COLD_LAYOUT.moveType,
+		HOT_COLD_LAYOUT.isDead     + UNIT_COLD_SIZE + UNIT_WARM_SIZE,
+		HOT_COLD_LAYOUT.beingBuilt + UNIT_COLD_SIZE + UNIT_WARM_SIZE,
+		HOT_COLD_LAYOUT.neutral    + UNIT_COLD_SIZE + UNIT_WARM_SIZE,
+	};
+	#pragma GCC diagnostic pop
+
+	static_assert(BASELINE_LAYOUT.neutral < BASELINE_LAYOUT.size, "");
+
+	struct Vec3 { float x, y, z; };
+
+	template<typename T> T Load(const uint8_t* u, size_t ofs) { T v; std::memcpy(&v, u + ofs, sizeof(T)); return v; }
+	template<typename T> void Store(uint8_t* u, size_t ofs, const T& v) { std::memcpy(u + ofs, &v, sizeof(T)); }
+
+	struct UnitPool {
+		UnitPool(const Layout& l, int numUnits): layout(l) {
+			std::mt19937 rng(1234);
+			std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+			// CUnitMemPool hands out fixed-size pages, units are adjacent
+			memory.reset(new uint8_t[layout.size * numUnits]);
+			std::memset(memory.get(), 0, layout.size * numUnits);
+
+			for (int i = 0; i < numUnits; i++) {
+				uint8_t* u = memory.get() + layout.size * i;
+
+				Store(u, layout.pos, Vec3{dist(rng) * 4096.0f, 0.0f, dist(rng) * 4096.0f});
+				Store(u, layout.speed, Vec3{dist(rng), 0.0f, dist(rng)});
+				Store(u, layout.health, 100.0f);
+				Store(u, layout.frontdir, Vec3{0.0f, 0.0f, 1.0f});
+				Store(u, layout.rightdir, Vec3{-1.0f, 0.0f, 0.0f});
+				Store(u, layout.updir, Vec3{0.0f, 1.0f, 0.0f});
+				Store(u, layout.relMidPos, Vec3{0.0f, 8.0f, 0.0f});
+				Store(u, layout.moveType, reinterpret_cast<uintptr_t>(u));
+
+				units.push_back(u);
+			}
+
+			// activeUnits is in creation order, which with unit deaths and
+			// id reuse is only loosely related to the pool order
+			for (size_t i = 0; i < units.size(); i += 7) {
+				std::swap(units[i], units[rng() % units.size()]);
+			}
+		}
+
+		const Layout& layout;
+
+		std::unique_ptr<uint8_t[]> memory;
+		std::vector<uint8_t*> units;
+	};
+
+	float UpdateUnits(const UnitPool& pool) {
+		const Layout& l = pool.layout;
+		float sum = 0.0f;
+
+		for (uint8_t* u: pool.units) {
+			if (Load<bool>(u, l.isDead) || Load<bool>(u, l.beingBuilt) || Load<bool>(u, l.neutral))
+				continue;
+			if (Load<uintptr_t>(u, l.transporter) != 0)
+				continue;
+
+			Vec3 pos = Load<Vec3>(u, l.pos);
+			const Vec3 spd = Load<Vec3>(u, l.speed);
+			const Vec3 fwd = Load<Vec3>(u, l.frontdir);
+			const Vec3 rgt = Load<Vec3>(u, l.rightdir);
+			const Vec3 upd = Load<Vec3>(u, l.updir);
+			const Vec3 rel = Load<Vec3>(u, l.relMidPos);
+
+			pos.x += spd.x;
+			pos.z += spd.z;
+
+			const Vec3 mid = {
+				pos.x + fwd.x * rel.z + rgt.x * rel.x + upd.x * rel.y,
+				pos.y + fwd.y * rel.z + rgt.y * rel.x + upd.y * rel.y,
+				pos.z + fwd.z * rel.z + rgt.z * rel.x + upd.z * rel.y,
+			};
+
+			Store(u, l.pos, pos);
+			Store(u, l.midPos, mid);
+			Store(u, l.aimPos, mid);
+			Store(u, l.mapPos, int32_t(pos.x) >> 3);
+			Store(u, l.heading, int16_t(Load<int16_t>(u, l.heading) + 1));
+
+			sum += Load<float>(u, l.health);
+			sum += float(Load<uint32_t>(u, l.physicalState) & 1);
+			sum += float(Load<uintptr_t>(u, l.moveDef) != 0);
+			sum += float(Load<uintptr_t>(u, l.moveType) != 0);
+		}
+
+		return sum;
+	}
+}
+
+template<const Layout& layout>
+static void BenchUnitLoop(benchmark::State& state) {
+	const UnitPool pool(layout, state.range(0));
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(UpdateUnits(pool));
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BenchUnitLoop, BASELINE_LAYOUT)->Arg(5000)->Arg(8000);
+BENCHMARK_TEMPLATE(BenchUnitLoop, HOT_COLD_LAYOUT)->Arg(5000)->Arg(8000);
+
+BENCHMARK_MAIN();
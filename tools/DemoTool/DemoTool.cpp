@@ -26,6 +26,7 @@ no console output (you still could use this.exe > z.tzt though).
 
 	DEFINE_string(demofile,     "",    "Path to demo file");
 	DEFINE_bool  (dump,         false, "Only dump networc traffic saved in demo");
+	DEFINE_bool  (chat,         false, "Only dump chat and lua messages saved in demo");
 	DEFINE_bool  (stats,        false, "Print all game, player and team stats");
 	DEFINE_bool  (header,       false, "Print demoheader content");
 	DEFINE_bool  (playerstats,  false, "Print playerstats");
@@ -35,6 +36,7 @@ no console output (you still could use this.exe > z.tzt though).
 
 
 void TrafficDump(CDemoReader& reader, bool trafficStats);
+void ChatDump(CDemoReader& reader);
 void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string& file);
 
 int main (int argc, char* argv[])
@@ -59,6 +61,11 @@ int main (int argc, char* argv[])
 		TrafficDump(reader, true);
 		return 0;
 	}
+	if (FLAGS_chat)
+	{
+		ChatDump(reader);
+		return 0;
+	}
 	if (!FLAGS_teamsstatcsv.empty())
 	{
 		if (FLAGS_team < 0)
@@ -453,6 +460,34 @@ void TrafficDump(CDemoReader& reader, bool trafficStats)
 	}
 }
 
+void ChatDump(CDemoReader& reader)
+{
+	DemoMsgTypeMask msgTypes;
+	msgTypes.Clear();
+	msgTypes.Add(NETMSG_CHAT);
+	msgTypes.Add(NETMSG_LUAMSG);
+
+	// blocks without any of these are skipped undecompressed if the demo has a block index
+	netcode::RawPacket* packet;
+	while ((packet = reader.GetNextPacket(msgTypes)) != NULL)
+	{
+		const unsigned char* buffer = packet->data;
+		std::cout << "Frame " << reader.GetFrameNum() << " ";
+		switch ((unsigned char)buffer[0])
+		{
+			case NETMSG_CHAT:
+				std::cout << "CHAT: Player: " << (unsigned)buffer[2] << " Msg: " << (char*)(buffer+4) << std::endl;
+				break;
+			case NETMSG_LUAMSG:
+				std::cout << "LUAMSG length:" << packet->length << " Player:" << (unsigned)buffer[3] << " Script: " << *(uint16_t*)&buffer[4] << " Mode: " << (unsigned)buffer[6] << " Msg: ";
+				PrintBinary(&packet->data[7], packet->length - 7);
+				std::cout << std::endl;
+				break;
+		}
+		delete packet;
+	}
+}
+
 template<typename T>
 void PrintSep(std::ofstream& file, T value)
 {